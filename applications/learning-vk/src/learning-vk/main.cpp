@@ -1,4 +1,6 @@
+#include <chrono>
 #include <iostream>
+#include <string_view>
 
 #include <rsl/utilities>
 
@@ -24,8 +26,231 @@ Wndproc(
 
 #endif
 
-int main()
+namespace
 {
+	// SPIR-V 1.0 of the compute shader below, kept inline so the benchmark doesn't depend on shader files. Every
+	// iteration loads from the storage buffer at an index only known at runtime, which robustBufferAccess has to
+	// bounds check.
+	//
+	// #version 450
+	// layout(local_size_x = 64) in;
+	// layout(set = 0, binding = 0) buffer Data { uint values[]; };
+	// layout(push_constant) uniform Parameters { uint iterations; uint mask; uint outputOffset; };
+	//
+	// void main()
+	// {
+	//     uint index = gl_GlobalInvocationID.x;
+	//     uint acc = index;
+	//     for (uint i = 0; i < iterations; i++)
+	//     {
+	//         acc = acc * 1664525u + values[(acc ^ i) & mask];
+	//     }
+	//     values[outputOffset + index] = acc;
+	// }
+	constexpr rsl::uint32 robustnessBenchmarkShader[] = {
+		0x07230203, 0x00010000, 0x00000000, 0x00000035, 0x00000000, 0x00020011, 0x00000001, 0x0003000e,
+		0x00000000, 0x00000001, 0x0006000f, 0x00000005, 0x00000001, 0x6e69616d, 0x00000000, 0x00000002,
+		0x00060010, 0x00000001, 0x00000011, 0x00000040, 0x00000001, 0x00000001, 0x00040047, 0x00000002,
+		0x0000000b, 0x0000001c, 0x00040047, 0x00000003, 0x00000006, 0x00000004, 0x00050048, 0x00000004,
+		0x00000000, 0x00000023, 0x00000000, 0x00030047, 0x00000004, 0x00000003, 0x00040047, 0x00000005,
+		0x00000022, 0x00000000, 0x00040047, 0x00000005, 0x00000021, 0x00000000, 0x00050048, 0x00000006,
+		0x00000000, 0x00000023, 0x00000000, 0x00050048, 0x00000006, 0x00000001, 0x00000023, 0x00000004,
+		0x00050048, 0x00000006, 0x00000002, 0x00000023, 0x00000008, 0x00030047, 0x00000006, 0x00000002,
+		0x00020013, 0x00000008, 0x00030021, 0x00000009, 0x00000008, 0x00040015, 0x0000000a, 0x00000020,
+		0x00000000, 0x00040017, 0x0000000b, 0x0000000a, 0x00000003, 0x00020014, 0x00000013, 0x00040020,
+		0x0000000c, 0x00000001, 0x0000000b, 0x00040020, 0x0000000d, 0x00000001, 0x0000000a, 0x0003001d,
+		0x00000003, 0x0000000a, 0x0003001e, 0x00000004, 0x00000003, 0x00040020, 0x0000000e, 0x00000002,
+		0x00000004, 0x00040020, 0x0000000f, 0x00000002, 0x0000000a, 0x0005001e, 0x00000006, 0x0000000a,
+		0x0000000a, 0x0000000a, 0x00040020, 0x00000010, 0x00000009, 0x00000006, 0x00040020, 0x00000011,
+		0x00000009, 0x0000000a, 0x00040020, 0x00000012, 0x00000007, 0x0000000a, 0x0004002b, 0x0000000a,
+		0x00000014, 0x00000000, 0x0004002b, 0x0000000a, 0x00000015, 0x00000001, 0x0004002b, 0x0000000a,
+		0x00000016, 0x00000002, 0x0004002b, 0x0000000a, 0x00000017, 0x0019660d, 0x0004003b, 0x0000000c,
+		0x00000002, 0x00000001, 0x0004003b, 0x0000000e, 0x00000005, 0x00000002, 0x0004003b, 0x00000010,
+		0x00000007, 0x00000009, 0x00050036, 0x00000008, 0x00000001, 0x00000000, 0x00000009, 0x000200f8,
+		0x00000018, 0x0004003b, 0x00000012, 0x00000019, 0x00000007, 0x0004003b, 0x00000012, 0x0000001a,
+		0x00000007, 0x00050041, 0x0000000d, 0x0000001b, 0x00000002, 0x00000014, 0x0004003d, 0x0000000a,
+		0x0000001c, 0x0000001b, 0x0003003e, 0x00000019, 0x0000001c, 0x0003003e, 0x0000001a, 0x00000014,
+		0x000200f9, 0x0000001d, 0x000200f8, 0x0000001d, 0x000400f6, 0x0000001e, 0x0000001f, 0x00000000,
+		0x000200f9, 0x00000020, 0x000200f8, 0x00000020, 0x0004003d, 0x0000000a, 0x00000021, 0x0000001a,
+		0x00050041, 0x00000011, 0x00000022, 0x00000007, 0x00000014, 0x0004003d, 0x0000000a, 0x00000023,
+		0x00000022, 0x000500b0, 0x00000013, 0x00000024, 0x00000021, 0x00000023, 0x000400fa, 0x00000024,
+		0x00000025, 0x0000001e, 0x000200f8, 0x00000025, 0x0004003d, 0x0000000a, 0x00000026, 0x00000019,
+		0x000500c6, 0x0000000a, 0x00000027, 0x00000026, 0x00000021, 0x00050041, 0x00000011, 0x00000028,
+		0x00000007, 0x00000015, 0x0004003d, 0x0000000a, 0x00000029, 0x00000028, 0x000500c7, 0x0000000a,
+		0x0000002a, 0x00000027, 0x00000029, 0x00060041, 0x0000000f, 0x0000002b, 0x00000005, 0x00000014,
+		0x0000002a, 0x0004003d, 0x0000000a, 0x0000002c, 0x0000002b, 0x00050084, 0x0000000a, 0x0000002d,
+		0x00000026, 0x00000017, 0x00050080, 0x0000000a, 0x0000002e, 0x0000002d, 0x0000002c, 0x0003003e,
+		0x00000019, 0x0000002e, 0x000200f9, 0x0000001f, 0x000200f8, 0x0000001f, 0x00050080, 0x0000000a,
+		0x0000002f, 0x00000021, 0x00000015, 0x0003003e, 0x0000001a, 0x0000002f, 0x000200f9, 0x0000001d,
+		0x000200f8, 0x0000001e, 0x00050041, 0x00000011, 0x00000030, 0x00000007, 0x00000016, 0x0004003d,
+		0x0000000a, 0x00000031, 0x00000030, 0x00050080, 0x0000000a, 0x00000032, 0x00000031, 0x0000001c,
+		0x0004003d, 0x0000000a, 0x00000033, 0x00000019, 0x00060041, 0x0000000f, 0x00000034, 0x00000005,
+		0x00000014, 0x00000032, 0x0003003e, 0x00000034, 0x00000033, 0x000100fd, 0x00010038,
+	};
+
+	// The first half of the buffer is read, the second half receives one result per invocation.
+	constexpr rsl::uint32 robustnessBenchmarkElementCount = 1 << 20;
+	constexpr rsl::uint32 robustnessBenchmarkIterations = 64;
+
+	struct robustness_benchmark_parameters
+	{
+		rsl::uint32 iterations;
+		rsl::uint32 mask;
+		rsl::uint32 outputOffset;
+	};
+
+	// Average seconds per dispatch of robustnessBenchmarkShader on a device created with exactly the given features,
+	// negative when the device or one of the objects couldn't be created.
+	double run_robustness_benchmark(vk::instance& instance, const vk::physical_device_features& features)
+	{
+		constexpr rsl::uint32 elementCount = robustnessBenchmarkElementCount;
+		constexpr rsl::uint32 groupSize = 64;
+		constexpr rsl::size_type dispatchCount = 16;
+		const robustness_benchmark_parameters parameters{
+			.iterations = robustnessBenchmarkIterations,
+			.mask = elementCount - 1,
+			.outputOffset = elementCount,
+		};
+
+		const vk::physical_device_description deviceDesc{.requiredFeatures = features};
+		const vk::queue_description queueDesc{.requiredFeatures = vk::queue_feature_flags::compute};
+
+		auto renderDevice = instance.auto_select_and_create_device(deviceDesc, {&queueDesc, 1});
+		if (!renderDevice)
+		{
+			return -1.0;
+		}
+
+		auto queue = renderDevice.get_queues()[0];
+		auto buffer = renderDevice.create_buffer(vk::buffer_description{
+			.size = elementCount * 2ull * sizeof(rsl::uint32),
+			.usage = vk::buffer_usage_flags::storageBuffer,
+		});
+
+		auto shaderModule = renderDevice.create_shader_module(robustnessBenchmarkShader);
+		vk::pipeline_layout layout;
+		vk::pipeline pipeline;
+		if (shaderModule)
+		{
+			layout = renderDevice.create_pipeline_layout({&shaderModule, 1});
+		}
+
+		if (layout)
+		{
+			pipeline = renderDevice.create_compute_pipeline(vk::compute_pipeline_description{
+				.stage = {.stage = vk::shader_stage_flags::compute, .module = shaderModule},
+				.layout = layout,
+			});
+		}
+
+		auto descriptorAllocator = renderDevice.create_descriptor_allocator();
+		auto descriptorWriter = renderDevice.create_descriptor_writer();
+		vk::descriptor_set descriptorSet;
+		if (layout && descriptorAllocator && descriptorWriter && buffer)
+		{
+			descriptorSet = descriptorAllocator.allocate(layout.get_descriptor_set_layout(0));
+			if (descriptorSet)
+			{
+				descriptorWriter.write_buffer(
+					descriptorSet, 0, vk::descriptor_type::storageBuffer, buffer.get_buffer_handle()
+				);
+				descriptorWriter.flush();
+			}
+		}
+
+		auto commandPool = queue.create_persistent_command_pool();
+		vk::command_buffer commandBuffer;
+		if (commandPool)
+		{
+			commandBuffer = commandPool.get_command_buffer();
+		}
+
+		// Every dispatch is submitted and waited on by itself, later dispatches overwrite the same results.
+		auto runDispatch = [&]() -> bool {
+			if (!commandBuffer.begin())
+			{
+				return false;
+			}
+
+			commandBuffer.bind_pipeline(pipeline);
+			commandBuffer.bind_descriptor_sets(pipeline, 0, {&descriptorSet, 1});
+			commandBuffer.push_constants(
+				pipeline, vk::shader_stage_flags::compute, 0,
+				{reinterpret_cast<const rsl::byte*>(&parameters), sizeof(parameters)}
+			);
+			commandBuffer.dispatch(elementCount / groupSize);
+
+			return commandBuffer.end() && queue.submit({&commandBuffer, 1}) && queue.wait_idle();
+		};
+
+		double result = -1.0;
+		if (pipeline && descriptorSet && commandBuffer && runDispatch())
+		{
+			const auto start = std::chrono::steady_clock::now();
+			rsl::size_type completed = 0;
+			while (completed < dispatchCount && runDispatch()) { completed++; }
+			const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+			if (completed == dispatchCount)
+			{
+				result = duration.count() / static_cast<double>(dispatchCount);
+			}
+		}
+
+		commandBuffer.return_to_pool();
+		commandPool.release();
+		descriptorWriter.release();
+		descriptorAllocator.release();
+		pipeline.release();
+		layout.release();
+		shaderModule.release();
+		buffer.release();
+		queue.release();
+		renderDevice.release();
+
+		return result;
+	}
+
+	// Runs the benchmark without and with robustBufferAccess, every other feature stays disabled on both devices.
+	bool benchmark_robustness(vk::instance& instance)
+	{
+		constexpr auto robustFeatures =
+			vk::physical_device_features::of<vk::physical_device_feature::robustBufferAccess>();
+		constexpr double loadsPerDispatch =
+			static_cast<double>(robustnessBenchmarkElementCount) * robustnessBenchmarkIterations;
+
+		std::cout << "Robustness benchmark:\n";
+
+		const double withoutRobustness = run_robustness_benchmark(instance, {});
+		if (withoutRobustness < 0.0)
+		{
+			std::cout << "\tFailed to run the benchmark\n";
+			return false;
+		}
+
+		std::cout << "\trobustBufferAccess off: " << withoutRobustness * 1000.0 << "ms per dispatch ("
+				  << loadsPerDispatch / withoutRobustness / 1e9 << " G loads/s)\n";
+
+		const double withRobustness = run_robustness_benchmark(instance, robustFeatures);
+		if (withRobustness < 0.0)
+		{
+			std::cout << "\tFailed to run the benchmark with robustBufferAccess\n";
+			return false;
+		}
+
+		std::cout << "\trobustBufferAccess on: " << withRobustness * 1000.0 << "ms per dispatch ("
+				  << loadsPerDispatch / withRobustness / 1e9 << " G loads/s)\n";
+		std::cout << "\trobustness overhead: " << (withRobustness / withoutRobustness - 1.0) * 100.0 << "%\n";
+
+		return true;
+	}
+} // namespace
+
+int main(int argc, char** argv)
+{
+	// --robustness-benchmark measures the shader throughput cost of robustBufferAccess instead of running frames.
+	const bool robustnessBenchmark = argc > 1 && std::string_view(argv[1]) == "--robustness-benchmark";
+
 	rsl::default_pmu_allocator allocator;
 	vk::graphics_library lib = vk::init(allocator);
 
@@ -95,6 +320,21 @@ int main()
 		return -1;
 	}
 
+	if (robustnessBenchmark)
+	{
+		const bool succeeded = benchmark_robustness(instance);
+
+		instance.release();
+		vk::release_window_handle(windowHandle);
+		lib.release();
+
+#if RYTHE_PLATFORM_WINDOWS
+		DestroyWindow(hwnd);
+#endif
+
+		return succeeded ? 0 : -1;
+	}
+
 	vk::physical_device_description deviceDesc;
 
 	vk::queue_description queueDescs[] = {
@@ -115,6 +355,12 @@ int main()
 
 	auto surface = instance.create_surface();
 
+	// Without a window frames go to a headless target, which is submitted to on the graphics queue.
+	if (!surface)
+	{
+		queueDescs[3].requiredFeatures = vk::queue_feature_flags::graphics;
+	}
+
 	auto renderDevice = instance.auto_select_and_create_device(deviceDesc, queueDescs, surface);
 
 	if (!renderDevice)
@@ -231,7 +477,7 @@ int main()
 
 		std::cout << "\tfeatures:\n";
 #define PRINT_FEATURE(name)                                                                                            \
-	if (features.name)                                                                                                 \
+	if (features.has(vk::physical_device_feature::name))                                                               \
 	{                                                                                                                  \
 		std::cout << "\t\t" #name ": yes\n";                                                                           \
 	}                                                                                                                  \
@@ -355,24 +601,201 @@ int main()
 	auto transferQueue = queues[2];
 	auto presentQueue = queues[3];
 
-	auto presentCommandPool = presentQueue.create_persistent_command_pool();
+	// Frames are recorded for and submitted on the graphics queue.
+	auto frameCommandPool = graphicsQueue.create_persistent_command_pool();
 
-	auto presentCommandBuffer = presentCommandPool.get_command_buffer();
+	vk::swapchain swapchain;
+	vk::headless_target headlessTarget;
+	if (surface)
+	{
+		swapchain = renderDevice.create_swapchain(surface, vk::swapchain_description{});
+	}
+	else
+	{
+		headlessTarget = renderDevice.create_headless_target(vk::headless_target_description{});
+	}
 
-    std::cout << (presentCommandBuffer ? "Command buffer created!\n" : "Command buffer failed to be created...\n");
+	if (swapchain)
+	{
+		std::cout << "Swapchain:\n";
+		std::cout << "\tpresent mode: " << vk::to_string(swapchain.get_present_mode()) << '\n';
+		std::cout << "\timage count: " << swapchain.get_image_count() << '\n';
+		std::cout << "\tframes in flight: " << swapchain.get_frames_in_flight() << '\n';
+		std::cout << "\textent: " << swapchain.get_extent().x << 'x' << swapchain.get_extent().y << '\n';
+	}
 
-#if RYTHE_PLATFORM_WINDOWS
-	MSG message;
-	while (GetMessage(&message, NULL, 0, 0) > 0)
+	if (headlessTarget)
+	{
+		std::cout << "Headless target:\n";
+		std::cout << "\timage count: " << headlessTarget.get_image_count() << '\n';
+		std::cout << "\tframes in flight: " << headlessTarget.get_frames_in_flight() << '\n';
+		std::cout << "\textent: " << headlessTarget.get_extent().x << 'x' << headlessTarget.get_extent().y << '\n';
+	}
+
+	// One command buffer per frame in flight, a command buffer can't be recorded again while its frame runs.
+	std::vector<vk::command_buffer> frameCommandBuffers;
 	{
-		TranslateMessage(&message);
-		DispatchMessage(&message);
+		rsl::size_type framesInFlight = 0;
+		if (swapchain)
+		{
+			framesInFlight = swapchain.get_frames_in_flight();
+		}
+		else if (headlessTarget)
+		{
+			framesInFlight = headlessTarget.get_frames_in_flight();
+		}
+
+		for (rsl::size_type i = 0; i < framesInFlight; i++)
+		{
+			frameCommandBuffers.push_back(frameCommandPool.get_command_buffer());
+			if (!frameCommandBuffers.back())
+			{
+				std::cout << "Command buffer failed to be created...\n";
+			}
+		}
+	}
+
+	// Clears the current image, the same loop runs on the swapchain and on the headless target.
+	rsl::size_type frameCount = 0;
+	auto renderFrame = [&](auto& target) -> bool {
+		vk::swapchain_status status = target.acquire_next_image();
+		if (status == vk::swapchain_status::outOfDate)
+		{
+			return target.recreate() != vk::swapchain_status::failed;
+		}
+
+		if (status == vk::swapchain_status::failed)
+		{
+			return false;
+		}
+
+		bool recreate = status == vk::swapchain_status::suboptimal;
+
+		auto& commandBuffer = frameCommandBuffers[target.get_frame_index()];
+		if (!commandBuffer.begin())
+		{
+			return false;
+		}
+
+		const float brightness = static_cast<float>(frameCount % 256) / 255.f;
+		const vk::clear_value clearValue{.color = {brightness, 0.2f, 1.f - brightness, 1.f}};
+
+		const vk::image_handle image = target.get_current_image();
+		if (renderDevice.supports_dynamic_rendering())
+		{
+			commandBuffer.transition_image_layout(
+				image, vk::image_layout::undefined, vk::image_layout::colorAttachmentOptimal
+			);
+
+			const vk::rendering_attachment colorAttachment{
+				.imageView = target.get_current_image_view(),
+				.clearValue = clearValue,
+			};
+
+			commandBuffer.begin_rendering(vk::rendering_description{
+				.renderAreaExtent = target.get_extent(),
+				.colorAttachments = {&colorAttachment, 1},
+			});
+			commandBuffer.end_rendering();
+
+			commandBuffer.transition_image_layout(
+				image, vk::image_layout::colorAttachmentOptimal, target.get_present_layout()
+			);
+		}
+		else
+		{
+			commandBuffer.transition_image_layout(
+				image, vk::image_layout::undefined, vk::image_layout::transferDstOptimal
+			);
+			commandBuffer.clear_color_image(image, vk::image_layout::transferDstOptimal, clearValue);
+			commandBuffer.transition_image_layout(
+				image, vk::image_layout::transferDstOptimal, target.get_present_layout()
+			);
+		}
+
+		if (!commandBuffer.end())
+		{
+			return false;
+		}
+
+		status = target.present(graphicsQueue, {&commandBuffer, 1}, presentQueue);
+		frameCount++;
+
+		if (status == vk::swapchain_status::failed)
+		{
+			return false;
+		}
+
+		recreate = recreate || status != vk::swapchain_status::ready;
+		return !recreate || target.recreate() != vk::swapchain_status::failed;
 	};
+
+	auto printLatency = [](const vk::frame_latency& latency) {
+		auto printHistogram = [](const char* name, const vk::latency_histogram& histogram) {
+			if (histogram.get_sample_count() == 0)
+			{
+				return;
+			}
+
+			std::cout << '\t' << name << ": mean " << histogram.get_mean() / 1000 << "us, p50 "
+					  << histogram.get_percentile(0.5f) / 1000 << "us, p99 " << histogram.get_percentile(0.99f) / 1000
+					  << "us, max " << histogram.get_max() / 1000 << "us\n";
+		};
+
+		std::cout << "Frame latency:\n";
+		printHistogram("acquire", latency.acquire);
+		printHistogram("cpu frame", latency.cpuFrame);
+		printHistogram("present", latency.present);
+		printHistogram("start to display", latency.startToDisplay);
+	};
+
+#if RYTHE_PLATFORM_WINDOWS
+	bool running = true;
+	while (running)
+	{
+		MSG message;
+		while (PeekMessage(&message, NULL, 0, 0, PM_REMOVE))
+		{
+			if (message.message == WM_QUIT)
+			{
+				running = false;
+			}
+
+			TranslateMessage(&message);
+			DispatchMessage(&message);
+		}
+
+		if (running && swapchain && !renderFrame(swapchain))
+		{
+			running = false;
+		}
+	}
+
+	if (swapchain)
+	{
+		printLatency(swapchain.get_latency());
+	}
 #endif
 
-	presentCommandBuffer.return_to_pool();
+	if (headlessTarget)
+	{
+		constexpr rsl::size_type headlessFrameCount = 1000;
+
+		const auto start = std::chrono::steady_clock::now();
+		while (frameCount < headlessFrameCount && renderFrame(headlessTarget)) {}
+		const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+		std::cout << "Rendered " << frameCount << " headless frames in " << duration.count() << "s ("
+				  << static_cast<double>(frameCount) / duration.count() << " fps)\n";
+		printLatency(headlessTarget.get_latency());
+	}
+
+	swapchain.release();
+	headlessTarget.release();
+
+	for (auto& commandBuffer : frameCommandBuffers) { commandBuffer.return_to_pool(); }
 
-	presentCommandPool.release();
+	frameCommandPool.release();
 
 	graphicsQueue.release();
 	computeQueue.release();
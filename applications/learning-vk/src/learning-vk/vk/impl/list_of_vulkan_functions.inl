@@ -72,6 +72,12 @@ INSTANCE_LEVEL_PHYSICAL_DEVICE_VULKAN_FUNCTION_FROM_EXTENSION(
 INSTANCE_LEVEL_PHYSICAL_DEVICE_VULKAN_FUNCTION_FROM_EXTENSION(
 	vkGetPhysicalDeviceSurfacePresentModesKHR, VK_KHR_SURFACE_EXTENSION_NAME
 )
+INSTANCE_LEVEL_PHYSICAL_DEVICE_VULKAN_FUNCTION_FROM_EXTENSION(
+	vkGetPhysicalDeviceFeatures2KHR, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME
+)
+INSTANCE_LEVEL_PHYSICAL_DEVICE_VULKAN_FUNCTION_FROM_EXTENSION(
+	vkGetPhysicalDeviceProperties2KHR, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME
+)
 
 #undef INSTANCE_LEVEL_PHYSICAL_DEVICE_VULKAN_FUNCTION_FROM_EXTENSION
 
@@ -187,5 +193,42 @@ DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkGetSwapchainImagesKHR, VK_KHR_SWAP
 DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkAcquireNextImageKHR, VK_KHR_SWAPCHAIN_EXTENSION_NAME)
 DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkQueuePresentKHR, VK_KHR_SWAPCHAIN_EXTENSION_NAME)
 DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkDestroySwapchainKHR, VK_KHR_SWAPCHAIN_EXTENSION_NAME)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkWaitForPresentKHR, VK_KHR_PRESENT_WAIT_EXTENSION_NAME)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkCmdBeginRenderingKHR, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkCmdEndRenderingKHR, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkCmdSetCullModeEXT, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkCmdSetFrontFaceEXT, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkCmdSetPrimitiveTopologyEXT, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkCmdSetDepthTestEnableEXT, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkCmdSetDepthWriteEnableEXT, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkCmdSetDepthCompareOpEXT, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(
+	vkCmdSetPrimitiveRestartEnableEXT, VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME
+)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkCmdSetDepthBiasEnableEXT, VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkCmdSetPolygonModeEXT, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkCmdSetDepthClampEnableEXT, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkCmdSetColorBlendEnableEXT, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(
+	vkCmdSetColorBlendEquationEXT, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME
+)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(vkCmdSetColorWriteMaskEXT, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)
 
 #undef DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION
+
+#if !defined(DEVICE_LEVEL_VULKAN_FUNCTION_FROM_VERSION)
+	#define DEVICE_LEVEL_VULKAN_FUNCTION_FROM_VERSION(function, version)
+#endif // !DEVICE_LEVEL_VULKAN_FUNCTION_FROM_VERSION
+
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_VERSION(vkCmdBeginRendering, VK_API_VERSION_1_3)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_VERSION(vkCmdEndRendering, VK_API_VERSION_1_3)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_VERSION(vkCmdSetCullMode, VK_API_VERSION_1_3)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_VERSION(vkCmdSetFrontFace, VK_API_VERSION_1_3)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_VERSION(vkCmdSetPrimitiveTopology, VK_API_VERSION_1_3)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_VERSION(vkCmdSetDepthTestEnable, VK_API_VERSION_1_3)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_VERSION(vkCmdSetDepthWriteEnable, VK_API_VERSION_1_3)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_VERSION(vkCmdSetDepthCompareOp, VK_API_VERSION_1_3)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_VERSION(vkCmdSetPrimitiveRestartEnable, VK_API_VERSION_1_3)
+DEVICE_LEVEL_VULKAN_FUNCTION_FROM_VERSION(vkCmdSetDepthBiasEnable, VK_API_VERSION_1_3)
+
+#undef DEVICE_LEVEL_VULKAN_FUNCTION_FROM_VERSION
@@ -1,6 +1,20 @@
 #include "vulkan.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <bit>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
 #define VK_NO_PROTOTYPES
 #include <vulkan/vulkan.h>
@@ -21,6 +35,15 @@
 	#endif
 #endif
 
+#if RYTHE_PLATFORM_WINDOWS
+	#include <windows.h>
+#elif RYTHE_PLATFORM_LINUX
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
 #define MAKE_HASHED_STRING_VIEW_LITERAL_IMPL(str) (str##_hsv)
 #define MAKE_HASHED_STRING_VIEW_LITERAL(str) MAKE_HASHED_STRING_VIEW_LITERAL_IMPL(str)
 
@@ -67,6 +90,122 @@ namespace vk
 			alloc.deallocate(ptr, sizeof(T) * count);
 		}
 
+		// FNV-1a, used for on-disk checksums. Stable across runs and platforms, unlike std::hash.
+		[[nodiscard]] constexpr rsl::uint64
+		hash_bytes(std::span<const rsl::byte> bytes, rsl::uint64 seed = 14695981039346656037ull) noexcept
+		{
+			rsl::uint64 hash = seed;
+			for (rsl::byte byte : bytes)
+			{
+				hash ^= static_cast<rsl::uint64>(byte);
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+
+		template <typename T>
+		[[nodiscard]] rsl::uint64 hash_value(const T& value, rsl::uint64 seed = 14695981039346656037ull) noexcept
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			return hash_bytes(std::span<const rsl::byte>(reinterpret_cast<const rsl::byte*>(&value), sizeof(T)), seed);
+		}
+
+		[[nodiscard]] rsl::uint64 hash_string(std::string_view str, rsl::uint64 seed = 14695981039346656037ull) noexcept
+		{
+			return hash_bytes(
+				std::span<const rsl::byte>(reinterpret_cast<const rsl::byte*>(str.data()), str.size()), seed
+			);
+		}
+
+		// Byte image of the state a cached object is created from, together with its hash. Caches are keyed on the
+		// whole image, so two different states with the same 64-bit hash never end up sharing an object.
+		struct cache_key
+		{
+			rsl::uint64 hash = hash_bytes({});
+			std::vector<rsl::byte> bytes;
+
+			void append_bytes(std::span<const rsl::byte> data)
+			{
+				bytes.insert(bytes.end(), data.begin(), data.end());
+				hash = hash_bytes(data, hash);
+			}
+
+			template <typename T>
+			void append(const T& value)
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				append_bytes(std::span<const rsl::byte>(reinterpret_cast<const rsl::byte*>(&value), sizeof(T)));
+			}
+
+			// Prefixed with the length so adjacent strings can't run into each other.
+			void append_string(std::string_view str)
+			{
+				append(str.size());
+				append_bytes(std::span<const rsl::byte>(reinterpret_cast<const rsl::byte*>(str.data()), str.size()));
+			}
+
+			// Nests the full contents of another key, length prefixed like strings.
+			void append_key(const cache_key& other)
+			{
+				append(other.bytes.size());
+				append_bytes(other.bytes);
+			}
+
+			[[nodiscard]] bool operator==(const cache_key& other) const = default;
+		};
+
+		struct cache_key_hash
+		{
+			[[nodiscard]] rsl::size_type operator()(const cache_key& key) const noexcept
+			{
+				return static_cast<rsl::size_type>(key.hash);
+			}
+		};
+
+		template <typename T>
+		using cache_map = std::unordered_map<cache_key, T, cache_key_hash>;
+
+		// Writes to a temporary file first and renames it over the target, so a crash never leaves a torn file.
+		bool write_file_atomically(
+			const std::filesystem::path& targetPath, std::span<const rsl::byte> header, std::span<const rsl::byte> data,
+			std::string_view fileKind
+		)
+		{
+			std::filesystem::path tempPath = targetPath;
+			tempPath += ".tmp";
+
+			std::error_code error;
+			if (targetPath.has_parent_path())
+			{
+				std::filesystem::create_directories(targetPath.parent_path(), error);
+			}
+
+			{
+				std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+				file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+				file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+				file.flush();
+
+				if (!file)
+				{
+					std::cout << "Could not write " << fileKind << " file " << tempPath << '\n';
+					file.close();
+					std::filesystem::remove(tempPath, error);
+					return false;
+				}
+			}
+
+			std::filesystem::rename(tempPath, targetPath, error);
+			if (error)
+			{
+				std::cout << "Could not replace " << fileKind << " file " << targetPath << ": " << error.message()
+						  << '\n';
+				std::filesystem::remove(tempPath, error);
+				return false;
+			}
+
+			return true;
+		}
 	} // namespace
 
 #if RYTHE_PLATFORM_WINDOWS
@@ -187,6 +326,81 @@ namespace vk
 		target.m_nativeCommandBuffer = handle;
 	}
 
+	static void set_native_handle(pipeline_cache& target, native_pipeline_cache handle)
+	{
+		target.m_nativePipelineCache = handle;
+	}
+
+	static void set_native_handle(shader_module& target, native_shader_module handle)
+	{
+		target.m_nativeShaderModule = handle;
+	}
+
+	static void set_native_handle(shader_pack& target, native_shader_pack handle)
+	{
+		target.m_nativeShaderPack = handle;
+	}
+
+	static void set_native_handle(descriptor_set_layout& target, native_descriptor_set_layout handle)
+	{
+		target.m_nativeDescriptorSetLayout = handle;
+	}
+
+	static void set_native_handle(pipeline_layout& target, native_pipeline_layout handle)
+	{
+		target.m_nativePipelineLayout = handle;
+	}
+
+	static void set_native_handle(descriptor_set& target, native_descriptor_set handle)
+	{
+		target.m_nativeDescriptorSet = handle;
+	}
+
+	static void set_native_handle(descriptor_allocator& target, native_descriptor_allocator handle)
+	{
+		target.m_nativeDescriptorAllocator = handle;
+	}
+
+	static void set_native_handle(descriptor_writer& target, native_descriptor_writer handle)
+	{
+		target.m_nativeDescriptorWriter = handle;
+	}
+
+	static void set_native_handle(sampler& target, native_sampler handle)
+	{
+		target.m_nativeSampler = handle;
+	}
+
+	static void set_native_handle(bindless_table& target, native_bindless_table handle)
+	{
+		target.m_nativeBindlessTable = handle;
+	}
+
+	static void set_native_handle(render_pass& target, native_render_pass handle)
+	{
+		target.m_nativeRenderPass = handle;
+	}
+
+	static void set_native_handle(pipeline& target, native_pipeline handle)
+	{
+		target.m_nativePipeline = handle;
+	}
+
+	static void set_native_handle(pipeline_batch& target, native_pipeline_batch handle)
+	{
+		target.m_nativePipelineBatch = handle;
+	}
+
+	static void set_native_handle(swapchain& target, native_swapchain handle)
+	{
+		target.m_nativeSwapchain = handle;
+	}
+
+	static void set_native_handle(headless_target& target, native_headless_target handle)
+	{
+		target.m_nativeHeadlessTarget = handle;
+	}
+
 	namespace
 	{
 		template <typename T>
@@ -194,11 +408,39 @@ namespace vk
 		{
 		};
 
+		// Hash of a layer or extension name to its index in the properties vector it was built from.
+		using name_index = std::unordered_map<rsl::id_type, rsl::size_type>;
+
+		// Instance level functions, loaded once per instance and shared by pointer with its physical and render
+		// devices. Immutable once published.
+		struct instance_dispatch_table
+		{
+#define INSTANCE_LEVEL_VULKAN_FUNCTION(name) [[maybe_unused]] PFN_##name name = nullptr;
+#define INSTANCE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(name, extension) [[maybe_unused]] PFN_##name name = nullptr;
+#define INSTANCE_LEVEL_PHYSICAL_DEVICE_VULKAN_FUNCTION(name) [[maybe_unused]] PFN_##name name = nullptr;
+#define INSTANCE_LEVEL_PHYSICAL_DEVICE_VULKAN_FUNCTION_FROM_EXTENSION(name, extension)                                 \
+	[[maybe_unused]] PFN_##name name = nullptr;
+#define INSTANCE_LEVEL_DEVICE_VULKAN_FUNCTION(name) [[maybe_unused]] PFN_##name name = nullptr;
+#include "impl/list_of_vulkan_functions.inl"
+		};
+
+		// Device level functions, loaded once per render device, every object created from the device reaches them
+		// through it. Immutable once published.
+		struct device_dispatch_table
+		{
+#define DEVICE_LEVEL_VULKAN_FUNCTION(name) [[maybe_unused]] PFN_##name name = nullptr;
+#define DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(name, extension) [[maybe_unused]] PFN_##name name = nullptr;
+#define DEVICE_LEVEL_VULKAN_FUNCTION_FROM_VERSION(name, version) [[maybe_unused]] PFN_##name name = nullptr;
+#include "impl/list_of_vulkan_functions.inl"
+		};
+
 		struct native_graphics_library_vk
 		{
 			rsl::dynamic_library vulkanLibrary;
 			std::vector<layer_properties> availableInstanceLayers;
 			std::vector<extension_properties> availableInstanceExtensions;
+			name_index availableInstanceLayerIndex;
+			name_index availableInstanceExtensionIndex;
 
 			rsl::pmu_allocator* alloc;
 			VkAllocationCallbacks allocCallbacks;
@@ -231,13 +473,11 @@ namespace vk
 		{
 			bool load_functions(std::span<const rsl::cstring> extensions);
 
-#define INSTANCE_LEVEL_VULKAN_FUNCTION(name) [[maybe_unused]] PFN_##name name = nullptr;
-#define INSTANCE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(name, extension) [[maybe_unused]] PFN_##name name = nullptr;
-#define INSTANCE_LEVEL_PHYSICAL_DEVICE_VULKAN_FUNCTION(name) [[maybe_unused]] PFN_##name name = nullptr;
-#define INSTANCE_LEVEL_PHYSICAL_DEVICE_VULKAN_FUNCTION_FROM_EXTENSION(name, extension)                                 \
-	[[maybe_unused]] PFN_##name name = nullptr;
-#define INSTANCE_LEVEL_DEVICE_VULKAN_FUNCTION(name) [[maybe_unused]] PFN_##name name = nullptr;
-#include "impl/list_of_vulkan_functions.inl"
+			// Owned by the instance and freed by instance::release. Physical and render devices point into it without
+			// a reference, so every render device must be released before the instance, as Vulkan requires anyway.
+			const instance_dispatch_table* functions = nullptr;
+			// Live render devices created from the instance's physical devices, checked by instance::release.
+			std::atomic<rsl::size_type> renderDeviceCount = 0;
 
 			std::vector<physical_device> physicalDevices;
 			application_info applicationInfo;
@@ -248,6 +488,11 @@ namespace vk
 			std::vector<layer_properties> enabledLayers;
 			std::vector<extension_properties> enabledExtensions;
 
+			std::filesystem::path capabilitySnapshotPath;
+			// Set when the selected device didn't match its snapshot entry, the driver is queried until the snapshot
+			// is rewritten.
+			bool capabilitySnapshotStale = false;
+
 			VkInstance instance = VK_NULL_HANDLE;
 			graphics_library graphicsLib;
 		};
@@ -292,11 +537,11 @@ namespace vk
 
 		struct native_physical_device_vk
 		{
-#define INSTANCE_LEVEL_PHYSICAL_DEVICE_VULKAN_FUNCTION(name) [[maybe_unused]] PFN_##name name = nullptr;
-#define INSTANCE_LEVEL_PHYSICAL_DEVICE_VULKAN_FUNCTION_FROM_EXTENSION(name, extension)                                 \
-	[[maybe_unused]] PFN_##name name = nullptr;
-#define INSTANCE_LEVEL_DEVICE_VULKAN_FUNCTION(name) [[maybe_unused]] PFN_##name name = nullptr;
-#include "impl/list_of_vulkan_functions.inl"
+			// Owned by the instance, valid until instance::release.
+			const instance_dispatch_table* functions = nullptr;
+
+			// The instance's device list and every render device created from this device hold a reference.
+			rsl::size_type refCount = 1;
 
 			render_device renderDevice;
 
@@ -304,11 +549,16 @@ namespace vk
 			surface_capabilities surfaceCaps;
 			bool featuresLoaded = false;
 			physical_device_features features;
+			bool descriptorIndexingLoaded = false;
+			descriptor_indexing_capabilities descriptorIndexing;
 			bool propertiesLoaded = false;
 			physical_device_properties properties;
 			std::vector<layer_properties> availableLayers;
 			std::vector<extension_properties> availableExtensions;
+			name_index availableExtensionIndex;
 			std::vector<queue_family_properties> availableQueueFamilies;
+			// The capabilities above came from the instance's capability snapshot instead of the driver.
+			bool fromSnapshot = false;
 
 			rsl::pmu_allocator* alloc = nullptr;
 			VkAllocationCallbacks* allocCallbacks = nullptr;
@@ -331,14 +581,51 @@ namespace vk
 			using handle_type = native_physical_device;
 		};
 
+		struct native_shader_module_vk;
+		struct native_sampler_vk;
+		struct native_descriptor_set_layout_vk;
+		struct native_pipeline_layout_vk;
+		struct native_pipeline_vk;
+		struct native_render_pass_vk;
+
+		// Libraries of the shader parts are compiled against a layout and evicted when it's destroyed, the vertex
+		// input and fragment output parts have no layout.
+		struct cached_pipeline_library
+		{
+			VkPipeline library = VK_NULL_HANDLE;
+			const native_pipeline_layout_vk* layout = nullptr;
+		};
+
+		struct cached_framebuffer
+		{
+			VkFramebuffer framebuffer = VK_NULL_HANDLE;
+			std::vector<VkImageView> imageViews;
+		};
+
+		// An image view and the framebuffers that were evicted with it, destroyed once retireFrame has completed.
+		struct retired_image_view
+		{
+			VkImageView imageView = VK_NULL_HANDLE;
+			std::vector<VkFramebuffer> framebuffers;
+			rsl::uint64 retireFrame = 0;
+		};
+
+		// A fast-linked pipeline waiting for its link time optimized version, holds a reference to the pipeline.
+		struct pending_pipeline_link
+		{
+			pipeline target;
+			// One library per pipeline_library_part.
+			VkPipeline libraries[4] = {};
+		};
+
 		struct native_render_device_vk
 		{
 			bool load_functions(std::span<const rsl::cstring> extensions);
 
-#define INSTANCE_LEVEL_DEVICE_VULKAN_FUNCTION(name) [[maybe_unused]] PFN_##name name = nullptr;
-#define DEVICE_LEVEL_VULKAN_FUNCTION(name) [[maybe_unused]] PFN_##name name = nullptr;
-#define DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(name, extension) [[maybe_unused]] PFN_##name name = nullptr;
-#include "impl/list_of_vulkan_functions.inl"
+			// Owned by the render device.
+			const device_dispatch_table* functions = nullptr;
+			// Owned by the instance, the render device must be released before it.
+			const instance_dispatch_table* instanceFunctions = nullptr;
 
 			physical_device physicalDevice;
 			rsl::pmu_allocator* alloc = nullptr;
@@ -346,6 +633,72 @@ namespace vk
 
 			std::vector<queue> queues;
 
+			// Lower of the instance and physical device API versions, functions from later versions aren't loaded.
+			rsl::uint32 apiVersion = VK_API_VERSION_1_0;
+			// vkCmdBeginRendering and vkCmdEndRendering point to the KHR entry points on pre 1.3 devices.
+			bool dynamicRendering = false;
+			// The vkCmdSet* functions of extended dynamic state 1 and 2 point to the EXT entry points on pre 1.3
+			// devices.
+			dynamic_state_flags dynamicStateSupport = dynamic_state_flags::none;
+			// Graphics pipelines are linked from cached libraries when VK_EXT_graphics_pipeline_library was enabled.
+			bool graphicsPipelineLibrary = false;
+			bool graphicsPipelineLibraryFastLinking = false;
+			// Presents can carry an id and be waited on, VK_KHR_present_id and VK_KHR_present_wait were enabled.
+			bool presentWait = false;
+
+			// The core features enabled at device creation, only what was requested.
+			physical_device_features enabledFeatures;
+			// What was enabled at device creation, all false when VK_EXT_descriptor_indexing wasn't enabled.
+			descriptor_indexing_capabilities descriptorIndexing;
+
+			// Live shader modules keyed on their SPIR-V.
+			std::mutex shaderModuleMutex;
+			cache_map<native_shader_module_vk*> shaderModules;
+
+			// Live samplers keyed on their canonical description.
+			std::mutex samplerMutex;
+			cache_map<native_sampler_vk*> samplers;
+			bool samplerLimitWarned = false;
+
+			// Live descriptor set layouts keyed on their canonical bindings.
+			std::mutex descriptorSetLayoutMutex;
+			cache_map<native_descriptor_set_layout_vk*> descriptorSetLayouts;
+
+			// Bumped whenever a descriptor allocator resets or destroys its pools. Descriptor writers forget what they
+			// last wrote once it changes, the sets they wrote to may have been handed out again since.
+			std::atomic<rsl::uint64> descriptorPoolResetCount = 0;
+
+			// Live pipeline layouts keyed on their canonical description.
+			std::mutex pipelineLayoutMutex;
+			cache_map<native_pipeline_layout_vk*> pipelineLayouts;
+
+			// Live render passes keyed on their description.
+			std::mutex renderPassMutex;
+			cache_map<native_render_pass_vk*> renderPasses;
+
+			// Framebuffers are owned by the device, keyed on render pass compatibility, image views and extent. The
+			// second map lists the framebuffers using each image view so they can be evicted when it's destroyed.
+			// Views retired with a frame number wait in retiredImageViews until that frame has completed.
+			std::mutex framebufferMutex;
+			cache_map<cached_framebuffer> framebuffers;
+			std::unordered_map<VkImageView, std::vector<cache_key>> framebuffersByImageView;
+			std::vector<retired_image_view> retiredImageViews;
+
+			// Live pipelines keyed on the canonical form of their create info.
+			std::mutex pipelineMutex;
+			cache_map<native_pipeline_vk*> pipelines;
+
+			// Graphics pipeline libraries keyed on the state of their part, owned by the device.
+			std::mutex pipelineLibraryMutex;
+			cache_map<cached_pipeline_library> pipelineLibraries;
+
+			// Link time optimization of fast-linked pipelines runs on linkWorker, which is started on first use.
+			std::mutex linkMutex;
+			std::condition_variable linkCondition;
+			std::deque<pending_pipeline_link> pendingLinks;
+			std::thread linkWorker;
+			bool stopLinkWorker = false;
+
 			VkDevice device = VK_NULL_HANDLE;
 		};
 
@@ -510,2220 +863,10089 @@ namespace vk
 			using handle_type = native_command_buffer;
 		};
 
-		template <typename T>
-		[[nodiscard]] [[rythe_always_inline]] typename native_handle_traits<T>::native_type*
-		get_native_ptr(const T& inst)
+		struct native_pipeline_cache_vk
 		{
-			return std::bit_cast<typename native_handle_traits<T>::native_type*>(inst.get_native_handle());
-		}
+			render_device renderDevice;
+			rsl::pmu_allocator* alloc = nullptr;
+			VkAllocationCallbacks* allocCallbacks = nullptr;
 
-		template <typename T>
-		[[nodiscard]] [[rythe_always_inline]] typename native_handle_traits<T>::native_type&
-		get_native_ref(const T& inst)
-		{
-			auto* ptr = get_native_ptr(inst);
-			rsl_assert_invalid_object(ptr);
-			return *ptr;
-		}
+			std::string filePath;
 
-		template <typename T>
-		[[nodiscard]] [[rythe_always_inline]] auto create_native_handle(T* inst)
-		{
-			return std::bit_cast<typename native_handle_traits<T>::handle_type>(inst);
-		}
+			VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+		};
 
-		struct alloc_data
+		template <>
+		struct native_handle_traits<pipeline_cache>
 		{
-			rsl::size_type size;
-			rsl::size_type alignment;
+			using native_type = native_pipeline_cache_vk;
+			using handle_type = native_pipeline_cache;
 		};
 
-		rsl::size_type get_additional_alloc_size(rsl::size_type alignment)
+		template <>
+		struct native_handle_traits<native_pipeline_cache_vk>
 		{
-			if (alignment >= sizeof(alloc_data))
-			{
-				return alignment;
-			}
-
-			return sizeof(alloc_data);
-		}
+			using api_type = pipeline_cache;
+			using handle_type = native_pipeline_cache;
+		};
 
-		void* defaultVKAllocFunc(
-			void* userData, rsl::size_type size, rsl::size_type alignment, VkSystemAllocationScope
-		) noexcept
+		struct native_shader_module_vk
 		{
-			rsl::pmu_allocator* alloc = static_cast<rsl::pmu_allocator*>(userData);
+			render_device renderDevice;
+			rsl::pmu_allocator* alloc = nullptr;
+			VkAllocationCallbacks* allocCallbacks = nullptr;
 
-			const rsl::size_type additionalAllocSize = get_additional_alloc_size(alignment);
-			const rsl::size_type totalSize = size + additionalAllocSize;
-			void* mem;
-			if (alignment == 0)
-			{
-				mem = alloc->allocate(totalSize);
-			}
-			else
-			{
-				mem = alloc->allocate(totalSize, alignment);
-			}
+			// Guarded by native_render_device_vk::shaderModuleMutex. Holds the SPIR-V the module was created from.
+			cache_key key;
+			rsl::size_type refCount = 1;
 
-			alloc_data* allocData = std::bit_cast<alloc_data*>(static_cast<rsl::byte*>(mem) + additionalAllocSize) - 1;
+			shader_reflection reflection;
 
-			allocData->alignment = alignment;
-			allocData->size = totalSize;
+			VkShaderModule shaderModule = VK_NULL_HANDLE;
+		};
 
-			return static_cast<rsl::byte*>(mem) + additionalAllocSize;
-		}
+		template <>
+		struct native_handle_traits<shader_module>
+		{
+			using native_type = native_shader_module_vk;
+			using handle_type = native_shader_module;
+		};
 
-		void defaultVKFreeFunc(void* userData, void* ptr) noexcept
+		template <>
+		struct native_handle_traits<native_shader_module_vk>
 		{
-			if (!ptr)
-			{
-				return;
-			}
+			using api_type = shader_module;
+			using handle_type = native_shader_module;
+		};
 
-			rsl::pmu_allocator* alloc = static_cast<rsl::pmu_allocator*>(userData);
-			alloc_data* allocData = static_cast<alloc_data*>(ptr) - 1;
+		struct shader_pack_header
+		{
+			constexpr static rsl::uint32 expectedMagic = 0x4b565053; // "SPVK"
+			constexpr static rsl::uint32 expectedVersion = 1;
 
-			const rsl::size_type additionalAllocSize = get_additional_alloc_size(allocData->alignment);
-			void* originalPtr = static_cast<void*>(static_cast<rsl::byte*>(ptr) - additionalAllocSize);
+			rsl::uint32 magic;
+			rsl::uint32 version;
+			rsl::uint32 entryCount;
+			rsl::uint32 reserved;
+		};
 
-			if (allocData->alignment == 0)
-			{
-				alloc->deallocate(originalPtr, allocData->size);
-			}
-			else
-			{
-				alloc->deallocate(originalPtr, allocData->size, allocData->alignment);
-			}
-		}
+		struct shader_pack_entry
+		{
+			rsl::uint32 nameOffset;
+			rsl::uint32 nameSize;
+			rsl::uint64 dataOffset;
+			rsl::uint64 dataSize;
+		};
 
-		void* defaultVKReallocationFunc(
-			void* userData, void* ptr, rsl::size_type size, rsl::size_type alignment, VkSystemAllocationScope
-		) noexcept
+		struct native_shader_pack_vk
 		{
-			rsl::pmu_allocator* alloc = static_cast<rsl::pmu_allocator*>(userData);
-			alloc_data* oldAllocData = static_cast<alloc_data*>(ptr) - 1;
+			render_device renderDevice;
+			rsl::pmu_allocator* alloc = nullptr;
+			VkAllocationCallbacks* allocCallbacks = nullptr;
 
-			rsl_assert_msg_consistent(alignment == oldAllocData->alignment, "alignment mismatch");
+			std::string filePath;
 
-			void* originalPtr =
-				static_cast<void*>(static_cast<rsl::byte*>(ptr) - get_additional_alloc_size(oldAllocData->alignment));
+#if RYTHE_PLATFORM_WINDOWS
+			HANDLE file = INVALID_HANDLE_VALUE;
+			HANDLE mapping = nullptr;
+#endif
+			const rsl::byte* mappedData = nullptr;
+			rsl::size_type mappedSize = 0;
 
-			const rsl::size_type additionalAllocSize = get_additional_alloc_size(alignment);
-			const rsl::size_type totalSize = size + additionalAllocSize;
-			void* mem;
-			if (alignment == 0)
-			{
-				mem = alloc->reallocate(originalPtr, oldAllocData->size, totalSize);
-			}
-			else
-			{
-				mem = alloc->reallocate(originalPtr, oldAllocData->size, totalSize, alignment);
-			}
+			std::span<const shader_pack_entry> entries;
+			std::unordered_map<std::string_view, rsl::size_type> entryIndices;
+		};
 
-			alloc_data* newAllocData =
-				std::bit_cast<alloc_data*>(static_cast<rsl::byte*>(mem) + additionalAllocSize) - 1;
-			newAllocData->alignment = alignment;
-			newAllocData->size = totalSize;
+		template <>
+		struct native_handle_traits<shader_pack>
+		{
+			using native_type = native_shader_pack_vk;
+			using handle_type = native_shader_pack;
+		};
 
-			return static_cast<rsl::byte*>(mem) + additionalAllocSize;
-		}
+		template <>
+		struct native_handle_traits<native_shader_pack_vk>
+		{
+			using api_type = shader_pack;
+			using handle_type = native_shader_pack;
+		};
 
-		VkAllocationCallbacks createVKAllocator(rsl::pmu_allocator& alloc) noexcept
+		struct native_descriptor_set_layout_vk
 		{
-			return VkAllocationCallbacks{
-				.pUserData = &alloc,
-				.pfnAllocation = &defaultVKAllocFunc,
-				.pfnReallocation = &defaultVKReallocationFunc,
-				.pfnFree = &defaultVKFreeFunc,
-				.pfnInternalAllocation = nullptr,
-				.pfnInternalFree = nullptr,
-			};
-		}
-	} // namespace
+			render_device renderDevice;
+			rsl::pmu_allocator* alloc = nullptr;
+			VkAllocationCallbacks* allocCallbacks = nullptr;
 
-	[[nodiscard]] graphics_library init(rsl::pmu_allocator& alloc)
-	{
-		native_graphics_library_vk* nativeGL = allocate<native_graphics_library_vk>(alloc);
+			// Guarded by native_render_device_vk::descriptorSetLayoutMutex. Canonical form of the bindings.
+			cache_key key;
+			rsl::size_type refCount = 1;
 
-		nativeGL->alloc = &alloc;
-		nativeGL->allocCallbacks = createVKAllocator(*nativeGL->alloc);
-		nativeGL->vulkanLibrary = rsl::platform::load_library(native_graphics_library_vk::vulkanLibName);
+			descriptor_set_layout_description description;
 
-		if (!nativeGL->vulkanLibrary)
+			VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+		};
+
+		template <>
+		struct native_handle_traits<descriptor_set_layout>
 		{
-			std::cout << "could not load " << native_graphics_library_vk::vulkanLibName.get() << '\n';
-			deallocate<native_graphics_library_vk>(alloc, nativeGL);
-			return {};
-		}
+			using native_type = native_descriptor_set_layout_vk;
+			using handle_type = native_descriptor_set_layout;
+		};
 
-#define EXPORTED_VULKAN_FUNCTION(name)                                                                                 \
-	nativeGL->name = nativeGL->vulkanLibrary.get_symbol<PFN_##name>(#name);                                            \
-	if (!nativeGL->name)                                                                                               \
-	{                                                                                                                  \
-		std::cout << "Could not load exported Vulkan function \"" #name "\"\n";                                        \
-		deallocate<native_graphics_library_vk>(alloc, nativeGL);                                                       \
-		return {};                                                                                                     \
-	}
+		template <>
+		struct native_handle_traits<native_descriptor_set_layout_vk>
+		{
+			using api_type = descriptor_set_layout;
+			using handle_type = native_descriptor_set_layout;
+		};
 
-#define GLOBAL_LEVEL_VULKAN_FUNCTION(name)                                                                             \
-	nativeGL->name = std::bit_cast<PFN_##name>(nativeGL->vkGetInstanceProcAddr(nullptr, #name));                       \
-	if (!nativeGL->name)                                                                                               \
-	{                                                                                                                  \
-		std::cout << "Could not load global-level Vulkan function \"" #name "\"\n";                                    \
-		deallocate<native_graphics_library_vk>(alloc, nativeGL);                                                       \
-		return {};                                                                                                     \
-	}
+		struct native_pipeline_layout_vk
+		{
+			render_device renderDevice;
+			rsl::pmu_allocator* alloc = nullptr;
+			VkAllocationCallbacks* allocCallbacks = nullptr;
 
-#include "impl/list_of_vulkan_functions.inl"
+			// Guarded by native_render_device_vk::pipelineLayoutMutex. Canonical form of the layout's description.
+			cache_key key;
+			rsl::size_type refCount = 1;
 
-		graphics_library result;
-		set_native_handle(result, create_native_handle(nativeGL));
+			std::vector<descriptor_set_layout> descriptorSetLayouts;
 
-		return result;
-	}
+			VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+		};
 
-	graphics_library::operator bool() const noexcept
-	{
-		return get_native_ptr(*this);
-	}
+		template <>
+		struct native_handle_traits<pipeline_layout>
+		{
+			using native_type = native_pipeline_layout_vk;
+			using handle_type = native_pipeline_layout;
+		};
 
-	void graphics_library::release()
-	{
-		auto* impl = get_native_ptr(*this);
-		if (!impl)
+		template <>
+		struct native_handle_traits<native_pipeline_layout_vk>
 		{
-			return;
-		}
+			using api_type = pipeline_layout;
+			using handle_type = native_pipeline_layout;
+		};
 
-		impl->vulkanLibrary.release();
+		struct native_descriptor_allocator_vk
+		{
+			render_device renderDevice;
+			rsl::pmu_allocator* alloc = nullptr;
+			VkAllocationCallbacks* allocCallbacks = nullptr;
 
-		m_nativeGL = invalid_native_graphics_library;
-		deallocate<native_graphics_library_vk>(*impl->alloc, impl);
-	}
+			descriptor_allocator_description description;
+			rsl::uint32 nextPoolSetCount = 0;
+			rsl::size_type allocatedSetCount = 0;
 
-	namespace
-	{
-		[[rythe_always_inline]] constexpr rsl::size_type
-		get_layer_index(std::span<const layer_properties> layers, rsl::hashed_string_view layerName) noexcept
+			VkDescriptorPool currentPool = VK_NULL_HANDLE;
+			std::vector<VkDescriptorPool> fullPools;
+			std::vector<VkDescriptorPool> readyPools;
+		};
+
+		template <>
+		struct native_handle_traits<descriptor_allocator>
 		{
-			for (rsl::size_type i = 0; i < layers.size(); i++)
-			{
-				if (layers[i].name == layerName)
-				{
-					return i;
-				}
-			}
-			return rsl::npos;
-		}
+			using native_type = native_descriptor_allocator_vk;
+			using handle_type = native_descriptor_allocator;
+		};
 
-		[[rythe_always_inline]] constexpr rsl::size_type get_extension_index(
-			std::span<const extension_properties> extensions, rsl::hashed_string_view extensionName
-		) noexcept
+		template <>
+		struct native_handle_traits<native_descriptor_allocator_vk>
 		{
-			for (rsl::size_type i = 0; i < extensions.size(); i++)
-			{
-				if (extensions[i].name == extensionName)
-				{
-					return i;
-				}
-			}
-			return rsl::npos;
-		}
-	} // namespace
+			using api_type = descriptor_allocator;
+			using handle_type = native_descriptor_allocator;
+		};
 
-	std::span<const layer_properties> graphics_library::get_available_instance_layers(bool forceRefresh)
-	{
-		auto& impl = get_native_ref(*this);
+		struct native_sampler_vk
+		{
+			render_device renderDevice;
+			rsl::pmu_allocator* alloc = nullptr;
+			VkAllocationCallbacks* allocCallbacks = nullptr;
 
-		if (forceRefresh || impl.availableInstanceLayers.empty())
+			// Guarded by native_render_device_vk::samplerMutex. Canonical form of the description.
+			cache_key key;
+			rsl::size_type refCount = 1;
+
+			sampler_description description;
+
+			VkSampler sampler = VK_NULL_HANDLE;
+		};
+
+		template <>
+		struct native_handle_traits<sampler>
 		{
-			rsl::uint32 layerCount = 0;
-			VkResult result = impl.vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
-			if (result != VK_SUCCESS || layerCount == 0)
-			{
-				std::cout << "Could not query the number of instance layers.\n";
-				return {};
-			}
+			using native_type = native_sampler_vk;
+			using handle_type = native_sampler;
+		};
 
-			std::vector<VkLayerProperties> availableInstanceLayersBuffer;
-			availableInstanceLayersBuffer.resize(layerCount);
-			result = impl.vkEnumerateInstanceLayerProperties(&layerCount, availableInstanceLayersBuffer.data());
-			if (result != VK_SUCCESS || layerCount == 0)
-			{
-				std::cout << "Could not enumerate instance layers.\n";
-				return {};
-			}
+		template <>
+		struct native_handle_traits<native_sampler_vk>
+		{
+			using api_type = sampler;
+			using handle_type = native_sampler;
+		};
 
-			impl.availableInstanceLayers.clear();
-			impl.availableInstanceLayers.reserve(layerCount);
-			for (auto& layer : availableInstanceLayersBuffer)
+		struct native_bindless_table_vk
+		{
+			render_device renderDevice;
+			rsl::pmu_allocator* alloc = nullptr;
+			VkAllocationCallbacks* allocCallbacks = nullptr;
+
+			struct binding_slots
 			{
-				impl.availableInstanceLayers.push_back({
-					.name = rsl::hashed_string(layer.layerName),
-					.specVersion = decomposeVkVersion(layer.specVersion),
-					.implementationVersion = decomposeVkVersion(layer.implementationVersion),
-					.description = std::string(layer.description),
-				});
-			}
-		}
+				rsl::uint32 capacity = 0;
+				// Slots from highWaterMark up have never been handed out, freed slots are reused before those.
+				rsl::uint32 highWaterMark = 0;
+				std::vector<rsl::uint32> freeSlots;
+				// One bit per slot, set while the slot is handed out. Catches double frees.
+				std::vector<bool> allocatedSlots;
+				bool updateAfterBind = false;
+			};
 
-		return impl.availableInstanceLayers;
-	}
+			// Guards the slots and writes to descriptorSet.
+			std::mutex mutex;
+			binding_slots bindings[4];
 
-	bool graphics_library::is_instance_layer_available(rsl::hashed_string_view layerName)
-	{
-		return get_layer_index(get_available_instance_layers(), layerName) != rsl::npos;
-	}
+			descriptor_set_layout layout;
+			VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		};
 
-	std::span<const extension_properties> graphics_library::get_available_instance_extensions(bool forceRefresh)
-	{
-		auto& impl = get_native_ref(*this);
+		template <>
+		struct native_handle_traits<bindless_table>
+		{
+			using native_type = native_bindless_table_vk;
+			using handle_type = native_bindless_table;
+		};
 
-		if (forceRefresh || impl.availableInstanceExtensions.empty())
+		template <>
+		struct native_handle_traits<native_bindless_table_vk>
 		{
-			rsl::uint32 extensionCount = 0;
-			VkResult result = impl.vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
-			if (result != VK_SUCCESS || extensionCount == 0)
+			using api_type = bindless_table;
+			using handle_type = native_bindless_table;
+		};
+
+		// The last write of a descriptor, only the info matching the type is used. Compared field by field, so a
+		// rewrite is only skipped when it is exactly the same.
+		struct written_descriptor
+		{
+			VkDescriptorType type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+			VkDescriptorBufferInfo bufferInfo{};
+			VkDescriptorImageInfo imageInfo{};
+
+			void assign(VkDescriptorType descriptorType, const VkDescriptorBufferInfo& info) noexcept
 			{
-				std::cout << "Could not query the number of instance extensions.\n";
-				return {};
+				type = descriptorType;
+				bufferInfo = info;
 			}
 
-			std::vector<VkExtensionProperties> availableInstanceExtensionsBuffer;
-			availableInstanceExtensionsBuffer.resize(extensionCount);
-			result = impl.vkEnumerateInstanceExtensionProperties(
-				nullptr, &extensionCount, availableInstanceExtensionsBuffer.data()
-			);
-			if (result != VK_SUCCESS || extensionCount == 0)
+			void assign(VkDescriptorType descriptorType, const VkDescriptorImageInfo& info) noexcept
 			{
-				std::cout << "Could not enumerate instance extensions.\n";
-				return {};
+				type = descriptorType;
+				imageInfo = info;
 			}
 
-			impl.availableInstanceExtensions.clear();
-			impl.availableInstanceExtensions.reserve(extensionCount);
-			for (auto& extension : availableInstanceExtensionsBuffer)
+			[[nodiscard]] bool
+			matches(VkDescriptorType descriptorType, const VkDescriptorBufferInfo& info) const noexcept
 			{
-				impl.availableInstanceExtensions.push_back({
-					.name = rsl::hashed_string(extension.extensionName),
-					.specVersion = decomposeVkVersion(extension.specVersion),
-				});
+				return type == descriptorType && bufferInfo.buffer == info.buffer && bufferInfo.offset == info.offset &&
+					   bufferInfo.range == info.range;
 			}
-		}
 
-		return impl.availableInstanceExtensions;
-	}
+			[[nodiscard]] bool
+			matches(VkDescriptorType descriptorType, const VkDescriptorImageInfo& info) const noexcept
+			{
+				return type == descriptorType && imageInfo.sampler == info.sampler &&
+					   imageInfo.imageView == info.imageView && imageInfo.imageLayout == info.imageLayout;
+			}
+		};
 
-	bool graphics_library::is_instance_extension_available(rsl::hashed_string_view extensionName)
-	{
-		return get_extension_index(get_available_instance_extensions(), extensionName) != rsl::npos;
-	}
+		struct native_descriptor_writer_vk
+		{
+			render_device renderDevice;
+			rsl::pmu_allocator* alloc = nullptr;
+			VkAllocationCallbacks* allocCallbacks = nullptr;
 
-	[[nodiscard]] instance graphics_library::create_instance(
-		const application_info& _applicationInfo, const semver::version& apiVersion,
-		std::span<const rsl::hashed_string> layers, std::span<const rsl::hashed_string> extensions
-	)
-	{
-		using namespace rsl::hashed_string_literals;
+			// Frame local arena, cleared on flush but never shrunk. pBufferInfo/pImageInfo are patched in on flush
+			// since the info arrays may still reallocate before then, infoIndices holds the index until then.
+			std::vector<VkWriteDescriptorSet> writes;
+			std::vector<rsl::size_type> infoIndices;
+			std::vector<VkDescriptorBufferInfo> bufferInfos;
+			std::vector<VkDescriptorImageInfo> imageInfos;
 
-		std::vector<layer_properties> enabledLayerProperties;
-		std::vector<rsl::cstring> enabledLayers;
-		enabledLayerProperties.reserve(layers.size());
-		enabledLayers.reserve(layers.size());
+			// Pending write index per set and descriptor, so repeated writes before a flush replace each other.
+			std::unordered_map<VkDescriptorSet, std::unordered_map<rsl::uint64, rsl::size_type>> pendingWrites;
 
-#ifdef RYTHE_DEBUG
-		bool khrValidationLayerActive = false;
-#endif // RYTHE_DEBUG
+			// Last write per set and descriptor. Cleared when the device's descriptor pool reset count moves past
+			// observedPoolResetCount.
+			std::unordered_map<VkDescriptorSet, std::unordered_map<rsl::uint64, written_descriptor>> writtenContents;
+			rsl::uint64 observedPoolResetCount = 0;
 
-		auto availableLayers = get_available_instance_layers();
-		for (auto& layerName : layers)
+			rsl::size_type droppedCount = 0;
+		};
+
+		template <>
+		struct native_handle_traits<descriptor_writer>
 		{
-			rsl::size_type layerIndex = get_layer_index(availableLayers, layerName);
-			if (layerIndex == rsl::npos)
-			{
-				std::cout << "Layer \"" << layerName.c_str() << "\" is not available.\n";
-			}
-			else
-			{
-#ifdef RYTHE_DEBUG
-				if (layerName == "VK_LAYER_KHRONOS_validation"_hsv)
-				{
-					khrValidationLayerActive = true;
-				}
-#endif // RYTHE_DEBUG
+			using native_type = native_descriptor_writer_vk;
+			using handle_type = native_descriptor_writer;
+		};
 
-				enabledLayerProperties.push_back(availableLayers[layerIndex]);
-				enabledLayers.push_back(layerName.c_str());
-			}
-		}
-
-#ifdef RYTHE_DEBUG
-		if (!khrValidationLayerActive)
+		template <>
+		struct native_handle_traits<native_descriptor_writer_vk>
 		{
-			rsl::size_type validationLayerIndex = get_layer_index(availableLayers, "VK_LAYER_KHRONOS_validation"_hsv);
-			if (validationLayerIndex != rsl::npos)
-			{
-				enabledLayerProperties.push_back(availableLayers[validationLayerIndex]);
-				enabledLayers.push_back("VK_LAYER_KHRONOS_validation");
-			}
-		}
-#endif // RYTHE_DEBUG
+			using api_type = descriptor_writer;
+			using handle_type = native_descriptor_writer;
+		};
 
-		std::vector<extension_properties> enabledExtensionProperties;
-		std::vector<rsl::cstring> enabledExtensions;
-		enabledExtensionProperties.reserve(extensions.size());
-		enabledExtensions.reserve(extensions.size());
+		struct native_render_pass_vk
+		{
+			render_device renderDevice;
+			rsl::pmu_allocator* alloc = nullptr;
+			VkAllocationCallbacks* allocCallbacks = nullptr;
 
-		bool surfaceExtensionActive = false;
-		bool platformSurfaceExtensionActive = false;
-#ifdef RYTHE_DEBUG
-		bool debugUtilsExtensionActive = false;
-#endif // RYTHE_DEBUG
+			// Guarded by native_render_device_vk::renderPassMutex.
+			cache_key key;
+			rsl::size_type refCount = 1;
 
-		auto availableExtensions = get_available_instance_extensions();
-		for (auto& extensionName : extensions)
-		{
-			rsl::size_type extensionIndex = get_extension_index(availableExtensions, extensionName);
-			if (extensionIndex == rsl::npos)
-			{
-				std::cout << "Extension \"" << extensionName.c_str() << "\" is not available.\n";
-			}
-			else
-			{
-				if (extensionName == MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_SURFACE_EXTENSION_NAME))
-				{
-					surfaceExtensionActive = true;
-				}
-				else if (extensionName == MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_PLATFORM_SURFACE_EXTENSION_NAME))
-				{
-					platformSurfaceExtensionActive = true;
-				}
-#ifdef RYTHE_DEBUG
-				else if (extensionName == MAKE_HASHED_STRING_VIEW_LITERAL(VK_EXT_DEBUG_UTILS_EXTENSION_NAME))
-				{
-					debugUtilsExtensionActive = true;
-				}
-#endif // RYTHE_DEBUG
+			render_pass_description description;
 
-				enabledExtensionProperties.push_back(availableExtensions[extensionIndex]);
-				enabledExtensions.push_back(extensionName.c_str());
-			}
-		}
+			VkRenderPass renderPass = VK_NULL_HANDLE;
+		};
 
-#ifdef RYTHE_DEBUG
-		if (!debugUtilsExtensionActive)
+		template <>
+		struct native_handle_traits<render_pass>
 		{
-			enabledExtensionProperties.push_back(availableExtensions[get_extension_index(
-				availableExtensions, MAKE_HASHED_STRING_VIEW_LITERAL(VK_EXT_DEBUG_UTILS_EXTENSION_NAME)
-			)]);
-			enabledExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-		}
-#endif // RYTHE_DEBUG
+			using native_type = native_render_pass_vk;
+			using handle_type = native_render_pass;
+		};
 
-		if (_applicationInfo.windowHandle != invalid_native_window_handle)
+		template <>
+		struct native_handle_traits<native_render_pass_vk>
 		{
-			if (!surfaceExtensionActive)
-			{
-				enabledExtensionProperties.push_back(availableExtensions[get_extension_index(
-					availableExtensions, MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_SURFACE_EXTENSION_NAME)
-				)]);
-				enabledExtensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
-			}
+			using api_type = render_pass;
+			using handle_type = native_render_pass;
+		};
 
-			if (!platformSurfaceExtensionActive)
-			{
-				enabledExtensionProperties.push_back(availableExtensions[get_extension_index(
-					availableExtensions, MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_PLATFORM_SURFACE_EXTENSION_NAME)
-				)]);
-				enabledExtensions.push_back(VK_KHR_PLATFORM_SURFACE_EXTENSION_NAME);
-			}
-		}
-		else
+		struct native_pipeline_vk
 		{
-			if (surfaceExtensionActive)
-			{
-				std::cout << "Surface extension is activated, but no window handle was provided.\n";
-				return {};
-			}
-
-			if (platformSurfaceExtensionActive)
-			{
-				std::cout << "Platform specific surface extension is activated, but no window handle was provided.\n";
-				return {};
-			}
-		}
+			render_device renderDevice;
+			rsl::pmu_allocator* alloc = nullptr;
+			VkAllocationCallbacks* allocCallbacks = nullptr;
 
-		const VkApplicationInfo applicationInfo{
-			.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
-			.pNext = nullptr,
-			.pApplicationName = _applicationInfo.name.c_str(),
-			.applicationVersion = VK_MAKE_API_VERSION(
-				0, _applicationInfo.version.major, _applicationInfo.version.minor, _applicationInfo.version.patch
-			),
-			.pEngineName = "Rythe Engine",
-			.engineVersion = VK_MAKE_API_VERSION(0, 0, 0, 1),
-			.apiVersion = VK_MAKE_API_VERSION(0, apiVersion.major, apiVersion.minor, apiVersion.patch),
+			pipeline_bind_point bindPoint = pipeline_bind_point::graphics;
+			// Holds a reference, the link worker still links against the layout and its libraries are only evicted
+			// once no pipeline uses it anymore.
+			pipeline_layout layout;
+			VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+			dynamic_state_flags dynamicState = dynamic_state_flags::none;
+
+			// Guarded by native_render_device_vk::pipelineMutex.
+			cache_key key;
+			rsl::size_type refCount = 1;
+
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			// Set by the link worker once the link time optimized version of a fast-linked pipeline is ready, bound
+			// instead of pipeline from then on. Both stay alive until the pipeline is destroyed.
+			std::atomic<VkPipeline> optimizedPipeline = VK_NULL_HANDLE;
+			std::atomic_bool linkPending = false;
 		};
 
-		const VkInstanceCreateInfo instanceCreateInfo{
-			.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
-			.pNext = nullptr,
-			.flags = 0,
-			.pApplicationInfo = &applicationInfo,
-			.enabledLayerCount = static_cast<rsl::uint32>(enabledLayers.size()),
-			.ppEnabledLayerNames = enabledLayers.data(),
-			.enabledExtensionCount = static_cast<rsl::uint32>(enabledExtensions.size()),
-			.ppEnabledExtensionNames = enabledExtensions.data(),
+		template <>
+		struct native_handle_traits<pipeline>
+		{
+			using native_type = native_pipeline_vk;
+			using handle_type = native_pipeline;
 		};
 
-		auto& impl = get_native_ref(*this);
-
-		VkInstance vkInstance = VK_NULL_HANDLE;
-		VkResult result = impl.vkCreateInstance(&instanceCreateInfo, &impl.allocCallbacks, &vkInstance);
-
-		if (result != VK_SUCCESS || vkInstance == VK_NULL_HANDLE)
+		template <>
+		struct native_handle_traits<native_pipeline_vk>
 		{
-			std::cout << "Failed to create Vulkan Instance\n";
-			return {};
-		}
-
-		native_instance_vk* nativeInstance = allocate<native_instance_vk>(*impl.alloc);
-		nativeInstance->alloc = impl.alloc;
-		nativeInstance->allocCallbacks = &impl.allocCallbacks;
-		nativeInstance->instance = vkInstance;
-		nativeInstance->graphicsLib = *this;
+			using api_type = pipeline;
+			using handle_type = native_pipeline;
+		};
 
-		if (!nativeInstance->load_functions(enabledExtensions))
+		struct native_pipeline_batch_vk
 		{
-			if (nativeInstance->vkDestroyInstance)
-			{
-				nativeInstance->vkDestroyInstance(nativeInstance->instance, &impl.allocCallbacks);
-			}
+			render_device renderDevice;
+			rsl::pmu_allocator* alloc = nullptr;
+			VkAllocationCallbacks* allocCallbacks = nullptr;
 
-			deallocate<native_instance_vk>(*impl.alloc, nativeInstance);
-			return {};
-		}
+			pipeline_cache targetCache;
 
-		nativeInstance->applicationInfo = _applicationInfo;
-		nativeInstance->apiVersion = apiVersion;
-		nativeInstance->enabledLayers = std::move(enabledLayerProperties);
-		nativeInstance->enabledExtensions = std::move(enabledExtensionProperties);
+			std::vector<graphics_pipeline_description> graphicsDescriptions;
+			std::vector<compute_pipeline_description> computeDescriptions;
+			std::vector<std::promise<pipeline>> graphicsPromises;
+			std::vector<std::promise<pipeline>> computePromises;
+			std::vector<std::shared_future<pipeline>> graphicsPipelines;
+			std::vector<std::shared_future<pipeline>> computePipelines;
 
-		vk::instance instance;
-		set_native_handle(instance, create_native_handle(nativeInstance));
+			std::vector<VkPipelineCache> workerCaches;
+			std::vector<std::thread> workers;
 
-		return instance;
-	}
+			std::atomic<rsl::size_type> nextIndex = 0;
+			std::atomic<rsl::size_type> completedCount = 0;
+			std::atomic<rsl::size_type> activeWorkerCount = 0;
+			std::atomic_bool done = false;
+		};
 
-	std::string_view to_string(physical_device_type type)
-	{
-		switch (type)
+		template <>
+		struct native_handle_traits<pipeline_batch>
 		{
-			case physical_device_type::other: return "other";
-			case physical_device_type::integratedGPU: return "integrated GPU";
-			case physical_device_type::discreteGPU: return "discrete GPU";
-			case physical_device_type::virtualGPU: return "virtual GPU";
-			case physical_device_type::CPU: return "CPU";
-		}
-
-		return "unknown";
-	}
+			using native_type = native_pipeline_batch_vk;
+			using handle_type = native_pipeline_batch;
+		};
 
-	std::string_view to_string(queue_priority priority)
-	{
-		switch (priority)
+		template <>
+		struct native_handle_traits<native_pipeline_batch_vk>
 		{
-			case queue_priority::normal: return "normal";
-			case queue_priority::high: return "high";
-		}
-
-		return "unknown";
-	}
-
-	instance::operator bool() const noexcept
-	{
-		auto ptr = get_native_ptr(*this);
-		return ptr != nullptr && ptr->instance != VK_NULL_HANDLE;
-	}
+			using api_type = pipeline_batch;
+			using handle_type = native_pipeline_batch;
+		};
 
-	void instance::release()
-	{
-		auto impl = get_native_ptr(*this);
-		if (!impl)
+		// A swapchain replaced by swapchain::recreate. Once acquire_next_image has waited on the fence of frame
+		// retireFrame every frame submitted before the replacement has finished and the images can be destroyed.
+		struct retired_swapchain
 		{
-			return;
-		}
+			VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+			std::vector<image_view_handle> imageViews;
+			std::vector<VkSemaphore> renderFinishedSemaphores;
+			rsl::uint64 retireFrame = 0;
+		};
 
-		release_physical_devices();
+		struct native_swapchain_vk
+		{
+			render_device renderDevice;
+			rsl::pmu_allocator* alloc = nullptr;
+			VkAllocationCallbacks* allocCallbacks = nullptr;
 
-		impl->vkDestroyInstance(impl->instance, impl->allocCallbacks);
+			surface targetSurface;
+			swapchain_description description;
+
+			// What was actually picked for the current VkSwapchainKHR.
+			present_mode presentMode = present_mode::fifo;
+			format imageFormat = format::undefined;
+			rsl::math::uint2 extent = {0, 0};
+
+			VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+			std::vector<VkImage> images;
+			std::vector<image_view_handle> imageViews;
+			// Per image, an image isn't acquired again before its previous present finished waiting on it.
+			std::vector<VkSemaphore> renderFinishedSemaphores;
+
+			// Per frame in flight.
+			std::vector<VkSemaphore> acquireSemaphores;
+			std::vector<VkFence> frameFences;
+			rsl::size_type frameIndex = 0;
+			rsl::uint32 imageIndex = 0;
+			// Number of frames submitted by present so far, frame n uses frame slot n % framesInFlight.
+			rsl::uint64 frameCounter = 0;
+			// Set from a successful acquire until present, the slot's acquire semaphore is signaled meanwhile.
+			bool imageAcquired = false;
+			// Queues of the last present, release waits for the present queue before destroying what it still uses.
+			VkQueue lastSubmitQueue = VK_NULL_HANDLE;
+			VkQueue lastPresentQueue = VK_NULL_HANDLE;
+
+			std::vector<retired_swapchain> retiredSwapchains;
+
+			// Reused by every present so submitting doesn't allocate.
+			std::vector<VkCommandBuffer> submitCommandBuffers;
+
+			// Timestamps of the frame being recorded, frameStarted is set by begin_frame or acquire_next_image.
+			frame_timing currentTiming;
+			bool frameStarted = false;
+			// Present ids and present waits are used when the device enabled them.
+			bool presentWait = false;
+			// Presented frames whose presentComplete hasn't been observed yet, oldest first.
+			std::deque<frame_timing> pendingPresents;
+			frame_timing lastTiming;
+			frame_latency latency;
+		};
 
-		m_nativeInstance = invalid_native_instance;
-		deallocate<native_instance_vk>(*impl->alloc, impl);
-	}
+		template <>
+		struct native_handle_traits<swapchain>
+		{
+			using native_type = native_swapchain_vk;
+			using handle_type = native_swapchain;
+		};
 
-	std::span<physical_device> instance::create_physical_devices(bool forceRefresh)
-	{
-		auto& impl = get_native_ref(*this);
+		template <>
+		struct native_handle_traits<native_swapchain_vk>
+		{
+			using api_type = swapchain;
+			using handle_type = native_swapchain;
+		};
 
-		if (forceRefresh || impl.physicalDevices.empty())
+		struct native_headless_target_vk
 		{
-			rsl::uint32 deviceCount = 0;
-			VkResult result = impl.vkEnumeratePhysicalDevices(impl.instance, &deviceCount, nullptr);
-			if (result != VK_SUCCESS || deviceCount == 0)
-			{
-				std::cout << "Could not query the number of physical devices.\n";
-				return {};
-			}
+			render_device renderDevice;
+			rsl::pmu_allocator* alloc = nullptr;
+			VkAllocationCallbacks* allocCallbacks = nullptr;
 
-			std::vector<VkPhysicalDevice> physicalDevicesBuffer;
-			physicalDevicesBuffer.resize(deviceCount);
-			result = impl.vkEnumeratePhysicalDevices(impl.instance, &deviceCount, physicalDevicesBuffer.data());
+			headless_target_description description;
 
-			if (result != VK_SUCCESS || deviceCount == 0)
-			{
-				std::cout << "Could not enumerate physical devices.\n";
-				return {};
-			}
+			// One dedicated allocation per image, the ring is small and created once.
+			std::vector<VkImage> images;
+			std::vector<VkDeviceMemory> imageMemory;
+			std::vector<image_view_handle> imageViews;
 
-			release_physical_devices();
-			impl.physicalDevices.reserve(deviceCount);
-			for (auto& pd : physicalDevicesBuffer)
-			{
-				auto& physicalDevice = impl.physicalDevices.emplace_back();
-				native_physical_device_vk* nativePhysicalDevice = allocate<native_physical_device_vk>(*impl.alloc);
-				set_native_handle(physicalDevice, create_native_handle(nativePhysicalDevice));
+			// Per frame in flight.
+			std::vector<VkFence> frameFences;
+			rsl::size_type frameIndex = 0;
+			rsl::uint32 imageIndex = 0;
+			// Number of frames submitted by present so far.
+			rsl::uint64 frameCounter = 0;
 
-				nativePhysicalDevice->alloc = impl.alloc;
-				nativePhysicalDevice->allocCallbacks = impl.allocCallbacks;
-				nativePhysicalDevice->physicalDevice = pd;
-				nativePhysicalDevice->instance = *this;
+			// Reused by every present so submitting doesn't allocate.
+			std::vector<VkCommandBuffer> submitCommandBuffers;
 
-#define INSTANCE_LEVEL_PHYSICAL_DEVICE_VULKAN_FUNCTION(name) nativePhysicalDevice->name = impl.name;
-#define INSTANCE_LEVEL_PHYSICAL_DEVICE_VULKAN_FUNCTION_FROM_EXTENSION(name, extension)                                 \
-	nativePhysicalDevice->name = impl.name;
-#define INSTANCE_LEVEL_DEVICE_VULKAN_FUNCTION(name) nativePhysicalDevice->name = impl.name;
-#include "impl/list_of_vulkan_functions.inl"
-			}
-		}
+			frame_timing currentTiming;
+			bool frameStarted = false;
+			frame_timing lastTiming;
+			frame_latency latency;
+		};
 
-		return impl.physicalDevices;
-	}
+		template <>
+		struct native_handle_traits<headless_target>
+		{
+			using native_type = native_headless_target_vk;
+			using handle_type = native_headless_target;
+		};
 
-	void instance::release_physical_devices()
-	{
-		auto* impl = get_native_ptr(*this);
+		template <>
+		struct native_handle_traits<native_headless_target_vk>
+		{
+			using api_type = headless_target;
+			using handle_type = native_headless_target;
+		};
 
-		if (!impl)
+		struct native_buffer_vk
 		{
-			return;
-		}
+			render_device renderDevice;
+			rsl::pmu_allocator* alloc = nullptr;
+			VkAllocationCallbacks* allocCallbacks = nullptr;
 
-		for (auto& device : impl->physicalDevices) { device.release(); }
+			buffer_description description;
 
-		impl->physicalDevices.clear();
-	}
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+		};
 
-	const application_info& instance::get_application_info() const noexcept
-	{
-		return get_native_ref(*this).applicationInfo;
-	}
+		template <>
+		struct native_handle_traits<buffer>
+		{
+			using native_type = native_buffer_vk;
+			using handle_type = native_buffer;
+		};
 
-	const semver::version& instance::get_api_version() const noexcept
-	{
-		return get_native_ref(*this).apiVersion;
-	}
+		template <>
+		struct native_handle_traits<native_buffer_vk>
+		{
+			using api_type = buffer;
+			using handle_type = native_buffer;
+		};
 
-	namespace
-	{
-		[[nodiscard]] physical_device copy_physical_device(rsl::pmu_allocator& alloc, physical_device src)
+		template <typename T>
+		[[nodiscard]] [[rythe_always_inline]] typename native_handle_traits<T>::native_type*
+		get_native_ptr(const T& inst)
 		{
-			physical_device copy;
-			set_native_handle(
-				copy, create_native_handle(allocate<native_physical_device_vk>(alloc, 1, get_native_ref(src)))
-			);
+			return std::bit_cast<typename native_handle_traits<T>::native_type*>(inst.get_native_handle());
+		}
 
-			return copy;
+		template <typename T>
+		[[nodiscard]] [[rythe_always_inline]] typename native_handle_traits<T>::native_type&
+		get_native_ref(const T& inst)
+		{
+			auto* ptr = get_native_ptr(inst);
+			rsl_assert_invalid_object(ptr);
+			return *ptr;
 		}
 
-		[[nodiscard]] render_device create_render_device_no_extension_check(
-			physical_device& physicalDevice, std::span<const queue_description> queueDesciptions,
-			std::span<const rsl::cstring> extensions, std::span<const rsl::cstring> layers
-		)
+		template <typename T>
+		[[nodiscard]] [[rythe_always_inline]] auto create_native_handle(T* inst)
 		{
-			auto& impl = get_native_ref(physicalDevice);
+			return std::bit_cast<typename native_handle_traits<T>::handle_type>(inst);
+		}
 
-			std::vector<queue_family_selection> queueFamilySelections;
-			queueFamilySelections.resize(queueDesciptions.size());
+		struct alloc_data
+		{
+			rsl::size_type size;
+			rsl::size_type alignment;
+		};
 
-			if (!physicalDevice.get_queue_family_selection(queueFamilySelections, queueDesciptions))
+		rsl::size_type get_additional_alloc_size(rsl::size_type alignment)
+		{
+			if (alignment >= sizeof(alloc_data))
 			{
-				return {};
+				return alignment;
 			}
 
-			auto queueFamilies = physicalDevice.get_available_queue_families();
-
-			struct queue_mapping
-			{
-				std::vector<rsl::size_type> inputOrderIndex;
-				std::vector<rsl::float32> priorities;
-			};
+			return sizeof(alloc_data);
+		}
 
-			std::vector<queue_mapping> queueMapping;
-			queueMapping.resize(queueFamilies.size());
+		void* defaultVKAllocFunc(
+			void* userData, rsl::size_type size, rsl::size_type alignment, VkSystemAllocationScope
+		) noexcept
+		{
+			rsl::pmu_allocator* alloc = static_cast<rsl::pmu_allocator*>(userData);
 
-			for (rsl::size_type i = 0; i < queueDesciptions.size(); i++)
+			const rsl::size_type additionalAllocSize = get_additional_alloc_size(alignment);
+			const rsl::size_type totalSize = size + additionalAllocSize;
+			void* mem;
+			if (alignment == 0)
 			{
-				auto familyIndex = queueFamilySelections[i].familyIndex;
-
-				queueMapping[familyIndex].inputOrderIndex.push_back(i);
-				queueMapping[familyIndex].priorities.push_back(
-					queueDesciptions[i].priority == queue_priority::normal ? 0.5f : 1.f
-				);
+				mem = alloc->allocate(totalSize);
 			}
-
-			std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-			queueCreateInfos.reserve(queueDesciptions.size());
-			for (rsl::size_type i = 0; i < queueMapping.size(); i++)
+			else
 			{
-				auto& priorities = queueMapping[i].priorities;
-
-				if (!priorities.empty())
-				{
-					queueCreateInfos.push_back(VkDeviceQueueCreateInfo{
-						.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-						.pNext = nullptr,
-						.flags = 0,
-						.queueFamilyIndex = static_cast<rsl::uint32>(i),
-						.queueCount = static_cast<rsl::uint32>(priorities.size()),
-						.pQueuePriorities = priorities.data(),
-					});
-				}
+				mem = alloc->allocate(totalSize, alignment);
 			}
 
-			VkPhysicalDeviceFeatures features;
-			impl.vkGetPhysicalDeviceFeatures(impl.physicalDevice, &features);
+			alloc_data* allocData = std::bit_cast<alloc_data*>(static_cast<rsl::byte*>(mem) + additionalAllocSize) - 1;
 
-			const VkDeviceCreateInfo deviceCreateInfo{
-				.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-				.pNext = nullptr,
-				.flags = 0,
-				.queueCreateInfoCount = static_cast<rsl::uint32>(queueCreateInfos.size()),
-				.pQueueCreateInfos = queueCreateInfos.data(),
-				.enabledLayerCount = static_cast<rsl::uint32>(layers.size()),
-				.ppEnabledLayerNames = layers.data(),
-				.enabledExtensionCount = static_cast<rsl::uint32>(extensions.size()),
-				.ppEnabledExtensionNames = extensions.data(),
-				.pEnabledFeatures = &features,
-			};
+			allocData->alignment = alignment;
+			allocData->size = totalSize;
 
-			VkDevice device = VK_NULL_HANDLE;
+			return static_cast<rsl::byte*>(mem) + additionalAllocSize;
+		}
 
+		void defaultVKFreeFunc(void* userData, void* ptr) noexcept
+		{
+			if (!ptr)
 			{
-				VkResult result =
-					impl.vkCreateDevice(impl.physicalDevice, &deviceCreateInfo, impl.allocCallbacks, &device);
-
-				if (result != VK_SUCCESS || device == VK_NULL_HANDLE)
-				{
-					return {};
-				}
+				return;
 			}
 
-			auto* renderDevicePtr = allocate<native_render_device_vk>(*impl.alloc);
-			renderDevicePtr->alloc = impl.alloc;
-			renderDevicePtr->allocCallbacks = impl.allocCallbacks;
-			renderDevicePtr->device = device;
+			rsl::pmu_allocator* alloc = static_cast<rsl::pmu_allocator*>(userData);
+			alloc_data* allocData = static_cast<alloc_data*>(ptr) - 1;
 
-#define INSTANCE_LEVEL_DEVICE_VULKAN_FUNCTION(name) renderDevicePtr->name = impl.name;
-#include "impl/list_of_vulkan_functions.inl"
+			const rsl::size_type additionalAllocSize = get_additional_alloc_size(allocData->alignment);
+			void* originalPtr = static_cast<void*>(static_cast<rsl::byte*>(ptr) - additionalAllocSize);
 
-			if (!renderDevicePtr->load_functions(extensions))
+			if (allocData->alignment == 0)
 			{
-				if (renderDevicePtr->vkDestroyDevice)
-				{
-					renderDevicePtr->vkDestroyDevice(renderDevicePtr->device, impl.allocCallbacks);
-				}
-
-				deallocate<native_render_device_vk>(*impl.alloc, renderDevicePtr);
-				return {};
+				alloc->deallocate(originalPtr, allocData->size);
 			}
-
-			renderDevicePtr->physicalDevice = copy_physical_device(*impl.alloc, physicalDevice);
-			set_native_handle(impl.renderDevice, create_native_handle(renderDevicePtr));
-
-			renderDevicePtr->queues.resize(queueDesciptions.size());
-			for (rsl::size_type i = 0; i < queueCreateInfos.size(); i++)
+			else
 			{
-				auto& info = queueCreateInfos[i];
-				auto& mapping = queueMapping[info.queueFamilyIndex];
-
-				for (rsl::size_type queueIndex = 0; queueIndex < info.queueCount; queueIndex++)
-				{
-					VkQueue vkQueue = VK_NULL_HANDLE;
-					renderDevicePtr->vkGetDeviceQueue(
-						renderDevicePtr->device, info.queueFamilyIndex, static_cast<rsl::uint32>(queueIndex), &vkQueue
-					);
-					auto inputIndex = mapping.inputOrderIndex[queueIndex];
+				alloc->deallocate(originalPtr, allocData->size, allocData->alignment);
+			}
+		}
 
-					if (vkQueue == VK_NULL_HANDLE)
-					{
-						std::cout << "Failed to create queue " << inputIndex << '\n';
-						continue;
-					}
+		void* defaultVKReallocationFunc(
+			void* userData, void* ptr, rsl::size_type size, rsl::size_type alignment, VkSystemAllocationScope
+		) noexcept
+		{
+			rsl::pmu_allocator* alloc = static_cast<rsl::pmu_allocator*>(userData);
+			alloc_data* oldAllocData = static_cast<alloc_data*>(ptr) - 1;
 
-					auto& queue = renderDevicePtr->queues[inputIndex];
+			rsl_assert_msg_consistent(alignment == oldAllocData->alignment, "alignment mismatch");
 
-					native_queue_vk* nativeQueue = allocate<native_queue_vk>(*impl.alloc);
-					nativeQueue->alloc = impl.alloc;
-					nativeQueue->allocCallbacks = impl.allocCallbacks;
-					nativeQueue->queue = vkQueue;
-					nativeQueue->renderDevice = impl.renderDevice;
-					nativeQueue->queueIndex = inputIndex;
-					nativeQueue->familyIndex = info.queueFamilyIndex;
-					nativeQueue->family = queueFamilies[info.queueFamilyIndex];
-					nativeQueue->priority = queueDesciptions[inputIndex].priority;
+			void* originalPtr =
+				static_cast<void*>(static_cast<rsl::byte*>(ptr) - get_additional_alloc_size(oldAllocData->alignment));
 
-					set_native_handle(queue, create_native_handle(nativeQueue));
-				}
+			const rsl::size_type additionalAllocSize = get_additional_alloc_size(alignment);
+			const rsl::size_type totalSize = size + additionalAllocSize;
+			void* mem;
+			if (alignment == 0)
+			{
+				mem = alloc->reallocate(originalPtr, oldAllocData->size, totalSize);
+			}
+			else
+			{
+				mem = alloc->reallocate(originalPtr, oldAllocData->size, totalSize, alignment);
 			}
 
-			return impl.renderDevice;
-		}
-	} // namespace
+			alloc_data* newAllocData =
+				std::bit_cast<alloc_data*>(static_cast<rsl::byte*>(mem) + additionalAllocSize) - 1;
+			newAllocData->alignment = alignment;
+			newAllocData->size = totalSize;
 
-	[[nodiscard]] surface instance::create_surface()
-	{
-		auto& impl = get_native_ref(*this);
+			return static_cast<rsl::byte*>(mem) + additionalAllocSize;
+		}
 
-		if (impl.applicationInfo.windowHandle == invalid_native_window_handle)
+		VkAllocationCallbacks createVKAllocator(rsl::pmu_allocator& alloc) noexcept
 		{
-			return {};
+			return VkAllocationCallbacks{
+				.pUserData = &alloc,
+				.pfnAllocation = &defaultVKAllocFunc,
+				.pfnReallocation = &defaultVKReallocationFunc,
+				.pfnFree = &defaultVKFreeFunc,
+				.pfnInternalAllocation = nullptr,
+				.pfnInternalFree = nullptr,
+			};
 		}
+	} // namespace
 
-		VkSurfaceKHR vkSurface = VK_NULL_HANDLE;
-
-#if RYTHE_PLATFORM_WINDOWS
-		VkWin32SurfaceCreateInfoKHR surfaceCreateInfo = {
-			.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR,
-			.pNext = nullptr,
-			.flags = 0,
-			.hinstance = get_hinstance(impl.applicationInfo.windowHandle),
-			.hwnd = get_hwnd(impl.applicationInfo.windowHandle),
-		};
+	[[nodiscard]] graphics_library init(rsl::pmu_allocator& alloc)
+	{
+		native_graphics_library_vk* nativeGL = allocate<native_graphics_library_vk>(alloc);
 
-		if (impl.vkCreateWin32SurfaceKHR(impl.instance, &surfaceCreateInfo, impl.allocCallbacks, &vkSurface) !=
-			VK_SUCCESS)
-		{
-			return {};
-		}
-#elif RYTHE_PLATFORM_LINUX
-	#ifdef RYTHE_SURFACE_XCB
-		VkXcbSurfaceCreateInfoKHR surfaceCreateInfo = {
-			.sType = VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR,
-			.pNext = nullptr,
-			.flags = 0,
-			.connection = get_connection(impl.applicationInfo.windowHandle),
-			.window = get_window(impl.applicationInfo.windowHandle),
-		};
+		nativeGL->alloc = &alloc;
+		nativeGL->allocCallbacks = createVKAllocator(*nativeGL->alloc);
+		nativeGL->vulkanLibrary = rsl::platform::load_library(native_graphics_library_vk::vulkanLibName);
 
-		if (impl.vkCreateXcbSurfaceKHR(impl.instance, &surfaceCreateInfo, impl.allocCallbacks, &vkSurface) !=
-			VK_SUCCESS)
+		if (!nativeGL->vulkanLibrary)
 		{
+			std::cout << "could not load " << native_graphics_library_vk::vulkanLibName.get() << '\n';
+			deallocate<native_graphics_library_vk>(alloc, nativeGL);
 			return {};
 		}
 
-	#elif RYTHE_SURFACE_XLIB
-		VkXlibSurfaceCreateInfoKHR surfaceCreateInfo = {
-			.sType = VK_STRUCTURE_TYPE_XLIB_SURFACE_CREATE_INFO_KHR,
-			.pNext = nullptr,
-			.flags = 0,
-			.dpy = get_display(impl.applicationInfo.windowHandle),
-			.window = get_window(impl.applicationInfo.windowHandle),
-		};
+#define EXPORTED_VULKAN_FUNCTION(name)                                                                                 \
+	nativeGL->name = nativeGL->vulkanLibrary.get_symbol<PFN_##name>(#name);                                            \
+	if (!nativeGL->name)                                                                                               \
+	{                                                                                                                  \
+		std::cout << "Could not load exported Vulkan function \"" #name "\"\n";                                        \
+		deallocate<native_graphics_library_vk>(alloc, nativeGL);                                                       \
+		return {};                                                                                                     \
+	}
 
-		if (impl.vkCreateXlibSurfaceKHR(impl.instance, &surfaceCreateInfo, impl.allocCallbacks, &vkSurface) !=
-			VK_SUCCESS)
-		{
-			return {};
-		}
-	#endif
-#endif
+#define GLOBAL_LEVEL_VULKAN_FUNCTION(name)                                                                             \
+	nativeGL->name = std::bit_cast<PFN_##name>(nativeGL->vkGetInstanceProcAddr(nullptr, #name));                       \
+	if (!nativeGL->name)                                                                                               \
+	{                                                                                                                  \
+		std::cout << "Could not load global-level Vulkan function \"" #name "\"\n";                                    \
+		deallocate<native_graphics_library_vk>(alloc, nativeGL);                                                       \
+		return {};                                                                                                     \
+	}
 
-		native_surface_vk* nativeSurface = allocate<native_surface_vk>(*impl.alloc);
-		nativeSurface->surface = vkSurface;
-		nativeSurface->alloc = impl.alloc;
-		nativeSurface->allocCallbacks = impl.allocCallbacks;
-		nativeSurface->instance = *this;
+#include "impl/list_of_vulkan_functions.inl"
 
-		surface result;
-		set_native_handle(result, create_native_handle(nativeSurface));
+		graphics_library result;
+		set_native_handle(result, create_native_handle(nativeGL));
 
 		return result;
 	}
 
-	[[nodiscard]] render_device instance::auto_select_and_create_device(
-		const physical_device_description& physicalDeviceDescription,
-		std::span<const queue_description> queueDesciptions, surface surface,
-		std::span<const rsl::hashed_string> extensions
-	)
+	graphics_library::operator bool() const noexcept
 	{
-		using namespace rsl::hashed_string_literals;
-		using namespace semver::literals;
-		const bool supportsProtectedMemory = get_api_version() >= "1.1.0"_version;
+		return get_native_ptr(*this);
+	}
 
-		for (rsl::size_type i = 0; i < queueDesciptions.size(); i++)
+	void graphics_library::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
 		{
-			if (!supportsProtectedMemory &&
-				rsl::enum_flags::has_flag(queueDesciptions[i].requiredFeatures, queue_feature_flags::protectedMemory))
-			{
-				std::cout << "Protected memory operations are not supported for Vulkan versions prior to 1.1.0\n";
-				return {};
-			}
+			return;
 		}
 
-		bool presentingApplication = get_application_info().windowHandle != invalid_native_window_handle;
-
-		std::vector<rsl::cstring> enabledExtensions;
-		std::vector<rsl::id_type> enabledExtensionHashes;
-		enabledExtensions.reserve(extensions.size() + (presentingApplication ? 1 : 0));
-		enabledExtensionHashes.reserve(enabledExtensions.size());
-
-		bool swapchainExtensionPresent = false;
-
-		constexpr auto swapchainExtensionName = MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
-
-		for (auto& extensionName : extensions)
-		{
-			enabledExtensions.push_back(extensionName.c_str());
-			enabledExtensionHashes.push_back(extensionName.value);
+		impl->vulkanLibrary.release();
 
-			if (presentingApplication && extensionName == swapchainExtensionName)
-			{
-				swapchainExtensionPresent = true;
-			}
-		}
+		m_nativeGL = invalid_native_graphics_library;
+		deallocate<native_graphics_library_vk>(*impl->alloc, impl);
+	}
 
-		if (presentingApplication && !swapchainExtensionPresent)
+	namespace
+	{
+		template <typename Properties>
+		void build_name_index(name_index& index, std::span<const Properties> properties)
 		{
-			enabledExtensions.push_back(swapchainExtensionName.data());
-			enabledExtensionHashes.push_back(swapchainExtensionName.value);
+			index.clear();
+			index.reserve(properties.size());
+			for (rsl::size_type i = 0; i < properties.size(); i++) { index.emplace(properties[i].name.value, i); }
 		}
 
-		if (!presentingApplication && swapchainExtensionPresent)
+		[[nodiscard]] rsl::size_type find_name(const name_index& index, rsl::hashed_string_view name)
 		{
-			std::cout << "Swapchain extension is activated, but no window handle was provided.\n";
-			return {};
+			auto it = index.find(name.value);
+			return it == index.end() ? rsl::npos : it->second;
 		}
 
-		auto physicalDevices = create_physical_devices();
-
-		rsl::size_type selectedDevice = rsl::npos;
-		rsl::size_type currentScore = 0;
-
-		rsl::size_type deviceIndex = 0;
-		for (auto& device : physicalDevices)
+		[[nodiscard]] bool contains_all_names(const name_index& index, std::span<const rsl::hashed_string_view> names)
 		{
-			auto& props = device.get_properties();
-
-			if (props.apiVersion < physicalDeviceDescription.apiVersion)
+			for (auto& name : names)
 			{
-				continue;
+				if (!index.contains(name.value))
+				{
+					return false;
+				}
 			}
 
-			if (props.limits.maxPerStageDescriptorSampledImages <
-				physicalDeviceDescription.requiredPerStageSampledImages)
-			{
-				continue;
-			}
+			return true;
+		}
+	} // namespace
 
-			auto& features = device.get_features();
+	std::span<const layer_properties> graphics_library::get_available_instance_layers(bool forceRefresh)
+	{
+		auto& impl = get_native_ref(*this);
 
-#define CHECK_FEATURE(feature)                                                                                         \
-	if (physicalDeviceDescription.requiredFeatures.feature && !features.feature)                                       \
-	{                                                                                                                  \
-		continue;                                                                                                      \
-	}
-
-			CHECK_FEATURE(robustBufferAccess);
-			CHECK_FEATURE(fullDrawIndexUint32);
-			CHECK_FEATURE(imageCubeArray);
-			CHECK_FEATURE(independentBlend);
-			CHECK_FEATURE(geometryShader);
-			CHECK_FEATURE(tessellationShader);
-			CHECK_FEATURE(sampleRateShading);
-			CHECK_FEATURE(dualSrcBlend);
-			CHECK_FEATURE(logicOp);
-			CHECK_FEATURE(multiDrawIndirect);
-			CHECK_FEATURE(drawIndirectFirstInstance);
-			CHECK_FEATURE(depthClamp);
-			CHECK_FEATURE(depthBiasClamp);
-			CHECK_FEATURE(fillModeNonSolid);
-			CHECK_FEATURE(depthBounds);
-			CHECK_FEATURE(wideLines);
-			CHECK_FEATURE(largePoints);
-			CHECK_FEATURE(alphaToOne);
-			CHECK_FEATURE(multiViewport);
-			CHECK_FEATURE(samplerAnisotropy);
-			CHECK_FEATURE(textureCompressionETC2);
-			CHECK_FEATURE(textureCompressionASTC_LDR);
-			CHECK_FEATURE(textureCompressionBC);
-			CHECK_FEATURE(occlusionQueryPrecise);
-			CHECK_FEATURE(pipelineStatisticsQuery);
-			CHECK_FEATURE(vertexPipelineStoresAndAtomics);
-			CHECK_FEATURE(fragmentStoresAndAtomics);
-			CHECK_FEATURE(shaderTessellationAndGeometryPointSize);
-			CHECK_FEATURE(shaderImageGatherExtended);
-			CHECK_FEATURE(shaderStorageImageExtendedFormats);
-			CHECK_FEATURE(shaderStorageImageMultisample);
-			CHECK_FEATURE(shaderStorageImageReadWithoutFormat);
-			CHECK_FEATURE(shaderStorageImageWriteWithoutFormat);
-			CHECK_FEATURE(shaderUniformBufferArrayDynamicIndexing);
-			CHECK_FEATURE(shaderSampledImageArrayDynamicIndexing);
-			CHECK_FEATURE(shaderStorageBufferArrayDynamicIndexing);
-			CHECK_FEATURE(shaderStorageImageArrayDynamicIndexing);
-			CHECK_FEATURE(shaderClipDistance);
-			CHECK_FEATURE(shaderCullDistance);
-			CHECK_FEATURE(shaderFloat64);
-			CHECK_FEATURE(shaderInt64);
-			CHECK_FEATURE(shaderInt16);
-			CHECK_FEATURE(shaderResourceResidency);
-			CHECK_FEATURE(shaderResourceMinLod);
-			CHECK_FEATURE(sparseBinding);
-			CHECK_FEATURE(sparseResidencyBuffer);
-			CHECK_FEATURE(sparseResidencyImage2D);
-			CHECK_FEATURE(sparseResidencyImage3D);
-			CHECK_FEATURE(sparseResidency2Samples);
-			CHECK_FEATURE(sparseResidency4Samples);
-			CHECK_FEATURE(sparseResidency8Samples);
-			CHECK_FEATURE(sparseResidency16Samples);
-			CHECK_FEATURE(sparseResidencyAliased);
-			CHECK_FEATURE(variableMultisampleRate);
-			CHECK_FEATURE(inheritedQueries);
-
-#undef CHECK_FEATURE
-
-			for (rsl::size_type i = 0; i < enabledExtensions.size(); i++)
-			{
-				rsl::hashed_string_view hashStrView;
-				hashStrView.str = enabledExtensions[i];
-				hashStrView.value = enabledExtensionHashes[i];
-
-				if (!device.is_extension_available(hashStrView))
-				{
-					continue;
-				}
+		if (forceRefresh || impl.availableInstanceLayers.empty())
+		{
+			rsl::uint32 layerCount = 0;
+			VkResult result = impl.vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+			if (result != VK_SUCCESS || layerCount == 0)
+			{
+				std::cout << "Could not query the number of instance layers.\n";
+				return {};
 			}
 
-			std::vector<queue_family_selection> queueFamilySelections;
-			queueFamilySelections.resize(queueDesciptions.size());
-			if (!device.get_queue_family_selection(queueFamilySelections, queueDesciptions, surface))
+			std::vector<VkLayerProperties> availableInstanceLayersBuffer;
+			availableInstanceLayersBuffer.resize(layerCount);
+			result = impl.vkEnumerateInstanceLayerProperties(&layerCount, availableInstanceLayersBuffer.data());
+			if (result != VK_SUCCESS || layerCount == 0)
 			{
-				continue;
+				std::cout << "Could not enumerate instance layers.\n";
+				return {};
 			}
 
-			rsl::size_type deviceScore = 1;
-
-			deviceScore +=
-				physicalDeviceDescription.deviceTypeImportance[static_cast<rsl::size_type>(props.deviceType)];
-
-			deviceScore += props.limits.maxImageDimension2D;
-
-			if (deviceScore > currentScore)
+			impl.availableInstanceLayers.clear();
+			impl.availableInstanceLayers.reserve(layerCount);
+			for (auto& layer : availableInstanceLayersBuffer)
 			{
-				selectedDevice = deviceIndex;
-				currentScore = deviceScore;
+				impl.availableInstanceLayers.push_back({
+					.name = rsl::hashed_string(layer.layerName),
+					.specVersion = decomposeVkVersion(layer.specVersion),
+					.implementationVersion = decomposeVkVersion(layer.implementationVersion),
+					.description = std::string(layer.description),
+				});
 			}
 
-			deviceIndex++;
-		}
-
-		if (selectedDevice >= physicalDevices.size())
-		{
-			return {};
+			build_name_index<layer_properties>(impl.availableInstanceLayerIndex, impl.availableInstanceLayers);
 		}
 
-		auto& impl = get_native_ref(*this);
-		std::vector<rsl::cstring> enabledLayers;
-		enabledLayers.reserve(impl.enabledLayers.size());
-		for (auto& layer : impl.enabledLayers) { enabledLayers.push_back(layer.name.c_str()); }
-
-		auto result = create_render_device_no_extension_check(
-			physicalDevices[selectedDevice], queueDesciptions, enabledExtensions, enabledLayers
-		);
-
-		release_physical_devices();
-
-		return result;
+		return impl.availableInstanceLayers;
 	}
 
-	bool native_instance_vk::load_functions(std::span<const rsl::cstring> extensions)
+	bool graphics_library::is_instance_layer_available(rsl::hashed_string_view layerName)
 	{
-		auto& lib = get_native_ref(graphicsLib);
-
-#define INSTANCE_LEVEL_VULKAN_FUNCTION(name)                                                                           \
-	name = std::bit_cast<PFN_##name>(lib.vkGetInstanceProcAddr(instance, #name));                                      \
-	if (!name)                                                                                                         \
-	{                                                                                                                  \
-		std::cout << "Could not load instance-level Vulkan function \"" #name "\"\n";                                  \
-		return false;                                                                                                  \
+		get_available_instance_layers();
+		return get_native_ref(*this).availableInstanceLayerIndex.contains(layerName.value);
 	}
 
-#define INSTANCE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(name, extension)                                                 \
-	for (auto& enabledExtension : extensions)                                                                          \
-	{                                                                                                                  \
-		if (std::string_view(enabledExtension) == std::string_view(extension))                                         \
-		{                                                                                                              \
-			name = std::bit_cast<PFN_##name>(lib.vkGetInstanceProcAddr(instance, #name));                              \
-			if (!name)                                                                                                 \
-			{                                                                                                          \
-				std::cout << "Could not load instance-level Vulkan function \"" #name "\"\n";                          \
-				return false;                                                                                          \
-			}                                                                                                          \
-			break;                                                                                                     \
-		}                                                                                                              \
+	bool graphics_library::are_instance_layers_available(std::span<const rsl::hashed_string_view> layerNames)
+	{
+		get_available_instance_layers();
+		return contains_all_names(get_native_ref(*this).availableInstanceLayerIndex, layerNames);
 	}
 
-#define INSTANCE_LEVEL_PHYSICAL_DEVICE_VULKAN_FUNCTION(name)                                                           \
-	name = std::bit_cast<PFN_##name>(lib.vkGetInstanceProcAddr(instance, #name));                                      \
-	if (!name)                                                                                                         \
-	{                                                                                                                  \
-		std::cout << "Could not load instance-level Vulkan function \"" #name "\"\n";                                  \
-		return false;                                                                                                  \
-	}
+	std::span<const extension_properties> graphics_library::get_available_instance_extensions(bool forceRefresh)
+	{
+		auto& impl = get_native_ref(*this);
 
-#define INSTANCE_LEVEL_PHYSICAL_DEVICE_VULKAN_FUNCTION_FROM_EXTENSION(name, extension)                                 \
-	for (auto& enabledExtension : extensions)                                                                          \
-	{                                                                                                                  \
-		if (std::string_view(enabledExtension) == std::string_view(extension))                                         \
-		{                                                                                                              \
-			name = std::bit_cast<PFN_##name>(lib.vkGetInstanceProcAddr(instance, #name));                              \
-			if (!name)                                                                                                 \
-			{                                                                                                          \
-				std::cout << "Could not load instance-level Vulkan function \"" #name "\"\n";                          \
-				return false;                                                                                          \
-			}                                                                                                          \
-			break;                                                                                                     \
-		}                                                                                                              \
-	}
+		if (forceRefresh || impl.availableInstanceExtensions.empty())
+		{
+			rsl::uint32 extensionCount = 0;
+			VkResult result = impl.vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+			if (result != VK_SUCCESS || extensionCount == 0)
+			{
+				std::cout << "Could not query the number of instance extensions.\n";
+				return {};
+			}
 
-#define INSTANCE_LEVEL_DEVICE_VULKAN_FUNCTION(name)                                                                    \
-	name = std::bit_cast<PFN_##name>(lib.vkGetInstanceProcAddr(instance, #name));                                      \
-	if (!name)                                                                                                         \
-	{                                                                                                                  \
-		std::cout << "Could not load instance-level Vulkan function \"" #name "\"\n";                                  \
-		return false;                                                                                                  \
-	}
+			std::vector<VkExtensionProperties> availableInstanceExtensionsBuffer;
+			availableInstanceExtensionsBuffer.resize(extensionCount);
+			result = impl.vkEnumerateInstanceExtensionProperties(
+				nullptr, &extensionCount, availableInstanceExtensionsBuffer.data()
+			);
+			if (result != VK_SUCCESS || extensionCount == 0)
+			{
+				std::cout << "Could not enumerate instance extensions.\n";
+				return {};
+			}
 
-#include "impl/list_of_vulkan_functions.inl"
+			impl.availableInstanceExtensions.clear();
+			impl.availableInstanceExtensions.reserve(extensionCount);
+			for (auto& extension : availableInstanceExtensionsBuffer)
+			{
+				impl.availableInstanceExtensions.push_back({
+					.name = rsl::hashed_string(extension.extensionName),
+					.specVersion = decomposeVkVersion(extension.specVersion),
+				});
+			}
 
-		return true;
-	}
+			build_name_index<extension_properties>(
+				impl.availableInstanceExtensionIndex, impl.availableInstanceExtensions
+			);
+		}
 
-	surface::operator bool() const noexcept
-	{
-		auto ptr = get_native_ptr(*this);
-		return ptr != nullptr && ptr->surface != VK_NULL_HANDLE;
+		return impl.availableInstanceExtensions;
 	}
 
-	void surface::release()
+	bool graphics_library::is_instance_extension_available(rsl::hashed_string_view extensionName)
 	{
-		auto impl = get_native_ptr(*this);
-		if (!impl)
-		{
-			return;
-		}
-
-		auto nativeInstance = get_native_ptr(impl->instance);
-		nativeInstance->vkDestroySurfaceKHR(nativeInstance->instance, impl->surface, impl->allocCallbacks);
-
-		m_nativeSurface = invalid_native_surface;
-		deallocate<native_surface_vk>(*impl->alloc, impl);
+		get_available_instance_extensions();
+		return get_native_ref(*this).availableInstanceExtensionIndex.contains(extensionName.value);
 	}
 
-	physical_device::operator bool() const noexcept
+	bool graphics_library::are_instance_extensions_available(std::span<const rsl::hashed_string_view> extensionNames)
 	{
-		auto ptr = get_native_ptr(*this);
-		return ptr != nullptr && ptr->physicalDevice != VK_NULL_HANDLE;
+		get_available_instance_extensions();
+		return contains_all_names(get_native_ref(*this).availableInstanceExtensionIndex, extensionNames);
 	}
 
-	void physical_device::release()
+	[[nodiscard]] instance graphics_library::create_instance(
+		const application_info& _applicationInfo, const semver::version& apiVersion,
+		std::span<const rsl::hashed_string> layers, std::span<const rsl::hashed_string> extensions
+	)
 	{
-		auto* impl = get_native_ptr(*this);
+		using namespace rsl::hashed_string_literals;
 
-		if (!impl)
-		{
-			return;
-		}
+		std::vector<layer_properties> enabledLayerProperties;
+		std::vector<rsl::cstring> enabledLayers;
+		enabledLayerProperties.reserve(layers.size());
+		enabledLayers.reserve(layers.size());
 
-		m_nativePhysicalDevice = invalid_native_physical_device;
-		deallocate<native_physical_device_vk>(*impl->alloc, impl);
-	}
+#ifdef RYTHE_DEBUG
+		bool khrValidationLayerActive = false;
+#endif // RYTHE_DEBUG
 
-	namespace
-	{
-		surface_transform_flags map_vk_surface_transform_flags(VkSurfaceTransformFlagBitsKHR flags)
+		auto availableLayers = get_available_instance_layers();
+		const name_index& availableLayerIndex = get_native_ref(*this).availableInstanceLayerIndex;
+		for (auto& layerName : layers)
 		{
-			surface_transform_flags result = rsl::enum_flags::make_zero<surface_transform_flags>();
+			rsl::size_type layerIndex = find_name(availableLayerIndex, layerName);
+			if (layerIndex == rsl::npos)
+			{
+				std::cout << "Layer \"" << layerName.c_str() << "\" is not available.\n";
+			}
+			else
+			{
+#ifdef RYTHE_DEBUG
+				if (layerName == "VK_LAYER_KHRONOS_validation"_hsv)
+				{
+					khrValidationLayerActive = true;
+				}
+#endif // RYTHE_DEBUG
 
-			result = rsl::enum_flags::set_flag(
-				result, surface_transform_flags::identity,
-				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, surface_transform_flags::rotate90,
-				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_ROTATE_90_BIT_KHR)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, surface_transform_flags::rotate180,
-				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_ROTATE_180_BIT_KHR)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, surface_transform_flags::rotate270,
-				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_ROTATE_270_BIT_KHR)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, surface_transform_flags::horizontalMirror,
-				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_HORIZONTAL_MIRROR_BIT_KHR)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, surface_transform_flags::horizontalMirrorRotate90,
-				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_HORIZONTAL_MIRROR_ROTATE_90_BIT_KHR)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, surface_transform_flags::horizontalMirrorRotate180,
-				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_HORIZONTAL_MIRROR_ROTATE_180_BIT_KHR)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, surface_transform_flags::horizontalMirrorRotate270,
-				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_HORIZONTAL_MIRROR_ROTATE_270_BIT_KHR)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, surface_transform_flags::inherit,
-				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_INHERIT_BIT_KHR)
-			);
+				enabledLayerProperties.push_back(availableLayers[layerIndex]);
+				enabledLayers.push_back(layerName.c_str());
+			}
+		}
 
-			return result;
+#ifdef RYTHE_DEBUG
+		if (!khrValidationLayerActive)
+		{
+			rsl::size_type validationLayerIndex = find_name(availableLayerIndex, "VK_LAYER_KHRONOS_validation"_hsv);
+			if (validationLayerIndex != rsl::npos)
+			{
+				enabledLayerProperties.push_back(availableLayers[validationLayerIndex]);
+				enabledLayers.push_back("VK_LAYER_KHRONOS_validation");
+			}
 		}
+#endif // RYTHE_DEBUG
 
-		composite_alpha_flags map_vk_composite_alpha_flags(VkCompositeAlphaFlagBitsKHR flags)
+		std::vector<extension_properties> enabledExtensionProperties;
+		std::vector<rsl::cstring> enabledExtensions;
+		enabledExtensionProperties.reserve(extensions.size());
+		enabledExtensions.reserve(extensions.size());
+
+		bool surfaceExtensionActive = false;
+		bool platformSurfaceExtensionActive = false;
+		bool properties2ExtensionActive = false;
+#ifdef RYTHE_DEBUG
+		bool debugUtilsExtensionActive = false;
+#endif // RYTHE_DEBUG
+
+		auto availableExtensions = get_available_instance_extensions();
+		const name_index& availableExtensionIndex = get_native_ref(*this).availableInstanceExtensionIndex;
+		for (auto& extensionName : extensions)
 		{
-			composite_alpha_flags result = rsl::enum_flags::make_zero<composite_alpha_flags>();
+			rsl::size_type extensionIndex = find_name(availableExtensionIndex, extensionName);
+			if (extensionIndex == rsl::npos)
+			{
+				std::cout << "Extension \"" << extensionName.c_str() << "\" is not available.\n";
+			}
+			else
+			{
+				if (extensionName == MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_SURFACE_EXTENSION_NAME))
+				{
+					surfaceExtensionActive = true;
+				}
+				else if (extensionName == MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_PLATFORM_SURFACE_EXTENSION_NAME))
+				{
+					platformSurfaceExtensionActive = true;
+				}
+				else if (extensionName ==
+						 MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+				{
+					properties2ExtensionActive = true;
+				}
+#ifdef RYTHE_DEBUG
+				else if (extensionName == MAKE_HASHED_STRING_VIEW_LITERAL(VK_EXT_DEBUG_UTILS_EXTENSION_NAME))
+				{
+					debugUtilsExtensionActive = true;
+				}
+#endif // RYTHE_DEBUG
 
-			result = rsl::enum_flags::set_flag(
-				result, composite_alpha_flags::opaque,
-				rsl::enum_flags::has_flag(flags, VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, composite_alpha_flags::preMultiplied,
-				rsl::enum_flags::has_flag(flags, VK_COMPOSITE_ALPHA_PRE_MULTIPLIED_BIT_KHR)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, composite_alpha_flags::postMultiplied,
-				rsl::enum_flags::has_flag(flags, VK_COMPOSITE_ALPHA_POST_MULTIPLIED_BIT_KHR)
+				enabledExtensionProperties.push_back(availableExtensions[extensionIndex]);
+				enabledExtensions.push_back(extensionName.c_str());
+			}
+		}
+
+#ifdef RYTHE_DEBUG
+		if (!debugUtilsExtensionActive)
+		{
+			enabledExtensionProperties.push_back(availableExtensions[find_name(
+				availableExtensionIndex, MAKE_HASHED_STRING_VIEW_LITERAL(VK_EXT_DEBUG_UTILS_EXTENSION_NAME)
+			)]);
+			enabledExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+		}
+#endif // RYTHE_DEBUG
+
+		// Needed to query and enable extension features such as descriptor indexing, only enabled when available.
+		if (!properties2ExtensionActive)
+		{
+			rsl::size_type extensionIndex = find_name(
+				availableExtensionIndex,
+				MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)
 			);
-			result = rsl::enum_flags::set_flag(
-				result, composite_alpha_flags::inherit,
-				rsl::enum_flags::has_flag(flags, VK_COMPOSITE_ALPHA_INHERIT_BIT_KHR)
+			if (extensionIndex != rsl::npos)
+			{
+				enabledExtensionProperties.push_back(availableExtensions[extensionIndex]);
+				enabledExtensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+			}
+		}
+
+		if (_applicationInfo.windowHandle != invalid_native_window_handle)
+		{
+			if (!surfaceExtensionActive)
+			{
+				enabledExtensionProperties.push_back(availableExtensions[find_name(
+					availableExtensionIndex, MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_SURFACE_EXTENSION_NAME)
+				)]);
+				enabledExtensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+			}
+
+			if (!platformSurfaceExtensionActive)
+			{
+				enabledExtensionProperties.push_back(availableExtensions[find_name(
+					availableExtensionIndex, MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_PLATFORM_SURFACE_EXTENSION_NAME)
+				)]);
+				enabledExtensions.push_back(VK_KHR_PLATFORM_SURFACE_EXTENSION_NAME);
+			}
+		}
+		else
+		{
+			if (surfaceExtensionActive)
+			{
+				std::cout << "Surface extension is activated, but no window handle was provided.\n";
+				return {};
+			}
+
+			if (platformSurfaceExtensionActive)
+			{
+				std::cout << "Platform specific surface extension is activated, but no window handle was provided.\n";
+				return {};
+			}
+		}
+
+		auto& impl = get_native_ref(*this);
+
+		// 1.0 loaders don't have vkEnumerateInstanceVersion and fail instance creation for anything above 1.0.
+		semver::version instanceVersion = apiVersion;
+		{
+			auto enumerateInstanceVersion = std::bit_cast<PFN_vkEnumerateInstanceVersion>(
+				impl.vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion")
 			);
 
-			return result;
+			rsl::uint32 loaderVersion = VK_API_VERSION_1_0;
+			if (enumerateInstanceVersion)
+			{
+				enumerateInstanceVersion(&loaderVersion);
+			}
+
+			const semver::version supportedVersion = decomposeVkVersion(loaderVersion);
+			if (supportedVersion < instanceVersion)
+			{
+				std::cout << "Vulkan loader only supports API version " << supportedVersion << ", requested "
+						  << apiVersion << '\n';
+				instanceVersion = supportedVersion;
+			}
 		}
 
-		image_usage_flags map_vk_image_usage_flags(VkImageUsageFlagBits flags)
+		const VkApplicationInfo applicationInfo{
+			.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+			.pNext = nullptr,
+			.pApplicationName = _applicationInfo.name.c_str(),
+			.applicationVersion = VK_MAKE_API_VERSION(
+				0, _applicationInfo.version.major, _applicationInfo.version.minor, _applicationInfo.version.patch
+			),
+			.pEngineName = "Rythe Engine",
+			.engineVersion = VK_MAKE_API_VERSION(0, 0, 0, 1),
+			.apiVersion =
+				VK_MAKE_API_VERSION(0, instanceVersion.major, instanceVersion.minor, instanceVersion.patch),
+		};
+
+		const VkInstanceCreateInfo instanceCreateInfo{
+			.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.pApplicationInfo = &applicationInfo,
+			.enabledLayerCount = static_cast<rsl::uint32>(enabledLayers.size()),
+			.ppEnabledLayerNames = enabledLayers.data(),
+			.enabledExtensionCount = static_cast<rsl::uint32>(enabledExtensions.size()),
+			.ppEnabledExtensionNames = enabledExtensions.data(),
+		};
+
+		VkInstance vkInstance = VK_NULL_HANDLE;
+		VkResult result = impl.vkCreateInstance(&instanceCreateInfo, &impl.allocCallbacks, &vkInstance);
+
+		if (result != VK_SUCCESS || vkInstance == VK_NULL_HANDLE)
 		{
-			image_usage_flags result = rsl::enum_flags::make_zero<image_usage_flags>();
+			std::cout << "Failed to create Vulkan Instance\n";
+			return {};
+		}
 
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::transferSrc,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::transferDst,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_TRANSFER_DST_BIT)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::sampled, rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_SAMPLED_BIT)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::storage, rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_STORAGE_BIT)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::colorAttachment,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::depthStencilAttachment,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::transientAttachment,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::inputAttachment,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::fragmentShadingRateAttachment,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::fragmentDensityMap,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_FRAGMENT_DENSITY_MAP_BIT_EXT)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::videoDecodeDst,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_VIDEO_DECODE_DST_BIT_KHR)
-			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::videoDecodeSrc,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_VIDEO_DECODE_SRC_BIT_KHR)
+		native_instance_vk* nativeInstance = allocate<native_instance_vk>(*impl.alloc);
+		nativeInstance->alloc = impl.alloc;
+		nativeInstance->allocCallbacks = &impl.allocCallbacks;
+		nativeInstance->instance = vkInstance;
+		nativeInstance->graphicsLib = *this;
+
+		if (!nativeInstance->load_functions(enabledExtensions))
+		{
+			auto destroyInstance =
+				std::bit_cast<PFN_vkDestroyInstance>(impl.vkGetInstanceProcAddr(vkInstance, "vkDestroyInstance"));
+			if (destroyInstance)
+			{
+				destroyInstance(vkInstance, &impl.allocCallbacks);
+			}
+
+			deallocate<native_instance_vk>(*impl.alloc, nativeInstance);
+			return {};
+		}
+
+		nativeInstance->applicationInfo = _applicationInfo;
+		nativeInstance->apiVersion = instanceVersion;
+		nativeInstance->enabledLayers = std::move(enabledLayerProperties);
+		nativeInstance->enabledExtensions = std::move(enabledExtensionProperties);
+
+		vk::instance instance;
+		set_native_handle(instance, create_native_handle(nativeInstance));
+
+		return instance;
+	}
+
+	std::string_view to_string(physical_device_type type)
+	{
+		switch (type)
+		{
+			case physical_device_type::other: return "other";
+			case physical_device_type::integratedGPU: return "integrated GPU";
+			case physical_device_type::discreteGPU: return "discrete GPU";
+			case physical_device_type::virtualGPU: return "virtual GPU";
+			case physical_device_type::CPU: return "CPU";
+		}
+
+		return "unknown";
+	}
+
+	std::string_view to_string(queue_priority priority)
+	{
+		switch (priority)
+		{
+			case queue_priority::normal: return "normal";
+			case queue_priority::high: return "high";
+		}
+
+		return "unknown";
+	}
+
+	std::string_view to_string(present_mode mode)
+	{
+		switch (mode)
+		{
+			case present_mode::immediate: return "immediate";
+			case present_mode::mailbox: return "mailbox";
+			case present_mode::fifo: return "fifo";
+			case present_mode::fifoRelaxed: return "fifo relaxed";
+		}
+
+		return "unknown";
+	}
+
+	instance::operator bool() const noexcept
+	{
+		auto ptr = get_native_ptr(*this);
+		return ptr != nullptr && ptr->instance != VK_NULL_HANDLE;
+	}
+
+	void instance::release()
+	{
+		auto impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		// A live render device would be left with a dangling dispatch table.
+		rsl_assert_msg_consistent(
+			impl->renderDeviceCount == 0, "render devices must be released before their instance"
+		);
+
+		release_physical_devices();
+
+		impl->functions->vkDestroyInstance(impl->instance, impl->allocCallbacks);
+		deallocate<instance_dispatch_table>(*impl->alloc, const_cast<instance_dispatch_table*>(impl->functions));
+
+		m_nativeInstance = invalid_native_instance;
+		deallocate<native_instance_vk>(*impl->alloc, impl);
+	}
+
+	namespace
+	{
+		struct capability_snapshot_header
+		{
+			constexpr static rsl::uint32 expectedMagic = 0x53434b56; // "VKCS"
+			constexpr static rsl::uint32 expectedVersion = 2;
+
+			rsl::uint32 magic;
+			rsl::uint32 version;
+			rsl::uint64 key;
+			rsl::uint64 dataSize;
+			rsl::uint64 dataHash;
+			rsl::uint32 deviceCount;
+		};
+
+		// Driver manifests in the Vulkan loader's default search paths, plus its environment overrides. Installing,
+		// removing or updating a driver changes the list, or the size or write time of a manifest.
+		[[nodiscard]] rsl::uint64 hash_icd_list(rsl::uint64 seed)
+		{
+			rsl::uint64 hash = seed;
+			for (rsl::cstring variable : {"VK_ICD_FILENAMES", "VK_DRIVER_FILES", "VK_ADD_DRIVER_FILES"})
+			{
+				if (rsl::cstring value = std::getenv(variable))
+				{
+					hash = hash_string(value, hash);
+				}
+			}
+
+			std::vector<std::filesystem::path> manifests;
+#if RYTHE_PLATFORM_WINDOWS
+			HKEY driversKey;
+			if (RegOpenKeyExA(HKEY_LOCAL_MACHINE, "SOFTWARE\\Khronos\\Vulkan\\Drivers", 0, KEY_READ, &driversKey) ==
+				ERROR_SUCCESS)
+			{
+				char valueName[MAX_PATH];
+				DWORD valueNameSize = MAX_PATH;
+				for (DWORD index = 0;
+					 RegEnumValueA(driversKey, index, valueName, &valueNameSize, nullptr, nullptr, nullptr, nullptr) ==
+					 ERROR_SUCCESS;
+					 index++)
+				{
+					manifests.emplace_back(std::string_view(valueName, valueNameSize));
+					valueNameSize = MAX_PATH;
+				}
+
+				RegCloseKey(driversKey);
+			}
+#elif RYTHE_PLATFORM_LINUX
+			std::vector<std::filesystem::path> directories = {
+				"/etc/xdg/vulkan/icd.d",
+				"/etc/vulkan/icd.d",
+				"/usr/local/share/vulkan/icd.d",
+				"/usr/share/vulkan/icd.d",
+			};
+
+			if (rsl::cstring home = std::getenv("HOME"))
+			{
+				directories.push_back(std::filesystem::path(home) / ".config/vulkan/icd.d");
+				directories.push_back(std::filesystem::path(home) / ".local/share/vulkan/icd.d");
+			}
+
+			for (auto& directory : directories)
+			{
+				std::error_code error;
+				for (auto& entry : std::filesystem::directory_iterator(directory, error))
+				{
+					if (entry.path().extension() == ".json")
+					{
+						manifests.push_back(entry.path());
+					}
+				}
+			}
+#endif
+
+			// Directory iteration order is unspecified.
+			std::sort(manifests.begin(), manifests.end());
+
+			for (auto& manifest : manifests)
+			{
+				std::error_code error;
+				hash = hash_string(manifest.string(), hash);
+				hash = hash_value(static_cast<rsl::uint64>(std::filesystem::file_size(manifest, error)), hash);
+				hash = hash_value(std::filesystem::last_write_time(manifest, error).time_since_epoch().count(), hash);
+			}
+
+			return hash;
+		}
+
+		[[nodiscard]] rsl::uint64 make_capability_snapshot_key(const native_instance_vk& impl)
+		{
+			// Capabilities are stored as raw structs, changing their layout invalidates the snapshot.
+			rsl::uint64 key = hash_value(capability_snapshot_header::expectedVersion);
+			key = hash_value(sizeof(physical_device_limits), key);
+			key = hash_value(sizeof(physical_device_sparse_properties), key);
+			key = hash_value(sizeof(physical_device_features), key);
+			key = hash_value(sizeof(descriptor_indexing_capabilities), key);
+			key = hash_value(sizeof(queue_family_properties), key);
+
+			// What can be queried depends on the instance version and extensions.
+			key = hash_value(impl.apiVersion.major, key);
+			key = hash_value(impl.apiVersion.minor, key);
+			key = hash_value(impl.apiVersion.patch, key);
+			for (auto& extension : impl.enabledExtensions) { key = hash_string(extension.name.c_str(), key); }
+
+			return hash_icd_list(key);
+		}
+
+		struct capability_snapshot_writer
+		{
+			std::vector<rsl::byte> data;
+
+			template <typename T>
+			void write(const T& value)
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				auto* bytes = reinterpret_cast<const rsl::byte*>(&value);
+				data.insert(data.end(), bytes, bytes + sizeof(T));
+			}
+
+			void write_string(std::string_view str)
+			{
+				write(static_cast<rsl::uint32>(str.size()));
+				auto* bytes = reinterpret_cast<const rsl::byte*>(str.data());
+				data.insert(data.end(), bytes, bytes + str.size());
+			}
+
+			void write_version(const semver::version& version)
+			{
+				write(version.major);
+				write(version.minor);
+				write(version.patch);
+			}
+		};
+
+		struct capability_snapshot_reader
+		{
+			std::span<const rsl::byte> data;
+			rsl::size_type offset = 0;
+
+			template <typename T>
+			[[nodiscard]] bool read(T& value)
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				if (data.size() - offset < sizeof(T))
+				{
+					return false;
+				}
+
+				std::memcpy(&value, data.data() + offset, sizeof(T));
+				offset += sizeof(T);
+				return true;
+			}
+
+			[[nodiscard]] bool read_string(std::string& str)
+			{
+				rsl::uint32 size = 0;
+				if (!read(size) || data.size() - offset < size)
+				{
+					return false;
+				}
+
+				str.assign(reinterpret_cast<const char*>(data.data() + offset), size);
+				offset += size;
+				return true;
+			}
+
+			[[nodiscard]] bool read_version(semver::version& version)
+			{
+				rsl::uint8 major = 0;
+				rsl::uint8 minor = 0;
+				rsl::uint8 patch = 0;
+				if (!read(major) || !read(minor) || !read(patch))
+				{
+					return false;
+				}
+
+				version = semver::version(major, minor, patch);
+				return true;
+			}
+		};
+
+		// Entries start with the ids devices are matched on and the size of the rest, so an entry can be found
+		// without parsing the ones before it.
+		void write_capability_snapshot_entry(capability_snapshot_writer& writer, physical_device& device)
+		{
+			auto& props = device.get_properties();
+			writer.write(props.vendorID);
+			writer.write(props.deviceID);
+			const rsl::size_type sizeOffset = writer.data.size();
+			writer.write(rsl::uint64{0});
+			const rsl::size_type entryOffset = writer.data.size();
+
+			writer.write_version(props.apiVersion);
+			writer.write_version(props.driverVersion);
+			writer.write(props.rawDriverVersion);
+			writer.write(props.deviceType);
+			writer.write_string(props.deviceName);
+			writer.write(props.pipelineCacheUUID);
+			writer.write(props.limits);
+			writer.write(props.sparseProperties);
+
+			writer.write(device.get_features());
+			writer.write(device.get_descriptor_indexing_capabilities());
+
+			auto extensions = device.get_available_extensions();
+			writer.write(static_cast<rsl::uint32>(extensions.size()));
+			for (auto& extension : extensions)
+			{
+				writer.write_string(extension.name.c_str());
+				writer.write_version(extension.specVersion);
+			}
+
+			auto queueFamilies = device.get_available_queue_families();
+			writer.write(static_cast<rsl::uint32>(queueFamilies.size()));
+			for (auto& queueFamily : queueFamilies) { writer.write(queueFamily); }
+
+			const auto entrySize = static_cast<rsl::uint64>(writer.data.size() - entryOffset);
+			std::memcpy(writer.data.data() + sizeOffset, &entrySize, sizeof(entrySize));
+		}
+
+		struct capability_snapshot_entry
+		{
+			rsl::uint32 vendorID = 0;
+			rsl::uint32 deviceID = 0;
+			std::span<const rsl::byte> data;
+			bool used = false;
+		};
+
+		[[nodiscard]] bool
+		read_capability_snapshot_entry(capability_snapshot_reader& reader, native_physical_device_vk& impl)
+		{
+			auto& props = impl.properties;
+			if (!reader.read_version(props.apiVersion) || !reader.read_version(props.driverVersion) ||
+				!reader.read(props.rawDriverVersion) || !reader.read(props.deviceType) ||
+				!reader.read_string(props.deviceName) || !reader.read(props.pipelineCacheUUID) ||
+				!reader.read(props.limits) || !reader.read(props.sparseProperties) || !reader.read(impl.features) ||
+				!reader.read(impl.descriptorIndexing))
+			{
+				return false;
+			}
+
+			rsl::uint32 extensionCount = 0;
+			if (!reader.read(extensionCount))
+			{
+				return false;
+			}
+
+			impl.availableExtensions.reserve(extensionCount);
+			for (rsl::uint32 i = 0; i < extensionCount; i++)
+			{
+				std::string name;
+				semver::version specVersion;
+				if (!reader.read_string(name) || !reader.read_version(specVersion))
+				{
+					return false;
+				}
+
+				impl.availableExtensions.push_back(extension_properties{
+					.name = rsl::hashed_string(name.c_str()),
+					.specVersion = specVersion,
+				});
+			}
+
+			rsl::uint32 queueFamilyCount = 0;
+			if (!reader.read(queueFamilyCount))
+			{
+				return false;
+			}
+
+			impl.availableQueueFamilies.resize(queueFamilyCount);
+			for (auto& queueFamily : impl.availableQueueFamilies)
+			{
+				if (!reader.read(queueFamily))
+				{
+					return false;
+				}
+			}
+
+			build_name_index<extension_properties>(impl.availableExtensionIndex, impl.availableExtensions);
+			impl.propertiesLoaded = true;
+			impl.featuresLoaded = true;
+			impl.descriptorIndexingLoaded = true;
+			impl.fromSnapshot = true;
+			return true;
+		}
+
+		void clear_capabilities(native_physical_device_vk& impl)
+		{
+			impl.propertiesLoaded = false;
+			impl.featuresLoaded = false;
+			impl.descriptorIndexingLoaded = false;
+			impl.availableExtensions.clear();
+			impl.availableExtensionIndex.clear();
+			impl.availableQueueFamilies.clear();
+			impl.fromSnapshot = false;
+		}
+
+		bool load_capability_snapshot(native_instance_vk& impl)
+		{
+			std::ifstream file(impl.capabilitySnapshotPath, std::ios::binary);
+			if (!file)
+			{
+				return false;
+			}
+
+			capability_snapshot_header header;
+			if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+				header.magic != capability_snapshot_header::expectedMagic ||
+				header.version != capability_snapshot_header::expectedVersion)
+			{
+				std::cout << "Capability snapshot " << impl.capabilitySnapshotPath
+						  << " is not recognized, ignoring it.\n";
+				return false;
+			}
+
+			if (header.key != make_capability_snapshot_key(impl) || header.deviceCount != impl.physicalDevices.size())
+			{
+				std::cout << "Capability snapshot " << impl.capabilitySnapshotPath
+						  << " was written for other drivers, ignoring it.\n";
+				return false;
+			}
+
+			// The size comes from disk, check it against the file before allocating for it.
+			std::error_code error;
+			const std::uintmax_t fileSize = std::filesystem::file_size(impl.capabilitySnapshotPath, error);
+			if (error || header.dataSize != fileSize - sizeof(header))
+			{
+				std::cout << "Capability snapshot " << impl.capabilitySnapshotPath << " is corrupt, ignoring it.\n";
+				return false;
+			}
+
+			std::vector<rsl::byte> data;
+			data.resize(header.dataSize);
+			if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())) ||
+				hash_bytes(data) != header.dataHash)
+			{
+				std::cout << "Capability snapshot " << impl.capabilitySnapshotPath << " is corrupt, ignoring it.\n";
+				return false;
+			}
+
+			std::vector<capability_snapshot_entry> entries;
+			entries.reserve(header.deviceCount);
+
+			capability_snapshot_reader reader{.data = data};
+			for (rsl::uint32 i = 0; i < header.deviceCount; i++)
+			{
+				capability_snapshot_entry& entry = entries.emplace_back();
+				rsl::uint64 entrySize = 0;
+				if (!reader.read(entry.vendorID) || !reader.read(entry.deviceID) || !reader.read(entrySize) ||
+					data.size() - reader.offset < entrySize)
+				{
+					std::cout << "Capability snapshot " << impl.capabilitySnapshotPath << " is corrupt, ignoring it.\n";
+					return false;
+				}
+
+				entry.data = std::span<const rsl::byte>(data).subspan(reader.offset, entrySize);
+				reader.offset += entrySize;
+			}
+
+			// The enumeration order isn't stable, each device takes the first unused entry with its vendor and device
+			// id. Reading the ids from the driver is cheap next to the rest of the capabilities.
+			for (auto& device : impl.physicalDevices)
+			{
+				auto& deviceImpl = get_native_ref(device);
+
+				VkPhysicalDeviceProperties liveProps;
+				deviceImpl.functions->vkGetPhysicalDeviceProperties(deviceImpl.physicalDevice, &liveProps);
+
+				auto entry = std::find_if(
+					entries.begin(), entries.end(),
+					[&](const capability_snapshot_entry& candidate) {
+						return !candidate.used && candidate.vendorID == liveProps.vendorID &&
+							   candidate.deviceID == liveProps.deviceID;
+					}
+				);
+
+				bool loaded = false;
+				if (entry == entries.end())
+				{
+					std::cout << "Capability snapshot " << impl.capabilitySnapshotPath
+							  << " was written for other devices, ignoring it.\n";
+				}
+				else
+				{
+					entry->used = true;
+					capability_snapshot_reader entryReader{.data = entry->data};
+					loaded = read_capability_snapshot_entry(entryReader, deviceImpl);
+					if (!loaded)
+					{
+						std::cout << "Capability snapshot " << impl.capabilitySnapshotPath
+								  << " is corrupt, ignoring it.\n";
+					}
+				}
+
+				if (!loaded)
+				{
+					for (auto& clearedDevice : impl.physicalDevices)
+					{
+						clear_capabilities(get_native_ref(clearedDevice));
+					}
+					return false;
+				}
+
+				deviceImpl.properties.vendorID = entry->vendorID;
+				deviceImpl.properties.deviceID = entry->deviceID;
+			}
+
+			return true;
+		}
+
+		// Queries a device that was loaded from the snapshot from the driver again. Returns false when the driver
+		// reports another device or driver version than the snapshot did.
+		[[nodiscard]] bool refresh_snapshot_device(physical_device& device, surface surface)
+		{
+			auto& impl = get_native_ref(device);
+			const rsl::uint32 vendorID = impl.properties.vendorID;
+			const rsl::uint32 deviceID = impl.properties.deviceID;
+			const rsl::uint32 rawDriverVersion = impl.properties.rawDriverVersion;
+
+			clear_capabilities(impl);
+
+			auto& props = device.get_properties();
+			if (props.vendorID != vendorID || props.deviceID != deviceID || props.rawDriverVersion != rawDriverVersion)
+			{
+				return false;
+			}
+
+			device.get_features();
+			device.get_descriptor_indexing_capabilities();
+			device.get_available_extensions();
+			device.get_available_queue_families(surface);
+			return true;
+		}
+
+		// Fills every capability cache of the devices that didn't come from the snapshot, so device selection only
+		// reads caches. Each device is queried by a single worker, the calling thread works along.
+		void query_physical_devices(std::span<physical_device> devices, surface surface, rsl::size_type threadCount)
+		{
+			std::atomic<rsl::size_type> nextIndex = 0;
+
+			auto queryDevices = [&]()
+			{
+				for (rsl::size_type index = nextIndex.fetch_add(1, std::memory_order_relaxed); index < devices.size();
+					 index = nextIndex.fetch_add(1, std::memory_order_relaxed))
+				{
+					auto& device = devices[index];
+					if (get_native_ref(device).fromSnapshot)
+					{
+						continue;
+					}
+
+					device.get_properties();
+					device.get_features();
+					device.get_descriptor_indexing_capabilities();
+					device.get_available_extensions();
+					device.get_available_queue_families(surface);
+				}
+			};
+
+			std::vector<std::thread> workers;
+			workers.reserve(threadCount - 1);
+			for (rsl::size_type i = 1; i < threadCount; i++) { workers.emplace_back(queryDevices); }
+
+			queryDevices();
+
+			for (auto& worker : workers) { worker.join(); }
+		}
+	} // namespace
+
+	void instance::set_capability_snapshot_path(std::string_view filePath)
+	{
+		get_native_ref(*this).capabilitySnapshotPath = filePath;
+	}
+
+	bool instance::save_capability_snapshot()
+	{
+		auto& impl = get_native_ref(*this);
+		if (impl.capabilitySnapshotPath.empty())
+		{
+			return false;
+		}
+
+		capability_snapshot_writer writer;
+		for (auto& device : create_physical_devices()) { write_capability_snapshot_entry(writer, device); }
+
+		capability_snapshot_header header{};
+		header.magic = capability_snapshot_header::expectedMagic;
+		header.version = capability_snapshot_header::expectedVersion;
+		header.key = make_capability_snapshot_key(impl);
+		header.dataSize = writer.data.size();
+		header.dataHash = hash_bytes(writer.data);
+		header.deviceCount = static_cast<rsl::uint32>(impl.physicalDevices.size());
+
+		if (!write_file_atomically(
+				impl.capabilitySnapshotPath,
+				std::span<const rsl::byte>(reinterpret_cast<const rsl::byte*>(&header), sizeof(header)), writer.data,
+				"capability snapshot"
+			))
+		{
+			return false;
+		}
+
+		impl.capabilitySnapshotStale = false;
+		return true;
+	}
+
+	std::span<physical_device> instance::create_physical_devices(bool forceRefresh, rsl::size_type threadCount)
+	{
+		auto& impl = get_native_ref(*this);
+
+		if (forceRefresh || impl.physicalDevices.empty())
+		{
+			rsl::uint32 deviceCount = 0;
+			VkResult result = impl.functions->vkEnumeratePhysicalDevices(impl.instance, &deviceCount, nullptr);
+			if (result != VK_SUCCESS || deviceCount == 0)
+			{
+				std::cout << "Could not query the number of physical devices.\n";
+				return {};
+			}
+
+			std::vector<VkPhysicalDevice> physicalDevicesBuffer;
+			physicalDevicesBuffer.resize(deviceCount);
+			result = impl.functions->vkEnumeratePhysicalDevices(
+				impl.instance, &deviceCount, physicalDevicesBuffer.data()
+			);
+
+			if (result != VK_SUCCESS || deviceCount == 0)
+			{
+				std::cout << "Could not enumerate physical devices.\n";
+				return {};
+			}
+
+			release_physical_devices();
+			impl.physicalDevices.reserve(deviceCount);
+			for (auto& pd : physicalDevicesBuffer)
+			{
+				auto& physicalDevice = impl.physicalDevices.emplace_back();
+				native_physical_device_vk* nativePhysicalDevice = allocate<native_physical_device_vk>(*impl.alloc);
+				set_native_handle(physicalDevice, create_native_handle(nativePhysicalDevice));
+
+				nativePhysicalDevice->alloc = impl.alloc;
+				nativePhysicalDevice->allocCallbacks = impl.allocCallbacks;
+				nativePhysicalDevice->physicalDevice = pd;
+				nativePhysicalDevice->instance = *this;
+				nativePhysicalDevice->functions = impl.functions;
+			}
+
+			if (!impl.capabilitySnapshotPath.empty() && !impl.capabilitySnapshotStale)
+			{
+				load_capability_snapshot(impl);
+			}
+
+			if (threadCount == 0)
+			{
+				threadCount = static_cast<rsl::size_type>(std::thread::hardware_concurrency());
+			}
+			threadCount = rsl::math::min(threadCount, impl.physicalDevices.size());
+			if (threadCount == 0)
+			{
+				threadCount = 1;
+			}
+
+			// Shared by the workers, otherwise each device creates its own to query present support.
+			surface querySurface = create_surface();
+			query_physical_devices(impl.physicalDevices, querySurface, threadCount);
+			querySurface.release();
+		}
+
+		return impl.physicalDevices;
+	}
+
+	void instance::release_physical_devices()
+	{
+		auto* impl = get_native_ptr(*this);
+
+		if (!impl)
+		{
+			return;
+		}
+
+		for (auto& device : impl->physicalDevices) { device.release(); }
+
+		impl->physicalDevices.clear();
+	}
+
+	const application_info& instance::get_application_info() const noexcept
+	{
+		return get_native_ref(*this).applicationInfo;
+	}
+
+	const semver::version& instance::get_api_version() const noexcept
+	{
+		return get_native_ref(*this).apiVersion;
+	}
+
+	namespace
+	{
+		[[nodiscard]] physical_device share_physical_device(physical_device src)
+		{
+			get_native_ref(src).refCount++;
+			return src;
+		}
+
+		// Hashes of extension names, the extension gated functions in list_of_vulkan_functions.inl are resolved with
+		// one lookup each, against the compile time hash of their extension's name.
+		using extension_set = std::unordered_set<rsl::id_type>;
+
+		[[nodiscard]] extension_set make_extension_set(std::span<const rsl::cstring> extensions)
+		{
+			extension_set result;
+			result.reserve(extensions.size());
+			for (auto& extension : extensions) { result.insert(rsl::hashed_string(extension).value); }
+
+			return result;
+		}
+
+		[[nodiscard]] bool contains_extension(std::span<const rsl::cstring> extensions, std::string_view extensionName)
+		{
+			for (auto& extension : extensions)
+			{
+				if (std::string_view(extension) == extensionName)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		// The version a render device on this physical device runs at, the lower of the instance and device versions.
+		[[nodiscard]] rsl::uint32 get_device_api_version(physical_device& physicalDevice)
+		{
+			auto& impl = get_native_ref(physicalDevice);
+
+			const semver::version& instanceVersion = impl.instance.get_api_version();
+			const semver::version& deviceVersion = physicalDevice.get_properties().apiVersion;
+			const semver::version& version = deviceVersion < instanceVersion ? deviceVersion : instanceVersion;
+
+			return VK_MAKE_API_VERSION(0, version.major, version.minor, version.patch);
+		}
+
+		// Fills a single feature struct through vkGetPhysicalDeviceFeatures2KHR, returns false when that isn't
+		// loaded.
+		template <typename FeatureStruct>
+		[[nodiscard]] bool
+		query_features(native_physical_device_vk& impl, FeatureStruct& features, VkStructureType structureType)
+		{
+			if (!impl.functions->vkGetPhysicalDeviceFeatures2KHR)
+			{
+				return false;
+			}
+
+			features = {};
+			features.sType = structureType;
+
+			VkPhysicalDeviceFeatures2KHR features2{};
+			features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+			features2.pNext = &features;
+			impl.functions->vkGetPhysicalDeviceFeatures2KHR(impl.physicalDevice, &features2);
+
+			features.pNext = nullptr;
+			return true;
+		}
+
+		// Fills a single property struct through vkGetPhysicalDeviceProperties2KHR, returns false when that isn't
+		// loaded.
+		template <typename PropertyStruct>
+		[[nodiscard]] bool
+		query_properties(native_physical_device_vk& impl, PropertyStruct& properties, VkStructureType structureType)
+		{
+			if (!impl.functions->vkGetPhysicalDeviceProperties2KHR)
+			{
+				return false;
+			}
+
+			properties = {};
+			properties.sType = structureType;
+
+			VkPhysicalDeviceProperties2KHR properties2{};
+			properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+			properties2.pNext = &properties;
+			impl.functions->vkGetPhysicalDeviceProperties2KHR(impl.physicalDevice, &properties2);
+
+			properties.pNext = nullptr;
+			return true;
+		}
+
+		// Returns false when the device doesn't have VK_EXT_descriptor_indexing or the instance can't query extension
+		// features.
+		[[nodiscard]] bool query_descriptor_indexing(
+			physical_device& physicalDevice, VkPhysicalDeviceDescriptorIndexingFeaturesEXT& features,
+			VkPhysicalDeviceDescriptorIndexingPropertiesEXT& properties
+		)
+		{
+			auto& impl = get_native_ref(physicalDevice);
+
+			if (!impl.functions->vkGetPhysicalDeviceFeatures2KHR ||
+				!impl.functions->vkGetPhysicalDeviceProperties2KHR ||
+				!physicalDevice.is_extension_available(
+					MAKE_HASHED_STRING_VIEW_LITERAL(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)
+				))
+			{
+				return false;
+			}
+
+			if (!query_features(impl, features, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT))
+			{
+				return false;
+			}
+
+			properties = {};
+			properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+
+			VkPhysicalDeviceProperties2KHR properties2{};
+			properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+			properties2.pNext = &properties;
+			impl.functions->vkGetPhysicalDeviceProperties2KHR(impl.physicalDevice, &properties2);
+
+			properties.pNext = nullptr;
+			return true;
+		}
+
+		void map_vk_descriptor_indexing(
+			descriptor_indexing_capabilities& target, const VkPhysicalDeviceDescriptorIndexingFeaturesEXT& features,
+			const VkPhysicalDeviceDescriptorIndexingPropertiesEXT& properties
+		)
+		{
+			target.shaderSampledImageArrayNonUniformIndexing = features.shaderSampledImageArrayNonUniformIndexing;
+			target.shaderStorageBufferArrayNonUniformIndexing = features.shaderStorageBufferArrayNonUniformIndexing;
+			target.shaderStorageImageArrayNonUniformIndexing = features.shaderStorageImageArrayNonUniformIndexing;
+			target.descriptorBindingSampledImageUpdateAfterBind = features.descriptorBindingSampledImageUpdateAfterBind;
+			target.descriptorBindingStorageImageUpdateAfterBind = features.descriptorBindingStorageImageUpdateAfterBind;
+			target.descriptorBindingStorageBufferUpdateAfterBind =
+				features.descriptorBindingStorageBufferUpdateAfterBind;
+			target.descriptorBindingUpdateUnusedWhilePending = features.descriptorBindingUpdateUnusedWhilePending;
+			target.descriptorBindingPartiallyBound = features.descriptorBindingPartiallyBound;
+			target.descriptorBindingVariableDescriptorCount = features.descriptorBindingVariableDescriptorCount;
+			target.runtimeDescriptorArray = features.runtimeDescriptorArray;
+
+			target.maxUpdateAfterBindDescriptorsInAllPools = properties.maxUpdateAfterBindDescriptorsInAllPools;
+			target.maxPerStageDescriptorUpdateAfterBindSamplers =
+				properties.maxPerStageDescriptorUpdateAfterBindSamplers;
+			target.maxPerStageDescriptorUpdateAfterBindStorageBuffers =
+				properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers;
+			target.maxPerStageDescriptorUpdateAfterBindSampledImages =
+				properties.maxPerStageDescriptorUpdateAfterBindSampledImages;
+			target.maxPerStageDescriptorUpdateAfterBindStorageImages =
+				properties.maxPerStageDescriptorUpdateAfterBindStorageImages;
+			target.maxDescriptorSetUpdateAfterBindSamplers = properties.maxDescriptorSetUpdateAfterBindSamplers;
+			target.maxDescriptorSetUpdateAfterBindStorageBuffers =
+				properties.maxDescriptorSetUpdateAfterBindStorageBuffers;
+			target.maxDescriptorSetUpdateAfterBindSampledImages =
+				properties.maxDescriptorSetUpdateAfterBindSampledImages;
+			target.maxDescriptorSetUpdateAfterBindStorageImages =
+				properties.maxDescriptorSetUpdateAfterBindStorageImages;
+		}
+
+		[[nodiscard]] dynamic_state_flags get_dynamic_state_support(
+			const native_render_device_vk& renderDevice, bool extendedDynamicState, bool extendedDynamicState2,
+			const VkPhysicalDeviceExtendedDynamicState3FeaturesEXT& extendedDynamicState3
+		)
+		{
+			using enum dynamic_state_flags;
+
+			constexpr dynamic_state_flags extendedDynamicStateFlags[] = {
+				cullMode, frontFace, primitiveTopology, depthTestEnable, depthWriteEnable, depthCompareOp,
+			};
+
+			dynamic_state_flags result = none;
+			if (extendedDynamicState && renderDevice.functions->vkCmdSetCullMode)
+			{
+				for (auto flag : extendedDynamicStateFlags) { result = rsl::enum_flags::set_flag(result, flag, true); }
+			}
+
+			if (extendedDynamicState2 && renderDevice.functions->vkCmdSetPrimitiveRestartEnable)
+			{
+				result = rsl::enum_flags::set_flag(result, primitiveRestartEnable, true);
+				result = rsl::enum_flags::set_flag(result, depthBiasEnable, true);
+			}
+
+			// Only set when VK_EXT_extended_dynamic_state3 was enabled, the features are zeroed otherwise.
+			result = rsl::enum_flags::set_flag(
+				result, polygonMode,
+				extendedDynamicState3.extendedDynamicState3PolygonMode && renderDevice.functions->vkCmdSetPolygonModeEXT
+			);
+			result = rsl::enum_flags::set_flag(
+				result, depthClampEnable,
+				extendedDynamicState3.extendedDynamicState3DepthClampEnable &&
+					renderDevice.functions->vkCmdSetDepthClampEnableEXT
+			);
+			result = rsl::enum_flags::set_flag(
+				result, colorBlendEnable,
+				extendedDynamicState3.extendedDynamicState3ColorBlendEnable &&
+					renderDevice.functions->vkCmdSetColorBlendEnableEXT
+			);
+			result = rsl::enum_flags::set_flag(
+				result, colorBlendEquation,
+				extendedDynamicState3.extendedDynamicState3ColorBlendEquation &&
+					renderDevice.functions->vkCmdSetColorBlendEquationEXT
+			);
+			result = rsl::enum_flags::set_flag(
+				result, colorWriteMask,
+				extendedDynamicState3.extendedDynamicState3ColorWriteMask &&
+					renderDevice.functions->vkCmdSetColorWriteMaskEXT
+			);
+
+			return result;
+		}
+
+		[[nodiscard]] VkPhysicalDeviceFeatures to_vk_physical_device_features(const physical_device_features& src)
+		{
+			VkBool32 values[physical_device_features::featureCount];
+			for (rsl::size_type i = 0; i < physical_device_features::featureCount; i++)
+			{
+				values[i] = src.has(static_cast<physical_device_feature>(i)) ? VK_TRUE : VK_FALSE;
+			}
+
+			VkPhysicalDeviceFeatures result;
+			std::memcpy(&result, values, sizeof(values));
+			return result;
+		}
+
+		[[nodiscard]] render_device create_render_device_no_extension_check(
+			physical_device& physicalDevice, std::span<const queue_description> queueDesciptions,
+			std::span<const rsl::cstring> extensions, std::span<const rsl::cstring> layers,
+			const physical_device_features& enabledFeatures
+		)
+		{
+			auto& impl = get_native_ref(physicalDevice);
+
+			if (!physicalDevice.get_features().contains(enabledFeatures))
+			{
+				std::cout << "Not all requested device features are supported.\n";
+				return {};
+			}
+
+			std::vector<queue_family_selection> queueFamilySelections;
+			queueFamilySelections.resize(queueDesciptions.size());
+
+			if (!physicalDevice.get_queue_family_selection(queueFamilySelections, queueDesciptions))
+			{
+				return {};
+			}
+
+			auto queueFamilies = physicalDevice.get_available_queue_families();
+
+			struct queue_mapping
+			{
+				std::vector<rsl::size_type> inputOrderIndex;
+				std::vector<rsl::float32> priorities;
+			};
+
+			std::vector<queue_mapping> queueMapping;
+			queueMapping.resize(queueFamilies.size());
+
+			for (rsl::size_type i = 0; i < queueDesciptions.size(); i++)
+			{
+				auto familyIndex = queueFamilySelections[i].familyIndex;
+
+				queueMapping[familyIndex].inputOrderIndex.push_back(i);
+				queueMapping[familyIndex].priorities.push_back(
+					queueDesciptions[i].priority == queue_priority::normal ? 0.5f : 1.f
+				);
+			}
+
+			std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+			queueCreateInfos.reserve(queueDesciptions.size());
+			for (rsl::size_type i = 0; i < queueMapping.size(); i++)
+			{
+				auto& priorities = queueMapping[i].priorities;
+
+				if (!priorities.empty())
+				{
+					queueCreateInfos.push_back(VkDeviceQueueCreateInfo{
+						.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+						.pNext = nullptr,
+						.flags = 0,
+						.queueFamilyIndex = static_cast<rsl::uint32>(i),
+						.queueCount = static_cast<rsl::uint32>(priorities.size()),
+						.pQueuePriorities = priorities.data(),
+					});
+				}
+			}
+
+			// Only the requested core features are enabled, features like robustBufferAccess cost performance on many
+			// drivers even when nothing relies on them.
+			const VkPhysicalDeviceFeatures features = to_vk_physical_device_features(enabledFeatures);
+
+			// Extension features are enabled in full when their extension is, they are only there because the
+			// extension was asked for.
+			void* featureChain = nullptr;
+
+			VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures{};
+			VkPhysicalDeviceDescriptorIndexingPropertiesEXT descriptorIndexingProperties{};
+			bool descriptorIndexingEnabled = false;
+			if (contains_extension(extensions, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) &&
+				query_descriptor_indexing(physicalDevice, descriptorIndexingFeatures, descriptorIndexingProperties))
+			{
+				descriptorIndexingFeatures.pNext = featureChain;
+				featureChain = &descriptorIndexingFeatures;
+				descriptorIndexingEnabled = true;
+			}
+
+			const rsl::uint32 apiVersion = get_device_api_version(physicalDevice);
+
+			// Vulkan 1.3 features can't be chained together with the structs of the extensions they were promoted
+			// from, so dynamic rendering is enabled through one or the other.
+			VkPhysicalDeviceVulkan13Features supportedVulkan13Features{};
+			VkPhysicalDeviceVulkan13Features vulkan13Features{};
+			VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+			bool dynamicRenderingEnabled = false;
+			if (apiVersion >= VK_API_VERSION_1_3)
+			{
+				if (query_features(
+						impl, supportedVulkan13Features, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES
+					))
+				{
+					// Only dynamic rendering is used, every other 1.3 feature stays off. That includes image
+					// robustness, which costs as much as robustBufferAccess.
+					vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+					vulkan13Features.dynamicRendering = supportedVulkan13Features.dynamicRendering;
+					vulkan13Features.pNext = featureChain;
+					featureChain = &vulkan13Features;
+					dynamicRenderingEnabled = vulkan13Features.dynamicRendering == VK_TRUE;
+				}
+			}
+			else if (contains_extension(extensions, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) &&
+					 query_features(
+						 impl, dynamicRenderingFeatures,
+						 VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR
+					 ))
+			{
+				dynamicRenderingFeatures.pNext = featureChain;
+				featureChain = &dynamicRenderingFeatures;
+				dynamicRenderingEnabled = dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+			}
+
+			// Extended dynamic state 1 and 2 are core in 1.3 and have no feature bits there.
+			VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures{};
+			VkPhysicalDeviceExtendedDynamicState2FeaturesEXT extendedDynamicState2Features{};
+			VkPhysicalDeviceExtendedDynamicState3FeaturesEXT extendedDynamicState3Features{};
+			bool extendedDynamicStateEnabled = apiVersion >= VK_API_VERSION_1_3;
+			bool extendedDynamicState2Enabled = apiVersion >= VK_API_VERSION_1_3;
+			if (!extendedDynamicStateEnabled &&
+				contains_extension(extensions, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME) &&
+				query_features(
+					impl, extendedDynamicStateFeatures,
+					VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT
+				))
+			{
+				extendedDynamicStateFeatures.pNext = featureChain;
+				featureChain = &extendedDynamicStateFeatures;
+				extendedDynamicStateEnabled = extendedDynamicStateFeatures.extendedDynamicState == VK_TRUE;
+			}
+
+			if (!extendedDynamicState2Enabled &&
+				contains_extension(extensions, VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME) &&
+				query_features(
+					impl, extendedDynamicState2Features,
+					VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT
+				))
+			{
+				extendedDynamicState2Features.pNext = featureChain;
+				featureChain = &extendedDynamicState2Features;
+				extendedDynamicState2Enabled = extendedDynamicState2Features.extendedDynamicState2 == VK_TRUE;
+			}
+
+			VkPhysicalDeviceExtendedDynamicState3FeaturesEXT supportedExtendedDynamicState3Features{};
+			if (contains_extension(extensions, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME) &&
+				query_features(
+					impl, supportedExtendedDynamicState3Features,
+					VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT
+				))
+			{
+				// Only the states get_dynamic_state_support maps are enabled.
+				auto& supported = supportedExtendedDynamicState3Features;
+				auto& enabled = extendedDynamicState3Features;
+				enabled.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+				enabled.extendedDynamicState3PolygonMode = supported.extendedDynamicState3PolygonMode;
+				enabled.extendedDynamicState3DepthClampEnable = supported.extendedDynamicState3DepthClampEnable;
+				enabled.extendedDynamicState3ColorBlendEnable = supported.extendedDynamicState3ColorBlendEnable;
+				enabled.extendedDynamicState3ColorBlendEquation = supported.extendedDynamicState3ColorBlendEquation;
+				enabled.extendedDynamicState3ColorWriteMask = supported.extendedDynamicState3ColorWriteMask;
+				extendedDynamicState3Features.pNext = featureChain;
+				featureChain = &extendedDynamicState3Features;
+			}
+
+			VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibraryFeatures{};
+			VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT graphicsPipelineLibraryProperties{};
+			bool graphicsPipelineLibraryEnabled = false;
+			if (contains_extension(extensions, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+				query_features(
+					impl, graphicsPipelineLibraryFeatures,
+					VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT
+				) &&
+				query_properties(
+					impl, graphicsPipelineLibraryProperties,
+					VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT
+				))
+			{
+				graphicsPipelineLibraryFeatures.pNext = featureChain;
+				featureChain = &graphicsPipelineLibraryFeatures;
+				graphicsPipelineLibraryEnabled = graphicsPipelineLibraryFeatures.graphicsPipelineLibrary == VK_TRUE;
+			}
+
+			VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+			VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+			bool presentWaitEnabled = false;
+			if (contains_extension(extensions, VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+				contains_extension(extensions, VK_KHR_PRESENT_WAIT_EXTENSION_NAME) &&
+				query_features(impl, presentIdFeatures, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR) &&
+				query_features(impl, presentWaitFeatures, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR))
+			{
+				presentIdFeatures.pNext = featureChain;
+				presentWaitFeatures.pNext = &presentIdFeatures;
+				featureChain = &presentWaitFeatures;
+				presentWaitEnabled =
+					presentIdFeatures.presentId == VK_TRUE && presentWaitFeatures.presentWait == VK_TRUE;
+			}
+
+			const VkDeviceCreateInfo deviceCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+				.pNext = featureChain,
+				.flags = 0,
+				.queueCreateInfoCount = static_cast<rsl::uint32>(queueCreateInfos.size()),
+				.pQueueCreateInfos = queueCreateInfos.data(),
+				.enabledLayerCount = static_cast<rsl::uint32>(layers.size()),
+				.ppEnabledLayerNames = layers.data(),
+				.enabledExtensionCount = static_cast<rsl::uint32>(extensions.size()),
+				.ppEnabledExtensionNames = extensions.data(),
+				.pEnabledFeatures = &features,
+			};
+
+			VkDevice device = VK_NULL_HANDLE;
+
+			{
+				VkResult result = impl.functions->vkCreateDevice(
+					impl.physicalDevice, &deviceCreateInfo, impl.allocCallbacks, &device
+				);
+
+				if (result != VK_SUCCESS || device == VK_NULL_HANDLE)
+				{
+					return {};
+				}
+			}
+
+			auto* renderDevicePtr = allocate<native_render_device_vk>(*impl.alloc);
+			renderDevicePtr->alloc = impl.alloc;
+			renderDevicePtr->allocCallbacks = impl.allocCallbacks;
+			renderDevicePtr->device = device;
+			renderDevicePtr->apiVersion = apiVersion;
+			renderDevicePtr->enabledFeatures = enabledFeatures;
+
+			if (descriptorIndexingEnabled)
+			{
+				map_vk_descriptor_indexing(
+					renderDevicePtr->descriptorIndexing, descriptorIndexingFeatures, descriptorIndexingProperties
+				);
+			}
+
+			renderDevicePtr->instanceFunctions = impl.functions;
+
+			if (!renderDevicePtr->load_functions(extensions))
+			{
+				auto destroyDevice =
+					std::bit_cast<PFN_vkDestroyDevice>(impl.functions->vkGetDeviceProcAddr(device, "vkDestroyDevice"));
+				if (destroyDevice)
+				{
+					destroyDevice(device, impl.allocCallbacks);
+				}
+
+				deallocate<native_render_device_vk>(*impl.alloc, renderDevicePtr);
+				return {};
+			}
+
+			renderDevicePtr->dynamicRendering =
+				dynamicRenderingEnabled && renderDevicePtr->functions->vkCmdBeginRendering;
+
+			renderDevicePtr->dynamicStateSupport = get_dynamic_state_support(
+				*renderDevicePtr, extendedDynamicStateEnabled, extendedDynamicState2Enabled,
+				extendedDynamicState3Features
+			);
+
+			renderDevicePtr->graphicsPipelineLibrary = graphicsPipelineLibraryEnabled;
+			renderDevicePtr->graphicsPipelineLibraryFastLinking =
+				graphicsPipelineLibraryProperties.graphicsPipelineLibraryFastLinking == VK_TRUE;
+
+			renderDevicePtr->presentWait = presentWaitEnabled && renderDevicePtr->functions->vkWaitForPresentKHR;
+
+			renderDevicePtr->physicalDevice = share_physical_device(physicalDevice);
+			get_native_ref(impl.instance).renderDeviceCount++;
+			set_native_handle(impl.renderDevice, create_native_handle(renderDevicePtr));
+
+			renderDevicePtr->queues.resize(queueDesciptions.size());
+			for (rsl::size_type i = 0; i < queueCreateInfos.size(); i++)
+			{
+				auto& info = queueCreateInfos[i];
+				auto& mapping = queueMapping[info.queueFamilyIndex];
+
+				for (rsl::size_type queueIndex = 0; queueIndex < info.queueCount; queueIndex++)
+				{
+					VkQueue vkQueue = VK_NULL_HANDLE;
+					renderDevicePtr->functions->vkGetDeviceQueue(
+						renderDevicePtr->device, info.queueFamilyIndex, static_cast<rsl::uint32>(queueIndex), &vkQueue
+					);
+					auto inputIndex = mapping.inputOrderIndex[queueIndex];
+
+					if (vkQueue == VK_NULL_HANDLE)
+					{
+						std::cout << "Failed to create queue " << inputIndex << '\n';
+						continue;
+					}
+
+					auto& queue = renderDevicePtr->queues[inputIndex];
+
+					native_queue_vk* nativeQueue = allocate<native_queue_vk>(*impl.alloc);
+					nativeQueue->alloc = impl.alloc;
+					nativeQueue->allocCallbacks = impl.allocCallbacks;
+					nativeQueue->queue = vkQueue;
+					nativeQueue->renderDevice = impl.renderDevice;
+					nativeQueue->queueIndex = inputIndex;
+					nativeQueue->familyIndex = info.queueFamilyIndex;
+					nativeQueue->family = queueFamilies[info.queueFamilyIndex];
+					nativeQueue->priority = queueDesciptions[inputIndex].priority;
+
+					set_native_handle(queue, create_native_handle(nativeQueue));
+				}
+			}
+
+			return impl.renderDevice;
+		}
+	} // namespace
+
+	[[nodiscard]] surface instance::create_surface()
+	{
+		auto& impl = get_native_ref(*this);
+
+		if (impl.applicationInfo.windowHandle == invalid_native_window_handle)
+		{
+			return {};
+		}
+
+		VkSurfaceKHR vkSurface = VK_NULL_HANDLE;
+
+#if RYTHE_PLATFORM_WINDOWS
+		VkWin32SurfaceCreateInfoKHR surfaceCreateInfo = {
+			.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR,
+			.pNext = nullptr,
+			.flags = 0,
+			.hinstance = get_hinstance(impl.applicationInfo.windowHandle),
+			.hwnd = get_hwnd(impl.applicationInfo.windowHandle),
+		};
+
+		if (impl.functions->vkCreateWin32SurfaceKHR(
+				impl.instance, &surfaceCreateInfo, impl.allocCallbacks, &vkSurface
+			) != VK_SUCCESS)
+		{
+			return {};
+		}
+#elif RYTHE_PLATFORM_LINUX
+	#ifdef RYTHE_SURFACE_XCB
+		VkXcbSurfaceCreateInfoKHR surfaceCreateInfo = {
+			.sType = VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR,
+			.pNext = nullptr,
+			.flags = 0,
+			.connection = get_connection(impl.applicationInfo.windowHandle),
+			.window = get_window(impl.applicationInfo.windowHandle),
+		};
+
+		if (impl.functions->vkCreateXcbSurfaceKHR(impl.instance, &surfaceCreateInfo, impl.allocCallbacks, &vkSurface) !=
+			VK_SUCCESS)
+		{
+			return {};
+		}
+
+	#elif RYTHE_SURFACE_XLIB
+		VkXlibSurfaceCreateInfoKHR surfaceCreateInfo = {
+			.sType = VK_STRUCTURE_TYPE_XLIB_SURFACE_CREATE_INFO_KHR,
+			.pNext = nullptr,
+			.flags = 0,
+			.dpy = get_display(impl.applicationInfo.windowHandle),
+			.window = get_window(impl.applicationInfo.windowHandle),
+		};
+
+		if (impl.functions->vkCreateXlibSurfaceKHR(
+				impl.instance, &surfaceCreateInfo, impl.allocCallbacks, &vkSurface
+			) != VK_SUCCESS)
+		{
+			return {};
+		}
+	#endif
+#endif
+
+		native_surface_vk* nativeSurface = allocate<native_surface_vk>(*impl.alloc);
+		nativeSurface->surface = vkSurface;
+		nativeSurface->alloc = impl.alloc;
+		nativeSurface->allocCallbacks = impl.allocCallbacks;
+		nativeSurface->instance = *this;
+
+		surface result;
+		set_native_handle(result, create_native_handle(nativeSurface));
+
+		return result;
+	}
+
+	[[nodiscard]] render_device instance::auto_select_and_create_device(
+		const physical_device_description& physicalDeviceDescription,
+		std::span<const queue_description> queueDesciptions, surface surface,
+		std::span<const rsl::hashed_string> extensions
+	)
+	{
+		using namespace rsl::hashed_string_literals;
+		using namespace semver::literals;
+		const bool supportsProtectedMemory = get_api_version() >= "1.1.0"_version;
+
+		for (rsl::size_type i = 0; i < queueDesciptions.size(); i++)
+		{
+			if (!supportsProtectedMemory &&
+				rsl::enum_flags::has_flag(queueDesciptions[i].requiredFeatures, queue_feature_flags::protectedMemory))
+			{
+				std::cout << "Protected memory operations are not supported for Vulkan versions prior to 1.1.0\n";
+				return {};
+			}
+		}
+
+		bool presentingApplication = get_application_info().windowHandle != invalid_native_window_handle;
+
+		std::vector<rsl::cstring> enabledExtensions;
+		std::vector<rsl::hashed_string_view> requiredExtensions;
+		enabledExtensions.reserve(extensions.size() + (presentingApplication ? 1 : 0));
+		requiredExtensions.reserve(enabledExtensions.capacity());
+
+		bool swapchainExtensionPresent = false;
+
+		constexpr auto swapchainExtensionName = MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+		for (auto& extensionName : extensions)
+		{
+			enabledExtensions.push_back(extensionName.c_str());
+
+			rsl::hashed_string_view hashStrView;
+			hashStrView.str = extensionName.c_str();
+			hashStrView.value = extensionName.value;
+			requiredExtensions.push_back(hashStrView);
+
+			if (presentingApplication && extensionName == swapchainExtensionName)
+			{
+				swapchainExtensionPresent = true;
+			}
+		}
+
+		if (presentingApplication && !swapchainExtensionPresent)
+		{
+			enabledExtensions.push_back(swapchainExtensionName.data());
+			requiredExtensions.push_back(swapchainExtensionName);
+		}
+
+		if (!presentingApplication && swapchainExtensionPresent)
+		{
+			std::cout << "Swapchain extension is activated, but no window handle was provided.\n";
+			return {};
+		}
+
+		auto selectDevice = [&](std::span<physical_device> physicalDevices)
+		{
+			rsl::size_type selectedDevice = rsl::npos;
+			rsl::size_type currentScore = 0;
+
+			for (rsl::size_type deviceIndex = 0; deviceIndex < physicalDevices.size(); deviceIndex++)
+			{
+				auto& device = physicalDevices[deviceIndex];
+				auto& props = device.get_properties();
+
+				if (props.apiVersion < physicalDeviceDescription.apiVersion)
+				{
+					continue;
+				}
+
+				if (props.limits.maxPerStageDescriptorSampledImages <
+					physicalDeviceDescription.requiredPerStageSampledImages)
+				{
+					continue;
+				}
+
+				if (!device.get_features().contains(physicalDeviceDescription.requiredFeatures))
+				{
+					continue;
+				}
+
+				if (!device.are_extensions_available(requiredExtensions))
+				{
+					continue;
+				}
+
+				std::vector<queue_family_selection> queueFamilySelections;
+				queueFamilySelections.resize(queueDesciptions.size());
+				if (!device.get_queue_family_selection(queueFamilySelections, queueDesciptions, surface))
+				{
+					continue;
+				}
+
+				rsl::size_type deviceScore = 1;
+
+				deviceScore +=
+					physicalDeviceDescription.deviceTypeImportance[static_cast<rsl::size_type>(props.deviceType)];
+
+				deviceScore += props.limits.maxImageDimension2D;
+
+				if (deviceScore > currentScore)
+				{
+					selectedDevice = deviceIndex;
+					currentScore = deviceScore;
+				}
+			}
+
+			return selectedDevice;
+		};
+
+		auto& impl = get_native_ref(*this);
+
+		auto physicalDevices = create_physical_devices();
+		const bool fromSnapshot = !physicalDevices.empty() && get_native_ref(physicalDevices.front()).fromSnapshot;
+		rsl::size_type selectedDevice = selectDevice(physicalDevices);
+
+		// Only the selected device is checked against the driver, the others keep their snapshot capabilities.
+		if (fromSnapshot && selectedDevice < physicalDevices.size() &&
+			!refresh_snapshot_device(physicalDevices[selectedDevice], surface))
+		{
+			std::cout << "Capability snapshot doesn't match the installed drivers, querying every device.\n";
+			impl.capabilitySnapshotStale = true;
+			physicalDevices = create_physical_devices(true);
+			selectedDevice = selectDevice(physicalDevices);
+		}
+
+		if (!impl.capabilitySnapshotPath.empty() && (!fromSnapshot || impl.capabilitySnapshotStale))
+		{
+			save_capability_snapshot();
+		}
+
+		if (selectedDevice >= physicalDevices.size())
+		{
+			return {};
+		}
+
+		std::vector<rsl::cstring> enabledLayers;
+		enabledLayers.reserve(impl.enabledLayers.size());
+		for (auto& layer : impl.enabledLayers) { enabledLayers.push_back(layer.name.c_str()); }
+
+		// Optional features only count when the selected device has them.
+		const physical_device_features enabledFeatures =
+			physicalDeviceDescription.requiredFeatures |
+			(physicalDeviceDescription.optionalFeatures & physicalDevices[selectedDevice].get_features());
+
+		auto result = create_render_device_no_extension_check(
+			physicalDevices[selectedDevice], queueDesciptions, enabledExtensions, enabledLayers, enabledFeatures
+		);
+
+		release_physical_devices();
+
+		return result;
+	}
+
+	bool native_instance_vk::load_functions(std::span<const rsl::cstring> extensions)
+	{
+		auto& lib = get_native_ref(graphicsLib);
+		const extension_set enabledExtensions = make_extension_set(extensions);
+		instance_dispatch_table table;
+
+#define INSTANCE_LEVEL_VULKAN_FUNCTION(name)                                                                           \
+	table.name = std::bit_cast<PFN_##name>(lib.vkGetInstanceProcAddr(instance, #name));                                \
+	if (!table.name)                                                                                                   \
+	{                                                                                                                  \
+		std::cout << "Could not load instance-level Vulkan function \"" #name "\"\n";                                  \
+		return false;                                                                                                  \
+	}
+
+#define INSTANCE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(name, extension)                                                 \
+	if (constexpr rsl::id_type extensionHash = MAKE_HASHED_STRING_VIEW_LITERAL(extension).value;                       \
+		enabledExtensions.contains(extensionHash))                                                                     \
+	{                                                                                                                  \
+		table.name = std::bit_cast<PFN_##name>(lib.vkGetInstanceProcAddr(instance, #name));                            \
+		if (!table.name)                                                                                               \
+		{                                                                                                              \
+			std::cout << "Could not load instance-level Vulkan function \"" #name "\"\n";                              \
+			return false;                                                                                              \
+		}                                                                                                              \
+	}
+
+#define INSTANCE_LEVEL_PHYSICAL_DEVICE_VULKAN_FUNCTION(name)                                                           \
+	table.name = std::bit_cast<PFN_##name>(lib.vkGetInstanceProcAddr(instance, #name));                                \
+	if (!table.name)                                                                                                   \
+	{                                                                                                                  \
+		std::cout << "Could not load instance-level Vulkan function \"" #name "\"\n";                                  \
+		return false;                                                                                                  \
+	}
+
+#define INSTANCE_LEVEL_PHYSICAL_DEVICE_VULKAN_FUNCTION_FROM_EXTENSION(name, extension)                                 \
+	if (constexpr rsl::id_type extensionHash = MAKE_HASHED_STRING_VIEW_LITERAL(extension).value;                       \
+		enabledExtensions.contains(extensionHash))                                                                     \
+	{                                                                                                                  \
+		table.name = std::bit_cast<PFN_##name>(lib.vkGetInstanceProcAddr(instance, #name));                            \
+		if (!table.name)                                                                                               \
+		{                                                                                                              \
+			std::cout << "Could not load instance-level Vulkan function \"" #name "\"\n";                              \
+			return false;                                                                                              \
+		}                                                                                                              \
+	}
+
+#define INSTANCE_LEVEL_DEVICE_VULKAN_FUNCTION(name)                                                                    \
+	table.name = std::bit_cast<PFN_##name>(lib.vkGetInstanceProcAddr(instance, #name));                                \
+	if (!table.name)                                                                                                   \
+	{                                                                                                                  \
+		std::cout << "Could not load instance-level Vulkan function \"" #name "\"\n";                                  \
+		return false;                                                                                                  \
+	}
+
+#include "impl/list_of_vulkan_functions.inl"
+
+		functions = allocate<instance_dispatch_table>(*alloc, 1, table);
+		return true;
+	}
+
+	surface::operator bool() const noexcept
+	{
+		auto ptr = get_native_ptr(*this);
+		return ptr != nullptr && ptr->surface != VK_NULL_HANDLE;
+	}
+
+	void surface::release()
+	{
+		auto impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		auto nativeInstance = get_native_ptr(impl->instance);
+		nativeInstance->functions->vkDestroySurfaceKHR(nativeInstance->instance, impl->surface, impl->allocCallbacks);
+
+		m_nativeSurface = invalid_native_surface;
+		deallocate<native_surface_vk>(*impl->alloc, impl);
+	}
+
+	physical_device::operator bool() const noexcept
+	{
+		auto ptr = get_native_ptr(*this);
+		return ptr != nullptr && ptr->physicalDevice != VK_NULL_HANDLE;
+	}
+
+	void physical_device::release()
+	{
+		auto* impl = get_native_ptr(*this);
+
+		if (!impl)
+		{
+			return;
+		}
+
+		m_nativePhysicalDevice = invalid_native_physical_device;
+		if (--impl->refCount != 0)
+		{
+			return;
+		}
+
+		deallocate<native_physical_device_vk>(*impl->alloc, impl);
+	}
+
+	namespace
+	{
+		surface_transform_flags map_vk_surface_transform_flags(VkSurfaceTransformFlagBitsKHR flags)
+		{
+			surface_transform_flags result = rsl::enum_flags::make_zero<surface_transform_flags>();
+
+			result = rsl::enum_flags::set_flag(
+				result, surface_transform_flags::identity,
+				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, surface_transform_flags::rotate90,
+				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_ROTATE_90_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, surface_transform_flags::rotate180,
+				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_ROTATE_180_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, surface_transform_flags::rotate270,
+				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_ROTATE_270_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, surface_transform_flags::horizontalMirror,
+				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_HORIZONTAL_MIRROR_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, surface_transform_flags::horizontalMirrorRotate90,
+				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_HORIZONTAL_MIRROR_ROTATE_90_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, surface_transform_flags::horizontalMirrorRotate180,
+				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_HORIZONTAL_MIRROR_ROTATE_180_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, surface_transform_flags::horizontalMirrorRotate270,
+				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_HORIZONTAL_MIRROR_ROTATE_270_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, surface_transform_flags::inherit,
+				rsl::enum_flags::has_flag(flags, VK_SURFACE_TRANSFORM_INHERIT_BIT_KHR)
+			);
+
+			return result;
+		}
+
+		composite_alpha_flags map_vk_composite_alpha_flags(VkCompositeAlphaFlagBitsKHR flags)
+		{
+			composite_alpha_flags result = rsl::enum_flags::make_zero<composite_alpha_flags>();
+
+			result = rsl::enum_flags::set_flag(
+				result, composite_alpha_flags::opaque,
+				rsl::enum_flags::has_flag(flags, VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, composite_alpha_flags::preMultiplied,
+				rsl::enum_flags::has_flag(flags, VK_COMPOSITE_ALPHA_PRE_MULTIPLIED_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, composite_alpha_flags::postMultiplied,
+				rsl::enum_flags::has_flag(flags, VK_COMPOSITE_ALPHA_POST_MULTIPLIED_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, composite_alpha_flags::inherit,
+				rsl::enum_flags::has_flag(flags, VK_COMPOSITE_ALPHA_INHERIT_BIT_KHR)
+			);
+
+			return result;
+		}
+
+		image_usage_flags map_vk_image_usage_flags(VkImageUsageFlagBits flags)
+		{
+			image_usage_flags result = rsl::enum_flags::make_zero<image_usage_flags>();
+
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::transferSrc,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::transferDst,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::sampled, rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_SAMPLED_BIT)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::storage, rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_STORAGE_BIT)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::colorAttachment,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::depthStencilAttachment,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::transientAttachment,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::inputAttachment,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::fragmentShadingRateAttachment,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::fragmentDensityMap,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_FRAGMENT_DENSITY_MAP_BIT_EXT)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::videoDecodeDst,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_VIDEO_DECODE_DST_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::videoDecodeSrc,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_VIDEO_DECODE_SRC_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::videoDecodeDpb,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_VIDEO_DECODE_DPB_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::videoEncodeDst,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_VIDEO_ENCODE_DST_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::videoEncodeSrc,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_VIDEO_ENCODE_SRC_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::videoEncodeDpb,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_VIDEO_ENCODE_DPB_BIT_KHR)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::invocationMaskHUAWEI,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_INVOCATION_MASK_BIT_HUAWEI)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::attachmentFeedbackLoop,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_ATTACHMENT_FEEDBACK_LOOP_BIT_EXT)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::sampleWeightQCOM,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_SAMPLE_WEIGHT_BIT_QCOM)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::sampleBlockMatchQCOM,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_SAMPLE_BLOCK_MATCH_BIT_QCOM)
+			);
+			result = rsl::enum_flags::set_flag(
+				result, image_usage_flags::hostTransfer,
+				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT)
+			);
+
+			return result;
+		}
+	} // namespace
+
+	const surface_capabilities& physical_device::get_surface_capabilities(surface _surface, bool forceRefresh)
+	{
+		auto& impl = get_native_ref(*this);
+
+		if (forceRefresh || !impl.surfaceCapsLoaded)
+		{
+			auto& nativeSurface = get_native_ref(_surface);
+
+			VkSurfaceCapabilitiesKHR vkSurfaceCaps;
+			impl.functions->vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
+				impl.physicalDevice, nativeSurface.surface, &vkSurfaceCaps
+			);
+
+			impl.surfaceCaps.minImageCount = static_cast<rsl::size_type>(vkSurfaceCaps.minImageCount);
+			impl.surfaceCaps.maxImageCount = static_cast<rsl::size_type>(vkSurfaceCaps.maxImageCount);
+			impl.surfaceCaps.currentExtent =
+				rsl::math::uint2(vkSurfaceCaps.currentExtent.width, vkSurfaceCaps.currentExtent.height);
+			impl.surfaceCaps.minImageExtent =
+				rsl::math::uint2(vkSurfaceCaps.minImageExtent.width, vkSurfaceCaps.minImageExtent.height);
+			impl.surfaceCaps.maxImageExtent =
+				rsl::math::uint2(vkSurfaceCaps.maxImageExtent.width, vkSurfaceCaps.maxImageExtent.height);
+			impl.surfaceCaps.maxImageArrayLayers = static_cast<rsl::size_type>(vkSurfaceCaps.maxImageArrayLayers);
+			impl.surfaceCaps.supportedTransforms = map_vk_surface_transform_flags(
+				static_cast<VkSurfaceTransformFlagBitsKHR>(vkSurfaceCaps.supportedTransforms)
+			);
+			impl.surfaceCaps.currentTransform = map_vk_surface_transform_flags(vkSurfaceCaps.currentTransform);
+			impl.surfaceCaps.supportedCompositeAlpha = map_vk_composite_alpha_flags(
+				static_cast<VkCompositeAlphaFlagBitsKHR>(vkSurfaceCaps.supportedCompositeAlpha)
+			);
+			impl.surfaceCaps.supportedUsageFlags =
+				map_vk_image_usage_flags(static_cast<VkImageUsageFlagBits>(vkSurfaceCaps.supportedUsageFlags));
+
+			impl.surfaceCapsLoaded = true;
+		}
+
+		return impl.surfaceCaps;
+	}
+
+	namespace
+	{
+		physical_device_type map_vk_physical_device_type(VkPhysicalDeviceType type)
+		{
+			switch (type)
+			{
+				case VK_PHYSICAL_DEVICE_TYPE_OTHER: return physical_device_type::other;
+				case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return physical_device_type::integratedGPU;
+				case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return physical_device_type::discreteGPU;
+				case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return physical_device_type::virtualGPU;
+				case VK_PHYSICAL_DEVICE_TYPE_CPU: return physical_device_type::CPU;
+				case VK_PHYSICAL_DEVICE_TYPE_MAX_ENUM: return physical_device_type::other;
+			}
+
+			return physical_device_type::other;
+		}
+
+		void map_vk_physical_device_limits(physical_device_limits& target, const VkPhysicalDeviceLimits& src)
+		{
+			target.maxImageDimension1D = src.maxImageDimension1D;
+			target.maxImageDimension2D = src.maxImageDimension2D;
+			target.maxImageDimension3D = src.maxImageDimension3D;
+			target.maxImageDimensionCube = src.maxImageDimensionCube;
+			target.maxImageArrayLayers = src.maxImageArrayLayers;
+			target.maxTexelBufferElements = src.maxTexelBufferElements;
+			target.maxUniformBufferRange = src.maxUniformBufferRange;
+			target.maxStorageBufferRange = src.maxStorageBufferRange;
+			target.maxPushConstantsSize = src.maxPushConstantsSize;
+			target.maxMemoryAllocationCount = src.maxMemoryAllocationCount;
+			target.maxSamplerAllocationCount = src.maxSamplerAllocationCount;
+			target.bufferImageGranularity = src.bufferImageGranularity;
+			target.sparseAddressSpaceSize = src.sparseAddressSpaceSize;
+			target.maxBoundDescriptorSets = src.maxBoundDescriptorSets;
+			target.maxPerStageDescriptorSamplers = src.maxPerStageDescriptorSamplers;
+			target.maxPerStageDescriptorUniformBuffers = src.maxPerStageDescriptorUniformBuffers;
+			target.maxPerStageDescriptorStorageBuffers = src.maxPerStageDescriptorStorageBuffers;
+			target.maxPerStageDescriptorSampledImages = src.maxPerStageDescriptorSampledImages;
+			target.maxPerStageDescriptorStorageImages = src.maxPerStageDescriptorStorageImages;
+			target.maxPerStageDescriptorInputAttachments = src.maxPerStageDescriptorInputAttachments;
+			target.maxPerStageResources = src.maxPerStageResources;
+			target.maxDescriptorSetSamplers = src.maxDescriptorSetSamplers;
+			target.maxDescriptorSetUniformBuffers = src.maxDescriptorSetUniformBuffers;
+			target.maxDescriptorSetUniformBuffersDynamic = src.maxDescriptorSetUniformBuffersDynamic;
+			target.maxDescriptorSetStorageBuffers = src.maxDescriptorSetStorageBuffers;
+			target.maxDescriptorSetStorageBuffersDynamic = src.maxDescriptorSetStorageBuffersDynamic;
+			target.maxDescriptorSetSampledImages = src.maxDescriptorSetSampledImages;
+			target.maxDescriptorSetStorageImages = src.maxDescriptorSetStorageImages;
+			target.maxDescriptorSetInputAttachments = src.maxDescriptorSetInputAttachments;
+			target.maxVertexInputAttributes = src.maxVertexInputAttributes;
+			target.maxVertexInputBindings = src.maxVertexInputBindings;
+			target.maxVertexInputAttributeOffset = src.maxVertexInputAttributeOffset;
+			target.maxVertexInputBindingStride = src.maxVertexInputBindingStride;
+			target.maxVertexOutputComponents = src.maxVertexOutputComponents;
+			target.maxTessellationGenerationLevel = src.maxTessellationGenerationLevel;
+			target.maxTessellationPatchSize = src.maxTessellationPatchSize;
+			target.maxTessellationControlPerVertexInputComponents = src.maxTessellationControlPerVertexInputComponents;
+			target.maxTessellationControlPerVertexOutputComponents =
+				src.maxTessellationControlPerVertexOutputComponents;
+			target.maxTessellationControlPerPatchOutputComponents = src.maxTessellationControlPerPatchOutputComponents;
+			target.maxTessellationControlTotalOutputComponents = src.maxTessellationControlTotalOutputComponents;
+			target.maxTessellationEvaluationInputComponents = src.maxTessellationEvaluationInputComponents;
+			target.maxTessellationEvaluationOutputComponents = src.maxTessellationEvaluationOutputComponents;
+			target.maxGeometryShaderInvocations = src.maxGeometryShaderInvocations;
+			target.maxGeometryInputComponents = src.maxGeometryInputComponents;
+			target.maxGeometryOutputComponents = src.maxGeometryOutputComponents;
+			target.maxGeometryOutputVertices = src.maxGeometryOutputVertices;
+			target.maxGeometryTotalOutputComponents = src.maxGeometryTotalOutputComponents;
+			target.maxFragmentInputComponents = src.maxFragmentInputComponents;
+			target.maxFragmentOutputAttachments = src.maxFragmentOutputAttachments;
+			target.maxFragmentDualSrcAttachments = src.maxFragmentDualSrcAttachments;
+			target.maxFragmentCombinedOutputResources = src.maxFragmentCombinedOutputResources;
+			target.maxComputeSharedMemorySize = src.maxComputeSharedMemorySize;
+			target.maxComputeWorkGroupCount[0] = src.maxComputeWorkGroupCount[0];
+			target.maxComputeWorkGroupCount[1] = src.maxComputeWorkGroupCount[1];
+			target.maxComputeWorkGroupCount[2] = src.maxComputeWorkGroupCount[2];
+			target.maxComputeWorkGroupInvocations = src.maxComputeWorkGroupInvocations;
+			target.maxComputeWorkGroupSize[0] = src.maxComputeWorkGroupSize[0];
+			target.maxComputeWorkGroupSize[1] = src.maxComputeWorkGroupSize[1];
+			target.maxComputeWorkGroupSize[2] = src.maxComputeWorkGroupSize[2];
+			target.subPixelPrecisionBits = src.subPixelPrecisionBits;
+			target.subTexelPrecisionBits = src.subTexelPrecisionBits;
+			target.mipmapPrecisionBits = src.mipmapPrecisionBits;
+			target.maxDrawIndexedIndexValue = src.maxDrawIndexedIndexValue;
+			target.maxDrawIndirectCount = src.maxDrawIndirectCount;
+			target.maxSamplerLodBias = src.maxSamplerLodBias;
+			target.maxSamplerAnisotropy = src.maxSamplerAnisotropy;
+			target.maxViewports = src.maxViewports;
+			target.maxViewportDimensions[0] = src.maxViewportDimensions[0];
+			target.maxViewportDimensions[1] = src.maxViewportDimensions[1];
+			target.viewportBoundsRange[0] = src.viewportBoundsRange[0];
+			target.viewportBoundsRange[1] = src.viewportBoundsRange[1];
+			target.viewportSubPixelBits = src.viewportSubPixelBits;
+			target.minMemoryMapAlignment = src.minMemoryMapAlignment;
+			target.minTexelBufferOffsetAlignment = src.minTexelBufferOffsetAlignment;
+			target.minUniformBufferOffsetAlignment = src.minUniformBufferOffsetAlignment;
+			target.minStorageBufferOffsetAlignment = src.minStorageBufferOffsetAlignment;
+			target.minTexelOffset = src.minTexelOffset;
+			target.maxTexelOffset = src.maxTexelOffset;
+			target.minTexelGatherOffset = src.minTexelGatherOffset;
+			target.maxTexelGatherOffset = src.maxTexelGatherOffset;
+			target.minInterpolationOffset = src.minInterpolationOffset;
+			target.maxInterpolationOffset = src.maxInterpolationOffset;
+			target.subPixelInterpolationOffsetBits = src.subPixelInterpolationOffsetBits;
+			target.maxFramebufferWidth = src.maxFramebufferWidth;
+			target.maxFramebufferHeight = src.maxFramebufferHeight;
+			target.maxFramebufferLayers = src.maxFramebufferLayers;
+			target.framebufferColorSampleCounts = static_cast<sample_count_flags>(src.framebufferColorSampleCounts);
+			target.framebufferDepthSampleCounts = static_cast<sample_count_flags>(src.framebufferDepthSampleCounts);
+			target.framebufferStencilSampleCounts = static_cast<sample_count_flags>(src.framebufferStencilSampleCounts);
+			target.framebufferNoAttachmentsSampleCounts =
+				static_cast<sample_count_flags>(src.framebufferNoAttachmentsSampleCounts);
+			target.maxColorAttachments = src.maxColorAttachments;
+			target.sampledImageColorSampleCounts = static_cast<sample_count_flags>(src.sampledImageColorSampleCounts);
+			target.sampledImageIntegerSampleCounts =
+				static_cast<sample_count_flags>(src.sampledImageIntegerSampleCounts);
+			target.sampledImageDepthSampleCounts = static_cast<sample_count_flags>(src.sampledImageDepthSampleCounts);
+			target.sampledImageStencilSampleCounts =
+				static_cast<sample_count_flags>(src.sampledImageStencilSampleCounts);
+			target.storageImageSampleCounts = static_cast<sample_count_flags>(src.storageImageSampleCounts);
+			target.maxSampleMaskWords = src.maxSampleMaskWords;
+			target.timestampComputeAndGraphics = src.timestampComputeAndGraphics == VK_TRUE;
+			target.timestampPeriod = src.timestampPeriod;
+			target.maxClipDistances = src.maxClipDistances;
+			target.maxCullDistances = src.maxCullDistances;
+			target.maxCombinedClipAndCullDistances = src.maxCombinedClipAndCullDistances;
+			target.discreteQueuePriorities = src.discreteQueuePriorities;
+			target.pointSizeRange[0] = src.pointSizeRange[0];
+			target.pointSizeRange[1] = src.pointSizeRange[1];
+			target.lineWidthRange[0] = src.lineWidthRange[0];
+			target.lineWidthRange[1] = src.lineWidthRange[1];
+			target.pointSizeGranularity = src.pointSizeGranularity;
+			target.lineWidthGranularity = src.lineWidthGranularity;
+			target.strictLines = src.strictLines == VK_TRUE;
+			target.standardSampleLocations = src.standardSampleLocations == VK_TRUE;
+			target.optimalBufferCopyOffsetAlignment = src.optimalBufferCopyOffsetAlignment;
+			target.optimalBufferCopyRowPitchAlignment = src.optimalBufferCopyRowPitchAlignment;
+			target.nonCoherentAtomSize = src.nonCoherentAtomSize;
+		}
+
+		void map_vk_physical_device_sparse_properties(
+			physical_device_sparse_properties& target, const VkPhysicalDeviceSparseProperties& src
+		)
+		{
+			target.residencyStandard2DBlockShape = src.residencyStandard2DBlockShape == VK_TRUE;
+			target.residencyStandard2DMultisampleBlockShape = src.residencyStandard2DMultisampleBlockShape == VK_TRUE;
+			target.residencyStandard3DBlockShape = src.residencyStandard3DBlockShape == VK_TRUE;
+			target.residencyAlignedMipSize = src.residencyAlignedMipSize == VK_TRUE;
+			target.residencyNonResidentStrict = src.residencyNonResidentStrict == VK_TRUE;
+		}
+	} // namespace
+
+	const physical_device_properties& physical_device::get_properties(bool forceRefresh)
+	{
+		auto& impl = get_native_ref(*this);
+
+		if (forceRefresh || !impl.propertiesLoaded)
+		{
+			VkPhysicalDeviceProperties props;
+			impl.functions->vkGetPhysicalDeviceProperties(impl.physicalDevice, &props);
+
+			impl.properties.apiVersion = decomposeVkVersion(props.apiVersion);
+			impl.properties.driverVersion = decomposeVkVersion(props.driverVersion);
+			impl.properties.rawDriverVersion = props.driverVersion;
+			impl.properties.vendorID = props.vendorID;
+			impl.properties.deviceID = props.deviceID;
+			impl.properties.deviceType = map_vk_physical_device_type(props.deviceType);
+			impl.properties.deviceName = props.deviceName;
+			std::memcpy(impl.properties.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE);
+			map_vk_physical_device_limits(impl.properties.limits, props.limits);
+			map_vk_physical_device_sparse_properties(impl.properties.sparseProperties, props.sparseProperties);
+
+			impl.propertiesLoaded = true;
+		}
+
+		return impl.properties;
+	}
+
+	namespace
+	{
+		void map_vk_physical_device_features(physical_device_features& target, const VkPhysicalDeviceFeatures& src)
+		{
+			// VkPhysicalDeviceFeatures is a plain sequence of VkBool32, in physical_device_feature order.
+			static_assert(
+				sizeof(VkPhysicalDeviceFeatures) == sizeof(VkBool32) * physical_device_features::featureCount
+			);
+			VkBool32 values[physical_device_features::featureCount];
+			std::memcpy(values, &src, sizeof(values));
+
+			target = {};
+			for (rsl::size_type i = 0; i < physical_device_features::featureCount; i++)
+			{
+				target.set(static_cast<physical_device_feature>(i), values[i] == VK_TRUE);
+			}
+		}
+	} // namespace
+
+	const physical_device_features& physical_device::get_features(bool forceRefresh)
+	{
+		auto& impl = get_native_ref(*this);
+
+		if (forceRefresh || !impl.featuresLoaded)
+		{
+			VkPhysicalDeviceFeatures features;
+			impl.functions->vkGetPhysicalDeviceFeatures(impl.physicalDevice, &features);
+			map_vk_physical_device_features(impl.features, features);
+
+			impl.featuresLoaded = true;
+		}
+
+		return impl.features;
+	}
+
+	const descriptor_indexing_capabilities& physical_device::get_descriptor_indexing_capabilities(bool forceRefresh)
+	{
+		auto& impl = get_native_ref(*this);
+
+		if (forceRefresh || !impl.descriptorIndexingLoaded)
+		{
+			impl.descriptorIndexing = {};
+
+			VkPhysicalDeviceDescriptorIndexingFeaturesEXT features;
+			VkPhysicalDeviceDescriptorIndexingPropertiesEXT properties;
+			if (query_descriptor_indexing(*this, features, properties))
+			{
+				map_vk_descriptor_indexing(impl.descriptorIndexing, features, properties);
+			}
+
+			impl.descriptorIndexingLoaded = true;
+		}
+
+		return impl.descriptorIndexing;
+	}
+
+	std::span<const extension_properties> physical_device::get_available_extensions(bool forceRefresh)
+	{
+		auto& impl = get_native_ref(*this);
+
+		if (forceRefresh || impl.availableExtensions.empty())
+		{
+			rsl::uint32 extensionCount = 0;
+
+			VkResult result = impl.functions->vkEnumerateDeviceExtensionProperties(
+				impl.physicalDevice, nullptr, &extensionCount, nullptr
+			);
+			if (result != VK_SUCCESS || extensionCount == 0)
+			{
+				std::cout << "Count not query the number of device extensions.\n";
+				return {};
+			}
+
+			std::vector<VkExtensionProperties> extensionPropertiesBuffer;
+			extensionPropertiesBuffer.resize(extensionCount);
+			result = impl.functions->vkEnumerateDeviceExtensionProperties(
+				impl.physicalDevice, nullptr, &extensionCount, extensionPropertiesBuffer.data()
+			);
+
+			if (result != VK_SUCCESS || extensionCount == 0)
+			{
+				std::cout << "Could not enumerate device extensions.\n";
+				return {};
+			}
+
+			impl.availableExtensions.clear();
+			impl.availableExtensions.reserve(extensionCount);
+			for (auto& extension : extensionPropertiesBuffer)
+			{
+				impl.availableExtensions.push_back(extension_properties{
+					.name = rsl::hashed_string(extension.extensionName),
+					.specVersion = decomposeVkVersion(extension.specVersion),
+				});
+			}
+
+			build_name_index<extension_properties>(impl.availableExtensionIndex, impl.availableExtensions);
+		}
+
+		return impl.availableExtensions;
+	}
+
+	bool physical_device::is_extension_available(rsl::hashed_string_view extensionName)
+	{
+		get_available_extensions();
+		return get_native_ref(*this).availableExtensionIndex.contains(extensionName.value);
+	}
+
+	bool physical_device::are_extensions_available(std::span<const rsl::hashed_string_view> extensionNames)
+	{
+		get_available_extensions();
+		return contains_all_names(get_native_ref(*this).availableExtensionIndex, extensionNames);
+	}
+
+	namespace
+	{
+		queue_feature_flags map_vk_queue_features(VkQueueFlags features, bool supportsPresent)
+		{
+			return rsl::enum_flags::set_flag(
+				static_cast<queue_feature_flags>(features), queue_feature_flags::present, supportsPresent
+			);
+		}
+	} // namespace
+
+	std::span<const queue_family_properties>
+	physical_device::get_available_queue_families(surface surface, bool forceRefresh)
+	{
+		auto& impl = get_native_ref(*this);
+
+		if (forceRefresh || impl.availableQueueFamilies.empty())
+		{
+			rsl::uint32 queueFamilyCount = 0;
+
+			impl.functions->vkGetPhysicalDeviceQueueFamilyProperties(impl.physicalDevice, &queueFamilyCount, nullptr);
+			if (queueFamilyCount == 0)
+			{
+				std::cout << "Count not query the number of queue families.\n";
+				return {};
+			}
+
+			std::vector<VkQueueFamilyProperties> queueFamiliesBuffer;
+			queueFamiliesBuffer.resize(queueFamilyCount);
+			impl.functions->vkGetPhysicalDeviceQueueFamilyProperties(
+				impl.physicalDevice, &queueFamilyCount, queueFamiliesBuffer.data()
+			);
+
+			if (queueFamilyCount == 0)
+			{
+				std::cout << "Could not get queue family properties.\n";
+				return {};
+			}
+
+			impl.availableQueueFamilies.clear();
+			impl.availableQueueFamilies.reserve(queueFamilyCount);
+
+			auto& nativeInstance = get_native_ref(impl.instance);
+
+			bool surfaceCreated = false;
+			if (!surface)
+			{
+				surface = impl.instance.create_surface();
+				surfaceCreated = true;
+			}
+
+			auto* nativeSurface = get_native_ptr(surface);
+
+			for (rsl::uint32 queueFamilyIndex = 0; queueFamilyIndex < queueFamilyCount; queueFamilyIndex++)
+			{
+				auto& queueFamily = queueFamiliesBuffer[queueFamilyIndex];
+
+				VkBool32 supportsPresent = VK_FALSE;
+
+				if (nativeSurface)
+				{
+					if (nativeInstance.functions->vkGetPhysicalDeviceSurfaceSupportKHR(
+							impl.physicalDevice, queueFamilyIndex, nativeSurface->surface, &supportsPresent
+						) != VK_SUCCESS)
+					{
+						supportsPresent = VK_FALSE;
+					}
+				}
+
+				impl.availableQueueFamilies.push_back({
+					.features = map_vk_queue_features(queueFamily.queueFlags, supportsPresent == VK_TRUE),
+					.queueCount = queueFamily.queueCount,
+					.timestampValidBits = queueFamily.timestampValidBits,
+					.minImageTransferGranularity =
+						rsl::math::uint3{
+										 queueFamily.minImageTransferGranularity.width,
+										 queueFamily.minImageTransferGranularity.height,
+										 queueFamily.minImageTransferGranularity.depth,
+										 },
+				});
+			}
+
+			if (surfaceCreated)
+			{
+				surface.release();
+			}
+		}
+
+		return impl.availableQueueFamilies;
+	}
+
+	bool physical_device::get_queue_family_selection(
+		std::span<queue_family_selection> queueFamilySelections, std::span<const queue_description> queueDesciptions,
+		surface surface
+	)
+	{
+		for (rsl::size_type i = 0; i < queueDesciptions.size(); i++)
+		{
+			queueFamilySelections[i].familyIndex = queueDesciptions[i].queueFamilyIndexOverride;
+		}
+
+		auto queueFamilies = get_available_queue_families(surface);
+
+		for (rsl::size_type queueIndex = 0; queueIndex < queueDesciptions.size(); queueIndex++)
+		{
+			auto& queueDesciption = queueDesciptions[queueIndex];
+			auto& selectionInfo = queueFamilySelections[queueIndex];
+
+			selectionInfo.familyIndex = rsl::npos;
+			for (rsl::size_type familyIndex = 0; familyIndex < queueFamilies.size(); familyIndex++)
+			{
+				auto& queueFamily = queueFamilies[familyIndex];
+
+				if (queueDesciption.queueFamilyIndexOverride != rsl::npos ||
+					!rsl::enum_flags::has_all_flags(queueFamily.features, queueDesciption.requiredFeatures) ||
+					queueFamily.queueCount == 0)
+				{
+					continue;
+				}
+
+				rsl::size_type score = 1;
+
+				score += queueFamily.queueCount * queueDesciption.queueCountImportance;
+				score += queueFamily.timestampValidBits * queueDesciption.timestampImportance;
+
+				if (queueDesciption.imageTransferGranularityImportance != 0ull)
+				{
+					rsl::size_type maxScore = 128ull * queueDesciption.imageTransferGranularityImportance;
+
+					score += maxScore - rsl::math::min(
+											maxScore, ((queueFamily.minImageTransferGranularity.x +
+														queueFamily.minImageTransferGranularity.y +
+														queueFamily.minImageTransferGranularity.z) /
+													   3u) *
+														  queueDesciption.imageTransferGranularityImportance
+										);
+				}
+
+				if (score > selectionInfo.score)
+				{
+					selectionInfo.familyIndex = familyIndex;
+					selectionInfo.score = score;
+				}
+			}
+
+			if (selectionInfo.familyIndex == rsl::npos)
+			{
+				std::cout << "No compatible queue family found for queue " << queueIndex << '\n';
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool physical_device::in_use() const noexcept
+	{
+		return get_native_ref(*this).renderDevice;
+	}
+
+	[[nodiscard]] render_device physical_device::create_render_device(
+		std::span<const queue_description> queueDesciptions, std::span<const rsl::hashed_string> extensions,
+		const physical_device_features& features
+	)
+	{
+		using namespace rsl::hashed_string_literals;
+
+		auto& impl = get_native_ref(*this);
+
+		bool presentingApplication = impl.instance.get_application_info().windowHandle != invalid_native_window_handle;
+
+		std::vector<rsl::cstring> enabledExtensions;
+		enabledExtensions.reserve(extensions.size() + (presentingApplication ? 1 : 0));
+
+		bool swapchainExtensionPresent = false;
+
+		for (auto& extensionName : extensions)
+		{
+			if (is_extension_available(extensionName))
+			{
+				enabledExtensions.push_back(extensionName.c_str());
+			}
+			else
+			{
+				std::cout << "Extension \"" << extensionName << "\" is not available.\n";
+			}
+
+			if (presentingApplication &&
+				extensionName == MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_SWAPCHAIN_EXTENSION_NAME))
+			{
+				swapchainExtensionPresent = true;
+			}
+		}
+
+		if (presentingApplication && !swapchainExtensionPresent)
+		{
+			enabledExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+		}
+
+		const rsl::uint32 apiVersion = get_device_api_version(*this);
+
+		// Dynamic rendering is core in 1.3, older devices get the extension when they have it.
+		if (apiVersion < VK_API_VERSION_1_3 &&
+			!contains_extension(enabledExtensions, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) &&
+			is_extension_available(MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)))
+		{
+			enabledExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+		}
+
+		// Extended dynamic state 1 and 2 are core in 1.3 as well. Extended dynamic state 3 and graphics pipeline
+		// libraries are enabled whenever available, so pipelines leave as much state dynamic as the device allows and
+		// are linked from shared libraries.
+		auto enableIfAvailable = [&](rsl::cstring extension, rsl::hashed_string_view hashedExtension) {
+			if (!contains_extension(enabledExtensions, extension) && is_extension_available(hashedExtension))
+			{
+				enabledExtensions.push_back(extension);
+			}
+		};
+
+		if (apiVersion < VK_API_VERSION_1_3)
+		{
+			enableIfAvailable(
+				VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME,
+				MAKE_HASHED_STRING_VIEW_LITERAL(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)
+			);
+			enableIfAvailable(
+				VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME,
+				MAKE_HASHED_STRING_VIEW_LITERAL(VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME)
+			);
+		}
+		enableIfAvailable(
+			VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME,
+			MAKE_HASHED_STRING_VIEW_LITERAL(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)
+		);
+		enableIfAvailable(
+			VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME,
+			MAKE_HASHED_STRING_VIEW_LITERAL(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)
+		);
+
+		// Present ids and present waits let swapchains measure when frames actually reach the display.
+		if (presentingApplication &&
+			is_extension_available(MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_PRESENT_ID_EXTENSION_NAME)) &&
+			is_extension_available(MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_PRESENT_WAIT_EXTENSION_NAME)))
+		{
+			enableIfAvailable(
+				VK_KHR_PRESENT_ID_EXTENSION_NAME, MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_PRESENT_ID_EXTENSION_NAME)
+			);
+			enableIfAvailable(
+				VK_KHR_PRESENT_WAIT_EXTENSION_NAME, MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_PRESENT_WAIT_EXTENSION_NAME)
+			);
+		}
+
+		struct extension_dependency
+		{
+			rsl::cstring extension;
+			rsl::cstring dependency;
+			rsl::uint32 coreVersion;
+		};
+
+		// Dependencies that aren't core yet in the device's API version. Dependencies of dependencies come later in
+		// the list, so a single pass resolves everything.
+		constexpr rsl::uint32 neverCore = ~0u;
+		constexpr extension_dependency extensionDependencies[] = {
+			{
+				.extension = VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME,
+				.dependency = VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME,
+				.coreVersion = neverCore,
+			},
+			{
+				.extension = VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
+				.dependency = VK_KHR_MAINTENANCE3_EXTENSION_NAME,
+				.coreVersion = VK_API_VERSION_1_1,
+			},
+			{
+				.extension = VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
+				.dependency = VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME,
+				.coreVersion = VK_API_VERSION_1_2,
+			},
+			{
+				.extension = VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME,
+				.dependency = VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME,
+				.coreVersion = VK_API_VERSION_1_2,
+			},
+			{
+				.extension = VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME,
+				.dependency = VK_KHR_MULTIVIEW_EXTENSION_NAME,
+				.coreVersion = VK_API_VERSION_1_1,
+			},
+			{
+				.extension = VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME,
+				.dependency = VK_KHR_MAINTENANCE2_EXTENSION_NAME,
+				.coreVersion = VK_API_VERSION_1_1,
+			},
+		};
+
+		for (auto& [extension, dependency, coreVersion] : extensionDependencies)
+		{
+			if (apiVersion < coreVersion && contains_extension(enabledExtensions, extension) &&
+				!contains_extension(enabledExtensions, dependency))
+			{
+				enabledExtensions.push_back(dependency);
+			}
+		}
+
+		if (!presentingApplication && swapchainExtensionPresent)
+		{
+			std::cout << "Swapchain extension is activated, but no window handle was provided.\n";
+			return {};
+		}
+
+		auto& instancePtr = get_native_ref(impl.instance);
+		std::vector<rsl::cstring> enabledLayers;
+		enabledLayers.reserve(instancePtr.enabledLayers.size());
+		for (auto& layer : instancePtr.enabledLayers) { enabledLayers.push_back(layer.name.c_str()); }
+
+		return create_render_device_no_extension_check(
+			*this, queueDesciptions, enabledExtensions, enabledLayers, features
+		);
+	}
+
+	render_device::operator bool() const noexcept
+	{
+		auto ptr = get_native_ptr(*this);
+		return ptr != nullptr && ptr->device != VK_NULL_HANDLE;
+	}
+
+	void render_device::release()
+	{
+		auto* impl = get_native_ptr(*this);
+
+		if (!impl)
+		{
+			return;
+		}
+
+		{
+			std::lock_guard lock(impl->linkMutex);
+			impl->stopLinkWorker = true;
+		}
+		impl->linkCondition.notify_all();
+		if (impl->linkWorker.joinable())
+		{
+			impl->linkWorker.join();
+		}
+
+		// Links that never ran still hold a reference to their pipeline.
+		for (auto& link : impl->pendingLinks) { link.target.release(); }
+		impl->pendingLinks.clear();
+
+		for (auto& [key, cached] : impl->pipelineLibraries)
+		{
+			impl->functions->vkDestroyPipeline(impl->device, cached.library, impl->allocCallbacks);
+		}
+		impl->pipelineLibraries.clear();
+
+		for (auto& [key, cached] : impl->framebuffers)
+		{
+			impl->functions->vkDestroyFramebuffer(impl->device, cached.framebuffer, impl->allocCallbacks);
+		}
+		impl->framebuffers.clear();
+		impl->framebuffersByImageView.clear();
+
+		for (auto& retired : impl->retiredImageViews)
+		{
+			for (VkFramebuffer framebuffer : retired.framebuffers)
+			{
+				impl->functions->vkDestroyFramebuffer(impl->device, framebuffer, impl->allocCallbacks);
+			}
+			impl->functions->vkDestroyImageView(impl->device, retired.imageView, impl->allocCallbacks);
+		}
+		impl->retiredImageViews.clear();
+
+		impl->functions->vkDestroyDevice(impl->device, impl->allocCallbacks);
+		deallocate<device_dispatch_table>(*impl->alloc, const_cast<device_dispatch_table*>(impl->functions));
+
+		get_native_ref(get_native_ref(impl->physicalDevice).instance).renderDeviceCount--;
+		impl->physicalDevice.release();
+
+		m_nativeRenderDevice = invalid_native_render_device;
+		deallocate<native_render_device_vk>(*impl->alloc, impl);
+	}
+
+	std::span<queue> render_device::get_queues() noexcept
+	{
+		return get_native_ref(*this).queues;
+	}
+
+	physical_device render_device::get_physical_device() const noexcept
+	{
+		return get_native_ref(*this).physicalDevice;
+	}
+
+	semver::version render_device::get_api_version() const noexcept
+	{
+		return decomposeVkVersion(get_native_ref(*this).apiVersion);
+	}
+
+	bool render_device::supports_dynamic_rendering() const noexcept
+	{
+		return get_native_ref(*this).dynamicRendering;
+	}
+
+	dynamic_state_flags render_device::get_dynamic_state_support() const noexcept
+	{
+		return get_native_ref(*this).dynamicStateSupport;
+	}
+
+	bool render_device::supports_graphics_pipeline_library() const noexcept
+	{
+		return get_native_ref(*this).graphicsPipelineLibrary;
+	}
+
+	bool render_device::supports_present_wait() const noexcept
+	{
+		return get_native_ref(*this).presentWait;
+	}
+
+	const physical_device_features& render_device::get_enabled_features() const noexcept
+	{
+		return get_native_ref(*this).enabledFeatures;
+	}
+
+	namespace
+	{
+		struct pipeline_cache_file_header
+		{
+			constexpr static rsl::uint32 expectedMagic = 0x50434b56; // "VKCP"
+			constexpr static rsl::uint32 expectedVersion = 2;
+
+			rsl::uint32 magic;
+			rsl::uint32 version;
+			rsl::uint32 vendorID;
+			rsl::uint32 deviceID;
+			rsl::uint32 driverVersion;
+			rsl::uint8 pipelineCacheUUID[VK_UUID_SIZE];
+			rsl::uint64 dataSize;
+			rsl::uint64 dataHash;
+		};
+
+		[[nodiscard]] pipeline_cache_file_header make_pipeline_cache_file_header(const physical_device_properties& props
+		) noexcept
+		{
+			pipeline_cache_file_header header{};
+			header.magic = pipeline_cache_file_header::expectedMagic;
+			header.version = pipeline_cache_file_header::expectedVersion;
+			header.vendorID = props.vendorID;
+			header.deviceID = props.deviceID;
+			header.driverVersion = props.rawDriverVersion;
+			std::memcpy(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE);
+			return header;
+		}
+
+		[[nodiscard]] bool is_pipeline_cache_file_compatible(
+			const pipeline_cache_file_header& header, const physical_device_properties& props
+		) noexcept
+		{
+			const pipeline_cache_file_header expected = make_pipeline_cache_file_header(props);
+
+			return header.magic == expected.magic && header.version == expected.version &&
+				   header.vendorID == expected.vendorID && header.deviceID == expected.deviceID &&
+				   header.driverVersion == expected.driverVersion &&
+				   std::memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+		}
+
+		[[nodiscard]] std::vector<rsl::byte>
+		read_pipeline_cache_file(const std::filesystem::path& filePath, const physical_device_properties& props)
+		{
+			std::ifstream file(filePath, std::ios::binary);
+			if (!file)
+			{
+				return {};
+			}
+
+			pipeline_cache_file_header header;
+			if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+			{
+				std::cout << "Pipeline cache file " << filePath << " is truncated, ignoring it.\n";
+				return {};
+			}
+
+			if (!is_pipeline_cache_file_compatible(header, props))
+			{
+				std::cout << "Pipeline cache file " << filePath
+						  << " was written by another device or driver, ignoring it.\n";
+				return {};
+			}
+
+			// The size comes from disk, check it against the file before allocating for it.
+			std::error_code error;
+			const std::uintmax_t fileSize = std::filesystem::file_size(filePath, error);
+			if (error || header.dataSize != fileSize - sizeof(header))
+			{
+				std::cout << "Pipeline cache file " << filePath << " is corrupt, ignoring it.\n";
+				return {};
+			}
+
+			std::vector<rsl::byte> data;
+			data.resize(header.dataSize);
+			if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())) ||
+				hash_bytes(data) != header.dataHash)
+			{
+				std::cout << "Pipeline cache file " << filePath << " is corrupt, ignoring it.\n";
+				return {};
+			}
+
+			return data;
+		}
+	} // namespace
+
+	[[nodiscard]] pipeline_cache render_device::create_pipeline_cache(std::string_view filePath)
+	{
+		auto& impl = get_native_ref(*this);
+
+		std::vector<rsl::byte> initialData;
+		if (!filePath.empty())
+		{
+			initialData = read_pipeline_cache_file(filePath, impl.physicalDevice.get_properties());
+		}
+
+		VkPipelineCacheCreateInfo pipelineCacheCreateInfo{
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.initialDataSize = initialData.size(),
+			.pInitialData = initialData.data(),
+		};
+
+		VkPipelineCache vkPipelineCache = VK_NULL_HANDLE;
+		VkResult result = impl.functions->vkCreatePipelineCache(
+			impl.device, &pipelineCacheCreateInfo, impl.allocCallbacks, &vkPipelineCache
+		);
+
+		if (result != VK_SUCCESS && !initialData.empty())
+		{
+			std::cout << "Driver rejected pipeline cache data from \"" << filePath << "\", starting empty.\n";
+
+			pipelineCacheCreateInfo.initialDataSize = 0;
+			pipelineCacheCreateInfo.pInitialData = nullptr;
+			result = impl.functions->vkCreatePipelineCache(
+				impl.device, &pipelineCacheCreateInfo, impl.allocCallbacks, &vkPipelineCache
+			);
+		}
+
+		if (result != VK_SUCCESS || vkPipelineCache == VK_NULL_HANDLE)
+		{
+			std::cout << "Failed to create pipeline cache\n";
+			return {};
+		}
+
+		native_pipeline_cache_vk* nativePipelineCache = allocate<native_pipeline_cache_vk>(*impl.alloc);
+		nativePipelineCache->renderDevice = *this;
+		nativePipelineCache->alloc = impl.alloc;
+		nativePipelineCache->allocCallbacks = impl.allocCallbacks;
+		nativePipelineCache->filePath = filePath;
+		nativePipelineCache->pipelineCache = vkPipelineCache;
+
+		pipeline_cache pipelineCache;
+		set_native_handle(pipelineCache, create_native_handle(nativePipelineCache));
+		return pipelineCache;
+	}
+
+	bool native_render_device_vk::load_functions(std::span<const rsl::cstring> extensions)
+	{
+		const extension_set enabledExtensions = make_extension_set(extensions);
+		auto vkGetDeviceProcAddr = instanceFunctions->vkGetDeviceProcAddr;
+		device_dispatch_table table;
+
+#define DEVICE_LEVEL_VULKAN_FUNCTION(name)                                                                             \
+	table.name = std::bit_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name));                                        \
+	if (!table.name)                                                                                                   \
+	{                                                                                                                  \
+		std::cout << "Could not load device-level Vulkan function \"" #name "\"\n";                                    \
+		return false;                                                                                                  \
+	}
+
+#define DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(name, extension)                                                   \
+	if (constexpr rsl::id_type extensionHash = MAKE_HASHED_STRING_VIEW_LITERAL(extension).value;                       \
+		enabledExtensions.contains(extensionHash))                                                                     \
+	{                                                                                                                  \
+		table.name = std::bit_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name));                                    \
+		if (!table.name)                                                                                               \
+		{                                                                                                              \
+			std::cout << "Could not load device-level Vulkan function \"" #name "\"\n";                                \
+			return false;                                                                                              \
+		}                                                                                                              \
+	}
+
+#define DEVICE_LEVEL_VULKAN_FUNCTION_FROM_VERSION(name, version)                                                       \
+	if (apiVersion >= version)                                                                                         \
+	{                                                                                                                  \
+		table.name = std::bit_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name));                                    \
+		if (!table.name)                                                                                               \
+		{                                                                                                              \
+			std::cout << "Could not load device-level Vulkan function \"" #name "\"\n";                                \
+			return false;                                                                                              \
+		}                                                                                                              \
+	}
+
+#include "impl/list_of_vulkan_functions.inl"
+
+		// Pre 1.3 devices get the KHR and EXT entry points under the core names.
+		if (!table.vkCmdBeginRendering)
+		{
+			table.vkCmdBeginRendering = table.vkCmdBeginRenderingKHR;
+			table.vkCmdEndRendering = table.vkCmdEndRenderingKHR;
+		}
+
+		if (!table.vkCmdSetCullMode)
+		{
+			table.vkCmdSetCullMode = table.vkCmdSetCullModeEXT;
+			table.vkCmdSetFrontFace = table.vkCmdSetFrontFaceEXT;
+			table.vkCmdSetPrimitiveTopology = table.vkCmdSetPrimitiveTopologyEXT;
+			table.vkCmdSetDepthTestEnable = table.vkCmdSetDepthTestEnableEXT;
+			table.vkCmdSetDepthWriteEnable = table.vkCmdSetDepthWriteEnableEXT;
+			table.vkCmdSetDepthCompareOp = table.vkCmdSetDepthCompareOpEXT;
+		}
+
+		if (!table.vkCmdSetPrimitiveRestartEnable)
+		{
+			table.vkCmdSetPrimitiveRestartEnable = table.vkCmdSetPrimitiveRestartEnableEXT;
+			table.vkCmdSetDepthBiasEnable = table.vkCmdSetDepthBiasEnableEXT;
+		}
+
+		functions = allocate<device_dispatch_table>(*alloc, 1, table);
+		return true;
+	}
+
+	queue::operator bool() const noexcept
+	{
+		auto* impl = get_native_ptr(*this);
+		return impl != nullptr && impl->queue != VK_NULL_HANDLE;
+	}
+
+	void queue::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		m_nativeQueue = invalid_native_queue;
+		deallocate<native_queue_vk>(*impl->alloc, impl);
+	}
+
+	rsl::size_type queue::get_index() const noexcept
+	{
+		return get_native_ref(*this).queueIndex;
+	}
+
+	rsl::size_type queue::get_family_index() const noexcept
+	{
+		return get_native_ref(*this).familyIndex;
+	}
+
+	queue_priority queue::get_priority() const noexcept
+	{
+		return get_native_ref(*this).priority;
+	}
+
+	const queue_family_properties& queue::get_family() const noexcept
+	{
+		return get_native_ref(*this).family;
+	}
+
+	bool queue::submit(std::span<const command_buffer> commandBuffers)
+	{
+		auto& impl = get_native_ref(*this);
+		auto& renderDevice = get_native_ref(impl.renderDevice);
+
+		std::vector<VkCommandBuffer> vkCommandBuffers;
+		vkCommandBuffers.reserve(commandBuffers.size());
+		for (auto& commandBuffer : commandBuffers)
+		{
+			vkCommandBuffers.push_back(get_native_ref(commandBuffer).commandBuffer);
+		}
+
+		const VkSubmitInfo submitInfo{
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+			.pNext = nullptr,
+			.waitSemaphoreCount = 0,
+			.pWaitSemaphores = nullptr,
+			.pWaitDstStageMask = nullptr,
+			.commandBufferCount = static_cast<rsl::uint32>(vkCommandBuffers.size()),
+			.pCommandBuffers = vkCommandBuffers.data(),
+			.signalSemaphoreCount = 0,
+			.pSignalSemaphores = nullptr,
+		};
+
+		if (renderDevice.functions->vkQueueSubmit(impl.queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+		{
+			std::cout << "Failed to submit to queue " << impl.queueIndex << '\n';
+			return false;
+		}
+
+		return true;
+	}
+
+	bool queue::wait_idle()
+	{
+		auto& impl = get_native_ref(*this);
+		return get_native_ref(impl.renderDevice).functions->vkQueueWaitIdle(impl.queue) == VK_SUCCESS;
+	}
+
+	namespace
+	{
+		bool create_command_pool(queue q, command_pool& commandPool, VkCommandPoolCreateFlags flags)
+		{
+			auto& impl = get_native_ref(q);
+			auto& renderDevice = get_native_ref(impl.renderDevice);
+			const VkCommandPoolCreateInfo commandPoolCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = flags,
+				.queueFamilyIndex = static_cast<rsl::uint32>(impl.familyIndex),
+			};
+
+			VkCommandPool vkCommandPool = VK_NULL_HANDLE;
+			VkResult result = renderDevice.functions->vkCreateCommandPool(
+				renderDevice.device, &commandPoolCreateInfo, impl.allocCallbacks, &vkCommandPool
+			);
+
+			if (result != VK_SUCCESS || vkCommandPool == VK_NULL_HANDLE)
+			{
+				std::cout << "Failed to create command pool for queue " << impl.queueIndex << '\n';
+				return false;
+			}
+
+			native_command_pool_vk* nativeCommandPool = allocate<native_command_pool_vk>(*impl.alloc);
+
+			nativeCommandPool->alloc = impl.alloc;
+			nativeCommandPool->allocCallbacks = impl.allocCallbacks;
+			nativeCommandPool->commandPool = vkCommandPool;
+			nativeCommandPool->renderDevice = impl.renderDevice;
+
+			set_native_handle(commandPool, create_native_handle(nativeCommandPool));
+			return true;
+		}
+	} // namespace
+
+	[[nodiscard]] persistent_command_pool queue::create_persistent_command_pool(bool protectedCommandBuffers)
+	{
+		persistent_command_pool commandPool;
+
+		if (!create_command_pool(
+				*this, commandPool,
+				VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT |
+					(protectedCommandBuffers ? VK_COMMAND_POOL_CREATE_PROTECTED_BIT : 0)
+			))
+		{
+			return {};
+		}
+
+		return commandPool;
+	}
+
+	transient_command_pool queue::create_transient_command_pool(bool protectedCommandBuffers)
+	{
+		transient_command_pool commandPool;
+
+		if (!create_command_pool(
+				*this, commandPool,
+				VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
+					(protectedCommandBuffers ? VK_COMMAND_POOL_CREATE_PROTECTED_BIT : 0)
+			))
+		{
+			return {};
+		}
+
+		return commandPool;
+	}
+
+	namespace
+	{
+		bool create_command_buffers(
+			native_command_pool_vk& impl, std::span<command_buffer> buffers,
+			std::span<VkCommandBuffer> commandBuffersBuffer, command_buffer_level level
+		)
+		{
+			rsl_assert_consistent(buffers.size() <= commandBuffersBuffer.size());
+
+			auto& renderDevice = get_native_ref(impl.renderDevice);
+
+			const VkCommandBufferAllocateInfo commandBufferAllocateInfo = {
+				.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+				.pNext = nullptr,
+				.commandPool = impl.commandPool,
+				.level =
+					(level == command_buffer_level::primary ? VK_COMMAND_BUFFER_LEVEL_PRIMARY
+															: VK_COMMAND_BUFFER_LEVEL_SECONDARY),
+				.commandBufferCount = static_cast<rsl::uint32>(buffers.size()),
+			};
+
+			VkResult result = renderDevice.functions->vkAllocateCommandBuffers(
+				renderDevice.device, &commandBufferAllocateInfo, commandBuffersBuffer.data()
+			);
+
+			if (result != VK_SUCCESS)
+			{
+				return false;
+			}
+
+			for (rsl::size_type i = 0; i < buffers.size(); i++)
+			{
+				command_buffer& buffer = buffers[i];
+				auto* nativeCommandBuffer = get_native_ptr(buffer);
+				if (!nativeCommandBuffer)
+				{
+					nativeCommandBuffer = allocate<native_command_buffer_vk>(*impl.alloc);
+					set_native_handle(buffer, create_native_handle(nativeCommandBuffer));
+				}
+
+				nativeCommandBuffer->device = impl.renderDevice;
+				nativeCommandBuffer->nextUnusedIndex = i + 1;
+				nativeCommandBuffer->indexInPool = i;
+				nativeCommandBuffer->level = level;
+				nativeCommandBuffer->commandBuffer = commandBuffersBuffer[i];
+			}
+
+			return true;
+		}
+	} // namespace
+
+	command_pool::operator bool() const noexcept
+	{
+		auto* impl = get_native_ptr(*this);
+		return impl != nullptr && impl->commandPool != VK_NULL_HANDLE;
+	}
+
+	void persistent_command_pool::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		for (auto& commandBuffer : impl->primaryCommandBuffers.commandBuffers)
+		{
+			auto* ptr = get_native_ptr(commandBuffer);
+			if (ptr)
+			{
+				deallocate<native_command_buffer_vk>(*impl->alloc, ptr);
+			}
+		}
+
+		for (auto& commandBuffer : impl->secondaryCommandBuffers.commandBuffers)
+		{
+			auto* ptr = get_native_ptr(commandBuffer);
+			if (ptr)
+			{
+				deallocate<native_command_buffer_vk>(*impl->alloc, ptr);
+			}
+		}
+
+		auto& renderDevice = get_native_ref(impl->renderDevice);
+
+		renderDevice.functions->vkDestroyCommandPool(renderDevice.device, impl->commandPool, impl->allocCallbacks);
+
+		m_nativeCommandPool = invalid_native_command_pool;
+		deallocate<native_command_pool_vk>(*impl->alloc, impl);
+	}
+
+	rsl::size_type persistent_command_pool::get_capacity(command_buffer_level level) const noexcept
+	{
+		auto& impl = get_native_ref(*this);
+		return level == command_buffer_level::primary ? impl.primaryCommandBuffers.commandBuffers.size()
+													  : impl.secondaryCommandBuffers.commandBuffers.size();
+	}
+
+	rsl::size_type persistent_command_pool::get_unused_count(command_buffer_level level) const noexcept
+	{
+		auto& impl = get_native_ref(*this);
+		return level == command_buffer_level::primary ? impl.primaryCommandBuffers.unusedCount
+													  : impl.secondaryCommandBuffers.unusedCount;
+	}
+
+	void persistent_command_pool::reserve(rsl::size_type count, command_buffer_level level)
+	{
+		auto& impl = get_native_ref(*this);
+
+		auto& commandBufferPool =
+			level == command_buffer_level::primary ? impl.primaryCommandBuffers : impl.secondaryCommandBuffers;
+
+		auto oldCount = commandBufferPool.commandBuffers.size();
+
+		if (oldCount >= count)
+		{
+			return;
+		}
+
+		rsl::size_type additionalCount = count - oldCount;
+		commandBufferPool.commandBuffers.resize(count);
+		if (additionalCount > impl.commandBuffersBuffer.size())
+		{
+			impl.commandBuffersBuffer.resize(additionalCount);
+		}
+
+        [[maybe_unused]]bool result = create_command_buffers(
+			impl, std::span(commandBufferPool.commandBuffers.data() + oldCount, additionalCount),
+			impl.commandBuffersBuffer, level
+		);
+		rsl_soft_assert_msg_consistent(result, "failed to create command buffer");
+
+		commandBufferPool.unusedCount += additionalCount;
+	}
+
+	command_buffer persistent_command_pool::get_command_buffer(command_buffer_level level)
+	{
+		auto& impl = get_native_ref(*this);
+
+		auto& commandBufferPool =
+			level == command_buffer_level::primary ? impl.primaryCommandBuffers : impl.secondaryCommandBuffers;
+
+		if (commandBufferPool.unusedCount == 0)
+		{
+			reserve(commandBufferPool.lastUnusedIndex + 1, level);
+		}
+		else
+		{
+			rsl_assert_consistent(commandBufferPool.lastUnusedIndex < commandBufferPool.commandBuffers.size());
+		}
+
+		command_buffer commandBuffer = commandBufferPool.commandBuffers[commandBufferPool.lastUnusedIndex];
+
+		auto& nativeCommandBuffer = get_native_ref(commandBuffer);
+		nativeCommandBuffer.commandPoolStorage.set(*this);
+		commandBufferPool.lastUnusedIndex = nativeCommandBuffer.nextUnusedIndex;
+		commandBufferPool.unusedCount--;
+
+		return commandBuffer;
+	}
+
+	void persistent_command_pool::return_command_buffer(command_buffer& commandBuffer)
+	{
+		auto& impl = get_native_ref(*this);
+		auto& nativeCommandBuffer = get_native_ref(commandBuffer);
+
+
+		auto& commandBufferPool = nativeCommandBuffer.level == command_buffer_level::primary
+									  ? impl.primaryCommandBuffers
+									  : impl.secondaryCommandBuffers;
+
+		nativeCommandBuffer.nextUnusedIndex = commandBufferPool.lastUnusedIndex;
+		commandBufferPool.lastUnusedIndex = nativeCommandBuffer.indexInPool;
+		commandBufferPool.unusedCount++;
+
+		set_native_handle(commandBuffer, invalid_native_command_buffer);
+	}
+
+	void transient_command_pool::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		auto& renderDevice = get_native_ref(impl->renderDevice);
+
+		renderDevice.functions->vkDestroyCommandPool(renderDevice.device, impl->commandPool, impl->allocCallbacks);
+
+		m_nativeCommandPool = invalid_native_command_pool;
+		deallocate<native_command_pool_vk>(*impl->alloc, impl);
+	}
+
+	rsl::size_type transient_command_pool::get_capacity([[maybe_unused]] command_buffer_level level) const noexcept
+	{
+		return rsl::size_type();
+	}
+
+	rsl::size_type transient_command_pool::get_unused_count([[maybe_unused]] command_buffer_level level) const noexcept
+	{
+		return rsl::size_type();
+	}
+
+	void
+	transient_command_pool::reserve([[maybe_unused]] rsl::size_type count, [[maybe_unused]] command_buffer_level level)
+	{
+	}
+
+	command_buffer transient_command_pool::get_command_buffer([[maybe_unused]] command_buffer_level level)
+	{
+		return command_buffer();
+	}
+
+	void transient_command_pool::return_command_buffer([[maybe_unused]] command_buffer& commandBuffer) {}
+
+	command_buffer::operator bool() const noexcept
+	{
+		auto* impl = get_native_ptr(*this);
+		return impl && impl->commandBuffer != VK_NULL_HANDLE;
+	}
+
+	void command_buffer::return_to_pool()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (impl)
+		{
+			impl->get_pool().return_command_buffer(*this);
+		}
+	}
+
+	namespace
+	{
+		[[nodiscard]] VkRenderingAttachmentInfoKHR
+		make_rendering_attachment_info(const rendering_attachment& attachment, bool colorAttachment)
+		{
+			VkClearValue clearValue;
+			if (colorAttachment)
+			{
+				std::copy_n(attachment.clearValue.color, 4, clearValue.color.float32);
+			}
+			else
+			{
+				clearValue.depthStencil = VkClearDepthStencilValue{
+					.depth = attachment.clearValue.depth,
+					.stencil = attachment.clearValue.stencil,
+				};
+			}
+
+			return VkRenderingAttachmentInfoKHR{
+				.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR,
+				.pNext = nullptr,
+				.imageView = std::bit_cast<VkImageView>(attachment.imageView),
+				.imageLayout = static_cast<VkImageLayout>(attachment.layout),
+				.resolveMode = VK_RESOLVE_MODE_NONE,
+				.resolveImageView = VK_NULL_HANDLE,
+				.resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+				.loadOp = static_cast<VkAttachmentLoadOp>(attachment.loadOp),
+				.storeOp = static_cast<VkAttachmentStoreOp>(attachment.storeOp),
+				.clearValue = clearValue,
+			};
+		}
+	} // namespace
+
+	bool command_buffer::begin_rendering(const rendering_description& description)
+	{
+		auto& impl = get_native_ref(*this);
+		auto& renderDevice = get_native_ref(impl.device);
+
+		if (!renderDevice.dynamicRendering)
+		{
+			std::cout << "Dynamic rendering isn't supported by the render device\n";
+			return false;
+		}
+
+		if (description.colorAttachments.size() > max_rendering_color_attachments)
+		{
+			std::cout << "Dynamic rendering supports at most " << max_rendering_color_attachments
+					  << " color attachments\n";
+			return false;
+		}
+
+		// Kept on the stack, beginning rendering happens every frame.
+		VkRenderingAttachmentInfoKHR colorAttachments[max_rendering_color_attachments];
+		rsl::uint32 colorAttachmentCount = 0;
+		for (auto& attachment : description.colorAttachments)
+		{
+			colorAttachments[colorAttachmentCount++] = make_rendering_attachment_info(attachment, true);
+		}
+
+		const VkRenderingAttachmentInfoKHR depthAttachment =
+			make_rendering_attachment_info(description.depthAttachment, false);
+		const VkRenderingAttachmentInfoKHR stencilAttachment =
+			make_rendering_attachment_info(description.stencilAttachment, false);
+
+		const VkRenderingInfoKHR renderingInfo{
+			.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR,
+			.pNext = nullptr,
+			.flags = 0,
+			.renderArea =
+				VkRect2D{
+					.offset = {.x = description.renderAreaOffset.x, .y = description.renderAreaOffset.y},
+					.extent = {.width = description.renderAreaExtent.x, .height = description.renderAreaExtent.y},
+				},
+			.layerCount = description.layerCount,
+			.viewMask = 0,
+			.colorAttachmentCount = colorAttachmentCount,
+			.pColorAttachments = colorAttachments,
+			.pDepthAttachment =
+				description.depthAttachment.imageView != invalid_image_view_handle ? &depthAttachment : nullptr,
+			.pStencilAttachment =
+				description.stencilAttachment.imageView != invalid_image_view_handle ? &stencilAttachment : nullptr,
+		};
+
+		renderDevice.functions->vkCmdBeginRendering(impl.commandBuffer, &renderingInfo);
+		return true;
+	}
+
+	void command_buffer::end_rendering()
+	{
+		auto& impl = get_native_ref(*this);
+		get_native_ref(impl.device).functions->vkCmdEndRendering(impl.commandBuffer);
+	}
+
+	bool command_buffer::begin()
+	{
+		auto& impl = get_native_ref(*this);
+
+		if (impl.level != command_buffer_level::primary)
+		{
+			std::cout << "Secondary command buffers need inheritance info to begin\n";
+			return false;
+		}
+
+		const VkCommandBufferBeginInfo beginInfo{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.pNext = nullptr,
+			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+			.pInheritanceInfo = nullptr,
+		};
+
+		if (get_native_ref(impl.device).functions->vkBeginCommandBuffer(impl.commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			std::cout << "Failed to begin command buffer\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	bool command_buffer::end()
+	{
+		auto& impl = get_native_ref(*this);
+
+		if (get_native_ref(impl.device).functions->vkEndCommandBuffer(impl.commandBuffer) != VK_SUCCESS)
+		{
+			std::cout << "Failed to end command buffer\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	namespace
+	{
+		struct layout_access
+		{
+			VkPipelineStageFlags stages;
+			VkAccessFlags access;
+		};
+
+		[[nodiscard]] layout_access get_layout_access(image_layout layout)
+		{
+			switch (layout)
+			{
+				case image_layout::undefined: return {VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0};
+				case image_layout::general:
+					return {VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT};
+				case image_layout::colorAttachmentOptimal:
+					return {
+						VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+						VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+					};
+				case image_layout::depthStencilAttachmentOptimal:
+					return {
+						VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+						VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+					};
+				case image_layout::depthStencilReadOnlyOptimal:
+					return {
+						VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+							VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+						VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+					};
+				case image_layout::shaderReadOnlyOptimal:
+					return {
+						VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+							VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+						VK_ACCESS_SHADER_READ_BIT,
+					};
+				case image_layout::transferSrcOptimal:
+					return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT};
+				case image_layout::transferDstOptimal:
+					return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT};
+				case image_layout::presentSrc: return {VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0};
+			}
+
+			return {VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT};
+		}
+
+		constexpr VkImageSubresourceRange firstColorSubresource{
+			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1,
+		};
+	} // namespace
+
+	void command_buffer::transition_image_layout(image_handle image, image_layout oldLayout, image_layout newLayout)
+	{
+		auto& impl = get_native_ref(*this);
+
+		const layout_access source = get_layout_access(oldLayout);
+		const layout_access destination = get_layout_access(newLayout);
+
+		const VkImageMemoryBarrier barrier{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+			.pNext = nullptr,
+			.srcAccessMask = source.access,
+			.dstAccessMask = destination.access,
+			.oldLayout = static_cast<VkImageLayout>(oldLayout),
+			.newLayout = static_cast<VkImageLayout>(newLayout),
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = std::bit_cast<VkImage>(image),
+			.subresourceRange = firstColorSubresource,
+		};
+
+		get_native_ref(impl.device).functions->vkCmdPipelineBarrier(
+			impl.commandBuffer, source.stages, destination.stages, 0, 0, nullptr, 0, nullptr, 1, &barrier
+		);
+	}
+
+	void command_buffer::clear_color_image(image_handle image, image_layout layout, const clear_value& value)
+	{
+		auto& impl = get_native_ref(*this);
+
+		VkClearColorValue clearColor;
+		std::copy_n(value.color, 4, clearColor.float32);
+
+		get_native_ref(impl.device).functions->vkCmdClearColorImage(
+			impl.commandBuffer, std::bit_cast<VkImage>(image), static_cast<VkImageLayout>(layout), &clearColor, 1,
+			&firstColorSubresource
+		);
+	}
+
+	void command_buffer::bind_pipeline(const pipeline& pipeline)
+	{
+		auto& impl = get_native_ref(*this);
+		auto& nativePipeline = get_native_ref(pipeline);
+
+		const VkPipelineBindPoint bindPoint = nativePipeline.bindPoint == pipeline_bind_point::compute
+												  ? VK_PIPELINE_BIND_POINT_COMPUTE
+												  : VK_PIPELINE_BIND_POINT_GRAPHICS;
+
+		// Fast-linked pipelines switch to their optimized version as soon as the link worker has finished it.
+		VkPipeline vkPipeline = nativePipeline.optimizedPipeline.load(std::memory_order_acquire);
+		if (!vkPipeline)
+		{
+			vkPipeline = nativePipeline.pipeline;
+		}
+		get_native_ref(impl.device).functions->vkCmdBindPipeline(impl.commandBuffer, bindPoint, vkPipeline);
+	}
+
+	void command_buffer::bind_descriptor_sets(
+		const pipeline& pipeline, rsl::uint32 firstSet, std::span<const descriptor_set> sets
+	)
+	{
+		auto& impl = get_native_ref(*this);
+		auto& nativePipeline = get_native_ref(pipeline);
+
+		const VkPipelineBindPoint bindPoint = nativePipeline.bindPoint == pipeline_bind_point::compute
+												  ? VK_PIPELINE_BIND_POINT_COMPUTE
+												  : VK_PIPELINE_BIND_POINT_GRAPHICS;
+
+		// descriptor_set is the raw handle, so the span can be passed on as is.
+		static_assert(sizeof(descriptor_set) == sizeof(VkDescriptorSet));
+		get_native_ref(impl.device).functions->vkCmdBindDescriptorSets(
+			impl.commandBuffer, bindPoint, nativePipeline.pipelineLayout, firstSet,
+			static_cast<rsl::uint32>(sets.size()), reinterpret_cast<const VkDescriptorSet*>(sets.data()), 0, nullptr
+		);
+	}
+
+	void command_buffer::push_constants(
+		const pipeline& pipeline, shader_stage_flags stages, rsl::uint32 offset, std::span<const rsl::byte> data
+	)
+	{
+		auto& impl = get_native_ref(*this);
+		get_native_ref(impl.device).functions->vkCmdPushConstants(
+			impl.commandBuffer, get_native_ref(pipeline).pipelineLayout, static_cast<VkShaderStageFlags>(stages),
+			offset, static_cast<rsl::uint32>(data.size()), data.data()
+		);
+	}
+
+	void command_buffer::dispatch(rsl::uint32 groupCountX, rsl::uint32 groupCountY, rsl::uint32 groupCountZ)
+	{
+		auto& impl = get_native_ref(*this);
+		get_native_ref(impl.device).functions->vkCmdDispatch(impl.commandBuffer, groupCountX, groupCountY, groupCountZ);
+	}
+
+	void command_buffer::set_dynamic_state(
+		const graphics_pipeline_description& description, dynamic_state_flags dynamicState
+	)
+	{
+		using enum dynamic_state_flags;
+		using rsl::enum_flags::has_flag;
+
+		auto& impl = get_native_ref(*this);
+		auto& renderDevice = get_native_ref(impl.device);
+		const VkCommandBuffer commandBuffer = impl.commandBuffer;
+		auto& rasterization = description.rasterization;
+		auto& depthStencil = description.depthStencil;
+
+		if (has_flag(dynamicState, cullMode))
+		{
+			renderDevice.functions->vkCmdSetCullMode(
+				commandBuffer, static_cast<VkCullModeFlags>(rasterization.cullMode)
+			);
+		}
+		if (has_flag(dynamicState, frontFace))
+		{
+			renderDevice.functions->vkCmdSetFrontFace(commandBuffer, static_cast<VkFrontFace>(rasterization.frontFace));
+		}
+		if (has_flag(dynamicState, primitiveTopology))
+		{
+			renderDevice.functions->vkCmdSetPrimitiveTopology(
+				commandBuffer, static_cast<VkPrimitiveTopology>(description.topology)
+			);
+		}
+		if (has_flag(dynamicState, primitiveRestartEnable))
+		{
+			renderDevice.functions->vkCmdSetPrimitiveRestartEnable(
+				commandBuffer, description.primitiveRestartEnable ? VK_TRUE : VK_FALSE
+			);
+		}
+		if (has_flag(dynamicState, depthTestEnable))
+		{
+			renderDevice.functions->vkCmdSetDepthTestEnable(
+				commandBuffer, depthStencil.depthTestEnable ? VK_TRUE : VK_FALSE
+			);
+		}
+		if (has_flag(dynamicState, depthWriteEnable))
+		{
+			renderDevice.functions->vkCmdSetDepthWriteEnable(
+				commandBuffer, depthStencil.depthWriteEnable ? VK_TRUE : VK_FALSE
+			);
+		}
+		if (has_flag(dynamicState, depthCompareOp))
+		{
+			renderDevice.functions->vkCmdSetDepthCompareOp(
+				commandBuffer, static_cast<VkCompareOp>(depthStencil.depthCompareOp)
+			);
+		}
+		if (has_flag(dynamicState, depthBiasEnable))
+		{
+			renderDevice.functions->vkCmdSetDepthBiasEnable(
+				commandBuffer, rasterization.depthBiasEnable ? VK_TRUE : VK_FALSE
+			);
+		}
+		if (has_flag(dynamicState, polygonMode))
+		{
+			renderDevice.functions->vkCmdSetPolygonModeEXT(
+				commandBuffer, static_cast<VkPolygonMode>(rasterization.polygonMode)
+			);
+		}
+		if (has_flag(dynamicState, depthClampEnable))
+		{
+			renderDevice.functions->vkCmdSetDepthClampEnableEXT(
+				commandBuffer, rasterization.depthClampEnable ? VK_TRUE : VK_FALSE
+			);
+		}
+
+		if (!has_flag(dynamicState, colorBlendEnable) && !has_flag(dynamicState, colorBlendEquation) &&
+			!has_flag(dynamicState, colorWriteMask))
+		{
+			return;
+		}
+
+		if (description.colorBlendAttachments.size() > max_rendering_color_attachments)
+		{
+			std::cout << "Dynamic blend state supports at most " << max_rendering_color_attachments
+					  << " color attachments\n";
+			return;
+		}
+
+		// Kept on the stack like the attachments in begin_rendering, this runs for every pipeline bind.
+		VkBool32 blendEnables[max_rendering_color_attachments];
+		VkColorBlendEquationEXT blendEquations[max_rendering_color_attachments];
+		VkColorComponentFlags writeMasks[max_rendering_color_attachments];
+		rsl::uint32 attachmentCount = 0;
+		for (auto& attachment : description.colorBlendAttachments)
+		{
+			blendEnables[attachmentCount] = attachment.blendEnable ? VK_TRUE : VK_FALSE;
+			blendEquations[attachmentCount] = VkColorBlendEquationEXT{
+				.srcColorBlendFactor = static_cast<VkBlendFactor>(attachment.srcColorBlendFactor),
+				.dstColorBlendFactor = static_cast<VkBlendFactor>(attachment.dstColorBlendFactor),
+				.colorBlendOp = static_cast<VkBlendOp>(attachment.colorBlendOp),
+				.srcAlphaBlendFactor = static_cast<VkBlendFactor>(attachment.srcAlphaBlendFactor),
+				.dstAlphaBlendFactor = static_cast<VkBlendFactor>(attachment.dstAlphaBlendFactor),
+				.alphaBlendOp = static_cast<VkBlendOp>(attachment.alphaBlendOp),
+			};
+			writeMasks[attachmentCount] = static_cast<VkColorComponentFlags>(attachment.colorWriteMask);
+			attachmentCount++;
+		}
+
+		if (attachmentCount == 0)
+		{
+			return;
+		}
+
+		if (has_flag(dynamicState, colorBlendEnable))
+		{
+			renderDevice.functions->vkCmdSetColorBlendEnableEXT(commandBuffer, 0, attachmentCount, blendEnables);
+		}
+		if (has_flag(dynamicState, colorBlendEquation))
+		{
+			renderDevice.functions->vkCmdSetColorBlendEquationEXT(commandBuffer, 0, attachmentCount, blendEquations);
+		}
+		if (has_flag(dynamicState, colorWriteMask))
+		{
+			renderDevice.functions->vkCmdSetColorWriteMaskEXT(commandBuffer, 0, attachmentCount, writeMasks);
+		}
+	}
+
+	pipeline_cache::operator bool() const noexcept
+	{
+		auto* impl = get_native_ptr(*this);
+		return impl != nullptr && impl->pipelineCache != VK_NULL_HANDLE;
+	}
+
+	void pipeline_cache::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		auto& renderDevice = get_native_ref(impl->renderDevice);
+		renderDevice.functions->vkDestroyPipelineCache(renderDevice.device, impl->pipelineCache, impl->allocCallbacks);
+
+		m_nativePipelineCache = invalid_native_pipeline_cache;
+		deallocate<native_pipeline_cache_vk>(*impl->alloc, impl);
+	}
+
+	bool pipeline_cache::save()
+	{
+		auto& impl = get_native_ref(*this);
+		if (impl.filePath.empty())
+		{
+			std::cout << "Pipeline cache has no file path to save to.\n";
+			return false;
+		}
+
+		return save(impl.filePath);
+	}
+
+	bool pipeline_cache::save(std::string_view filePath)
+	{
+		auto& impl = get_native_ref(*this);
+		auto& renderDevice = get_native_ref(impl.renderDevice);
+
+		rsl::size_type dataSize = 0;
+		VkResult result =
+			renderDevice.functions->vkGetPipelineCacheData(renderDevice.device, impl.pipelineCache, &dataSize, nullptr);
+		if (result != VK_SUCCESS)
+		{
+			std::cout << "Could not query the pipeline cache data size.\n";
+			return false;
+		}
+
+		std::vector<rsl::byte> data;
+		data.resize(dataSize);
+		result = renderDevice.functions->vkGetPipelineCacheData(
+			renderDevice.device, impl.pipelineCache, &dataSize, data.data()
+		);
+		if (result != VK_SUCCESS)
+		{
+			std::cout << "Could not retrieve the pipeline cache data.\n";
+			return false;
+		}
+		data.resize(dataSize);
+
+		pipeline_cache_file_header header =
+			make_pipeline_cache_file_header(renderDevice.physicalDevice.get_properties());
+		header.dataSize = data.size();
+		header.dataHash = hash_bytes(data);
+
+		return write_file_atomically(
+			filePath, std::span<const rsl::byte>(reinterpret_cast<const rsl::byte*>(&header), sizeof(header)), data,
+			"pipeline cache"
+		);
+	}
+
+	bool pipeline_cache::merge(std::span<const pipeline_cache> sourceCaches)
+	{
+		auto& impl = get_native_ref(*this);
+		auto& renderDevice = get_native_ref(impl.renderDevice);
+
+		std::vector<VkPipelineCache> vkSourceCaches;
+		vkSourceCaches.reserve(sourceCaches.size());
+		for (auto& sourceCache : sourceCaches)
+		{
+			auto* source = get_native_ptr(sourceCache);
+			if (source && source != &impl)
+			{
+				vkSourceCaches.push_back(source->pipelineCache);
+			}
+		}
+
+		if (vkSourceCaches.empty())
+		{
+			return true;
+		}
+
+		VkResult result = renderDevice.functions->vkMergePipelineCaches(
+			renderDevice.device, impl.pipelineCache, static_cast<rsl::uint32>(vkSourceCaches.size()),
+			vkSourceCaches.data()
+		);
+
+		if (result != VK_SUCCESS)
+		{
+			std::cout << "Failed to merge pipeline caches\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	rsl::size_type pipeline_cache::get_data_size() const
+	{
+		auto& impl = get_native_ref(*this);
+		auto& renderDevice = get_native_ref(impl.renderDevice);
+
+		rsl::size_type dataSize = 0;
+		if (renderDevice.functions->vkGetPipelineCacheData(
+				renderDevice.device, impl.pipelineCache, &dataSize, nullptr
+			) != VK_SUCCESS)
+		{
+			return 0;
+		}
+
+		return dataSize;
+	}
+
+	std::string_view pipeline_cache::get_file_path() const noexcept
+	{
+		return get_native_ref(*this).filePath;
+	}
+
+	namespace
+	{
+		namespace spirv
+		{
+			constexpr rsl::uint32 magic = 0x07230203;
+			constexpr rsl::size_type headerWordCount = 5;
+			// The universal limit on the id bound from the SPIR-V spec, anything above it is rejected before the per
+			// id tables are allocated.
+			constexpr rsl::uint32 maxBound = 4'194'303;
+			// Deepest type nesting get_spirv_type_size follows, real shaders stay far below it.
+			constexpr rsl::uint32 maxTypeDepth = 64;
+
+			enum struct op : rsl::uint16
+			{
+				entryPoint = 15,
+				typeBool = 20,
+				typeInt = 21,
+				typeFloat = 22,
+				typeVector = 23,
+				typeMatrix = 24,
+				typeImage = 25,
+				typeSampler = 26,
+				typeSampledImage = 27,
+				typeArray = 28,
+				typeRuntimeArray = 29,
+				typeStruct = 30,
+				typePointer = 32,
+				constant = 43,
+				variable = 59,
+				decorate = 71,
+				memberDecorate = 72,
+			};
+
+			enum struct decoration : rsl::uint32
+			{
+				block = 2,
+				bufferBlock = 3,
+				arrayStride = 6,
+				matrixStride = 7,
+				builtIn = 11,
+				location = 30,
+				binding = 33,
+				descriptorSet = 34,
+				offset = 35,
+			};
+
+			enum struct storage_class : rsl::uint32
+			{
+				uniformConstant = 0,
+				input = 1,
+				uniform = 2,
+				pushConstant = 9,
+				storageBuffer = 12,
+			};
+
+			enum struct dim : rsl::uint32
+			{
+				buffer = 5,
+				subpassData = 6,
+			};
+
+			constexpr rsl::uint32 unset = ~0u;
+
+			// Words up to and including the last operand reflection reads, shorter instructions are malformed.
+			[[nodiscard]] constexpr rsl::uint32 get_min_word_count(op opCode) noexcept
+			{
+				switch (opCode)
+				{
+					case op::typeBool: [[fallthrough]];
+					case op::typeSampler: [[fallthrough]];
+					case op::typeStruct: return 2;
+					case op::typeFloat: [[fallthrough]];
+					case op::typeSampledImage: [[fallthrough]];
+					case op::typeRuntimeArray: return 3;
+					case op::typeInt: [[fallthrough]];
+					case op::typeVector: [[fallthrough]];
+					case op::typeMatrix: [[fallthrough]];
+					case op::typeArray: [[fallthrough]];
+					case op::typePointer: [[fallthrough]];
+					case op::constant: [[fallthrough]];
+					case op::variable: return 4;
+					case op::typeImage: return 9;
+					default: return 1;
+				}
+			}
+		} // namespace spirv
+
+		// Only the ids reflection cares about are tracked, everything else is skipped while parsing.
+		struct spirv_module_info
+		{
+			std::span<const rsl::uint32> code;
+
+			std::vector<rsl::size_type> definitions;
+			std::vector<rsl::uint32> descriptorSets;
+			std::vector<rsl::uint32> bindings;
+			std::vector<rsl::uint32> locations;
+			std::vector<rsl::uint32> arrayStrides;
+			std::vector<bool> builtIns;
+			std::vector<bool> blocks;
+			std::vector<bool> bufferBlocks;
+
+			std::unordered_map<rsl::uint64, rsl::uint32> memberOffsets;
+			std::unordered_map<rsl::uint64, rsl::uint32> memberMatrixStrides;
+			std::unordered_map<rsl::uint64, bool> memberBuiltIns;
+
+			std::vector<rsl::size_type> variables;
+
+			// Buffer layout sizes of types without a MatrixStride override, filled in by get_spirv_type_size. unset
+			// until computed, 0 while being computed so a type that contains itself ends the recursion.
+			std::vector<rsl::uint32> typeSizes;
+
+			[[nodiscard]] spirv::op get_op(rsl::uint32 id) const noexcept
+			{
+				return static_cast<spirv::op>(code[definitions[id]] & 0xFFFF);
+			}
+
+			// parse_spirv checked that every defining instruction fits in code with this word count.
+			[[nodiscard]] rsl::uint32 get_word_count(rsl::uint32 id) const noexcept
+			{
+				return code[definitions[id]] >> 16;
+			}
+
+			// Operands past the end of the defining instruction read as 0.
+			[[nodiscard]] rsl::uint32 get_operand(rsl::uint32 id, rsl::size_type operand) const noexcept
+			{
+				return operand + 1 < get_word_count(id) ? code[definitions[id] + 1 + operand] : 0;
+			}
+
+			[[nodiscard]] bool is_defined(rsl::uint32 id) const noexcept
+			{
+				return id < definitions.size() && definitions[id] != 0;
+			}
+		};
+
+		[[nodiscard]] constexpr rsl::uint64 make_member_key(rsl::uint32 structId, rsl::uint32 member) noexcept
+		{
+			return (static_cast<rsl::uint64>(structId) << 32) | member;
+		}
+
+		[[nodiscard]] bool
+		parse_spirv(std::span<const rsl::uint32> code, spirv_module_info& info, shader_stage_flags& stage)
+		{
+			if (code.size() < spirv::headerWordCount || code[0] != spirv::magic)
+			{
+				return false;
+			}
+
+			const rsl::uint32 bound = code[3];
+			if (bound > spirv::maxBound)
+			{
+				return false;
+			}
+
+			info.code = code;
+			info.definitions.assign(bound, 0);
+			info.descriptorSets.assign(bound, spirv::unset);
+			info.bindings.assign(bound, spirv::unset);
+			info.locations.assign(bound, spirv::unset);
+			info.arrayStrides.assign(bound, 0);
+			info.builtIns.assign(bound, false);
+			info.blocks.assign(bound, false);
+			info.bufferBlocks.assign(bound, false);
+			info.typeSizes.assign(bound, spirv::unset);
+
+			bool foundEntryPoint = false;
+
+			for (rsl::size_type offset = spirv::headerWordCount; offset < code.size();)
+			{
+				const rsl::uint32 wordCount = code[offset] >> 16;
+				const auto opCode = static_cast<spirv::op>(code[offset] & 0xFFFF);
+
+				if (wordCount == 0 || offset + wordCount > code.size() || wordCount < spirv::get_min_word_count(opCode))
+				{
+					return false;
+				}
+
+				auto operand = [&](rsl::size_type index) -> rsl::uint32 {
+					return index + 1 < wordCount ? code[offset + 1 + index] : 0;
+				};
+
+				auto define = [&](rsl::uint32 id) {
+					if (id < bound)
+					{
+						info.definitions[id] = offset;
+					}
+				};
+
+				switch (opCode)
+				{
+					case spirv::op::entryPoint:
+					{
+						if (!foundEntryPoint)
+						{
+							// Execution models 0-5 are vertex through GLCompute, which map onto consecutive stage bits.
+							const rsl::uint32 executionModel = operand(0);
+							if (executionModel <= 5)
+							{
+								stage = static_cast<shader_stage_flags>(1u << executionModel);
+							}
+							foundEntryPoint = true;
+						}
+						break;
+					}
+					case spirv::op::typeBool: [[fallthrough]];
+					case spirv::op::typeInt: [[fallthrough]];
+					case spirv::op::typeFloat: [[fallthrough]];
+					case spirv::op::typeVector: [[fallthrough]];
+					case spirv::op::typeMatrix: [[fallthrough]];
+					case spirv::op::typeImage: [[fallthrough]];
+					case spirv::op::typeSampler: [[fallthrough]];
+					case spirv::op::typeSampledImage: [[fallthrough]];
+					case spirv::op::typeArray: [[fallthrough]];
+					case spirv::op::typeRuntimeArray: [[fallthrough]];
+					case spirv::op::typeStruct: [[fallthrough]];
+					case spirv::op::typePointer: define(operand(0)); break;
+					case spirv::op::constant: define(operand(1)); break;
+					case spirv::op::variable:
+					{
+						define(operand(1));
+						info.variables.push_back(offset);
+						break;
+					}
+					case spirv::op::decorate:
+					{
+						const rsl::uint32 target = operand(0);
+						if (target >= bound)
+						{
+							break;
+						}
+
+						switch (static_cast<spirv::decoration>(operand(1)))
+						{
+							case spirv::decoration::block: info.blocks[target] = true; break;
+							case spirv::decoration::bufferBlock: info.bufferBlocks[target] = true; break;
+							case spirv::decoration::arrayStride: info.arrayStrides[target] = operand(2); break;
+							case spirv::decoration::builtIn: info.builtIns[target] = true; break;
+							case spirv::decoration::location: info.locations[target] = operand(2); break;
+							case spirv::decoration::binding: info.bindings[target] = operand(2); break;
+							case spirv::decoration::descriptorSet: info.descriptorSets[target] = operand(2); break;
+							default: break;
+						}
+						break;
+					}
+					case spirv::op::memberDecorate:
+					{
+						const rsl::uint64 key = make_member_key(operand(0), operand(1));
+						switch (static_cast<spirv::decoration>(operand(2)))
+						{
+							case spirv::decoration::offset: info.memberOffsets[key] = operand(3); break;
+							case spirv::decoration::matrixStride: info.memberMatrixStrides[key] = operand(3); break;
+							case spirv::decoration::builtIn: info.memberBuiltIns[key] = true; break;
+							default: break;
+						}
+						break;
+					}
+					default: break;
+				}
+
+				offset += wordCount;
+			}
+
+			return foundEntryPoint;
+		}
+
+		[[nodiscard]] rsl::uint32 get_spirv_constant(const spirv_module_info& info, rsl::uint32 id) noexcept
+		{
+			if (!info.is_defined(id) || info.get_op(id) != spirv::op::constant)
+			{
+				return 1;
+			}
+
+			return info.get_operand(id, 2);
+		}
+
+		// Byte size of a type as laid out in a buffer block, relying on the Offset/ArrayStride/MatrixStride decorations
+		// the compiler emits for explicitly laid out types. Sizes are memoized in info.typeSizes, so shared member
+		// types are only walked once, and nesting deeper than spirv::maxTypeDepth counts as 0.
+		[[nodiscard]] rsl::uint32 get_spirv_type_size(
+			spirv_module_info& info, rsl::uint32 typeId, rsl::uint32 matrixStride = 0, rsl::uint32 depth = 0
+		) noexcept
+		{
+			if (!info.is_defined(typeId) || depth > spirv::maxTypeDepth)
+			{
+				return 0;
+			}
+
+			const spirv::op opCode = info.get_op(typeId);
+			if (opCode == spirv::op::typeMatrix && matrixStride != 0)
+			{
+				return info.get_operand(typeId, 2) * matrixStride;
+			}
+
+			if (info.typeSizes[typeId] != spirv::unset)
+			{
+				return info.typeSizes[typeId];
+			}
+			info.typeSizes[typeId] = 0;
+
+			rsl::uint32 size = 0;
+			switch (opCode)
+			{
+				case spirv::op::typeBool: size = 4; break;
+				case spirv::op::typeInt: [[fallthrough]];
+				case spirv::op::typeFloat: size = info.get_operand(typeId, 1) / 8; break;
+				case spirv::op::typeVector: [[fallthrough]];
+				case spirv::op::typeMatrix:
+					size = info.get_operand(typeId, 2) *
+						   get_spirv_type_size(info, info.get_operand(typeId, 1), 0, depth + 1);
+					break;
+				case spirv::op::typeArray:
+				{
+					const rsl::uint32 length = get_spirv_constant(info, info.get_operand(typeId, 2));
+					const rsl::uint32 stride = info.arrayStrides[typeId];
+					const rsl::uint32 elementType = info.get_operand(typeId, 1);
+					size = length * (stride != 0 ? stride : get_spirv_type_size(info, elementType, 0, depth + 1));
+					break;
+				}
+				case spirv::op::typeStruct:
+				{
+					const rsl::uint32 memberCount = info.get_word_count(typeId) - 2;
+					for (rsl::uint32 member = 0; member < memberCount; member++)
+					{
+						const rsl::uint64 key = make_member_key(typeId, member);
+						const auto offsetIter = info.memberOffsets.find(key);
+						const auto strideIter = info.memberMatrixStrides.find(key);
+
+						const rsl::uint32 memberOffset =
+							offsetIter != info.memberOffsets.end() ? offsetIter->second : size;
+						const rsl::uint32 memberSize = get_spirv_type_size(
+							info, info.get_operand(typeId, 1 + member),
+							strideIter != info.memberMatrixStrides.end() ? strideIter->second : 0, depth + 1
+						);
+						size = std::max(size, memberOffset + memberSize);
+					}
+					break;
+				}
+				default: break;
+			}
+
+			info.typeSizes[typeId] = size;
+			return size;
+		}
+
+		[[nodiscard]] rsl::uint32 get_spirv_struct_start(const spirv_module_info& info, rsl::uint32 structId) noexcept
+		{
+			if (!info.is_defined(structId) || info.get_op(structId) != spirv::op::typeStruct)
+			{
+				return 0;
+			}
+
+			rsl::uint32 start = ~0u;
+			const rsl::uint32 memberCount = info.get_word_count(structId) - 2;
+			for (rsl::uint32 member = 0; member < memberCount; member++)
+			{
+				auto iter = info.memberOffsets.find(make_member_key(structId, member));
+				start = std::min(start, iter != info.memberOffsets.end() ? iter->second : 0u);
+			}
+			return memberCount != 0 ? start : 0;
+		}
+
+		[[nodiscard]] bool get_spirv_descriptor_type(
+			const spirv_module_info& info, spirv::storage_class storageClass, rsl::uint32 typeId, descriptor_type& type
+		) noexcept
+		{
+			if (storageClass == spirv::storage_class::storageBuffer)
+			{
+				type = descriptor_type::storageBuffer;
+				return true;
+			}
+
+			if (storageClass == spirv::storage_class::uniform)
+			{
+				if (info.bufferBlocks[typeId])
+				{
+					type = descriptor_type::storageBuffer;
+					return true;
+				}
+
+				type = descriptor_type::uniformBuffer;
+				return info.blocks[typeId];
+			}
+
+			if (storageClass != spirv::storage_class::uniformConstant)
+			{
+				return false;
+			}
+
+			switch (info.get_op(typeId))
+			{
+				case spirv::op::typeSampler: type = descriptor_type::sampler; return true;
+				case spirv::op::typeSampledImage: type = descriptor_type::combinedImageSampler; return true;
+				case spirv::op::typeImage:
+				{
+					const auto imageDim = static_cast<spirv::dim>(info.get_operand(typeId, 2));
+					const bool sampled = info.get_operand(typeId, 6) == 1;
+
+					if (imageDim == spirv::dim::subpassData)
+					{
+						type = descriptor_type::inputAttachment;
+					}
+					else if (imageDim == spirv::dim::buffer)
+					{
+						type = sampled ? descriptor_type::uniformTexelBuffer : descriptor_type::storageTexelBuffer;
+					}
+					else
+					{
+						type = sampled ? descriptor_type::sampledImage : descriptor_type::storageImage;
+					}
+					return true;
+				}
+				default: return false;
+			}
+		}
+
+		[[nodiscard]] rsl::uint32 get_format_size(format vertexFormat) noexcept
+		{
+			switch (vertexFormat)
+			{
+				case format::r32Uint: [[fallthrough]];
+				case format::r32Sint: [[fallthrough]];
+				case format::r32Sfloat: return 4;
+				case format::r32g32Uint: [[fallthrough]];
+				case format::r32g32Sint: [[fallthrough]];
+				case format::r32g32Sfloat: return 8;
+				case format::r32g32b32Uint: [[fallthrough]];
+				case format::r32g32b32Sint: [[fallthrough]];
+				case format::r32g32b32Sfloat: return 12;
+				case format::r32g32b32a32Uint: [[fallthrough]];
+				case format::r32g32b32a32Sint: [[fallthrough]];
+				case format::r32g32b32a32Sfloat: return 16;
+				default: return 0;
+			}
+		}
+
+		[[nodiscard]] format get_spirv_vertex_format(const spirv_module_info& info, rsl::uint32 typeId) noexcept
+		{
+			rsl::uint32 componentCount = 1;
+			if (info.get_op(typeId) == spirv::op::typeVector)
+			{
+				componentCount = info.get_operand(typeId, 2);
+				typeId = info.get_operand(typeId, 1);
+			}
+
+			if (componentCount < 1 || componentCount > 4 || !info.is_defined(typeId) ||
+				info.get_operand(typeId, 1) != 32)
+			{
+				return format::undefined;
+			}
+
+			constexpr format floatFormats[] = {
+				format::r32Sfloat, format::r32g32Sfloat, format::r32g32b32Sfloat, format::r32g32b32a32Sfloat
+			};
+			constexpr format sintFormats[] = {
+				format::r32Sint, format::r32g32Sint, format::r32g32b32Sint, format::r32g32b32a32Sint
+			};
+			constexpr format uintFormats[] = {
+				format::r32Uint, format::r32g32Uint, format::r32g32b32Uint, format::r32g32b32a32Uint
+			};
+
+			switch (info.get_op(typeId))
+			{
+				case spirv::op::typeFloat: return floatFormats[componentCount - 1];
+				case spirv::op::typeInt:
+					return info.get_operand(typeId, 2) != 0 ? sintFormats[componentCount - 1]
+															: uintFormats[componentCount - 1];
+				default: return format::undefined;
+			}
+		}
+	} // namespace
+
+	[[nodiscard]] bool reflect_spirv(std::span<const rsl::uint32> code, shader_reflection& reflection)
+	{
+		reflection = {};
+
+		spirv_module_info info;
+		if (!parse_spirv(code, info, reflection.stage))
+		{
+			return false;
+		}
+
+		for (rsl::size_type offset : info.variables)
+		{
+			const rsl::uint32 variableId = code[offset + 2];
+			const auto storageClass = static_cast<spirv::storage_class>(code[offset + 3]);
+			const rsl::uint32 pointerId = code[offset + 1];
+
+			// Variables are only tracked when their id is below the bound, the per id tables are indexed with it.
+			if (variableId >= info.definitions.size() || !info.is_defined(pointerId) ||
+				info.get_op(pointerId) != spirv::op::typePointer)
+			{
+				continue;
+			}
+
+			rsl::uint32 typeId = info.get_operand(pointerId, 2);
+			if (!info.is_defined(typeId))
+			{
+				continue;
+			}
+
+			if (storageClass == spirv::storage_class::pushConstant)
+			{
+				const rsl::uint32 start = get_spirv_struct_start(info, typeId);
+				const rsl::uint32 end = get_spirv_type_size(info, typeId);
+				if (end > start)
+				{
+					reflection.pushConstantRanges.push_back(push_constant_range{
+						.stages = reflection.stage,
+						.offset = start,
+						.size = end - start,
+					});
+				}
+				continue;
+			}
+
+			if (storageClass == spirv::storage_class::input)
+			{
+				if (reflection.stage != shader_stage_flags::vertex || info.builtIns[variableId] ||
+					info.locations[variableId] == spirv::unset)
+				{
+					continue;
+				}
+
+				reflection.vertexInputs.push_back(vertex_attribute_description{
+					.location = info.locations[variableId],
+					.binding = 0,
+					.format = get_spirv_vertex_format(info, typeId),
+					.offset = 0,
+				});
+				continue;
+			}
+
+			if (info.descriptorSets[variableId] == spirv::unset || info.bindings[variableId] == spirv::unset)
+			{
+				continue;
+			}
+
+			rsl::uint32 count = 1;
+			if (info.get_op(typeId) == spirv::op::typeArray)
+			{
+				count = get_spirv_constant(info, info.get_operand(typeId, 2));
+				typeId = info.get_operand(typeId, 1);
+			}
+			else if (info.get_op(typeId) == spirv::op::typeRuntimeArray)
+			{
+				typeId = info.get_operand(typeId, 1);
+			}
+
+			descriptor_type type;
+			if (!info.is_defined(typeId) || !get_spirv_descriptor_type(info, storageClass, typeId, type))
+			{
+				std::cout << "Skipping descriptor " << info.descriptorSets[variableId] << ':'
+						  << info.bindings[variableId] << " of unsupported type\n";
+				continue;
+			}
+
+			const rsl::uint32 set = info.descriptorSets[variableId];
+			if (set >= reflection.descriptorSets.size())
+			{
+				reflection.descriptorSets.resize(set + 1);
+			}
+
+			reflection.descriptorSets[set].bindings.push_back(descriptor_binding_description{
+				.binding = info.bindings[variableId],
+				.type = type,
+				.count = count,
+				.stages = reflection.stage,
+				.flags = descriptor_binding_flags::none,
+			});
+		}
+
+		std::sort(
+			reflection.vertexInputs.begin(), reflection.vertexInputs.end(),
+			[](const vertex_attribute_description& lhs, const vertex_attribute_description& rhs) {
+				return lhs.location < rhs.location;
+			}
+		);
+
+		rsl::uint32 vertexOffset = 0;
+		for (auto& input : reflection.vertexInputs)
+		{
+			input.offset = vertexOffset;
+			vertexOffset += get_format_size(input.format);
+		}
+
+		for (auto& set : reflection.descriptorSets)
+		{
+			std::sort(
+				set.bindings.begin(), set.bindings.end(),
+				[](const descriptor_binding_description& lhs, const descriptor_binding_description& rhs) {
+					return lhs.binding < rhs.binding;
+				}
+			);
+		}
+
+		return true;
+	}
+
+	[[nodiscard]] pipeline_layout_description merge_shader_reflections(std::span<const shader_module> modules)
+	{
+		pipeline_layout_description result;
+
+		push_constant_range pushConstants{
+			.stages = rsl::enum_flags::make_zero<shader_stage_flags>(),
+			.offset = ~0u,
+			.size = 0,
+		};
+		rsl::uint32 pushConstantsEnd = 0;
+
+		for (auto& module : modules)
+		{
+			auto& reflection = module.get_reflection();
+
+			if (reflection.descriptorSets.size() > result.descriptorSets.size())
+			{
+				result.descriptorSets.resize(reflection.descriptorSets.size());
+			}
+
+			for (rsl::size_type set = 0; set < reflection.descriptorSets.size(); set++)
+			{
+				auto& mergedBindings = result.descriptorSets[set].bindings;
+				for (auto& binding : reflection.descriptorSets[set].bindings)
+				{
+					auto iter = std::find_if(
+						mergedBindings.begin(), mergedBindings.end(),
+						[&](const descriptor_binding_description& merged) { return merged.binding == binding.binding; }
+					);
+
+					if (iter == mergedBindings.end())
+					{
+						mergedBindings.push_back(binding);
+						continue;
+					}
+
+					if (iter->type != binding.type || iter->count != binding.count)
+					{
+						std::cout << "Descriptor " << set << ':' << binding.binding
+								  << " is declared differently between stages, keeping the first declaration\n";
+					}
+
+					iter->stages = rsl::enum_flags::set_flag(iter->stages, binding.stages, true);
+				}
+			}
+
+			for (auto& range : reflection.pushConstantRanges)
+			{
+				pushConstants.stages = rsl::enum_flags::set_flag(pushConstants.stages, range.stages, true);
+				pushConstants.offset = std::min(pushConstants.offset, range.offset);
+				pushConstantsEnd = std::max(pushConstantsEnd, range.offset + range.size);
+			}
+		}
+
+		for (auto& set : result.descriptorSets)
+		{
+			std::sort(
+				set.bindings.begin(), set.bindings.end(),
+				[](const descriptor_binding_description& lhs, const descriptor_binding_description& rhs) {
+					return lhs.binding < rhs.binding;
+				}
+			);
+		}
+
+		if (pushConstantsEnd != 0)
+		{
+			pushConstants.size = pushConstantsEnd - pushConstants.offset;
+			result.pushConstantRanges.push_back(pushConstants);
+		}
+
+		return result;
+	}
+
+	[[nodiscard]] shader_module render_device::create_shader_module(std::span<const rsl::uint32> spirv)
+	{
+		auto& impl = get_native_ref(*this);
+
+		cache_key key;
+		key.append_bytes(
+			std::span<const rsl::byte>(reinterpret_cast<const rsl::byte*>(spirv.data()), spirv.size_bytes())
+		);
+
+		// Held through creation so two threads loading the same code don't both create it, module creation is cheap.
+		std::lock_guard lock(impl.shaderModuleMutex);
+
+		if (auto iter = impl.shaderModules.find(key); iter != impl.shaderModules.end())
+		{
+			iter->second->refCount++;
+
+			shader_module shaderModule;
+			set_native_handle(shaderModule, create_native_handle(iter->second));
+			return shaderModule;
+		}
+
+		const VkShaderModuleCreateInfo shaderModuleCreateInfo{
+			.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.codeSize = spirv.size_bytes(),
+			.pCode = spirv.data(),
+		};
+
+		VkShaderModule vkShaderModule = VK_NULL_HANDLE;
+		VkResult result = impl.functions->vkCreateShaderModule(
+			impl.device, &shaderModuleCreateInfo, impl.allocCallbacks, &vkShaderModule
+		);
+
+		if (result != VK_SUCCESS || vkShaderModule == VK_NULL_HANDLE)
+		{
+			std::cout << "Failed to create shader module\n";
+			return {};
+		}
+
+		native_shader_module_vk* nativeShaderModule = allocate<native_shader_module_vk>(*impl.alloc);
+		nativeShaderModule->renderDevice = *this;
+		nativeShaderModule->alloc = impl.alloc;
+		nativeShaderModule->allocCallbacks = impl.allocCallbacks;
+		nativeShaderModule->key = key;
+		nativeShaderModule->shaderModule = vkShaderModule;
+
+		if (!reflect_spirv(spirv, nativeShaderModule->reflection))
+		{
+			std::cout << "Failed to reflect shader module, its layout has to be described manually\n";
+		}
+
+		impl.shaderModules.emplace(std::move(key), nativeShaderModule);
+
+		shader_module shaderModule;
+		set_native_handle(shaderModule, create_native_handle(nativeShaderModule));
+		return shaderModule;
+	}
+
+	namespace
+	{
+		void unmap_shader_pack(native_shader_pack_vk& pack) noexcept
+		{
+#if RYTHE_PLATFORM_WINDOWS
+			if (pack.mappedData)
+			{
+				UnmapViewOfFile(pack.mappedData);
+			}
+
+			if (pack.mapping)
+			{
+				CloseHandle(pack.mapping);
+			}
+
+			if (pack.file != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(pack.file);
+			}
+
+			pack.file = INVALID_HANDLE_VALUE;
+			pack.mapping = nullptr;
+#elif RYTHE_PLATFORM_LINUX
+			if (pack.mappedData)
+			{
+				munmap(const_cast<rsl::byte*>(pack.mappedData), pack.mappedSize);
+			}
+#endif
+			pack.mappedData = nullptr;
+			pack.mappedSize = 0;
+		}
+
+		[[nodiscard]] bool map_shader_pack(native_shader_pack_vk& pack)
+		{
+#if RYTHE_PLATFORM_WINDOWS
+			pack.file = CreateFileA(
+				pack.filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+				nullptr
+			);
+			if (pack.file == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(pack.file, &fileSize) || fileSize.QuadPart == 0)
+			{
+				unmap_shader_pack(pack);
+				return false;
+			}
+
+			pack.mapping = CreateFileMappingA(pack.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!pack.mapping)
+			{
+				unmap_shader_pack(pack);
+				return false;
+			}
+
+			pack.mappedData = static_cast<const rsl::byte*>(MapViewOfFile(pack.mapping, FILE_MAP_READ, 0, 0, 0));
+			pack.mappedSize = static_cast<rsl::size_type>(fileSize.QuadPart);
+#elif RYTHE_PLATFORM_LINUX
+			int fileDescriptor = open(pack.filePath.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fileDescriptor < 0)
+			{
+				return false;
+			}
+
+			struct stat fileStat;
+			if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size == 0)
+			{
+				close(fileDescriptor);
+				return false;
+			}
+
+			void* mapping =
+				mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+			// The mapping keeps its own reference to the file.
+			close(fileDescriptor);
+
+			if (mapping != MAP_FAILED)
+			{
+				pack.mappedData = static_cast<const rsl::byte*>(mapping);
+				pack.mappedSize = static_cast<rsl::size_type>(fileStat.st_size);
+			}
+#endif
+			if (!pack.mappedData)
+			{
+				unmap_shader_pack(pack);
+				return false;
+			}
+
+			return true;
+		}
+
+		[[nodiscard]] bool index_shader_pack(native_shader_pack_vk& pack)
+		{
+			if (pack.mappedSize < sizeof(shader_pack_header))
+			{
+				std::cout << "Shader pack " << pack.filePath << " is too small\n";
+				return false;
+			}
+
+			shader_pack_header header;
+			std::memcpy(&header, pack.mappedData, sizeof(header));
+
+			if (header.magic != shader_pack_header::expectedMagic ||
+				header.version != shader_pack_header::expectedVersion)
+			{
+				std::cout << "Shader pack " << pack.filePath << " has an unknown format\n";
+				return false;
+			}
+
+			const rsl::size_type tableEnd = sizeof(shader_pack_header) + header.entryCount * sizeof(shader_pack_entry);
+			if (tableEnd > pack.mappedSize)
+			{
+				std::cout << "Shader pack " << pack.filePath << " is truncated\n";
+				return false;
+			}
+
+			// The mapping is page aligned and the header keeps the table 8 byte aligned.
+			pack.entries = std::span<const shader_pack_entry>(
+				reinterpret_cast<const shader_pack_entry*>(pack.mappedData + sizeof(shader_pack_header)),
+				header.entryCount
+			);
+
+			pack.entryIndices.reserve(header.entryCount);
+			for (rsl::size_type i = 0; i < pack.entries.size(); i++)
+			{
+				auto& entry = pack.entries[i];
+
+				const bool nameInBounds =
+					static_cast<rsl::uint64>(entry.nameOffset) + entry.nameSize <= pack.mappedSize;
+				const bool dataInBounds =
+					entry.dataOffset <= pack.mappedSize && entry.dataSize <= pack.mappedSize - entry.dataOffset;
+				const bool dataAligned = entry.dataOffset % sizeof(rsl::uint32) == 0 &&
+										 entry.dataSize % sizeof(rsl::uint32) == 0 && entry.dataSize != 0;
+
+				if (!nameInBounds || !dataInBounds || !dataAligned)
+				{
+					std::cout << "Shader pack " << pack.filePath << " has an invalid entry " << i << '\n';
+					return false;
+				}
+
+				const char* name = reinterpret_cast<const char*>(pack.mappedData + entry.nameOffset);
+				pack.entryIndices.emplace(std::string_view(name, entry.nameSize), i);
+			}
+
+			return true;
+		}
+	} // namespace
+
+	[[nodiscard]] shader_pack render_device::open_shader_pack(std::string_view filePath)
+	{
+		auto& impl = get_native_ref(*this);
+
+		native_shader_pack_vk* nativeShaderPack = allocate<native_shader_pack_vk>(*impl.alloc);
+		nativeShaderPack->renderDevice = *this;
+		nativeShaderPack->alloc = impl.alloc;
+		nativeShaderPack->allocCallbacks = impl.allocCallbacks;
+		nativeShaderPack->filePath = filePath;
+
+		shader_pack shaderPack;
+		set_native_handle(shaderPack, create_native_handle(nativeShaderPack));
+
+		if (!map_shader_pack(*nativeShaderPack))
+		{
+			std::cout << "Failed to map shader pack " << filePath << '\n';
+			shaderPack.release();
+			return {};
+		}
+
+		if (!index_shader_pack(*nativeShaderPack))
+		{
+			shaderPack.release();
+			return {};
+		}
+
+		return shaderPack;
+	}
+
+	namespace
+	{
+		void sort_descriptor_bindings(descriptor_set_layout_description& description)
+		{
+			std::sort(
+				description.bindings.begin(), description.bindings.end(),
+				[](const descriptor_binding_description& lhs, const descriptor_binding_description& rhs) {
+					return lhs.binding < rhs.binding;
+				}
+			);
+		}
+
+		void
+		append_descriptor_set_layout_description(cache_key& key, const descriptor_set_layout_description& description)
+		{
+			key.append(description.bindings.size());
+			for (auto& binding : description.bindings)
+			{
+				key.append(binding.binding);
+				key.append(binding.type);
+				key.append(binding.count);
+				key.append(binding.stages);
+				key.append(binding.flags);
+			}
+		}
+
+		[[nodiscard]] cache_key make_pipeline_layout_key(const pipeline_layout_description& description)
+		{
+			cache_key key;
+			key.append(description.descriptorSets.size());
+			for (auto& set : description.descriptorSets) { append_descriptor_set_layout_description(key, set); }
+
+			key.append(description.pushConstantRanges.size());
+			for (auto& range : description.pushConstantRanges)
+			{
+				key.append(range.stages);
+				key.append(range.offset);
+				key.append(range.size);
+			}
+
+			return key;
+		}
+
+		void destroy_pipeline_layout(native_pipeline_layout_vk* nativePipelineLayout) noexcept
+		{
+			auto& renderDevice = get_native_ref(nativePipelineLayout->renderDevice);
+
+			if (nativePipelineLayout->pipelineLayout != VK_NULL_HANDLE)
+			{
+				renderDevice.functions->vkDestroyPipelineLayout(
+					renderDevice.device, nativePipelineLayout->pipelineLayout, nativePipelineLayout->allocCallbacks
+				);
+			}
+
+			for (auto& descriptorSetLayout : nativePipelineLayout->descriptorSetLayouts)
+			{
+				descriptorSetLayout.release();
+			}
+
+			deallocate<native_pipeline_layout_vk>(*nativePipelineLayout->alloc, nativePipelineLayout);
+		}
+	} // namespace
+
+	[[nodiscard]] descriptor_set_layout
+	render_device::create_descriptor_set_layout(const descriptor_set_layout_description& description)
+	{
+		auto& impl = get_native_ref(*this);
+
+		// Binding order doesn't change the layout, sort so equal layouts get equal keys.
+		descriptor_set_layout_description canonicalDescription = description;
+		sort_descriptor_bindings(canonicalDescription);
+
+		cache_key key;
+		append_descriptor_set_layout_description(key, canonicalDescription);
+
+		std::lock_guard lock(impl.descriptorSetLayoutMutex);
+
+		descriptor_set_layout descriptorSetLayout;
+
+		if (auto iter = impl.descriptorSetLayouts.find(key); iter != impl.descriptorSetLayouts.end())
+		{
+			iter->second->refCount++;
+			set_native_handle(descriptorSetLayout, create_native_handle(iter->second));
+			return descriptorSetLayout;
+		}
+
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		std::vector<VkDescriptorBindingFlagsEXT> bindingFlags;
+		bindings.reserve(canonicalDescription.bindings.size());
+		bindingFlags.reserve(canonicalDescription.bindings.size());
+
+		bool hasBindingFlags = false;
+		bool updateAfterBind = false;
+		for (auto& binding : canonicalDescription.bindings)
+		{
+			bindings.push_back(VkDescriptorSetLayoutBinding{
+				.binding = binding.binding,
+				.descriptorType = static_cast<VkDescriptorType>(binding.type),
+				.descriptorCount = binding.count,
+				.stageFlags = static_cast<VkShaderStageFlags>(binding.stages),
+				.pImmutableSamplers = nullptr,
+			});
+
+			bindingFlags.push_back(static_cast<VkDescriptorBindingFlagsEXT>(binding.flags));
+			hasBindingFlags |= binding.flags != descriptor_binding_flags::none;
+			updateAfterBind |= rsl::enum_flags::has_flag(binding.flags, descriptor_binding_flags::updateAfterBind);
+		}
+
+		VkDescriptorSetLayoutCreateFlags layoutFlags = 0;
+		if (updateAfterBind)
+		{
+			layoutFlags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+		}
+
+		const VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsCreateInfo{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT,
+			.pNext = nullptr,
+			.bindingCount = static_cast<rsl::uint32>(bindingFlags.size()),
+			.pBindingFlags = bindingFlags.data(),
+		};
+
+		const VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+			.pNext = hasBindingFlags ? &bindingFlagsCreateInfo : nullptr,
+			.flags = layoutFlags,
+			.bindingCount = static_cast<rsl::uint32>(bindings.size()),
+			.pBindings = bindings.data(),
+		};
+
+		VkDescriptorSetLayout vkDescriptorSetLayout = VK_NULL_HANDLE;
+		VkResult result = impl.functions->vkCreateDescriptorSetLayout(
+			impl.device, &descriptorSetLayoutCreateInfo, impl.allocCallbacks, &vkDescriptorSetLayout
+		);
+
+		if (result != VK_SUCCESS || vkDescriptorSetLayout == VK_NULL_HANDLE)
+		{
+			std::cout << "Failed to create descriptor set layout\n";
+			return {};
+		}
+
+		native_descriptor_set_layout_vk* nativeDescriptorSetLayout =
+			allocate<native_descriptor_set_layout_vk>(*impl.alloc);
+		nativeDescriptorSetLayout->renderDevice = *this;
+		nativeDescriptorSetLayout->alloc = impl.alloc;
+		nativeDescriptorSetLayout->allocCallbacks = impl.allocCallbacks;
+		nativeDescriptorSetLayout->key = key;
+		nativeDescriptorSetLayout->description = std::move(canonicalDescription);
+		nativeDescriptorSetLayout->descriptorSetLayout = vkDescriptorSetLayout;
+		impl.descriptorSetLayouts.emplace(std::move(key), nativeDescriptorSetLayout);
+
+		set_native_handle(descriptorSetLayout, create_native_handle(nativeDescriptorSetLayout));
+		return descriptorSetLayout;
+	}
+
+	[[nodiscard]] pipeline_layout render_device::create_pipeline_layout(const pipeline_layout_description& description)
+	{
+		auto& impl = get_native_ref(*this);
+
+		pipeline_layout_description canonicalDescription = description;
+		for (auto& set : canonicalDescription.descriptorSets) { sort_descriptor_bindings(set); }
+
+		cache_key key = make_pipeline_layout_key(canonicalDescription);
+
+		std::lock_guard lock(impl.pipelineLayoutMutex);
+
+		pipeline_layout pipelineLayout;
+
+		if (auto iter = impl.pipelineLayouts.find(key); iter != impl.pipelineLayouts.end())
+		{
+			iter->second->refCount++;
+			set_native_handle(pipelineLayout, create_native_handle(iter->second));
+			return pipelineLayout;
+		}
+
+		native_pipeline_layout_vk* nativePipelineLayout = allocate<native_pipeline_layout_vk>(*impl.alloc);
+		nativePipelineLayout->renderDevice = *this;
+		nativePipelineLayout->alloc = impl.alloc;
+		nativePipelineLayout->allocCallbacks = impl.allocCallbacks;
+		nativePipelineLayout->key = key;
+		nativePipelineLayout->descriptorSetLayouts.reserve(canonicalDescription.descriptorSets.size());
+
+		std::vector<VkDescriptorSetLayout> vkDescriptorSetLayouts;
+		vkDescriptorSetLayouts.reserve(canonicalDescription.descriptorSets.size());
+		for (auto& setDescription : canonicalDescription.descriptorSets)
+		{
+			descriptor_set_layout descriptorSetLayout = create_descriptor_set_layout(setDescription);
+			if (!descriptorSetLayout)
+			{
+				std::cout << "Failed to create descriptor set layout "
+						  << nativePipelineLayout->descriptorSetLayouts.size() << " of pipeline layout\n";
+				destroy_pipeline_layout(nativePipelineLayout);
+				return {};
+			}
+
+			nativePipelineLayout->descriptorSetLayouts.push_back(descriptorSetLayout);
+			vkDescriptorSetLayouts.push_back(get_native_ref(descriptorSetLayout).descriptorSetLayout);
+		}
+
+		std::vector<VkPushConstantRange> pushConstantRanges;
+		pushConstantRanges.reserve(canonicalDescription.pushConstantRanges.size());
+		for (auto& range : canonicalDescription.pushConstantRanges)
+		{
+			pushConstantRanges.push_back(VkPushConstantRange{
+				.stageFlags = static_cast<VkShaderStageFlags>(range.stages),
+				.offset = range.offset,
+				.size = range.size,
+			});
+		}
+
+		const VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.setLayoutCount = static_cast<rsl::uint32>(vkDescriptorSetLayouts.size()),
+			.pSetLayouts = vkDescriptorSetLayouts.data(),
+			.pushConstantRangeCount = static_cast<rsl::uint32>(pushConstantRanges.size()),
+			.pPushConstantRanges = pushConstantRanges.data(),
+		};
+
+		VkResult result = impl.functions->vkCreatePipelineLayout(
+			impl.device, &pipelineLayoutCreateInfo, impl.allocCallbacks, &nativePipelineLayout->pipelineLayout
+		);
+
+		if (result != VK_SUCCESS || nativePipelineLayout->pipelineLayout == VK_NULL_HANDLE)
+		{
+			std::cout << "Failed to create pipeline layout\n";
+			destroy_pipeline_layout(nativePipelineLayout);
+			return {};
+		}
+
+		impl.pipelineLayouts.emplace(std::move(key), nativePipelineLayout);
+
+		set_native_handle(pipelineLayout, create_native_handle(nativePipelineLayout));
+		return pipelineLayout;
+	}
+
+	[[nodiscard]] pipeline_layout render_device::create_pipeline_layout(std::span<const shader_module> modules)
+	{
+		return create_pipeline_layout(merge_shader_reflections(modules));
+	}
+
+	namespace
+	{
+		[[nodiscard]] cache_key make_render_pass_key(const render_pass_description& description)
+		{
+			cache_key key;
+			key.append(description.colorAttachments.size());
+
+			auto appendAttachment = [&](const attachment_description& attachment) {
+				key.append(attachment.format);
+				key.append(attachment.samples);
+				key.append(attachment.loadOp);
+				key.append(attachment.storeOp);
+				key.append(attachment.stencilLoadOp);
+				key.append(attachment.stencilStoreOp);
+				key.append(attachment.initialLayout);
+				key.append(attachment.finalLayout);
+			};
+
+			for (auto& attachment : description.colorAttachments) { appendAttachment(attachment); }
+			appendAttachment(description.depthStencilAttachment);
+			return key;
+		}
+	} // namespace
+
+	[[nodiscard]] render_pass render_device::create_render_pass(const render_pass_description& description)
+	{
+		auto& impl = get_native_ref(*this);
+
+		cache_key key = make_render_pass_key(description);
+
+		std::lock_guard lock(impl.renderPassMutex);
+
+		render_pass renderPass;
+
+		if (auto iter = impl.renderPasses.find(key); iter != impl.renderPasses.end())
+		{
+			iter->second->refCount++;
+			set_native_handle(renderPass, create_native_handle(iter->second));
+			return renderPass;
+		}
+
+		const bool hasDepthStencil = description.depthStencilAttachment.format != format::undefined;
+
+		std::vector<VkAttachmentDescription> attachments;
+		std::vector<VkAttachmentReference> colorReferences;
+		attachments.reserve(description.colorAttachments.size() + 1);
+		colorReferences.reserve(description.colorAttachments.size());
+
+		auto addAttachment = [&](const attachment_description& attachment) {
+			attachments.push_back(VkAttachmentDescription{
+				.flags = 0,
+				.format = static_cast<VkFormat>(attachment.format),
+				.samples = static_cast<VkSampleCountFlagBits>(attachment.samples),
+				.loadOp = static_cast<VkAttachmentLoadOp>(attachment.loadOp),
+				.storeOp = static_cast<VkAttachmentStoreOp>(attachment.storeOp),
+				.stencilLoadOp = static_cast<VkAttachmentLoadOp>(attachment.stencilLoadOp),
+				.stencilStoreOp = static_cast<VkAttachmentStoreOp>(attachment.stencilStoreOp),
+				.initialLayout = static_cast<VkImageLayout>(attachment.initialLayout),
+				.finalLayout = static_cast<VkImageLayout>(attachment.finalLayout),
+			});
+		};
+
+		for (auto& attachment : description.colorAttachments)
+		{
+			colorReferences.push_back(VkAttachmentReference{
+				.attachment = static_cast<rsl::uint32>(attachments.size()),
+				.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+			});
+			addAttachment(attachment);
+		}
+
+		const VkAttachmentReference depthStencilReference{
+			.attachment = static_cast<rsl::uint32>(attachments.size()),
+			.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+		};
+
+		if (hasDepthStencil)
+		{
+			addAttachment(description.depthStencilAttachment);
+		}
+
+		const VkSubpassDescription subpass{
+			.flags = 0,
+			.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+			.inputAttachmentCount = 0,
+			.pInputAttachments = nullptr,
+			.colorAttachmentCount = static_cast<rsl::uint32>(colorReferences.size()),
+			.pColorAttachments = colorReferences.data(),
+			.pResolveAttachments = nullptr,
+			.pDepthStencilAttachment = hasDepthStencil ? &depthStencilReference : nullptr,
+			.preserveAttachmentCount = 0,
+			.pPreserveAttachments = nullptr,
+		};
+
+		const VkSubpassDependency dependency{
+			.srcSubpass = VK_SUBPASS_EXTERNAL,
+			.dstSubpass = 0,
+			.srcStageMask =
+				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+				VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			.dstStageMask =
+				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+				VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			.srcAccessMask = 0,
+			.dstAccessMask =
+				VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			.dependencyFlags = 0,
+		};
+
+		const VkRenderPassCreateInfo renderPassCreateInfo{
+			.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.attachmentCount = static_cast<rsl::uint32>(attachments.size()),
+			.pAttachments = attachments.data(),
+			.subpassCount = 1,
+			.pSubpasses = &subpass,
+			.dependencyCount = 1,
+			.pDependencies = &dependency,
+		};
+
+		VkRenderPass vkRenderPass = VK_NULL_HANDLE;
+		VkResult result =
+			impl.functions->vkCreateRenderPass(impl.device, &renderPassCreateInfo, impl.allocCallbacks, &vkRenderPass);
+
+		if (result != VK_SUCCESS || vkRenderPass == VK_NULL_HANDLE)
+		{
+			std::cout << "Failed to create render pass\n";
+			return {};
+		}
+
+		native_render_pass_vk* nativeRenderPass = allocate<native_render_pass_vk>(*impl.alloc);
+		nativeRenderPass->renderDevice = *this;
+		nativeRenderPass->alloc = impl.alloc;
+		nativeRenderPass->allocCallbacks = impl.allocCallbacks;
+		nativeRenderPass->key = key;
+		nativeRenderPass->description = description;
+		nativeRenderPass->renderPass = vkRenderPass;
+		impl.renderPasses.emplace(std::move(key), nativeRenderPass);
+
+		set_native_handle(renderPass, create_native_handle(nativeRenderPass));
+		return renderPass;
+	}
+
+	namespace
+	{
+		[[nodiscard]] VkPipelineShaderStageCreateInfo
+		make_shader_stage_create_info(const shader_stage_description& stage)
+		{
+			return VkPipelineShaderStageCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.stage = static_cast<VkShaderStageFlagBits>(stage.stage),
+				.module = get_native_ref(stage.module).shaderModule,
+				.pName = stage.entryPoint.c_str(),
+				.pSpecializationInfo = nullptr,
+			};
+		}
+
+		// Modules go in with their whole SPIR-V rather than their hash or handle, so a hash collision can't match
+		// another module and a released module's address being reused can't either.
+		void append_shader_stage(cache_key& key, const shader_stage_description& stage)
+		{
+			key.append(stage.stage);
+			auto* nativeModule = get_native_ptr(stage.module);
+			key.append_key(nativeModule ? nativeModule->key : cache_key{});
+			key.append_string(stage.entryPoint);
+		}
+
+		// Two render passes are compatible when their attachment formats and sample counts match, load/store ops and
+		// layouts don't matter. Hashing only those lets pipelines be shared between compatible render passes.
+		void append_render_pass_compatibility(cache_key& key, render_pass renderPass)
+		{
+			auto* nativeRenderPass = get_native_ptr(renderPass);
+			if (!nativeRenderPass)
+			{
+				key.append(0ull);
+				return;
+			}
+
+			auto appendAttachment = [&](const attachment_description& attachment) {
+				key.append(attachment.format);
+				key.append(attachment.samples);
+			};
+
+			auto& description = nativeRenderPass->description;
+			key.append(description.colorAttachments.size());
+			for (auto& attachment : description.colorAttachments) { appendAttachment(attachment); }
+			appendAttachment(description.depthStencilAttachment);
+		}
+
+		// Layouts go in by their full description rather than their handle, a released layout's handle can be
+		// handed out again for an unrelated layout.
+		void append_pipeline_layout(cache_key& key, pipeline_layout layout)
+		{
+			auto* nativeLayout = get_native_ptr(layout);
+			key.append_key(nativeLayout ? nativeLayout->key : cache_key{});
+		}
+
+		struct dynamic_state_mapping
+		{
+			dynamic_state_flags flag;
+			VkDynamicState state;
+		};
+
+		constexpr dynamic_state_mapping dynamicStateMappings[] = {
+			{dynamic_state_flags::cullMode, VK_DYNAMIC_STATE_CULL_MODE},
+			{dynamic_state_flags::frontFace, VK_DYNAMIC_STATE_FRONT_FACE},
+			{dynamic_state_flags::primitiveTopology, VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY},
+			{dynamic_state_flags::primitiveRestartEnable, VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE},
+			{dynamic_state_flags::depthTestEnable, VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE},
+			{dynamic_state_flags::depthWriteEnable, VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE},
+			{dynamic_state_flags::depthCompareOp, VK_DYNAMIC_STATE_DEPTH_COMPARE_OP},
+			{dynamic_state_flags::depthBiasEnable, VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE},
+			{dynamic_state_flags::polygonMode, VK_DYNAMIC_STATE_POLYGON_MODE_EXT},
+			{dynamic_state_flags::depthClampEnable, VK_DYNAMIC_STATE_DEPTH_CLAMP_ENABLE_EXT},
+			{dynamic_state_flags::colorBlendEnable, VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT},
+			{dynamic_state_flags::colorBlendEquation, VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT},
+			{dynamic_state_flags::colorWriteMask, VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT},
+		};
+
+		[[nodiscard]] constexpr dynamic_state_flags
+		get_effective_dynamic_state(dynamic_state_flags requested, dynamic_state_flags supported) noexcept
+		{
+			return static_cast<dynamic_state_flags>(
+				static_cast<rsl::uint32>(requested) & static_cast<rsl::uint32>(supported)
 			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::videoDecodeDpb,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_VIDEO_DECODE_DPB_BIT_KHR)
+		}
+
+		// Without dynamicPrimitiveTopologyUnrestricted a dynamic topology has to stay within the class of the one the
+		// pipeline was created with.
+		[[nodiscard]] constexpr rsl::uint32 get_topology_class(primitive_topology topology) noexcept
+		{
+			switch (topology)
+			{
+				case primitive_topology::pointList: return 0;
+				case primitive_topology::lineList:
+				case primitive_topology::lineStrip:
+				case primitive_topology::lineListWithAdjacency:
+				case primitive_topology::lineStripWithAdjacency: return 1;
+				case primitive_topology::triangleList:
+				case primitive_topology::triangleStrip:
+				case primitive_topology::triangleFan:
+				case primitive_topology::triangleListWithAdjacency:
+				case primitive_topology::triangleStripWithAdjacency: return 2;
+				case primitive_topology::patchList: return 3;
+			}
+
+			return 2;
+		}
+
+		// The parts VK_EXT_graphics_pipeline_library splits a graphics pipeline into. Each part is hashed on its own
+		// so libraries can be shared between every pipeline that has the same state for that part.
+		enum struct [[rythe_closed_enum]] pipeline_library_part : rsl::uint8
+		{
+			vertexInput,
+			preRasterization,
+			fragmentShader,
+			fragmentOutput,
+		};
+
+		constexpr pipeline_library_part pipelineLibraryParts[] = {
+			pipeline_library_part::vertexInput,
+			pipeline_library_part::preRasterization,
+			pipeline_library_part::fragmentShader,
+			pipeline_library_part::fragmentOutput,
+		};
+
+		void append_render_target(cache_key& key, const graphics_pipeline_description& description)
+		{
+			key.append(static_cast<bool>(description.renderPass));
+			if (description.renderPass)
+			{
+				append_render_pass_compatibility(key, description.renderPass);
+				key.append(description.subpass);
+				return;
+			}
+
+			key.append(description.colorAttachmentFormats.size());
+			for (auto colorFormat : description.colorAttachmentFormats) { key.append(colorFormat); }
+			key.append(description.depthAttachmentFormat);
+			key.append(description.stencilAttachmentFormat);
+		}
+
+		// Dynamic states don't end up in the pipeline, so they are left out of the key.
+		[[nodiscard]] cache_key make_pipeline_library_key(
+			const graphics_pipeline_description& description, dynamic_state_flags dynamicState,
+			pipeline_library_part part
+		)
+		{
+			using rsl::enum_flags::has_flag;
+
+			cache_key key;
+			key.append(dynamicState);
+			key.append(part);
+			auto appendState = [&](dynamic_state_flags flag, const auto& value) {
+				if (!has_flag(dynamicState, flag))
+				{
+					key.append(value);
+				}
+			};
+
+			switch (part)
+			{
+				case pipeline_library_part::vertexInput:
+				{
+					key.append(description.vertexBindings.size());
+					for (auto& binding : description.vertexBindings)
+					{
+						key.append(binding.binding);
+						key.append(binding.stride);
+						key.append(binding.inputRate);
+					}
+
+					key.append(description.vertexAttributes.size());
+					for (auto& attribute : description.vertexAttributes)
+					{
+						key.append(attribute.location);
+						key.append(attribute.binding);
+						key.append(attribute.format);
+						key.append(attribute.offset);
+					}
+
+					if (has_flag(dynamicState, dynamic_state_flags::primitiveTopology))
+					{
+						key.append(get_topology_class(description.topology));
+					}
+					else
+					{
+						key.append(description.topology);
+					}
+					appendState(dynamic_state_flags::primitiveRestartEnable, description.primitiveRestartEnable);
+					return key;
+				}
+				case pipeline_library_part::preRasterization:
+				{
+					for (auto& stage : description.stages)
+					{
+						if (stage.stage != shader_stage_flags::fragment)
+						{
+							append_shader_stage(key, stage);
+						}
+					}
+
+					appendState(dynamic_state_flags::polygonMode, description.rasterization.polygonMode);
+					appendState(dynamic_state_flags::cullMode, description.rasterization.cullMode);
+					appendState(dynamic_state_flags::frontFace, description.rasterization.frontFace);
+					appendState(dynamic_state_flags::depthClampEnable, description.rasterization.depthClampEnable);
+					appendState(dynamic_state_flags::depthBiasEnable, description.rasterization.depthBiasEnable);
+					key.append(description.rasterization.lineWidth);
+
+					append_pipeline_layout(key, description.layout);
+					append_render_target(key, description);
+					return key;
+				}
+				case pipeline_library_part::fragmentShader:
+				{
+					for (auto& stage : description.stages)
+					{
+						if (stage.stage == shader_stage_flags::fragment)
+						{
+							append_shader_stage(key, stage);
+						}
+					}
+
+					key.append(description.samples);
+
+					appendState(dynamic_state_flags::depthTestEnable, description.depthStencil.depthTestEnable);
+					appendState(dynamic_state_flags::depthWriteEnable, description.depthStencil.depthWriteEnable);
+					appendState(dynamic_state_flags::depthCompareOp, description.depthStencil.depthCompareOp);
+
+					append_pipeline_layout(key, description.layout);
+					append_render_target(key, description);
+					return key;
+				}
+				case pipeline_library_part::fragmentOutput:
+				{
+					key.append(description.samples);
+
+					key.append(description.colorBlendAttachments.size());
+					for (auto& attachment : description.colorBlendAttachments)
+					{
+						appendState(dynamic_state_flags::colorBlendEnable, attachment.blendEnable);
+						appendState(dynamic_state_flags::colorBlendEquation, attachment.srcColorBlendFactor);
+						appendState(dynamic_state_flags::colorBlendEquation, attachment.dstColorBlendFactor);
+						appendState(dynamic_state_flags::colorBlendEquation, attachment.colorBlendOp);
+						appendState(dynamic_state_flags::colorBlendEquation, attachment.srcAlphaBlendFactor);
+						appendState(dynamic_state_flags::colorBlendEquation, attachment.dstAlphaBlendFactor);
+						appendState(dynamic_state_flags::colorBlendEquation, attachment.alphaBlendOp);
+						appendState(dynamic_state_flags::colorWriteMask, attachment.colorWriteMask);
+					}
+
+					append_render_target(key, description);
+					return key;
+				}
+			}
+
+			return key;
+		}
+
+		[[nodiscard]] cache_key make_graphics_pipeline_key(
+			const graphics_pipeline_description& description, dynamic_state_flags dynamicState
+		)
+		{
+			cache_key key;
+			key.append(pipeline_bind_point::graphics);
+			for (auto part : pipelineLibraryParts)
+			{
+				key.append_bytes(make_pipeline_library_key(description, dynamicState, part).bytes);
+			}
+			return key;
+		}
+
+		[[nodiscard]] cache_key make_compute_pipeline_key(const compute_pipeline_description& description)
+		{
+			cache_key key;
+			key.append(pipeline_bind_point::compute);
+			append_shader_stage(key, description.stage);
+			append_pipeline_layout(key, description.layout);
+			return key;
+		}
+
+		[[nodiscard]] pipeline find_cached_pipeline(render_device renderDevice, const cache_key& key)
+		{
+			auto& impl = get_native_ref(renderDevice);
+
+			std::lock_guard lock(impl.pipelineMutex);
+			auto iter = impl.pipelines.find(key);
+			if (iter == impl.pipelines.end())
+			{
+				return {};
+			}
+
+			iter->second->refCount++;
+
+			pipeline result;
+			set_native_handle(result, create_native_handle(iter->second));
+			return result;
+		}
+
+		[[nodiscard]] pipeline_layout retain_pipeline_layout(pipeline_layout layout)
+		{
+			auto* nativeLayout = get_native_ptr(layout);
+			{
+				std::lock_guard lock(get_native_ref(nativeLayout->renderDevice).pipelineLayoutMutex);
+				nativeLayout->refCount++;
+			}
+
+			pipeline_layout result;
+			set_native_handle(result, create_native_handle(nativeLayout));
+			return result;
+		}
+
+		[[nodiscard]] pipeline make_pipeline(
+			render_device renderDevice, pipeline_bind_point bindPoint, pipeline_layout layout, VkPipeline vkPipeline,
+			const cache_key& key, dynamic_state_flags dynamicState = dynamic_state_flags::none
+		)
+		{
+			auto& impl = get_native_ref(renderDevice);
+
+			pipeline_layout retainedLayout = retain_pipeline_layout(layout);
+
+			native_pipeline_vk* nativePipeline = nullptr;
+			{
+				std::lock_guard lock(impl.pipelineMutex);
+
+				// Another thread may have finished the same pipeline while we were compiling ours.
+				if (auto iter = impl.pipelines.find(key); iter != impl.pipelines.end())
+				{
+					nativePipeline = iter->second;
+					nativePipeline->refCount++;
+				}
+				else
+				{
+					nativePipeline = allocate<native_pipeline_vk>(*impl.alloc);
+					nativePipeline->renderDevice = renderDevice;
+					nativePipeline->alloc = impl.alloc;
+					nativePipeline->allocCallbacks = impl.allocCallbacks;
+					nativePipeline->bindPoint = bindPoint;
+					nativePipeline->pipelineLayout = get_native_ref(layout).pipelineLayout;
+					nativePipeline->layout = std::exchange(retainedLayout, pipeline_layout{});
+					nativePipeline->dynamicState = dynamicState;
+					nativePipeline->key = key;
+					nativePipeline->pipeline = vkPipeline;
+					impl.pipelines.emplace(key, nativePipeline);
+				}
+			}
+
+			if (nativePipeline->pipeline != vkPipeline)
+			{
+				impl.functions->vkDestroyPipeline(impl.device, vkPipeline, impl.allocCallbacks);
+			}
+			retainedLayout.release();
+
+			pipeline result;
+			set_native_handle(result, create_native_handle(nativePipeline));
+			return result;
+		}
+
+		// Destroys the libraries compiled against the layout. Every pipeline using the layout holds a reference to it,
+		// so none of them can still be waiting on the link worker.
+		void evict_pipeline_libraries(native_render_device_vk& device, const native_pipeline_layout_vk* layout)
+		{
+			std::lock_guard lock(device.pipelineLibraryMutex);
+			std::erase_if(device.pipelineLibraries, [&](const auto& entry) {
+				if (entry.second.layout != layout)
+				{
+					return false;
+				}
+
+				device.functions->vkDestroyPipeline(device.device, entry.second.library, device.allocCallbacks);
+				return true;
+			});
+		}
+
+		// Returns the cached library for the part, compiling it from createInfo on first use. Shader stages outside the
+		// part are filtered out, the other state of createInfo is ignored for parts it doesn't belong to.
+		[[nodiscard]] VkPipeline get_pipeline_library(
+			native_render_device_vk& impl, const graphics_pipeline_description& description,
+			dynamic_state_flags dynamicState, pipeline_library_part part,
+			const VkGraphicsPipelineCreateInfo& createInfo, VkPipelineCache vkPipelineCache
+		)
+		{
+			cache_key libraryKey = make_pipeline_library_key(description, dynamicState, part);
+			{
+				std::lock_guard lock(impl.pipelineLibraryMutex);
+				if (auto iter = impl.pipelineLibraries.find(libraryKey); iter != impl.pipelineLibraries.end())
+				{
+					return iter->second.library;
+				}
+			}
+
+			VkGraphicsPipelineLibraryFlagsEXT libraryFlags = 0;
+			switch (part)
+			{
+				case pipeline_library_part::vertexInput:
+					libraryFlags = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+					break;
+				case pipeline_library_part::preRasterization:
+					libraryFlags = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+					break;
+				case pipeline_library_part::fragmentShader:
+					libraryFlags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+					break;
+				case pipeline_library_part::fragmentOutput:
+					libraryFlags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+					break;
+			}
+
+			std::vector<VkPipelineShaderStageCreateInfo> stages;
+			for (rsl::uint32 i = 0; i < createInfo.stageCount; i++)
+			{
+				const bool fragmentStage = createInfo.pStages[i].stage == VK_SHADER_STAGE_FRAGMENT_BIT;
+				if ((part == pipeline_library_part::preRasterization && !fragmentStage) ||
+					(part == pipeline_library_part::fragmentShader && fragmentStage))
+				{
+					stages.push_back(createInfo.pStages[i]);
+				}
+			}
+
+			// Chained in front of the rendering create info, if there is one.
+			const VkGraphicsPipelineLibraryCreateInfoEXT libraryCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+				.pNext = const_cast<void*>(createInfo.pNext),
+				.flags = libraryFlags,
+			};
+
+			VkGraphicsPipelineCreateInfo libraryPipelineCreateInfo = createInfo;
+			libraryPipelineCreateInfo.pNext = &libraryCreateInfo;
+			libraryPipelineCreateInfo.flags =
+				VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+			libraryPipelineCreateInfo.stageCount = static_cast<rsl::uint32>(stages.size());
+			libraryPipelineCreateInfo.pStages = stages.data();
+
+			VkPipeline library = VK_NULL_HANDLE;
+			VkResult result = impl.functions->vkCreateGraphicsPipelines(
+				impl.device, vkPipelineCache, 1, &libraryPipelineCreateInfo, impl.allocCallbacks, &library
+			);
+
+			if (result != VK_SUCCESS || library == VK_NULL_HANDLE)
+			{
+				std::cout << "Failed to create graphics pipeline library\n";
+				return VK_NULL_HANDLE;
+			}
+
+			// Another thread may have finished the same library while we were compiling ours.
+			std::lock_guard lock(impl.pipelineLibraryMutex);
+			const bool usesLayout =
+				part == pipeline_library_part::preRasterization || part == pipeline_library_part::fragmentShader;
+			auto [iter, inserted] = impl.pipelineLibraries.emplace(
+				std::move(libraryKey),
+				cached_pipeline_library{
+					.library = library,
+					.layout = usesLayout ? get_native_ptr(description.layout) : nullptr,
+				}
 			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::videoEncodeDst,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_VIDEO_ENCODE_DST_BIT_KHR)
+			if (!inserted)
+			{
+				impl.functions->vkDestroyPipeline(impl.device, library, impl.allocCallbacks);
+			}
+
+			return iter->second.library;
+		}
+
+		[[nodiscard]] VkPipeline link_pipeline_libraries(
+			native_render_device_vk& impl, std::span<const VkPipeline> libraries, VkPipelineLayout pipelineLayout,
+			bool optimize, VkPipelineCache vkPipelineCache
+		)
+		{
+			const VkPipelineLibraryCreateInfoKHR libraryCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+				.pNext = nullptr,
+				.libraryCount = static_cast<rsl::uint32>(libraries.size()),
+				.pLibraries = libraries.data(),
+			};
+
+			VkPipelineCreateFlags flags = 0;
+			if (optimize)
+			{
+				flags = VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT;
+			}
+
+			const VkGraphicsPipelineCreateInfo pipelineCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+				.pNext = &libraryCreateInfo,
+				.flags = flags,
+				.stageCount = 0,
+				.pStages = nullptr,
+				.pVertexInputState = nullptr,
+				.pInputAssemblyState = nullptr,
+				.pTessellationState = nullptr,
+				.pViewportState = nullptr,
+				.pRasterizationState = nullptr,
+				.pMultisampleState = nullptr,
+				.pDepthStencilState = nullptr,
+				.pColorBlendState = nullptr,
+				.pDynamicState = nullptr,
+				.layout = pipelineLayout,
+				.renderPass = VK_NULL_HANDLE,
+				.subpass = 0,
+				.basePipelineHandle = VK_NULL_HANDLE,
+				.basePipelineIndex = -1,
+			};
+
+			VkPipeline vkPipeline = VK_NULL_HANDLE;
+			VkResult result = impl.functions->vkCreateGraphicsPipelines(
+				impl.device, vkPipelineCache, 1, &pipelineCreateInfo, impl.allocCallbacks, &vkPipeline
 			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::videoEncodeSrc,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_VIDEO_ENCODE_SRC_BIT_KHR)
+
+			if (result != VK_SUCCESS || vkPipeline == VK_NULL_HANDLE)
+			{
+				std::cout << "Failed to link graphics pipeline libraries\n";
+				return VK_NULL_HANDLE;
+			}
+
+			return vkPipeline;
+		}
+
+		void run_pipeline_link_worker(native_render_device_vk& impl)
+		{
+			while (true)
+			{
+				pending_pipeline_link link;
+				{
+					std::unique_lock lock(impl.linkMutex);
+					impl.linkCondition.wait(lock, [&] { return impl.stopLinkWorker || !impl.pendingLinks.empty(); });
+					if (impl.stopLinkWorker)
+					{
+						return;
+					}
+
+					link = std::move(impl.pendingLinks.front());
+					impl.pendingLinks.pop_front();
+				}
+
+				auto& nativePipeline = get_native_ref(link.target);
+
+				// Skip the link when the worker holds the last reference, the result would be destroyed right away.
+				bool stillUsed = false;
+				{
+					std::lock_guard lock(impl.pipelineMutex);
+					stillUsed = nativePipeline.refCount > 1;
+				}
+
+				if (stillUsed)
+				{
+					// Linked without a pipeline cache, the cache the pipeline was created with may be gone by now.
+					VkPipeline optimizedPipeline = link_pipeline_libraries(
+						impl, link.libraries, nativePipeline.pipelineLayout, true, VK_NULL_HANDLE
+					);
+
+					VkPipeline expected = VK_NULL_HANDLE;
+					if (optimizedPipeline &&
+						!nativePipeline.optimizedPipeline.compare_exchange_strong(
+							expected, optimizedPipeline, std::memory_order_release
+						))
+					{
+						impl.functions->vkDestroyPipeline(impl.device, optimizedPipeline, impl.allocCallbacks);
+					}
+				}
+
+				nativePipeline.linkPending.store(false);
+				link.target.release();
+			}
+		}
+
+		void
+		queue_optimized_link(native_render_device_vk& impl, const pipeline& target, const VkPipeline (&libraries)[4])
+		{
+			auto& nativePipeline = get_native_ref(target);
+			if (nativePipeline.optimizedPipeline.load() || nativePipeline.linkPending.exchange(true))
+			{
+				return;
+			}
+
+			pending_pipeline_link link;
+			{
+				std::lock_guard lock(impl.pipelineMutex);
+				nativePipeline.refCount++;
+			}
+			set_native_handle(link.target, create_native_handle(&nativePipeline));
+			std::copy(std::begin(libraries), std::end(libraries), link.libraries);
+
+			{
+				std::lock_guard lock(impl.linkMutex);
+				if (!impl.linkWorker.joinable())
+				{
+					impl.linkWorker = std::thread(run_pipeline_link_worker, std::ref(impl));
+				}
+				impl.pendingLinks.push_back(std::move(link));
+			}
+			impl.linkCondition.notify_one();
+		}
+
+		// Fast-links the pipeline from its cached libraries and queues the link time optimized version on the link
+		// worker. Devices without fast linking get the optimized link right away.
+		[[nodiscard]] pipeline build_graphics_pipeline_from_libraries(
+			render_device renderDevice, const graphics_pipeline_description& description,
+			dynamic_state_flags dynamicState, const VkGraphicsPipelineCreateInfo& createInfo,
+			VkPipelineCache vkPipelineCache, const cache_key& key
+		)
+		{
+			auto& impl = get_native_ref(renderDevice);
+
+			VkPipeline libraries[std::size(pipelineLibraryParts)];
+			for (rsl::size_type i = 0; i < std::size(pipelineLibraryParts); i++)
+			{
+				libraries[i] = get_pipeline_library(
+					impl, description, dynamicState, pipelineLibraryParts[i], createInfo, vkPipelineCache
+				);
+
+				if (!libraries[i])
+				{
+					return {};
+				}
+			}
+
+			const bool fastLink = impl.graphicsPipelineLibraryFastLinking;
+			VkPipeline vkPipeline =
+				link_pipeline_libraries(impl, libraries, createInfo.layout, !fastLink, vkPipelineCache);
+			if (!vkPipeline)
+			{
+				return {};
+			}
+
+			pipeline result = make_pipeline(
+				renderDevice, pipeline_bind_point::graphics, description.layout, vkPipeline, key, dynamicState
 			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::videoEncodeDpb,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_VIDEO_ENCODE_DPB_BIT_KHR)
+
+			if (fastLink && result)
+			{
+				queue_optimized_link(impl, result, libraries);
+			}
+
+			return result;
+		}
+
+		[[nodiscard]] pipeline build_graphics_pipeline(
+			render_device renderDevice, const graphics_pipeline_description& description,
+			VkPipelineCache vkPipelineCache
+		)
+		{
+			auto& impl = get_native_ref(renderDevice);
+
+			const dynamic_state_flags effectiveDynamicState =
+				get_effective_dynamic_state(description.dynamicState, impl.dynamicStateSupport);
+			const cache_key key = make_graphics_pipeline_key(description, effectiveDynamicState);
+			if (pipeline cached = find_cached_pipeline(renderDevice, key))
+			{
+				return cached;
+			}
+
+			std::vector<VkPipelineShaderStageCreateInfo> stages;
+			stages.reserve(description.stages.size());
+			for (auto& stage : description.stages) { stages.push_back(make_shader_stage_create_info(stage)); }
+
+			std::vector<VkVertexInputBindingDescription> vertexBindings;
+			vertexBindings.reserve(description.vertexBindings.size());
+			for (auto& binding : description.vertexBindings)
+			{
+				vertexBindings.push_back(VkVertexInputBindingDescription{
+					.binding = binding.binding,
+					.stride = binding.stride,
+					.inputRate = static_cast<VkVertexInputRate>(binding.inputRate),
+				});
+			}
+
+			std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+			vertexAttributes.reserve(description.vertexAttributes.size());
+			for (auto& attribute : description.vertexAttributes)
+			{
+				vertexAttributes.push_back(VkVertexInputAttributeDescription{
+					.location = attribute.location,
+					.binding = attribute.binding,
+					.format = static_cast<VkFormat>(attribute.format),
+					.offset = attribute.offset,
+				});
+			}
+
+			const VkPipelineVertexInputStateCreateInfo vertexInputState{
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.vertexBindingDescriptionCount = static_cast<rsl::uint32>(vertexBindings.size()),
+				.pVertexBindingDescriptions = vertexBindings.data(),
+				.vertexAttributeDescriptionCount = static_cast<rsl::uint32>(vertexAttributes.size()),
+				.pVertexAttributeDescriptions = vertexAttributes.data(),
+			};
+
+			const VkPipelineInputAssemblyStateCreateInfo inputAssemblyState{
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.topology = static_cast<VkPrimitiveTopology>(description.topology),
+				.primitiveRestartEnable = description.primitiveRestartEnable ? VK_TRUE : VK_FALSE,
+			};
+
+			const VkPipelineViewportStateCreateInfo viewportState{
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.viewportCount = 1,
+				.pViewports = nullptr,
+				.scissorCount = 1,
+				.pScissors = nullptr,
+			};
+
+			const VkPipelineRasterizationStateCreateInfo rasterizationState{
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.depthClampEnable = description.rasterization.depthClampEnable ? VK_TRUE : VK_FALSE,
+				.rasterizerDiscardEnable = VK_FALSE,
+				.polygonMode = static_cast<VkPolygonMode>(description.rasterization.polygonMode),
+				.cullMode = static_cast<VkCullModeFlags>(description.rasterization.cullMode),
+				.frontFace = static_cast<VkFrontFace>(description.rasterization.frontFace),
+				.depthBiasEnable = description.rasterization.depthBiasEnable ? VK_TRUE : VK_FALSE,
+				.depthBiasConstantFactor = 0.f,
+				.depthBiasClamp = 0.f,
+				.depthBiasSlopeFactor = 0.f,
+				.lineWidth = description.rasterization.lineWidth,
+			};
+
+			const VkPipelineMultisampleStateCreateInfo multisampleState{
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.rasterizationSamples = static_cast<VkSampleCountFlagBits>(description.samples),
+				.sampleShadingEnable = VK_FALSE,
+				.minSampleShading = 0.f,
+				.pSampleMask = nullptr,
+				.alphaToCoverageEnable = VK_FALSE,
+				.alphaToOneEnable = VK_FALSE,
+			};
+
+			const VkPipelineDepthStencilStateCreateInfo depthStencilState{
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.depthTestEnable = description.depthStencil.depthTestEnable ? VK_TRUE : VK_FALSE,
+				.depthWriteEnable = description.depthStencil.depthWriteEnable ? VK_TRUE : VK_FALSE,
+				.depthCompareOp = static_cast<VkCompareOp>(description.depthStencil.depthCompareOp),
+				.depthBoundsTestEnable = VK_FALSE,
+				.stencilTestEnable = VK_FALSE,
+				.front = {},
+				.back = {},
+				.minDepthBounds = 0.f,
+				.maxDepthBounds = 1.f,
+			};
+
+			std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments;
+			colorBlendAttachments.reserve(description.colorBlendAttachments.size());
+			for (auto& attachment : description.colorBlendAttachments)
+			{
+				colorBlendAttachments.push_back(VkPipelineColorBlendAttachmentState{
+					.blendEnable = attachment.blendEnable ? VK_TRUE : VK_FALSE,
+					.srcColorBlendFactor = static_cast<VkBlendFactor>(attachment.srcColorBlendFactor),
+					.dstColorBlendFactor = static_cast<VkBlendFactor>(attachment.dstColorBlendFactor),
+					.colorBlendOp = static_cast<VkBlendOp>(attachment.colorBlendOp),
+					.srcAlphaBlendFactor = static_cast<VkBlendFactor>(attachment.srcAlphaBlendFactor),
+					.dstAlphaBlendFactor = static_cast<VkBlendFactor>(attachment.dstAlphaBlendFactor),
+					.alphaBlendOp = static_cast<VkBlendOp>(attachment.alphaBlendOp),
+					.colorWriteMask = static_cast<VkColorComponentFlags>(attachment.colorWriteMask),
+				});
+			}
+
+			const VkPipelineColorBlendStateCreateInfo colorBlendState{
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.logicOpEnable = VK_FALSE,
+				.logicOp = VK_LOGIC_OP_COPY,
+				.attachmentCount = static_cast<rsl::uint32>(colorBlendAttachments.size()),
+				.pAttachments = colorBlendAttachments.data(),
+				.blendConstants = {0.f, 0.f, 0.f, 0.f},
+			};
+
+			VkDynamicState dynamicStates[2 + std::size(dynamicStateMappings)] = {
+				VK_DYNAMIC_STATE_VIEWPORT,
+				VK_DYNAMIC_STATE_SCISSOR,
+			};
+			rsl::uint32 dynamicStateCount = 2;
+			for (auto& [flag, state] : dynamicStateMappings)
+			{
+				if (rsl::enum_flags::has_flag(effectiveDynamicState, flag))
+				{
+					dynamicStates[dynamicStateCount++] = state;
+				}
+			}
+
+			const VkPipelineDynamicStateCreateInfo dynamicState{
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.dynamicStateCount = dynamicStateCount,
+				.pDynamicStates = dynamicStates,
+			};
+
+			const VkPipelineLayout vkPipelineLayout = get_native_ref(description.layout).pipelineLayout;
+
+			// Without a render pass the pipeline is used with dynamic rendering and gets its formats from here.
+			auto* nativeRenderPass = get_native_ptr(description.renderPass);
+			if (!nativeRenderPass && !impl.dynamicRendering)
+			{
+				std::cout << "Graphics pipelines need a render pass when dynamic rendering isn't supported\n";
+				return {};
+			}
+
+			std::vector<VkFormat> colorAttachmentFormats;
+			colorAttachmentFormats.reserve(description.colorAttachmentFormats.size());
+			for (auto colorFormat : description.colorAttachmentFormats)
+			{
+				colorAttachmentFormats.push_back(static_cast<VkFormat>(colorFormat));
+			}
+
+			const VkPipelineRenderingCreateInfoKHR renderingCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR,
+				.pNext = nullptr,
+				.viewMask = 0,
+				.colorAttachmentCount = static_cast<rsl::uint32>(colorAttachmentFormats.size()),
+				.pColorAttachmentFormats = colorAttachmentFormats.data(),
+				.depthAttachmentFormat = static_cast<VkFormat>(description.depthAttachmentFormat),
+				.stencilAttachmentFormat = static_cast<VkFormat>(description.stencilAttachmentFormat),
+			};
+
+			const VkGraphicsPipelineCreateInfo pipelineCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+				.pNext = nativeRenderPass ? nullptr : &renderingCreateInfo,
+				.flags = 0,
+				.stageCount = static_cast<rsl::uint32>(stages.size()),
+				.pStages = stages.data(),
+				.pVertexInputState = &vertexInputState,
+				.pInputAssemblyState = &inputAssemblyState,
+				.pTessellationState = nullptr,
+				.pViewportState = &viewportState,
+				.pRasterizationState = &rasterizationState,
+				.pMultisampleState = &multisampleState,
+				.pDepthStencilState = &depthStencilState,
+				.pColorBlendState = &colorBlendState,
+				.pDynamicState = &dynamicState,
+				.layout = vkPipelineLayout,
+				.renderPass = nativeRenderPass ? nativeRenderPass->renderPass : VK_NULL_HANDLE,
+				.subpass = nativeRenderPass ? description.subpass : 0,
+				.basePipelineHandle = VK_NULL_HANDLE,
+				.basePipelineIndex = -1,
+			};
+
+			if (impl.graphicsPipelineLibrary)
+			{
+				return build_graphics_pipeline_from_libraries(
+					renderDevice, description, effectiveDynamicState, pipelineCreateInfo, vkPipelineCache, key
+				);
+			}
+
+			VkPipeline vkPipeline = VK_NULL_HANDLE;
+			VkResult result = impl.functions->vkCreateGraphicsPipelines(
+				impl.device, vkPipelineCache, 1, &pipelineCreateInfo, impl.allocCallbacks, &vkPipeline
 			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::invocationMaskHUAWEI,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_INVOCATION_MASK_BIT_HUAWEI)
+
+			if (result != VK_SUCCESS || vkPipeline == VK_NULL_HANDLE)
+			{
+				std::cout << "Failed to create graphics pipeline\n";
+				return {};
+			}
+
+			return make_pipeline(
+				renderDevice, pipeline_bind_point::graphics, description.layout, vkPipeline, key, effectiveDynamicState
 			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::attachmentFeedbackLoop,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_ATTACHMENT_FEEDBACK_LOOP_BIT_EXT)
+		}
+
+		[[nodiscard]] pipeline build_compute_pipeline(
+			render_device renderDevice, const compute_pipeline_description& description, VkPipelineCache vkPipelineCache
+		)
+		{
+			const cache_key key = make_compute_pipeline_key(description);
+			if (pipeline cached = find_cached_pipeline(renderDevice, key))
+			{
+				return cached;
+			}
+
+			auto& impl = get_native_ref(renderDevice);
+
+			const VkPipelineLayout vkPipelineLayout = get_native_ref(description.layout).pipelineLayout;
+
+			const VkComputePipelineCreateInfo pipelineCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.stage = make_shader_stage_create_info(description.stage),
+				.layout = vkPipelineLayout,
+				.basePipelineHandle = VK_NULL_HANDLE,
+				.basePipelineIndex = -1,
+			};
+
+			VkPipeline vkPipeline = VK_NULL_HANDLE;
+			VkResult result = impl.functions->vkCreateComputePipelines(
+				impl.device, vkPipelineCache, 1, &pipelineCreateInfo, impl.allocCallbacks, &vkPipeline
 			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::sampleWeightQCOM,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_SAMPLE_WEIGHT_BIT_QCOM)
+
+			if (result != VK_SUCCESS || vkPipeline == VK_NULL_HANDLE)
+			{
+				std::cout << "Failed to create compute pipeline\n";
+				return {};
+			}
+
+			return make_pipeline(renderDevice, pipeline_bind_point::compute, description.layout, vkPipeline, key);
+		}
+
+		[[nodiscard]] VkPipelineCache get_vk_pipeline_cache(pipeline_cache cache)
+		{
+			auto* nativeCache = get_native_ptr(cache);
+			return nativeCache ? nativeCache->pipelineCache : VK_NULL_HANDLE;
+		}
+
+		void finish_pipeline_batch(native_pipeline_batch_vk& batch)
+		{
+			auto& renderDevice = get_native_ref(batch.renderDevice);
+
+			if (auto* targetCache = get_native_ptr(batch.targetCache); targetCache && !batch.workerCaches.empty())
+			{
+				VkResult result = renderDevice.functions->vkMergePipelineCaches(
+					renderDevice.device, targetCache->pipelineCache,
+					static_cast<rsl::uint32>(batch.workerCaches.size()), batch.workerCaches.data()
+				);
+
+				if (result != VK_SUCCESS)
+				{
+					std::cout << "Failed to merge worker pipeline caches\n";
+				}
+			}
+
+			for (VkPipelineCache workerCache : batch.workerCaches)
+			{
+				renderDevice.functions->vkDestroyPipelineCache(renderDevice.device, workerCache, batch.allocCallbacks);
+			}
+			batch.workerCaches.clear();
+
+			batch.done.store(true, std::memory_order_release);
+		}
+
+		void run_pipeline_batch_worker(native_pipeline_batch_vk& batch, VkPipelineCache workerCache)
+		{
+			const rsl::size_type graphicsCount = batch.graphicsDescriptions.size();
+			const rsl::size_type totalCount = graphicsCount + batch.computeDescriptions.size();
+
+			for (rsl::size_type index = batch.nextIndex.fetch_add(1, std::memory_order_relaxed); index < totalCount;
+				 index = batch.nextIndex.fetch_add(1, std::memory_order_relaxed))
+			{
+				const bool isGraphics = index < graphicsCount;
+				const rsl::size_type computeIndex = index - graphicsCount;
+				std::promise<pipeline>& promise =
+					isGraphics ? batch.graphicsPromises[index] : batch.computePromises[computeIndex];
+
+				// An escaping exception would terminate the process and leave every other future of the batch
+				// hanging, hand it to whoever waits on this pipeline instead.
+				try
+				{
+					if (isGraphics)
+					{
+						promise.set_value(
+							build_graphics_pipeline(batch.renderDevice, batch.graphicsDescriptions[index], workerCache)
+						);
+					}
+					else
+					{
+						promise.set_value(build_compute_pipeline(
+							batch.renderDevice, batch.computeDescriptions[computeIndex], workerCache
+						));
+					}
+				}
+				catch (...)
+				{
+					promise.set_exception(std::current_exception());
+				}
+
+				batch.completedCount.fetch_add(1, std::memory_order_release);
+			}
+
+			// The last worker out merges, the worker caches need no external synchronization up to this point.
+			if (batch.activeWorkerCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				finish_pipeline_batch(batch);
+			}
+		}
+	} // namespace
+
+	[[nodiscard]] pipeline render_device::create_graphics_pipeline(const graphics_pipeline_description& description)
+	{
+		return create_graphics_pipeline(description, pipeline_cache{});
+	}
+
+	[[nodiscard]] pipeline
+	render_device::create_graphics_pipeline(const graphics_pipeline_description& description, pipeline_cache cache)
+	{
+		return build_graphics_pipeline(*this, description, get_vk_pipeline_cache(cache));
+	}
+
+	[[nodiscard]] pipeline render_device::create_compute_pipeline(const compute_pipeline_description& description)
+	{
+		return create_compute_pipeline(description, pipeline_cache{});
+	}
+
+	[[nodiscard]] pipeline
+	render_device::create_compute_pipeline(const compute_pipeline_description& description, pipeline_cache cache)
+	{
+		return build_compute_pipeline(*this, description, get_vk_pipeline_cache(cache));
+	}
+
+	[[nodiscard]] pipeline_batch render_device::create_pipelines_async(
+		std::span<const graphics_pipeline_description> graphicsPipelines,
+		std::span<const compute_pipeline_description> computePipelines
+	)
+	{
+		return create_pipelines_async(graphicsPipelines, computePipelines, pipeline_cache{});
+	}
+
+	[[nodiscard]] pipeline_batch render_device::create_pipelines_async(
+		std::span<const graphics_pipeline_description> graphicsPipelines,
+		std::span<const compute_pipeline_description> computePipelines, pipeline_cache cache,
+		rsl::size_type threadCount
+	)
+	{
+		auto& impl = get_native_ref(*this);
+
+		const rsl::size_type totalCount = graphicsPipelines.size() + computePipelines.size();
+
+		if (threadCount == 0)
+		{
+			threadCount = static_cast<rsl::size_type>(std::thread::hardware_concurrency());
+		}
+		threadCount = rsl::math::min(threadCount, totalCount);
+		if (threadCount == 0)
+		{
+			threadCount = 1;
+		}
+
+		native_pipeline_batch_vk* batch = allocate<native_pipeline_batch_vk>(*impl.alloc);
+		batch->renderDevice = *this;
+		batch->alloc = impl.alloc;
+		batch->allocCallbacks = impl.allocCallbacks;
+		batch->targetCache = cache;
+		batch->graphicsDescriptions.assign(graphicsPipelines.begin(), graphicsPipelines.end());
+		batch->computeDescriptions.assign(computePipelines.begin(), computePipelines.end());
+
+		batch->graphicsPromises.resize(graphicsPipelines.size());
+		batch->graphicsPipelines.reserve(graphicsPipelines.size());
+		for (auto& promise : batch->graphicsPromises)
+		{
+			batch->graphicsPipelines.push_back(promise.get_future().share());
+		}
+
+		batch->computePromises.resize(computePipelines.size());
+		batch->computePipelines.reserve(computePipelines.size());
+		for (auto& promise : batch->computePromises)
+		{
+			batch->computePipelines.push_back(promise.get_future().share());
+		}
+
+		if (cache)
+		{
+			// Seed every worker with what the target cache already knows, so warm pipelines stay warm.
+			std::vector<rsl::byte> initialData;
+			rsl::size_type dataSize = 0;
+			auto& nativeCache = get_native_ref(cache);
+			if (impl.functions->vkGetPipelineCacheData(
+					impl.device, nativeCache.pipelineCache, &dataSize, nullptr
+				) == VK_SUCCESS)
+			{
+				initialData.resize(dataSize);
+				VkResult result = impl.functions->vkGetPipelineCacheData(
+					impl.device, nativeCache.pipelineCache, &dataSize, initialData.data()
+				);
+				if (result != VK_SUCCESS)
+				{
+					dataSize = 0;
+				}
+				initialData.resize(dataSize);
+			}
+
+			const VkPipelineCacheCreateInfo pipelineCacheCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.initialDataSize = initialData.size(),
+				.pInitialData = initialData.data(),
+			};
+
+			batch->workerCaches.reserve(threadCount);
+			for (rsl::size_type i = 0; i < threadCount; i++)
+			{
+				VkPipelineCache workerCache = VK_NULL_HANDLE;
+				VkResult result = impl.functions->vkCreatePipelineCache(
+					impl.device, &pipelineCacheCreateInfo, impl.allocCallbacks, &workerCache
+				);
+				if (result != VK_SUCCESS || workerCache == VK_NULL_HANDLE)
+				{
+					std::cout << "Failed to create worker pipeline cache " << i << '\n';
+					continue;
+				}
+
+				batch->workerCaches.push_back(workerCache);
+			}
+		}
+
+		batch->activeWorkerCount.store(threadCount, std::memory_order_relaxed);
+		batch->workers.reserve(threadCount);
+		for (rsl::size_type i = 0; i < threadCount; i++)
+		{
+			VkPipelineCache workerCache = i < batch->workerCaches.size() ? batch->workerCaches[i] : VK_NULL_HANDLE;
+			batch->workers.emplace_back(run_pipeline_batch_worker, std::ref(*batch), workerCache);
+		}
+
+		pipeline_batch result;
+		set_native_handle(result, create_native_handle(batch));
+		return result;
+	}
+
+	shader_module::operator bool() const noexcept
+	{
+		auto* impl = get_native_ptr(*this);
+		return impl != nullptr && impl->shaderModule != VK_NULL_HANDLE;
+	}
+
+	void shader_module::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		m_nativeShaderModule = invalid_native_shader_module;
+
+		auto& renderDevice = get_native_ref(impl->renderDevice);
+		{
+			std::lock_guard lock(renderDevice.shaderModuleMutex);
+			if (--impl->refCount != 0)
+			{
+				return;
+			}
+
+			renderDevice.shaderModules.erase(impl->key);
+		}
+
+		renderDevice.functions->vkDestroyShaderModule(renderDevice.device, impl->shaderModule, impl->allocCallbacks);
+		deallocate<native_shader_module_vk>(*impl->alloc, impl);
+	}
+
+	rsl::uint64 shader_module::get_hash() const noexcept
+	{
+		return get_native_ref(*this).key.hash;
+	}
+
+	const shader_reflection& shader_module::get_reflection() const noexcept
+	{
+		return get_native_ref(*this).reflection;
+	}
+
+	shader_pack::operator bool() const noexcept
+	{
+		auto* impl = get_native_ptr(*this);
+		return impl != nullptr && impl->mappedData != nullptr;
+	}
+
+	void shader_pack::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		unmap_shader_pack(*impl);
+
+		m_nativeShaderPack = invalid_native_shader_pack;
+		deallocate<native_shader_pack_vk>(*impl->alloc, impl);
+	}
+
+	rsl::size_type shader_pack::get_shader_count() const noexcept
+	{
+		return get_native_ref(*this).entries.size();
+	}
+
+	std::string_view shader_pack::get_shader_name(rsl::size_type index) const noexcept
+	{
+		auto& impl = get_native_ref(*this);
+		auto& entry = impl.entries[index];
+		return std::string_view(reinterpret_cast<const char*>(impl.mappedData + entry.nameOffset), entry.nameSize);
+	}
+
+	std::span<const rsl::uint32> shader_pack::get_shader_code(rsl::size_type index) const noexcept
+	{
+		auto& impl = get_native_ref(*this);
+		auto& entry = impl.entries[index];
+		return std::span<const rsl::uint32>(
+			reinterpret_cast<const rsl::uint32*>(impl.mappedData + entry.dataOffset),
+			static_cast<rsl::size_type>(entry.dataSize / sizeof(rsl::uint32))
+		);
+	}
+
+	rsl::size_type shader_pack::find_shader(std::string_view name) const noexcept
+	{
+		auto& impl = get_native_ref(*this);
+		auto iter = impl.entryIndices.find(name);
+		return iter != impl.entryIndices.end() ? iter->second : rsl::npos;
+	}
+
+	[[nodiscard]] shader_module shader_pack::load_shader_module(rsl::size_type index)
+	{
+		return get_native_ref(*this).renderDevice.create_shader_module(get_shader_code(index));
+	}
+
+	[[nodiscard]] shader_module shader_pack::load_shader_module(std::string_view name)
+	{
+		rsl::size_type index = find_shader(name);
+		if (index == rsl::npos)
+		{
+			std::cout << "Shader pack " << get_native_ref(*this).filePath << " has no shader named " << name << '\n';
+			return {};
+		}
+
+		return load_shader_module(index);
+	}
+
+	descriptor_set_layout::operator bool() const noexcept
+	{
+		auto* impl = get_native_ptr(*this);
+		return impl != nullptr && impl->descriptorSetLayout != VK_NULL_HANDLE;
+	}
+
+	void descriptor_set_layout::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		m_nativeDescriptorSetLayout = invalid_native_descriptor_set_layout;
+
+		auto& renderDevice = get_native_ref(impl->renderDevice);
+		{
+			std::lock_guard lock(renderDevice.descriptorSetLayoutMutex);
+			if (--impl->refCount != 0)
+			{
+				return;
+			}
+
+			renderDevice.descriptorSetLayouts.erase(impl->key);
+		}
+
+		renderDevice.functions->vkDestroyDescriptorSetLayout(
+			renderDevice.device, impl->descriptorSetLayout, impl->allocCallbacks
+		);
+		deallocate<native_descriptor_set_layout_vk>(*impl->alloc, impl);
+	}
+
+	const descriptor_set_layout_description& descriptor_set_layout::get_description() const noexcept
+	{
+		return get_native_ref(*this).description;
+	}
+
+	pipeline_layout::operator bool() const noexcept
+	{
+		auto* impl = get_native_ptr(*this);
+		return impl != nullptr && impl->pipelineLayout != VK_NULL_HANDLE;
+	}
+
+	void pipeline_layout::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		m_nativePipelineLayout = invalid_native_pipeline_layout;
+
+		auto& renderDevice = get_native_ref(impl->renderDevice);
+		{
+			std::lock_guard lock(renderDevice.pipelineLayoutMutex);
+			if (--impl->refCount != 0)
+			{
+				return;
+			}
+
+			renderDevice.pipelineLayouts.erase(impl->key);
+		}
+
+		evict_pipeline_libraries(renderDevice, impl);
+		destroy_pipeline_layout(impl);
+	}
+
+	rsl::size_type pipeline_layout::get_descriptor_set_count() const noexcept
+	{
+		return get_native_ref(*this).descriptorSetLayouts.size();
+	}
+
+	descriptor_set_layout pipeline_layout::get_descriptor_set_layout(rsl::size_type set) const noexcept
+	{
+		return get_native_ref(*this).descriptorSetLayouts[set];
+	}
+
+	render_pass::operator bool() const noexcept
+	{
+		auto* impl = get_native_ptr(*this);
+		return impl != nullptr && impl->renderPass != VK_NULL_HANDLE;
+	}
+
+	void render_pass::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		m_nativeRenderPass = invalid_native_render_pass;
+
+		auto& renderDevice = get_native_ref(impl->renderDevice);
+		{
+			std::lock_guard lock(renderDevice.renderPassMutex);
+			if (--impl->refCount != 0)
+			{
+				return;
+			}
+
+			renderDevice.renderPasses.erase(impl->key);
+		}
+
+		// Cached framebuffers don't reference the render pass after creation, they stay usable with compatible ones.
+		renderDevice.functions->vkDestroyRenderPass(renderDevice.device, impl->renderPass, impl->allocCallbacks);
+		deallocate<native_render_pass_vk>(*impl->alloc, impl);
+	}
+
+	pipeline::operator bool() const noexcept
+	{
+		auto* impl = get_native_ptr(*this);
+		return impl != nullptr && impl->pipeline != VK_NULL_HANDLE;
+	}
+
+	void pipeline::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		m_nativePipeline = invalid_native_pipeline;
+
+		auto& renderDevice = get_native_ref(impl->renderDevice);
+		{
+			std::lock_guard lock(renderDevice.pipelineMutex);
+			if (--impl->refCount != 0)
+			{
+				return;
+			}
+
+			renderDevice.pipelines.erase(impl->key);
+		}
+
+		renderDevice.functions->vkDestroyPipeline(renderDevice.device, impl->pipeline, impl->allocCallbacks);
+		if (VkPipeline optimizedPipeline = impl->optimizedPipeline.load())
+		{
+			renderDevice.functions->vkDestroyPipeline(renderDevice.device, optimizedPipeline, impl->allocCallbacks);
+		}
+		impl->layout.release();
+		deallocate<native_pipeline_vk>(*impl->alloc, impl);
+	}
+
+	pipeline_bind_point pipeline::get_bind_point() const noexcept
+	{
+		return get_native_ref(*this).bindPoint;
+	}
+
+	dynamic_state_flags pipeline::get_dynamic_state() const noexcept
+	{
+		return get_native_ref(*this).dynamicState;
+	}
+
+	bool pipeline::is_link_pending() const noexcept
+	{
+		return get_native_ref(*this).linkPending.load();
+	}
+
+	pipeline_batch::operator bool() const noexcept
+	{
+		return get_native_ptr(*this) != nullptr;
+	}
+
+	void pipeline_batch::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		wait();
+
+		m_nativePipelineBatch = invalid_native_pipeline_batch;
+		deallocate<native_pipeline_batch_vk>(*impl->alloc, impl);
+	}
+
+	void pipeline_batch::wait()
+	{
+		auto& impl = get_native_ref(*this);
+
+		for (auto& worker : impl.workers)
+		{
+			if (worker.joinable())
+			{
+				worker.join();
+			}
+		}
+	}
+
+	bool pipeline_batch::is_done() const noexcept
+	{
+		return get_native_ref(*this).done.load(std::memory_order_acquire);
+	}
+
+	rsl::size_type pipeline_batch::get_completed_count() const noexcept
+	{
+		return get_native_ref(*this).completedCount.load(std::memory_order_acquire);
+	}
+
+	std::span<const std::shared_future<pipeline>> pipeline_batch::get_graphics_pipelines() const noexcept
+	{
+		return get_native_ref(*this).graphicsPipelines;
+	}
+
+	std::span<const std::shared_future<pipeline>> pipeline_batch::get_compute_pipelines() const noexcept
+	{
+		return get_native_ref(*this).computePipelines;
+	}
+
+	namespace
+	{
+		[[nodiscard]] VkDescriptorPool
+		create_descriptor_pool(native_descriptor_allocator_vk& allocator, rsl::uint32 setCount)
+		{
+			auto& renderDevice = get_native_ref(allocator.renderDevice);
+
+			std::vector<VkDescriptorPoolSize> poolSizes;
+			poolSizes.reserve(allocator.description.ratios.size());
+			for (auto& ratio : allocator.description.ratios)
+			{
+				const auto descriptorCount = static_cast<rsl::uint32>(std::ceil(ratio.ratio * setCount));
+				if (descriptorCount == 0)
+				{
+					continue;
+				}
+
+				poolSizes.push_back(VkDescriptorPoolSize{
+					.type = static_cast<VkDescriptorType>(ratio.type),
+					.descriptorCount = descriptorCount,
+				});
+			}
+
+			const VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.maxSets = setCount,
+				.poolSizeCount = static_cast<rsl::uint32>(poolSizes.size()),
+				.pPoolSizes = poolSizes.data(),
+			};
+
+			VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+			VkResult result = renderDevice.functions->vkCreateDescriptorPool(
+				renderDevice.device, &descriptorPoolCreateInfo, allocator.allocCallbacks, &descriptorPool
 			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::sampleBlockMatchQCOM,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_SAMPLE_BLOCK_MATCH_BIT_QCOM)
+
+			if (result != VK_SUCCESS)
+			{
+				std::cout << "Failed to create descriptor pool for " << setCount << " sets\n";
+				return VK_NULL_HANDLE;
+			}
+
+			return descriptorPool;
+		}
+
+		// Makes a pool with free space current, reusing a pool that was reset before creating a new one.
+		[[nodiscard]] bool advance_descriptor_pool(native_descriptor_allocator_vk& allocator)
+		{
+			if (allocator.currentPool != VK_NULL_HANDLE)
+			{
+				allocator.fullPools.push_back(allocator.currentPool);
+				allocator.currentPool = VK_NULL_HANDLE;
+			}
+
+			if (!allocator.readyPools.empty())
+			{
+				allocator.currentPool = allocator.readyPools.back();
+				allocator.readyPools.pop_back();
+				return true;
+			}
+
+			allocator.currentPool = create_descriptor_pool(allocator, allocator.nextPoolSetCount);
+			if (allocator.currentPool == VK_NULL_HANDLE)
+			{
+				return false;
+			}
+
+			// Never shrinks, a growth factor below one would otherwise end in pools without room for a set.
+			const auto grownSetCount =
+				static_cast<rsl::uint32>(allocator.nextPoolSetCount * allocator.description.growthFactor);
+			allocator.nextPoolSetCount = rsl::math::min(
+				rsl::math::max(grownSetCount, allocator.nextPoolSetCount), allocator.description.maxSetsPerPool
 			);
-			result = rsl::enum_flags::set_flag(
-				result, image_usage_flags::hostTransfer,
-				rsl::enum_flags::has_flag(flags, VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT)
+			return true;
+		}
+
+		[[nodiscard]] bool allocate_descriptor_sets(
+			native_descriptor_allocator_vk& allocator, std::span<const VkDescriptorSetLayout> layouts,
+			VkDescriptorSet* sets
+		)
+		{
+			auto& renderDevice = get_native_ref(allocator.renderDevice);
+
+			if (allocator.currentPool == VK_NULL_HANDLE && !advance_descriptor_pool(allocator))
+			{
+				return false;
+			}
+
+			VkDescriptorSetAllocateInfo allocateInfo{
+				.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+				.pNext = nullptr,
+				.descriptorPool = allocator.currentPool,
+				.descriptorSetCount = static_cast<rsl::uint32>(layouts.size()),
+				.pSetLayouts = layouts.data(),
+			};
+
+			VkResult result = renderDevice.functions->vkAllocateDescriptorSets(
+				renderDevice.device, &allocateInfo, sets
 			);
 
-			return result;
+			// An exhausted or fragmented pool is expected, move on to a fresh pool and try once more.
+			if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+			{
+				if (!advance_descriptor_pool(allocator))
+				{
+					return false;
+				}
+
+				allocateInfo.descriptorPool = allocator.currentPool;
+				result = renderDevice.functions->vkAllocateDescriptorSets(renderDevice.device, &allocateInfo, sets);
+			}
+
+			if (result != VK_SUCCESS)
+			{
+				std::cout << "Failed to allocate " << layouts.size() << " descriptor sets\n";
+				return false;
+			}
+
+			allocator.allocatedSetCount += layouts.size();
+			return true;
+		}
+	} // namespace
+
+	[[nodiscard]] descriptor_allocator
+	render_device::create_descriptor_allocator(const descriptor_allocator_description& description)
+	{
+		auto& impl = get_native_ref(*this);
+
+		native_descriptor_allocator_vk* nativeAllocator = allocate<native_descriptor_allocator_vk>(*impl.alloc);
+		nativeAllocator->renderDevice = *this;
+		nativeAllocator->alloc = impl.alloc;
+		nativeAllocator->allocCallbacks = impl.allocCallbacks;
+		nativeAllocator->description = description;
+
+		// A pool without room for a single set could never hand one out.
+		auto& maxSetsPerPool = nativeAllocator->description.maxSetsPerPool;
+		maxSetsPerPool = rsl::math::max(maxSetsPerPool, 1u);
+		nativeAllocator->nextPoolSetCount =
+			rsl::math::max(rsl::math::min(description.initialSetsPerPool, maxSetsPerPool), 1u);
+
+		descriptor_allocator allocator;
+		set_native_handle(allocator, create_native_handle(nativeAllocator));
+		return allocator;
+	}
+
+	descriptor_set::operator bool() const noexcept
+	{
+		return m_nativeDescriptorSet != invalid_native_descriptor_set;
+	}
+
+	descriptor_allocator::operator bool() const noexcept
+	{
+		return get_native_ptr(*this) != nullptr;
+	}
+
+	void descriptor_allocator::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		auto& renderDevice = get_native_ref(impl->renderDevice);
+
+		auto destroyPool = [&](VkDescriptorPool pool) {
+			renderDevice.functions->vkDestroyDescriptorPool(renderDevice.device, pool, impl->allocCallbacks);
+		};
+
+		if (impl->currentPool != VK_NULL_HANDLE)
+		{
+			destroyPool(impl->currentPool);
+		}
+
+		for (VkDescriptorPool pool : impl->fullPools) { destroyPool(pool); }
+		for (VkDescriptorPool pool : impl->readyPools) { destroyPool(pool); }
+		renderDevice.descriptorPoolResetCount.fetch_add(1, std::memory_order_release);
+
+		m_nativeDescriptorAllocator = invalid_native_descriptor_allocator;
+		deallocate<native_descriptor_allocator_vk>(*impl->alloc, impl);
+	}
+
+	[[nodiscard]] descriptor_set descriptor_allocator::allocate(descriptor_set_layout layout)
+	{
+		const VkDescriptorSetLayout vkLayout = get_native_ref(layout).descriptorSetLayout;
+
+		VkDescriptorSet vkDescriptorSet = VK_NULL_HANDLE;
+		if (!allocate_descriptor_sets(get_native_ref(*this), std::span(&vkLayout, 1), &vkDescriptorSet))
+		{
+			return {};
+		}
+
+		descriptor_set result;
+		set_native_handle(result, std::bit_cast<native_descriptor_set>(vkDescriptorSet));
+		return result;
+	}
+
+	[[nodiscard]] bool
+	descriptor_allocator::allocate(std::span<const descriptor_set_layout> layouts, std::span<descriptor_set> sets)
+	{
+		rsl_assert_msg_consistent(layouts.size() == sets.size(), "Need exactly one set per layout.");
+
+		std::vector<VkDescriptorSetLayout> vkLayouts;
+		vkLayouts.reserve(layouts.size());
+		for (auto& layout : layouts) { vkLayouts.push_back(get_native_ref(layout).descriptorSetLayout); }
+
+		std::vector<VkDescriptorSet> vkDescriptorSets(layouts.size(), VK_NULL_HANDLE);
+		if (!allocate_descriptor_sets(get_native_ref(*this), vkLayouts, vkDescriptorSets.data()))
+		{
+			return false;
+		}
+
+		for (rsl::size_type i = 0; i < sets.size(); i++)
+		{
+			set_native_handle(sets[i], std::bit_cast<native_descriptor_set>(vkDescriptorSets[i]));
+		}
+
+		return true;
+	}
+
+	void descriptor_allocator::reset()
+	{
+		auto& impl = get_native_ref(*this);
+		auto& renderDevice = get_native_ref(impl.renderDevice);
+
+		if (impl.currentPool != VK_NULL_HANDLE)
+		{
+			impl.fullPools.push_back(impl.currentPool);
+			impl.currentPool = VK_NULL_HANDLE;
+		}
+
+		for (VkDescriptorPool pool : impl.fullPools)
+		{
+			renderDevice.functions->vkResetDescriptorPool(renderDevice.device, pool, 0);
+			impl.readyPools.push_back(pool);
+		}
+
+		impl.fullPools.clear();
+		impl.allocatedSetCount = 0;
+		renderDevice.descriptorPoolResetCount.fetch_add(1, std::memory_order_release);
+	}
+
+	rsl::size_type descriptor_allocator::get_pool_count() const noexcept
+	{
+		auto& impl = get_native_ref(*this);
+		return impl.fullPools.size() + impl.readyPools.size() + (impl.currentPool != VK_NULL_HANDLE ? 1 : 0);
+	}
+
+	rsl::size_type descriptor_allocator::get_allocated_set_count() const noexcept
+	{
+		return get_native_ref(*this).allocatedSetCount;
+	}
+
+	namespace
+	{
+		[[nodiscard]] constexpr bool is_image_descriptor(VkDescriptorType type) noexcept
+		{
+			switch (type)
+			{
+				case VK_DESCRIPTOR_TYPE_SAMPLER: [[fallthrough]];
+				case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER: [[fallthrough]];
+				case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE: [[fallthrough]];
+				case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE: [[fallthrough]];
+				case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT: return true;
+				default: return false;
+			}
+		}
+
+		// Texel buffers are written through buffer views, which the writer doesn't take.
+		[[nodiscard]] constexpr bool is_buffer_descriptor(VkDescriptorType type) noexcept
+		{
+			switch (type)
+			{
+				case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER: [[fallthrough]];
+				case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER: [[fallthrough]];
+				case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC: [[fallthrough]];
+				case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC: return true;
+				default: return false;
+			}
+		}
+
+		template <typename Info>
+		void queue_descriptor_write(
+			native_descriptor_writer_vk& writer, std::vector<Info>& infos, VkDescriptorSet set, rsl::uint32 binding,
+			rsl::uint32 arrayElement, VkDescriptorType type, const Info& info
+		)
+		{
+			const rsl::uint64 descriptorKey = (static_cast<rsl::uint64>(binding) << 32) | arrayElement;
+
+			// Once a pool has been reset its sets can come back with the same handle, so nothing we remember holds.
+			auto& renderDevice = get_native_ref(writer.renderDevice);
+			const rsl::uint64 poolResetCount = renderDevice.descriptorPoolResetCount.load(std::memory_order_acquire);
+			if (poolResetCount != writer.observedPoolResetCount)
+			{
+				writer.writtenContents.clear();
+				writer.observedPoolResetCount = poolResetCount;
+			}
+
+			auto& written = writer.writtenContents[set][descriptorKey];
+			if (written.matches(type, info))
+			{
+				writer.droppedCount++;
+				return;
+			}
+			written.assign(type, info);
+
+			auto& pendingWrites = writer.pendingWrites[set];
+			if (auto iter = pendingWrites.find(descriptorKey); iter != pendingWrites.end())
+			{
+				VkWriteDescriptorSet& pending = writer.writes[iter->second];
+				if (is_image_descriptor(pending.descriptorType) == is_image_descriptor(type))
+				{
+					pending.descriptorType = type;
+					infos[writer.infoIndices[iter->second]] = info;
+					writer.droppedCount++;
+					return;
+				}
+			}
+
+			pendingWrites[descriptorKey] = writer.writes.size();
+			writer.infoIndices.push_back(infos.size());
+			infos.push_back(info);
+
+			writer.writes.push_back(VkWriteDescriptorSet{
+				.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+				.pNext = nullptr,
+				.dstSet = set,
+				.dstBinding = binding,
+				.dstArrayElement = arrayElement,
+				.descriptorCount = 1,
+				.descriptorType = type,
+				.pImageInfo = nullptr,
+				.pBufferInfo = nullptr,
+				.pTexelBufferView = nullptr,
+			});
+		}
+	} // namespace
+
+	[[nodiscard]] descriptor_writer render_device::create_descriptor_writer()
+	{
+		auto& impl = get_native_ref(*this);
+
+		native_descriptor_writer_vk* nativeWriter = allocate<native_descriptor_writer_vk>(*impl.alloc);
+		nativeWriter->renderDevice = *this;
+		nativeWriter->alloc = impl.alloc;
+		nativeWriter->allocCallbacks = impl.allocCallbacks;
+		nativeWriter->observedPoolResetCount = impl.descriptorPoolResetCount.load(std::memory_order_acquire);
+
+		descriptor_writer writer;
+		set_native_handle(writer, create_native_handle(nativeWriter));
+		return writer;
+	}
+
+	descriptor_writer::operator bool() const noexcept
+	{
+		return get_native_ptr(*this) != nullptr;
+	}
+
+	void descriptor_writer::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		m_nativeDescriptorWriter = invalid_native_descriptor_writer;
+		deallocate<native_descriptor_writer_vk>(*impl->alloc, impl);
+	}
+
+	void descriptor_writer::write_buffer(
+		descriptor_set set, rsl::uint32 binding, descriptor_type type, buffer_handle buffer, rsl::uint64 offset,
+		rsl::uint64 range, rsl::uint32 arrayElement
+	)
+	{
+		if (!is_buffer_descriptor(static_cast<VkDescriptorType>(type)))
+		{
+			std::cout << "write_buffer only writes uniform and storage buffer descriptors\n";
+			return;
+		}
+
+		const VkDescriptorBufferInfo bufferInfo{
+			.buffer = std::bit_cast<VkBuffer>(buffer),
+			.offset = offset,
+			.range = range,
+		};
+
+		auto& impl = get_native_ref(*this);
+		queue_descriptor_write(
+			impl, impl.bufferInfos, std::bit_cast<VkDescriptorSet>(set.get_native_handle()), binding, arrayElement,
+			static_cast<VkDescriptorType>(type), bufferInfo
+		);
+	}
+
+	void descriptor_writer::write_image(
+		descriptor_set set, rsl::uint32 binding, descriptor_type type, image_view_handle imageView, image_layout layout,
+		sampler_handle sampler, rsl::uint32 arrayElement
+	)
+	{
+		if (!is_image_descriptor(static_cast<VkDescriptorType>(type)))
+		{
+			std::cout << "write_image only writes image and sampler descriptors\n";
+			return;
+		}
+
+		const VkDescriptorImageInfo imageInfo{
+			.sampler = std::bit_cast<VkSampler>(sampler),
+			.imageView = std::bit_cast<VkImageView>(imageView),
+			.imageLayout = static_cast<VkImageLayout>(layout),
+		};
+
+		auto& impl = get_native_ref(*this);
+		queue_descriptor_write(
+			impl, impl.imageInfos, std::bit_cast<VkDescriptorSet>(set.get_native_handle()), binding, arrayElement,
+			static_cast<VkDescriptorType>(type), imageInfo
+		);
+	}
+
+	rsl::size_type descriptor_writer::flush()
+	{
+		auto& impl = get_native_ref(*this);
+
+		const rsl::size_type writeCount = impl.writes.size();
+		if (writeCount == 0)
+		{
+			return 0;
+		}
+
+		for (rsl::size_type i = 0; i < writeCount; i++)
+		{
+			auto& write = impl.writes[i];
+			if (is_image_descriptor(write.descriptorType))
+			{
+				write.pImageInfo = &impl.imageInfos[impl.infoIndices[i]];
+			}
+			else
+			{
+				write.pBufferInfo = &impl.bufferInfos[impl.infoIndices[i]];
+			}
+		}
+
+		auto& renderDevice = get_native_ref(impl.renderDevice);
+		renderDevice.functions->vkUpdateDescriptorSets(
+			renderDevice.device, static_cast<rsl::uint32>(writeCount), impl.writes.data(), 0, nullptr
+		);
+
+		impl.writes.clear();
+		impl.infoIndices.clear();
+		impl.bufferInfos.clear();
+		impl.imageInfos.clear();
+		impl.pendingWrites.clear();
+
+		return writeCount;
+	}
+
+	void descriptor_writer::invalidate(descriptor_set set)
+	{
+		get_native_ref(*this).writtenContents.erase(std::bit_cast<VkDescriptorSet>(set.get_native_handle()));
+	}
+
+	void descriptor_writer::invalidate_all()
+	{
+		get_native_ref(*this).writtenContents.clear();
+	}
+
+	rsl::size_type descriptor_writer::get_pending_count() const noexcept
+	{
+		return get_native_ref(*this).writes.size();
+	}
+
+	rsl::size_type descriptor_writer::get_dropped_count() const noexcept
+	{
+		return get_native_ref(*this).droppedCount;
+	}
+
+	namespace
+	{
+		[[nodiscard]] sampler_description canonicalize_sampler_description(
+			sampler_description description, const physical_device_limits& limits, bool anisotropyEnabled
+		) noexcept
+		{
+			if (!anisotropyEnabled)
+			{
+				description.anisotropyEnable = false;
+			}
+
+			if (description.anisotropyEnable)
+			{
+				description.maxAnisotropy = std::clamp(description.maxAnisotropy, 1.f, limits.maxSamplerAnisotropy);
+			}
+			else
+			{
+				description.maxAnisotropy = 1.f;
+			}
+
+			if (!description.compareEnable)
+			{
+				description.compareOp = compare_op::never;
+			}
+
+			const bool usesBorder = description.addressModeU == sampler_address_mode::clampToBorder ||
+									description.addressModeV == sampler_address_mode::clampToBorder ||
+									description.addressModeW == sampler_address_mode::clampToBorder;
+			if (!usesBorder)
+			{
+				description.borderColor = border_color::floatTransparentBlack;
+			}
+
+			return description;
+		}
+
+		[[nodiscard]] cache_key make_sampler_key(const sampler_description& description)
+		{
+			cache_key key;
+			key.append(description.magFilter);
+			key.append(description.minFilter);
+			key.append(description.mipmapMode);
+			key.append(description.addressModeU);
+			key.append(description.addressModeV);
+			key.append(description.addressModeW);
+			key.append(description.mipLodBias);
+			key.append(description.anisotropyEnable);
+			key.append(description.maxAnisotropy);
+			key.append(description.compareEnable);
+			key.append(description.compareOp);
+			key.append(description.minLod);
+			key.append(description.maxLod);
+			key.append(description.borderColor);
+			key.append(description.unnormalizedCoordinates);
+			return key;
+		}
+	} // namespace
+
+	[[nodiscard]] sampler render_device::create_sampler(const sampler_description& description)
+	{
+		auto& impl = get_native_ref(*this);
+
+		const physical_device_limits& limits = impl.physicalDevice.get_properties().limits;
+		const sampler_description canonicalDescription = canonicalize_sampler_description(
+			description, limits, impl.enabledFeatures.has(physical_device_feature::samplerAnisotropy)
+		);
+		cache_key key = make_sampler_key(canonicalDescription);
+
+		std::lock_guard lock(impl.samplerMutex);
+
+		sampler result;
+
+		if (auto iter = impl.samplers.find(key); iter != impl.samplers.end())
+		{
+			iter->second->refCount++;
+			set_native_handle(result, create_native_handle(iter->second));
+			return result;
+		}
+
+		const rsl::size_type liveCount = impl.samplers.size();
+		if (liveCount >= limits.maxSamplerAllocationCount)
+		{
+			std::cout << "Failed to create sampler, all " << limits.maxSamplerAllocationCount
+					  << " sampler allocations are in use\n";
+			return {};
+		}
+
+		// Warn once when crossing 90% of the limit, rearmed when usage drops back below it.
+		const rsl::size_type warningThreshold = limits.maxSamplerAllocationCount / 10 * 9;
+		if (liveCount >= warningThreshold && !impl.samplerLimitWarned)
+		{
+			std::cout << "Warning: " << liveCount + 1 << " of " << limits.maxSamplerAllocationCount
+					  << " sampler allocations in use\n";
+			impl.samplerLimitWarned = true;
+		}
+
+		const VkSamplerCreateInfo samplerCreateInfo{
+			.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.magFilter = static_cast<VkFilter>(canonicalDescription.magFilter),
+			.minFilter = static_cast<VkFilter>(canonicalDescription.minFilter),
+			.mipmapMode = static_cast<VkSamplerMipmapMode>(canonicalDescription.mipmapMode),
+			.addressModeU = static_cast<VkSamplerAddressMode>(canonicalDescription.addressModeU),
+			.addressModeV = static_cast<VkSamplerAddressMode>(canonicalDescription.addressModeV),
+			.addressModeW = static_cast<VkSamplerAddressMode>(canonicalDescription.addressModeW),
+			.mipLodBias = canonicalDescription.mipLodBias,
+			.anisotropyEnable = canonicalDescription.anisotropyEnable ? VK_TRUE : VK_FALSE,
+			.maxAnisotropy = canonicalDescription.maxAnisotropy,
+			.compareEnable = canonicalDescription.compareEnable ? VK_TRUE : VK_FALSE,
+			.compareOp = static_cast<VkCompareOp>(canonicalDescription.compareOp),
+			.minLod = canonicalDescription.minLod,
+			.maxLod = canonicalDescription.maxLod,
+			.borderColor = static_cast<VkBorderColor>(canonicalDescription.borderColor),
+			.unnormalizedCoordinates = canonicalDescription.unnormalizedCoordinates ? VK_TRUE : VK_FALSE,
+		};
+
+		VkSampler vkSampler = VK_NULL_HANDLE;
+		VkResult vkResult = impl.functions->vkCreateSampler(
+			impl.device, &samplerCreateInfo, impl.allocCallbacks, &vkSampler
+		);
+
+		if (vkResult != VK_SUCCESS || vkSampler == VK_NULL_HANDLE)
+		{
+			std::cout << "Failed to create sampler\n";
+			return {};
+		}
+
+		native_sampler_vk* nativeSampler = allocate<native_sampler_vk>(*impl.alloc);
+		nativeSampler->renderDevice = *this;
+		nativeSampler->alloc = impl.alloc;
+		nativeSampler->allocCallbacks = impl.allocCallbacks;
+		nativeSampler->key = key;
+		nativeSampler->description = canonicalDescription;
+		nativeSampler->sampler = vkSampler;
+		impl.samplers.emplace(std::move(key), nativeSampler);
+
+		set_native_handle(result, create_native_handle(nativeSampler));
+		return result;
+	}
+
+	rsl::size_type render_device::get_live_sampler_count() const noexcept
+	{
+		auto& impl = get_native_ref(*this);
+		std::lock_guard lock(impl.samplerMutex);
+		return impl.samplers.size();
+	}
+
+	sampler::operator bool() const noexcept
+	{
+		auto* impl = get_native_ptr(*this);
+		return impl != nullptr && impl->sampler != VK_NULL_HANDLE;
+	}
+
+	void sampler::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		m_nativeSampler = invalid_native_sampler;
+
+		auto& renderDevice = get_native_ref(impl->renderDevice);
+		{
+			std::lock_guard lock(renderDevice.samplerMutex);
+			if (--impl->refCount != 0)
+			{
+				return;
+			}
+
+			renderDevice.samplers.erase(impl->key);
+
+			const physical_device_limits& limits = renderDevice.physicalDevice.get_properties().limits;
+			if (renderDevice.samplers.size() < limits.maxSamplerAllocationCount / 10 * 9)
+			{
+				renderDevice.samplerLimitWarned = false;
+			}
+		}
+
+		renderDevice.functions->vkDestroySampler(renderDevice.device, impl->sampler, impl->allocCallbacks);
+		deallocate<native_sampler_vk>(*impl->alloc, impl);
+	}
+
+	const sampler_description& sampler::get_description() const noexcept
+	{
+		return get_native_ref(*this).description;
+	}
+
+	sampler_handle sampler::get_sampler_handle() const noexcept
+	{
+		return std::bit_cast<sampler_handle>(get_native_ref(*this).sampler);
+	}
+
+	const descriptor_indexing_capabilities& render_device::get_descriptor_indexing_capabilities() const noexcept
+	{
+		return get_native_ref(*this).descriptorIndexing;
+	}
+
+	namespace
+	{
+		struct bindless_binding_setup
+		{
+			bindless_binding binding;
+			descriptor_type type;
+			rsl::uint32 requestedCapacity;
+			bool updateAfterBind;
+			rsl::uint32 maxPerStage;
+			rsl::uint32 maxPerSet;
+		};
+
+		// Takes a free slot, fills it and writes the descriptor. Returns invalid_slot when the binding is full.
+		[[nodiscard]] rsl::uint32 allocate_bindless_slot(
+			native_bindless_table_vk& table, bindless_binding binding, const VkDescriptorImageInfo* imageInfo,
+			const VkDescriptorBufferInfo* bufferInfo
+		)
+		{
+			static constexpr VkDescriptorType descriptorTypes[] = {
+				VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+				VK_DESCRIPTOR_TYPE_SAMPLER,
+				VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+				VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+			};
+
+			const auto bindingIndex = static_cast<rsl::uint32>(binding);
+			auto& slots = table.bindings[bindingIndex];
+
+			std::lock_guard lock(table.mutex);
+
+			rsl::uint32 slot = bindless_table::invalid_slot;
+			if (!slots.freeSlots.empty())
+			{
+				slot = slots.freeSlots.back();
+				slots.freeSlots.pop_back();
+			}
+			else if (slots.highWaterMark < slots.capacity)
+			{
+				slot = slots.highWaterMark++;
+			}
+			else
+			{
+				std::cout << "Bindless table binding " << bindingIndex << " is full (" << slots.capacity << " slots)\n";
+				return bindless_table::invalid_slot;
+			}
+			slots.allocatedSlots[slot] = true;
+
+			const VkWriteDescriptorSet write{
+				.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+				.pNext = nullptr,
+				.dstSet = table.descriptorSet,
+				.dstBinding = bindingIndex,
+				.dstArrayElement = slot,
+				.descriptorCount = 1,
+				.descriptorType = descriptorTypes[bindingIndex],
+				.pImageInfo = imageInfo,
+				.pBufferInfo = bufferInfo,
+				.pTexelBufferView = nullptr,
+			};
+
+			auto& renderDevice = get_native_ref(table.renderDevice);
+			renderDevice.functions->vkUpdateDescriptorSets(renderDevice.device, 1, &write, 0, nullptr);
+
+			return slot;
+		}
+	} // namespace
+
+	bindless_table render_device::create_bindless_table(const bindless_table_description& description)
+	{
+		auto& impl = get_native_ref(*this);
+		const descriptor_indexing_capabilities& indexing = impl.descriptorIndexing;
+
+		// Slots that were never written are left undefined, which is only valid for partially bound bindings.
+		if (!indexing.descriptorBindingPartiallyBound)
+		{
+			std::cout << "Bindless tables require descriptorBindingPartiallyBound, enable "
+						 "VK_EXT_descriptor_indexing on the render device\n";
+			return {};
+		}
+
+		const physical_device_limits& limits = impl.physicalDevice.get_properties().limits;
+
+		const bool sampledImageUpdateAfterBind = indexing.descriptorBindingSampledImageUpdateAfterBind;
+		const bool storageBufferUpdateAfterBind = indexing.descriptorBindingStorageBufferUpdateAfterBind;
+		const bool storageImageUpdateAfterBind = indexing.descriptorBindingStorageImageUpdateAfterBind;
+
+		// Update after bind bindings are limited by the separate, usually much larger, update after bind limits.
+		const bindless_binding_setup setups[] = {
+			{
+				.binding = bindless_binding::sampledImage,
+				.type = descriptor_type::sampledImage,
+				.requestedCapacity = description.sampledImageCapacity,
+				.updateAfterBind = sampledImageUpdateAfterBind,
+				.maxPerStage = sampledImageUpdateAfterBind ? indexing.maxPerStageDescriptorUpdateAfterBindSampledImages
+														   : limits.maxPerStageDescriptorSampledImages,
+				.maxPerSet = sampledImageUpdateAfterBind ? indexing.maxDescriptorSetUpdateAfterBindSampledImages
+														 : limits.maxDescriptorSetSampledImages,
+			},
+			{
+				.binding = bindless_binding::sampler,
+				.type = descriptor_type::sampler,
+				.requestedCapacity = description.samplerCapacity,
+				.updateAfterBind = sampledImageUpdateAfterBind,
+				.maxPerStage = sampledImageUpdateAfterBind ? indexing.maxPerStageDescriptorUpdateAfterBindSamplers
+														   : limits.maxPerStageDescriptorSamplers,
+				.maxPerSet = sampledImageUpdateAfterBind ? indexing.maxDescriptorSetUpdateAfterBindSamplers
+														 : limits.maxDescriptorSetSamplers,
+			},
+			{
+				.binding = bindless_binding::storageBuffer,
+				.type = descriptor_type::storageBuffer,
+				.requestedCapacity = description.storageBufferCapacity,
+				.updateAfterBind = storageBufferUpdateAfterBind,
+				.maxPerStage = storageBufferUpdateAfterBind
+								   ? indexing.maxPerStageDescriptorUpdateAfterBindStorageBuffers
+								   : limits.maxPerStageDescriptorStorageBuffers,
+				.maxPerSet = storageBufferUpdateAfterBind ? indexing.maxDescriptorSetUpdateAfterBindStorageBuffers
+														  : limits.maxDescriptorSetStorageBuffers,
+			},
+			{
+				.binding = bindless_binding::storageImage,
+				.type = descriptor_type::storageImage,
+				.requestedCapacity = description.storageImageCapacity,
+				.updateAfterBind = storageImageUpdateAfterBind,
+				.maxPerStage = storageImageUpdateAfterBind ? indexing.maxPerStageDescriptorUpdateAfterBindStorageImages
+														   : limits.maxPerStageDescriptorStorageImages,
+				.maxPerSet = storageImageUpdateAfterBind ? indexing.maxDescriptorSetUpdateAfterBindStorageImages
+														 : limits.maxDescriptorSetStorageImages,
+			},
+		};
+
+		native_bindless_table_vk::binding_slots bindingSlots[4];
+		descriptor_set_layout_description layoutDescription;
+		std::vector<VkDescriptorPoolSize> poolSizes;
+		bool updateAfterBindPool = false;
+
+		// Every update after bind descriptor of every pool counts against one device wide budget, the table takes
+		// at most what is left of it after the bindings before it.
+		rsl::uint32 updateAfterBindBudget = indexing.maxUpdateAfterBindDescriptorsInAllPools;
+
+		for (auto& setup : setups)
+		{
+			rsl::uint32 capacity = std::min({setup.requestedCapacity, setup.maxPerStage, setup.maxPerSet});
+			if (setup.updateAfterBind)
+			{
+				capacity = rsl::math::min(capacity, updateAfterBindBudget);
+				updateAfterBindBudget -= capacity;
+			}
+
+			if (capacity < setup.requestedCapacity)
+			{
+				std::cout << "Bindless table binding " << static_cast<rsl::uint32>(setup.binding) << " clamped from "
+						  << setup.requestedCapacity << " to " << capacity << " slots\n";
+			}
+
+			auto& slots = bindingSlots[static_cast<rsl::uint32>(setup.binding)];
+			slots.capacity = capacity;
+			slots.allocatedSlots.assign(capacity, false);
+			slots.updateAfterBind = setup.updateAfterBind;
+
+			if (capacity == 0)
+			{
+				continue;
+			}
+
+			auto flags = descriptor_binding_flags::partiallyBound;
+			if (setup.updateAfterBind)
+			{
+				flags = rsl::enum_flags::set_flag(flags, descriptor_binding_flags::updateAfterBind, true);
+				updateAfterBindPool = true;
+			}
+			if (indexing.descriptorBindingUpdateUnusedWhilePending)
+			{
+				flags = rsl::enum_flags::set_flag(flags, descriptor_binding_flags::updateUnusedWhilePending, true);
+			}
+
+			layoutDescription.bindings.push_back(descriptor_binding_description{
+				.binding = static_cast<rsl::uint32>(setup.binding),
+				.type = setup.type,
+				.count = capacity,
+				.stages = description.stages,
+				.flags = flags,
+			});
+
+			poolSizes.push_back(VkDescriptorPoolSize{
+				.type = static_cast<VkDescriptorType>(setup.type),
+				.descriptorCount = capacity,
+			});
+		}
+
+		if (layoutDescription.bindings.empty())
+		{
+			std::cout << "Bindless table has no bindings\n";
+			return {};
+		}
+
+		descriptor_set_layout layout = create_descriptor_set_layout(layoutDescription);
+		if (!layout)
+		{
+			return {};
+		}
+
+		VkDescriptorPoolCreateFlags poolFlags = 0;
+		if (updateAfterBindPool)
+		{
+			poolFlags |= VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+		}
+
+		const VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = poolFlags,
+			.maxSets = 1,
+			.poolSizeCount = static_cast<rsl::uint32>(poolSizes.size()),
+			.pPoolSizes = poolSizes.data(),
+		};
+
+		VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+		VkResult result = impl.functions->vkCreateDescriptorPool(
+			impl.device, &descriptorPoolCreateInfo, impl.allocCallbacks, &descriptorPool
+		);
+
+		if (result != VK_SUCCESS || descriptorPool == VK_NULL_HANDLE)
+		{
+			std::cout << "Failed to create bindless descriptor pool\n";
+			layout.release();
+			return {};
+		}
+
+		const VkDescriptorSetLayout vkDescriptorSetLayout = get_native_ref(layout).descriptorSetLayout;
+		const VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+			.pNext = nullptr,
+			.descriptorPool = descriptorPool,
+			.descriptorSetCount = 1,
+			.pSetLayouts = &vkDescriptorSetLayout,
+		};
+
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		result = impl.functions->vkAllocateDescriptorSets(impl.device, &descriptorSetAllocateInfo, &descriptorSet);
+
+		if (result != VK_SUCCESS || descriptorSet == VK_NULL_HANDLE)
+		{
+			std::cout << "Failed to allocate bindless descriptor set\n";
+			impl.functions->vkDestroyDescriptorPool(impl.device, descriptorPool, impl.allocCallbacks);
+			layout.release();
+			return {};
+		}
+
+		native_bindless_table_vk* nativeTable = allocate<native_bindless_table_vk>(*impl.alloc);
+		nativeTable->renderDevice = *this;
+		nativeTable->alloc = impl.alloc;
+		nativeTable->allocCallbacks = impl.allocCallbacks;
+		for (rsl::size_type i = 0; i < std::size(bindingSlots); i++)
+		{
+			nativeTable->bindings[i] = std::move(bindingSlots[i]);
+		}
+		nativeTable->layout = layout;
+		nativeTable->descriptorPool = descriptorPool;
+		nativeTable->descriptorSet = descriptorSet;
+
+		bindless_table table;
+		set_native_handle(table, create_native_handle(nativeTable));
+		return table;
+	}
+
+	bindless_table::operator bool() const noexcept
+	{
+		auto* impl = get_native_ptr(*this);
+		return impl != nullptr && impl->descriptorSet != VK_NULL_HANDLE;
+	}
+
+	void bindless_table::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		auto& renderDevice = get_native_ref(impl->renderDevice);
+		renderDevice.functions->vkDestroyDescriptorPool(
+			renderDevice.device, impl->descriptorPool, impl->allocCallbacks
+		);
+		impl->layout.release();
+
+		deallocate<native_bindless_table_vk>(*impl->alloc, impl);
+		m_nativeBindlessTable = invalid_native_bindless_table;
+	}
+
+	rsl::uint32 bindless_table::allocate_sampled_image(image_view_handle view, image_layout layout)
+	{
+		const VkDescriptorImageInfo imageInfo{
+			.sampler = VK_NULL_HANDLE,
+			.imageView = std::bit_cast<VkImageView>(view),
+			.imageLayout = static_cast<VkImageLayout>(layout),
+		};
+
+		return allocate_bindless_slot(get_native_ref(*this), bindless_binding::sampledImage, &imageInfo, nullptr);
+	}
+
+	rsl::uint32 bindless_table::allocate_sampler(sampler_handle sampler)
+	{
+		const VkDescriptorImageInfo imageInfo{
+			.sampler = std::bit_cast<VkSampler>(sampler),
+			.imageView = VK_NULL_HANDLE,
+			.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		};
+
+		return allocate_bindless_slot(get_native_ref(*this), bindless_binding::sampler, &imageInfo, nullptr);
+	}
+
+	rsl::uint32
+	bindless_table::allocate_storage_buffer(buffer_handle buffer, rsl::size_type offset, rsl::size_type range)
+	{
+		const VkDescriptorBufferInfo bufferInfo{
+			.buffer = std::bit_cast<VkBuffer>(buffer),
+			.offset = offset,
+			.range = range == ~0ull ? VK_WHOLE_SIZE : range,
+		};
+
+		return allocate_bindless_slot(get_native_ref(*this), bindless_binding::storageBuffer, nullptr, &bufferInfo);
+	}
+
+	rsl::uint32 bindless_table::allocate_storage_image(image_view_handle view)
+	{
+		const VkDescriptorImageInfo imageInfo{
+			.sampler = VK_NULL_HANDLE,
+			.imageView = std::bit_cast<VkImageView>(view),
+			.imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+		};
+
+		return allocate_bindless_slot(get_native_ref(*this), bindless_binding::storageImage, &imageInfo, nullptr);
+	}
+
+	void bindless_table::free(bindless_binding binding, rsl::uint32 slot)
+	{
+		auto& impl = get_native_ref(*this);
+		auto& slots = impl.bindings[static_cast<rsl::uint32>(binding)];
+
+		std::lock_guard lock(impl.mutex);
+
+		if (slot >= slots.highWaterMark || !slots.allocatedSlots[slot])
+		{
+			std::cout << "Freeing bindless slot " << slot << " of binding " << static_cast<rsl::uint32>(binding)
+					  << " that isn't allocated\n";
+			return;
+		}
+
+		// Freed slots keep their stale descriptor, partially bound bindings allow that as long as nothing reads it.
+		slots.allocatedSlots[slot] = false;
+		slots.freeSlots.push_back(slot);
+	}
+
+	rsl::uint32 bindless_table::get_capacity(bindless_binding binding) const noexcept
+	{
+		return get_native_ref(*this).bindings[static_cast<rsl::uint32>(binding)].capacity;
+	}
+
+	rsl::uint32 bindless_table::get_allocated_count(bindless_binding binding) const noexcept
+	{
+		auto& impl = get_native_ref(*this);
+		auto& slots = impl.bindings[static_cast<rsl::uint32>(binding)];
+
+		std::lock_guard lock(impl.mutex);
+		return slots.highWaterMark - static_cast<rsl::uint32>(slots.freeSlots.size());
+	}
+
+	bool bindless_table::is_update_after_bind(bindless_binding binding) const noexcept
+	{
+		return get_native_ref(*this).bindings[static_cast<rsl::uint32>(binding)].updateAfterBind;
+	}
+
+	descriptor_set_layout bindless_table::get_descriptor_set_layout() const noexcept
+	{
+		return get_native_ref(*this).layout;
+	}
+
+	descriptor_set bindless_table::get_descriptor_set() const noexcept
+	{
+		descriptor_set result;
+		set_native_handle(result, std::bit_cast<native_descriptor_set>(get_native_ref(*this).descriptorSet));
+		return result;
+	}
+
+	namespace
+	{
+		// Removes every cached framebuffer that uses imageView from the cache and hands them to the caller to destroy.
+		// The caller holds framebufferMutex.
+		void evict_framebuffers(
+			native_render_device_vk& device, VkImageView imageView, std::vector<VkFramebuffer>& evicted
+		)
+		{
+			auto iter = device.framebuffersByImageView.find(imageView);
+			if (iter == device.framebuffersByImageView.end())
+			{
+				return;
+			}
+
+			const std::vector<cache_key> keys = std::move(iter->second);
+			device.framebuffersByImageView.erase(iter);
+
+			for (const cache_key& key : keys)
+			{
+				auto framebufferIter = device.framebuffers.find(key);
+				if (framebufferIter == device.framebuffers.end())
+				{
+					continue;
+				}
+
+				// Unlink the framebuffer from the other image views it uses.
+				for (VkImageView otherView : framebufferIter->second.imageViews)
+				{
+					auto otherIter = device.framebuffersByImageView.find(otherView);
+					if (otherIter == device.framebuffersByImageView.end())
+					{
+						continue;
+					}
+
+					std::erase(otherIter->second, key);
+					if (otherIter->second.empty())
+					{
+						device.framebuffersByImageView.erase(otherIter);
+					}
+				}
+
+				evicted.push_back(framebufferIter->second.framebuffer);
+				device.framebuffers.erase(framebufferIter);
+			}
+		}
+
+		void destroy_retired_image_view(native_render_device_vk& device, const retired_image_view& retired)
+		{
+			for (VkFramebuffer framebuffer : retired.framebuffers)
+			{
+				device.functions->vkDestroyFramebuffer(device.device, framebuffer, device.allocCallbacks);
+			}
+			device.functions->vkDestroyImageView(device.device, retired.imageView, device.allocCallbacks);
 		}
 	} // namespace
 
-	const surface_capabilities& physical_device::get_surface_capabilities(surface _surface, bool forceRefresh)
+	framebuffer_handle render_device::get_framebuffer(const framebuffer_description& description)
 	{
 		auto& impl = get_native_ref(*this);
 
-		if (forceRefresh || !impl.surfaceCapsLoaded)
+		auto* nativeRenderPass = get_native_ptr(description.renderPass);
+		if (!nativeRenderPass)
 		{
-			auto& nativeSurface = get_native_ref(_surface);
+			std::cout << "Framebuffers need a render pass\n";
+			return invalid_framebuffer_handle;
+		}
 
-			VkSurfaceCapabilitiesKHR vkSurfaceCaps;
-			impl.vkGetPhysicalDeviceSurfaceCapabilitiesKHR(impl.physicalDevice, nativeSurface.surface, &vkSurfaceCaps);
+		// A framebuffer can be used with any render pass compatible with the one it was created with, so only the
+		// compatibility class goes into the key.
+		cache_key key;
+		append_render_pass_compatibility(key, description.renderPass);
+		key.append(description.attachments.size());
+		for (auto& attachment : description.attachments) { key.append(attachment); }
+		key.append(description.width);
+		key.append(description.height);
+		key.append(description.layers);
 
-			impl.surfaceCaps.minImageCount = static_cast<rsl::size_type>(vkSurfaceCaps.minImageCount);
-			impl.surfaceCaps.maxImageCount = static_cast<rsl::size_type>(vkSurfaceCaps.maxImageCount);
-			impl.surfaceCaps.currentExtent =
-				rsl::math::uint2(vkSurfaceCaps.currentExtent.width, vkSurfaceCaps.currentExtent.height);
-			impl.surfaceCaps.minImageExtent =
-				rsl::math::uint2(vkSurfaceCaps.minImageExtent.width, vkSurfaceCaps.minImageExtent.height);
-			impl.surfaceCaps.maxImageExtent =
-				rsl::math::uint2(vkSurfaceCaps.maxImageExtent.width, vkSurfaceCaps.maxImageExtent.height);
-			impl.surfaceCaps.maxImageArrayLayers = static_cast<rsl::size_type>(vkSurfaceCaps.maxImageArrayLayers);
-			impl.surfaceCaps.supportedTransforms = map_vk_surface_transform_flags(
-				static_cast<VkSurfaceTransformFlagBitsKHR>(vkSurfaceCaps.supportedTransforms)
-			);
-			impl.surfaceCaps.currentTransform = map_vk_surface_transform_flags(vkSurfaceCaps.currentTransform);
-			impl.surfaceCaps.supportedCompositeAlpha = map_vk_composite_alpha_flags(
-				static_cast<VkCompositeAlphaFlagBitsKHR>(vkSurfaceCaps.supportedCompositeAlpha)
-			);
-			impl.surfaceCaps.supportedUsageFlags =
-				map_vk_image_usage_flags(static_cast<VkImageUsageFlagBits>(vkSurfaceCaps.supportedUsageFlags));
+		std::lock_guard lock(impl.framebufferMutex);
 
-			impl.surfaceCapsLoaded = true;
+		if (auto iter = impl.framebuffers.find(key); iter != impl.framebuffers.end())
+		{
+			return std::bit_cast<framebuffer_handle>(iter->second.framebuffer);
 		}
 
-		return impl.surfaceCaps;
+		std::vector<VkImageView> imageViews;
+		imageViews.reserve(description.attachments.size());
+		for (auto& attachment : description.attachments)
+		{
+			imageViews.push_back(std::bit_cast<VkImageView>(attachment));
+		}
+
+		const VkFramebufferCreateInfo framebufferCreateInfo{
+			.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.renderPass = nativeRenderPass->renderPass,
+			.attachmentCount = static_cast<rsl::uint32>(imageViews.size()),
+			.pAttachments = imageViews.data(),
+			.width = description.width,
+			.height = description.height,
+			.layers = description.layers,
+		};
+
+		VkFramebuffer vkFramebuffer = VK_NULL_HANDLE;
+		VkResult result = impl.functions->vkCreateFramebuffer(
+			impl.device, &framebufferCreateInfo, impl.allocCallbacks, &vkFramebuffer
+		);
+
+		if (result != VK_SUCCESS || vkFramebuffer == VK_NULL_HANDLE)
+		{
+			std::cout << "Failed to create framebuffer\n";
+			return invalid_framebuffer_handle;
+		}
+
+		for (VkImageView imageView : imageViews)
+		{
+			auto& framebufferKeys = impl.framebuffersByImageView[imageView];
+			if (framebufferKeys.empty() || framebufferKeys.back() != key)
+			{
+				framebufferKeys.push_back(key);
+			}
+		}
+
+		impl.framebuffers.emplace(
+			std::move(key), cached_framebuffer{.framebuffer = vkFramebuffer, .imageViews = std::move(imageViews)}
+		);
+
+		return std::bit_cast<framebuffer_handle>(vkFramebuffer);
+	}
+
+	rsl::size_type render_device::get_cached_framebuffer_count() const noexcept
+	{
+		auto& impl = get_native_ref(*this);
+		std::lock_guard lock(impl.framebufferMutex);
+		return impl.framebuffers.size();
+	}
+
+	void render_device::destroy_image_view(image_view_handle imageView)
+	{
+		auto& impl = get_native_ref(*this);
+
+		retired_image_view retired{
+			.imageView = std::bit_cast<VkImageView>(imageView),
+			.framebuffers = {},
+			.retireFrame = 0,
+		};
+		{
+			std::lock_guard lock(impl.framebufferMutex);
+			evict_framebuffers(impl, retired.imageView, retired.framebuffers);
+		}
+
+		destroy_retired_image_view(impl, retired);
+	}
+
+	void render_device::destroy_image_view(image_view_handle imageView, rsl::uint64 retireFrame)
+	{
+		auto& impl = get_native_ref(*this);
+
+		retired_image_view retired{
+			.imageView = std::bit_cast<VkImageView>(imageView),
+			.framebuffers = {},
+			.retireFrame = retireFrame,
+		};
+
+		// Evicted right away so get_framebuffer never hands out a framebuffer of a view that is on its way out.
+		std::lock_guard lock(impl.framebufferMutex);
+		evict_framebuffers(impl, retired.imageView, retired.framebuffers);
+		impl.retiredImageViews.push_back(std::move(retired));
+	}
+
+	void render_device::collect_retired_image_views(rsl::uint64 completedFrame)
+	{
+		auto& impl = get_native_ref(*this);
+
+		std::lock_guard lock(impl.framebufferMutex);
+		std::erase_if(impl.retiredImageViews, [&](const retired_image_view& retired) {
+			if (retired.retireFrame > completedFrame)
+			{
+				return false;
+			}
+
+			destroy_retired_image_view(impl, retired);
+			return true;
+		});
 	}
 
 	namespace
 	{
-		physical_device_type map_vk_physical_device_type(VkPhysicalDeviceType type)
+		[[nodiscard]] VkSurfaceFormatKHR
+		select_surface_format(native_physical_device_vk& physicalDevice, VkSurfaceKHR vkSurface, format requested)
 		{
-			switch (type)
+			rsl::uint32 formatCount = 0;
+			physicalDevice.functions->vkGetPhysicalDeviceSurfaceFormatsKHR(
+				physicalDevice.physicalDevice, vkSurface, &formatCount, nullptr
+			);
+
+			std::vector<VkSurfaceFormatKHR> surfaceFormats(formatCount);
+			physicalDevice.functions->vkGetPhysicalDeviceSurfaceFormatsKHR(
+				physicalDevice.physicalDevice, vkSurface, &formatCount, surfaceFormats.data()
+			);
+
+			if (surfaceFormats.empty())
 			{
-				case VK_PHYSICAL_DEVICE_TYPE_OTHER: return physical_device_type::other;
-				case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return physical_device_type::integratedGPU;
-				case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return physical_device_type::discreteGPU;
-				case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return physical_device_type::virtualGPU;
-				case VK_PHYSICAL_DEVICE_TYPE_CPU: return physical_device_type::CPU;
-				case VK_PHYSICAL_DEVICE_TYPE_MAX_ENUM: return physical_device_type::other;
+				return VkSurfaceFormatKHR{
+					.format = VK_FORMAT_UNDEFINED,
+					.colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR,
+				};
 			}
 
-			return physical_device_type::other;
+			for (auto& surfaceFormat : surfaceFormats)
+			{
+				if (surfaceFormat.format == static_cast<VkFormat>(requested) &&
+					surfaceFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+				{
+					return surfaceFormat;
+				}
+			}
+
+			std::cout << "Requested swapchain format isn't supported by the surface, using the first available one\n";
+			return surfaceFormats.front();
 		}
 
-		void map_vk_physical_device_limits(physical_device_limits& target, const VkPhysicalDeviceLimits& src)
+		[[nodiscard]] present_mode
+		select_present_mode(native_physical_device_vk& physicalDevice, VkSurfaceKHR vkSurface, present_mode requested)
 		{
-			target.maxImageDimension1D = src.maxImageDimension1D;
-			target.maxImageDimension2D = src.maxImageDimension2D;
-			target.maxImageDimension3D = src.maxImageDimension3D;
-			target.maxImageDimensionCube = src.maxImageDimensionCube;
-			target.maxImageArrayLayers = src.maxImageArrayLayers;
-			target.maxTexelBufferElements = src.maxTexelBufferElements;
-			target.maxUniformBufferRange = src.maxUniformBufferRange;
-			target.maxStorageBufferRange = src.maxStorageBufferRange;
-			target.maxPushConstantsSize = src.maxPushConstantsSize;
-			target.maxMemoryAllocationCount = src.maxMemoryAllocationCount;
-			target.maxSamplerAllocationCount = src.maxSamplerAllocationCount;
-			target.bufferImageGranularity = src.bufferImageGranularity;
-			target.sparseAddressSpaceSize = src.sparseAddressSpaceSize;
-			target.maxBoundDescriptorSets = src.maxBoundDescriptorSets;
-			target.maxPerStageDescriptorSamplers = src.maxPerStageDescriptorSamplers;
-			target.maxPerStageDescriptorUniformBuffers = src.maxPerStageDescriptorUniformBuffers;
-			target.maxPerStageDescriptorStorageBuffers = src.maxPerStageDescriptorStorageBuffers;
-			target.maxPerStageDescriptorSampledImages = src.maxPerStageDescriptorSampledImages;
-			target.maxPerStageDescriptorStorageImages = src.maxPerStageDescriptorStorageImages;
-			target.maxPerStageDescriptorInputAttachments = src.maxPerStageDescriptorInputAttachments;
-			target.maxPerStageResources = src.maxPerStageResources;
-			target.maxDescriptorSetSamplers = src.maxDescriptorSetSamplers;
-			target.maxDescriptorSetUniformBuffers = src.maxDescriptorSetUniformBuffers;
-			target.maxDescriptorSetUniformBuffersDynamic = src.maxDescriptorSetUniformBuffersDynamic;
-			target.maxDescriptorSetStorageBuffers = src.maxDescriptorSetStorageBuffers;
-			target.maxDescriptorSetStorageBuffersDynamic = src.maxDescriptorSetStorageBuffersDynamic;
-			target.maxDescriptorSetSampledImages = src.maxDescriptorSetSampledImages;
-			target.maxDescriptorSetStorageImages = src.maxDescriptorSetStorageImages;
-			target.maxDescriptorSetInputAttachments = src.maxDescriptorSetInputAttachments;
-			target.maxVertexInputAttributes = src.maxVertexInputAttributes;
-			target.maxVertexInputBindings = src.maxVertexInputBindings;
-			target.maxVertexInputAttributeOffset = src.maxVertexInputAttributeOffset;
-			target.maxVertexInputBindingStride = src.maxVertexInputBindingStride;
-			target.maxVertexOutputComponents = src.maxVertexOutputComponents;
-			target.maxTessellationGenerationLevel = src.maxTessellationGenerationLevel;
-			target.maxTessellationPatchSize = src.maxTessellationPatchSize;
-			target.maxTessellationControlPerVertexInputComponents = src.maxTessellationControlPerVertexInputComponents;
-			target.maxTessellationControlPerVertexOutputComponents =
-				src.maxTessellationControlPerVertexOutputComponents;
-			target.maxTessellationControlPerPatchOutputComponents = src.maxTessellationControlPerPatchOutputComponents;
-			target.maxTessellationControlTotalOutputComponents = src.maxTessellationControlTotalOutputComponents;
-			target.maxTessellationEvaluationInputComponents = src.maxTessellationEvaluationInputComponents;
-			target.maxTessellationEvaluationOutputComponents = src.maxTessellationEvaluationOutputComponents;
-			target.maxGeometryShaderInvocations = src.maxGeometryShaderInvocations;
-			target.maxGeometryInputComponents = src.maxGeometryInputComponents;
-			target.maxGeometryOutputComponents = src.maxGeometryOutputComponents;
-			target.maxGeometryOutputVertices = src.maxGeometryOutputVertices;
-			target.maxGeometryTotalOutputComponents = src.maxGeometryTotalOutputComponents;
-			target.maxFragmentInputComponents = src.maxFragmentInputComponents;
-			target.maxFragmentOutputAttachments = src.maxFragmentOutputAttachments;
-			target.maxFragmentDualSrcAttachments = src.maxFragmentDualSrcAttachments;
-			target.maxFragmentCombinedOutputResources = src.maxFragmentCombinedOutputResources;
-			target.maxComputeSharedMemorySize = src.maxComputeSharedMemorySize;
-			target.maxComputeWorkGroupCount[0] = src.maxComputeWorkGroupCount[0];
-			target.maxComputeWorkGroupCount[1] = src.maxComputeWorkGroupCount[1];
-			target.maxComputeWorkGroupCount[2] = src.maxComputeWorkGroupCount[2];
-			target.maxComputeWorkGroupInvocations = src.maxComputeWorkGroupInvocations;
-			target.maxComputeWorkGroupSize[0] = src.maxComputeWorkGroupSize[0];
-			target.maxComputeWorkGroupSize[1] = src.maxComputeWorkGroupSize[1];
-			target.maxComputeWorkGroupSize[2] = src.maxComputeWorkGroupSize[2];
-			target.subPixelPrecisionBits = src.subPixelPrecisionBits;
-			target.subTexelPrecisionBits = src.subTexelPrecisionBits;
-			target.mipmapPrecisionBits = src.mipmapPrecisionBits;
-			target.maxDrawIndexedIndexValue = src.maxDrawIndexedIndexValue;
-			target.maxDrawIndirectCount = src.maxDrawIndirectCount;
-			target.maxSamplerLodBias = src.maxSamplerLodBias;
-			target.maxSamplerAnisotropy = src.maxSamplerAnisotropy;
-			target.maxViewports = src.maxViewports;
-			target.maxViewportDimensions[0] = src.maxViewportDimensions[0];
-			target.maxViewportDimensions[1] = src.maxViewportDimensions[1];
-			target.viewportBoundsRange[0] = src.viewportBoundsRange[0];
-			target.viewportBoundsRange[1] = src.viewportBoundsRange[1];
-			target.viewportSubPixelBits = src.viewportSubPixelBits;
-			target.minMemoryMapAlignment = src.minMemoryMapAlignment;
-			target.minTexelBufferOffsetAlignment = src.minTexelBufferOffsetAlignment;
-			target.minUniformBufferOffsetAlignment = src.minUniformBufferOffsetAlignment;
-			target.minStorageBufferOffsetAlignment = src.minStorageBufferOffsetAlignment;
-			target.minTexelOffset = src.minTexelOffset;
-			target.maxTexelOffset = src.maxTexelOffset;
-			target.minTexelGatherOffset = src.minTexelGatherOffset;
-			target.maxTexelGatherOffset = src.maxTexelGatherOffset;
-			target.minInterpolationOffset = src.minInterpolationOffset;
-			target.maxInterpolationOffset = src.maxInterpolationOffset;
-			target.subPixelInterpolationOffsetBits = src.subPixelInterpolationOffsetBits;
-			target.maxFramebufferWidth = src.maxFramebufferWidth;
-			target.maxFramebufferHeight = src.maxFramebufferHeight;
-			target.maxFramebufferLayers = src.maxFramebufferLayers;
-			target.framebufferColorSampleCounts = static_cast<sample_count_flags>(src.framebufferColorSampleCounts);
-			target.framebufferDepthSampleCounts = static_cast<sample_count_flags>(src.framebufferDepthSampleCounts);
-			target.framebufferStencilSampleCounts = static_cast<sample_count_flags>(src.framebufferStencilSampleCounts);
-			target.framebufferNoAttachmentsSampleCounts =
-				static_cast<sample_count_flags>(src.framebufferNoAttachmentsSampleCounts);
-			target.maxColorAttachments = src.maxColorAttachments;
-			target.sampledImageColorSampleCounts = static_cast<sample_count_flags>(src.sampledImageColorSampleCounts);
-			target.sampledImageIntegerSampleCounts =
-				static_cast<sample_count_flags>(src.sampledImageIntegerSampleCounts);
-			target.sampledImageDepthSampleCounts = static_cast<sample_count_flags>(src.sampledImageDepthSampleCounts);
-			target.sampledImageStencilSampleCounts =
-				static_cast<sample_count_flags>(src.sampledImageStencilSampleCounts);
-			target.storageImageSampleCounts = static_cast<sample_count_flags>(src.storageImageSampleCounts);
-			target.maxSampleMaskWords = src.maxSampleMaskWords;
-			target.timestampComputeAndGraphics = src.timestampComputeAndGraphics == VK_TRUE;
-			target.timestampPeriod = src.timestampPeriod;
-			target.maxClipDistances = src.maxClipDistances;
-			target.maxCullDistances = src.maxCullDistances;
-			target.maxCombinedClipAndCullDistances = src.maxCombinedClipAndCullDistances;
-			target.discreteQueuePriorities = src.discreteQueuePriorities;
-			target.pointSizeRange[0] = src.pointSizeRange[0];
-			target.pointSizeRange[1] = src.pointSizeRange[1];
-			target.lineWidthRange[0] = src.lineWidthRange[0];
-			target.lineWidthRange[1] = src.lineWidthRange[1];
-			target.pointSizeGranularity = src.pointSizeGranularity;
-			target.lineWidthGranularity = src.lineWidthGranularity;
-			target.strictLines = src.strictLines == VK_TRUE;
-			target.standardSampleLocations = src.standardSampleLocations == VK_TRUE;
-			target.optimalBufferCopyOffsetAlignment = src.optimalBufferCopyOffsetAlignment;
-			target.optimalBufferCopyRowPitchAlignment = src.optimalBufferCopyRowPitchAlignment;
-			target.nonCoherentAtomSize = src.nonCoherentAtomSize;
+			rsl::uint32 presentModeCount = 0;
+			physicalDevice.functions->vkGetPhysicalDeviceSurfacePresentModesKHR(
+				physicalDevice.physicalDevice, vkSurface, &presentModeCount, nullptr
+			);
+
+			std::vector<VkPresentModeKHR> presentModes(presentModeCount);
+			physicalDevice.functions->vkGetPhysicalDeviceSurfacePresentModesKHR(
+				physicalDevice.physicalDevice, vkSurface, &presentModeCount, presentModes.data()
+			);
+
+			for (auto presentMode : presentModes)
+			{
+				if (presentMode == static_cast<VkPresentModeKHR>(requested))
+				{
+					return requested;
+				}
+			}
+
+			std::cout << "Present mode " << to_string(requested) << " isn't supported, falling back to fifo\n";
+			return present_mode::fifo;
 		}
 
-		void map_vk_physical_device_sparse_properties(
-			physical_device_sparse_properties& target, const VkPhysicalDeviceSparseProperties& src
+		[[nodiscard]] rsl::uint32 select_image_count(
+			const VkSurfaceCapabilitiesKHR& capabilities, const swapchain_description& description,
+			present_mode presentMode
 		)
 		{
-			target.residencyStandard2DBlockShape = src.residencyStandard2DBlockShape == VK_TRUE;
-			target.residencyStandard2DMultisampleBlockShape = src.residencyStandard2DMultisampleBlockShape == VK_TRUE;
-			target.residencyStandard3DBlockShape = src.residencyStandard3DBlockShape == VK_TRUE;
-			target.residencyAlignedMipSize = src.residencyAlignedMipSize == VK_TRUE;
-			target.residencyNonResidentStrict = src.residencyNonResidentStrict == VK_TRUE;
+			rsl::uint32 imageCount = description.imageCount;
+			if (imageCount == 0)
+			{
+				imageCount = capabilities.minImageCount + 1;
+				if (presentMode == present_mode::mailbox)
+				{
+					imageCount = std::max(imageCount, 3u);
+				}
+			}
+
+			imageCount = std::max(imageCount, capabilities.minImageCount);
+
+			// A maxImageCount of 0 means there is no upper limit.
+			if (capabilities.maxImageCount != 0)
+			{
+				imageCount = std::min(imageCount, capabilities.maxImageCount);
+			}
+
+			return imageCount;
 		}
-	} // namespace
 
-	const physical_device_properties& physical_device::get_properties(bool forceRefresh)
-	{
-		auto& impl = get_native_ref(*this);
+		[[nodiscard]] VkExtent2D
+		select_extent(const VkSurfaceCapabilitiesKHR& capabilities, const swapchain_description& description)
+		{
+			// The window dictates the extent, unless the surface reports the special 0xFFFFFFFF value.
+			if (capabilities.currentExtent.width != ~0u)
+			{
+				return capabilities.currentExtent;
+			}
 
-		if (forceRefresh || !impl.propertiesLoaded)
+			return VkExtent2D{
+				.width = std::clamp(
+					description.extent.x, capabilities.minImageExtent.width, capabilities.maxImageExtent.width
+				),
+				.height = std::clamp(
+					description.extent.y, capabilities.minImageExtent.height, capabilities.maxImageExtent.height
+				),
+			};
+		}
+
+		[[nodiscard]] VkCompositeAlphaFlagBitsKHR select_composite_alpha(VkCompositeAlphaFlagsKHR supported)
 		{
-			VkPhysicalDeviceProperties props;
-			impl.vkGetPhysicalDeviceProperties(impl.physicalDevice, &props);
+			constexpr VkCompositeAlphaFlagBitsKHR preferredOrder[] = {
+				VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
+				VK_COMPOSITE_ALPHA_INHERIT_BIT_KHR,
+				VK_COMPOSITE_ALPHA_PRE_MULTIPLIED_BIT_KHR,
+				VK_COMPOSITE_ALPHA_POST_MULTIPLIED_BIT_KHR,
+			};
 
-			impl.properties.apiVersion = decomposeVkVersion(props.apiVersion);
-			impl.properties.driverVersion = decomposeVkVersion(props.driverVersion);
-			impl.properties.vendorID = props.vendorID;
-			impl.properties.deviceID = props.deviceID;
-			impl.properties.deviceType = map_vk_physical_device_type(props.deviceType);
-			impl.properties.deviceName = props.deviceName;
-			map_vk_physical_device_limits(impl.properties.limits, props.limits);
-			map_vk_physical_device_sparse_properties(impl.properties.sparseProperties, props.sparseProperties);
+			for (auto compositeAlpha : preferredOrder)
+			{
+				if (supported & compositeAlpha)
+				{
+					return compositeAlpha;
+				}
+			}
 
-			impl.propertiesLoaded = true;
+			return VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 		}
 
-		return impl.properties;
-	}
-
-	namespace
-	{
-		void map_vk_physical_device_features(physical_device_features& target, const VkPhysicalDeviceFeatures& src)
+		[[nodiscard]] swapchain_status map_vk_swapchain_result(VkResult result)
 		{
-			target.robustBufferAccess = src.robustBufferAccess == VK_TRUE;
-			target.fullDrawIndexUint32 = src.fullDrawIndexUint32 == VK_TRUE;
-			target.imageCubeArray = src.imageCubeArray == VK_TRUE;
-			target.independentBlend = src.independentBlend == VK_TRUE;
-			target.geometryShader = src.geometryShader == VK_TRUE;
-			target.tessellationShader = src.tessellationShader == VK_TRUE;
-			target.sampleRateShading = src.sampleRateShading == VK_TRUE;
-			target.dualSrcBlend = src.dualSrcBlend == VK_TRUE;
-			target.logicOp = src.logicOp == VK_TRUE;
-			target.multiDrawIndirect = src.multiDrawIndirect == VK_TRUE;
-			target.drawIndirectFirstInstance = src.drawIndirectFirstInstance == VK_TRUE;
-			target.depthClamp = src.depthClamp == VK_TRUE;
-			target.depthBiasClamp = src.depthBiasClamp == VK_TRUE;
-			target.fillModeNonSolid = src.fillModeNonSolid == VK_TRUE;
-			target.depthBounds = src.depthBounds == VK_TRUE;
-			target.wideLines = src.wideLines == VK_TRUE;
-			target.largePoints = src.largePoints == VK_TRUE;
-			target.alphaToOne = src.alphaToOne == VK_TRUE;
-			target.multiViewport = src.multiViewport == VK_TRUE;
-			target.samplerAnisotropy = src.samplerAnisotropy == VK_TRUE;
-			target.textureCompressionETC2 = src.textureCompressionETC2 == VK_TRUE;
-			target.textureCompressionASTC_LDR = src.textureCompressionASTC_LDR == VK_TRUE;
-			target.textureCompressionBC = src.textureCompressionBC == VK_TRUE;
-			target.occlusionQueryPrecise = src.occlusionQueryPrecise == VK_TRUE;
-			target.pipelineStatisticsQuery = src.pipelineStatisticsQuery == VK_TRUE;
-			target.vertexPipelineStoresAndAtomics = src.vertexPipelineStoresAndAtomics == VK_TRUE;
-			target.fragmentStoresAndAtomics = src.fragmentStoresAndAtomics == VK_TRUE;
-			target.shaderTessellationAndGeometryPointSize = src.shaderTessellationAndGeometryPointSize == VK_TRUE;
-			target.shaderImageGatherExtended = src.shaderImageGatherExtended == VK_TRUE;
-			target.shaderStorageImageExtendedFormats = src.shaderStorageImageExtendedFormats == VK_TRUE;
-			target.shaderStorageImageMultisample = src.shaderStorageImageMultisample == VK_TRUE;
-			target.shaderStorageImageReadWithoutFormat = src.shaderStorageImageReadWithoutFormat == VK_TRUE;
-			target.shaderStorageImageWriteWithoutFormat = src.shaderStorageImageWriteWithoutFormat == VK_TRUE;
-			target.shaderUniformBufferArrayDynamicIndexing = src.shaderUniformBufferArrayDynamicIndexing == VK_TRUE;
-			target.shaderSampledImageArrayDynamicIndexing = src.shaderSampledImageArrayDynamicIndexing == VK_TRUE;
-			target.shaderStorageBufferArrayDynamicIndexing = src.shaderStorageBufferArrayDynamicIndexing == VK_TRUE;
-			target.shaderStorageImageArrayDynamicIndexing = src.shaderStorageImageArrayDynamicIndexing == VK_TRUE;
-			target.shaderClipDistance = src.shaderClipDistance == VK_TRUE;
-			target.shaderCullDistance = src.shaderCullDistance == VK_TRUE;
-			target.shaderFloat64 = src.shaderFloat64 == VK_TRUE;
-			target.shaderInt64 = src.shaderInt64 == VK_TRUE;
-			target.shaderInt16 = src.shaderInt16 == VK_TRUE;
-			target.shaderResourceResidency = src.shaderResourceResidency == VK_TRUE;
-			target.shaderResourceMinLod = src.shaderResourceMinLod == VK_TRUE;
-			target.sparseBinding = src.sparseBinding == VK_TRUE;
-			target.sparseResidencyBuffer = src.sparseResidencyBuffer == VK_TRUE;
-			target.sparseResidencyImage2D = src.sparseResidencyImage2D == VK_TRUE;
-			target.sparseResidencyImage3D = src.sparseResidencyImage3D == VK_TRUE;
-			target.sparseResidency2Samples = src.sparseResidency2Samples == VK_TRUE;
-			target.sparseResidency4Samples = src.sparseResidency4Samples == VK_TRUE;
-			target.sparseResidency8Samples = src.sparseResidency8Samples == VK_TRUE;
-			target.sparseResidency16Samples = src.sparseResidency16Samples == VK_TRUE;
-			target.sparseResidencyAliased = src.sparseResidencyAliased == VK_TRUE;
-			target.variableMultisampleRate = src.variableMultisampleRate == VK_TRUE;
-			target.inheritedQueries = src.inheritedQueries == VK_TRUE;
+			switch (result)
+			{
+				case VK_SUCCESS: return swapchain_status::ready;
+				case VK_SUBOPTIMAL_KHR: return swapchain_status::suboptimal;
+				case VK_ERROR_OUT_OF_DATE_KHR: return swapchain_status::outOfDate;
+				default: return swapchain_status::failed;
+			}
 		}
-	} // namespace
 
-	const physical_device_features& physical_device::get_features(bool forceRefresh)
-	{
-		auto& impl = get_native_ref(*this);
+		// Moves the VkSwapchainKHR with its image views and per image semaphores out of impl, the per frame sync
+		// objects are kept. The frames submitted so far finish once every frame slot's fence has been waited on again.
+		[[nodiscard]] retired_swapchain take_swapchain_images(native_swapchain_vk& impl)
+		{
+			retired_swapchain retired{
+				.swapchain = std::exchange(impl.swapchain, VK_NULL_HANDLE),
+				.imageViews = std::move(impl.imageViews),
+				.renderFinishedSemaphores = std::move(impl.renderFinishedSemaphores),
+				.retireFrame = impl.frameCounter + impl.frameFences.size() - 1,
+			};
 
-		if (forceRefresh || !impl.featuresLoaded)
+			impl.images.clear();
+			impl.imageViews.clear();
+			impl.renderFinishedSemaphores.clear();
+			return retired;
+		}
+
+		void destroy_retired_swapchain(native_swapchain_vk& impl, retired_swapchain& retired)
 		{
-			VkPhysicalDeviceFeatures features;
-			impl.vkGetPhysicalDeviceFeatures(impl.physicalDevice, &features);
-			map_vk_physical_device_features(impl.features, features);
+			auto& renderDevice = get_native_ref(impl.renderDevice);
 
-			impl.featuresLoaded = true;
+			for (auto imageView : retired.imageViews) { impl.renderDevice.destroy_image_view(imageView); }
+			for (auto semaphore : retired.renderFinishedSemaphores)
+			{
+				renderDevice.functions->vkDestroySemaphore(renderDevice.device, semaphore, impl.allocCallbacks);
+			}
+
+			if (retired.swapchain != VK_NULL_HANDLE)
+			{
+				renderDevice.functions->vkDestroySwapchainKHR(
+					renderDevice.device, retired.swapchain, impl.allocCallbacks
+				);
+			}
 		}
 
-		return impl.features;
-	}
+		void destroy_swapchain_images(native_swapchain_vk& impl)
+		{
+			retired_swapchain current = take_swapchain_images(impl);
+			destroy_retired_swapchain(impl, current);
+		}
 
-	std::span<const extension_properties> physical_device::get_available_extensions(bool forceRefresh)
-	{
-		auto& impl = get_native_ref(*this);
+		// Called right after acquire_next_image waited on a frame fence.
+		void collect_retired_swapchains(native_swapchain_vk& impl)
+		{
+			std::erase_if(impl.retiredSwapchains, [&](retired_swapchain& retired) {
+				if (retired.retireFrame > impl.frameCounter)
+				{
+					return false;
+				}
 
-		if (forceRefresh || impl.availableExtensions.empty())
+				destroy_retired_swapchain(impl, retired);
+				return true;
+			});
+		}
+
+		// Only for fences that aren't pending, e.g. after the submit that was supposed to signal them failed.
+		void replace_with_signaled_fence(
+			native_render_device_vk& renderDevice, VkFence& fence, VkAllocationCallbacks* allocCallbacks
+		)
 		{
-			rsl::uint32 extensionCount = 0;
+			renderDevice.functions->vkDestroyFence(renderDevice.device, fence, allocCallbacks);
+			fence = VK_NULL_HANDLE;
 
-			VkResult result =
-				impl.vkEnumerateDeviceExtensionProperties(impl.physicalDevice, nullptr, &extensionCount, nullptr);
-			if (result != VK_SUCCESS || extensionCount == 0)
+			const VkFenceCreateInfo fenceCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = VK_FENCE_CREATE_SIGNALED_BIT,
+			};
+
+			if (renderDevice.functions->vkCreateFence(renderDevice.device, &fenceCreateInfo, allocCallbacks, &fence) !=
+				VK_SUCCESS)
 			{
-				std::cout << "Count not query the number of device extensions.\n";
-				return {};
+				std::cout << "Failed to recreate frame fence\n";
 			}
+		}
 
-			std::vector<VkExtensionProperties> extensionPropertiesBuffer;
-			extensionPropertiesBuffer.resize(extensionCount);
-			result = impl.vkEnumerateDeviceExtensionProperties(
-				impl.physicalDevice, nullptr, &extensionCount, extensionPropertiesBuffer.data()
-			);
+		// Finishes a frame slot whose image was acquired but whose work won't be submitted: an empty submit waits on
+		// the acquire semaphore so it can be signaled again, signals signalSemaphore when given and the slot's fence.
+		// Without a queue to submit to, or when that submit fails, the fence is replaced by a signaled one, the
+		// semaphores are left as is and false is returned.
+		bool submit_dropped_frame(native_swapchain_vk& impl, VkQueue queue, VkSemaphore signalSemaphore)
+		{
+			auto& renderDevice = get_native_ref(impl.renderDevice);
+			VkFence& frameFence = impl.frameFences[impl.frameIndex];
 
-			if (result != VK_SUCCESS || extensionCount == 0)
+			if (queue == VK_NULL_HANDLE && !renderDevice.queues.empty())
 			{
-				std::cout << "Could not enumerate device extensions.\n";
-				return {};
+				queue = get_native_ref(renderDevice.queues.front()).queue;
 			}
 
-			impl.availableExtensions.clear();
-			impl.availableExtensions.reserve(extensionCount);
-			for (auto& extension : extensionPropertiesBuffer)
+			// Called with a fence that was either waited on and is still signaled, or reset for a submit that failed.
+			renderDevice.functions->vkResetFences(renderDevice.device, 1, &frameFence);
+
+			const VkSemaphore acquireSemaphore = impl.acquireSemaphores[impl.frameIndex];
+			constexpr VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+			const VkSubmitInfo submitInfo{
+				.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+				.pNext = nullptr,
+				.waitSemaphoreCount = 1,
+				.pWaitSemaphores = &acquireSemaphore,
+				.pWaitDstStageMask = &waitStage,
+				.commandBufferCount = 0,
+				.pCommandBuffers = nullptr,
+				.signalSemaphoreCount = signalSemaphore != VK_NULL_HANDLE ? 1u : 0u,
+				.pSignalSemaphores = &signalSemaphore,
+			};
+
+			if (queue == VK_NULL_HANDLE ||
+				renderDevice.functions->vkQueueSubmit(queue, 1, &submitInfo, frameFence) != VK_SUCCESS)
 			{
-				impl.availableExtensions.push_back(extension_properties{
-					.name = rsl::hashed_string(extension.extensionName),
-					.specVersion = decomposeVkVersion(extension.specVersion),
-				});
+				std::cout << "Failed to submit dropped frame\n";
+				replace_with_signaled_fence(renderDevice, frameFence, impl.allocCallbacks);
+				return false;
 			}
-		}
 
-		return impl.availableExtensions;
-	}
+			return true;
+		}
 
-	bool physical_device::is_extension_available(rsl::hashed_string_view extensionName)
-	{
-		for (auto& extension : get_available_extensions())
+		// Gives up on an image that was acquired but won't be presented, for when the swapchain is retired or released.
+		void discard_acquired_image(native_swapchain_vk& impl)
 		{
-			if (extension.name == extensionName)
+			if (!impl.imageAcquired)
 			{
-				return true;
+				return;
 			}
-		}
 
-		return false;
-	}
+			submit_dropped_frame(impl, impl.lastSubmitQueue, VK_NULL_HANDLE);
+			impl.imageAcquired = false;
+		}
 
-	namespace
-	{
-		queue_feature_flags map_vk_queue_features(VkQueueFlags features, bool supportsPresent)
+		[[nodiscard]] rsl::uint64 get_timestamp() noexcept
 		{
-			return rsl::enum_flags::set_flag(
-				static_cast<queue_feature_flags>(features), queue_feature_flags::present, supportsPresent
+			return static_cast<rsl::uint64>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now().time_since_epoch()
+				)
+					.count()
 			);
 		}
-	} // namespace
 
-	std::span<const queue_family_properties>
-	physical_device::get_available_queue_families(surface surface, bool forceRefresh)
-	{
-		auto& impl = get_native_ref(*this);
+		// Shared by swapchains and headless targets.
+		template <typename Target>
+		void start_frame_timing(Target& impl) noexcept
+		{
+			impl.currentTiming = frame_timing{.frameStart = get_timestamp()};
+			impl.frameStarted = true;
+		}
 
-		if (forceRefresh || impl.availableQueueFamilies.empty())
+		// Checks the oldest pending presents with a zero timeout from acquire_next_image and present, so
+		// presentComplete is the first of those checks to see the present done, late by at most the time between two.
+		// vkWaitForPresentKHR needs external synchronization on the swapchain, the same as vkQueuePresentKHR, so a
+		// waiting thread would have to hold a lock that blocks present for as long as it waits.
+		void poll_present_completion(native_swapchain_vk& impl)
 		{
-			rsl::uint32 queueFamilyCount = 0;
+			auto& renderDevice = get_native_ref(impl.renderDevice);
 
-			impl.vkGetPhysicalDeviceQueueFamilyProperties(impl.physicalDevice, &queueFamilyCount, nullptr);
-			if (queueFamilyCount == 0)
+			while (!impl.pendingPresents.empty())
 			{
-				std::cout << "Count not query the number of queue families.\n";
-				return {};
+				frame_timing& timing = impl.pendingPresents.front();
+
+				const VkResult result = renderDevice.functions->vkWaitForPresentKHR(
+					renderDevice.device, impl.swapchain, timing.frameNumber, 0
+				);
+
+				if (result == VK_TIMEOUT)
+				{
+					return;
+				}
+
+				if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+				{
+					// Out of date or lost, the remaining presents won't complete on this swapchain.
+					impl.pendingPresents.clear();
+					return;
+				}
+
+				timing.presentComplete = get_timestamp();
+				impl.latency.startToDisplay.record(timing.presentComplete - timing.frameStart);
+				impl.lastTiming = timing;
+				impl.pendingPresents.pop_front();
 			}
+		}
 
-			std::vector<VkQueueFamilyProperties> queueFamiliesBuffer;
-			queueFamiliesBuffer.resize(queueFamilyCount);
-			impl.vkGetPhysicalDeviceQueueFamilyProperties(
-				impl.physicalDevice, &queueFamilyCount, queueFamiliesBuffer.data()
+		// Creates the VkSwapchainKHR, its image views and per image semaphores for the current state of the surface.
+		// An existing swapchain is passed as oldSwapchain and retired instead of destroyed, frames in flight keep
+		// using it.
+		[[nodiscard]] swapchain_status build_swapchain(native_swapchain_vk& impl)
+		{
+			auto& renderDevice = get_native_ref(impl.renderDevice);
+			auto& physicalDevice = get_native_ref(renderDevice.physicalDevice);
+			const VkSurfaceKHR vkSurface = get_native_ref(impl.targetSurface).surface;
+
+			VkSurfaceCapabilitiesKHR capabilities;
+			VkResult result = physicalDevice.functions->vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
+				physicalDevice.physicalDevice, vkSurface, &capabilities
 			);
 
-			if (queueFamilyCount == 0)
+			if (result != VK_SUCCESS)
 			{
-				std::cout << "Could not get queue family properties.\n";
-				return {};
+				std::cout << "Failed to query surface capabilities\n";
+				return swapchain_status::failed;
 			}
 
-			impl.availableQueueFamilies.clear();
-			impl.availableQueueFamilies.reserve(queueFamilyCount);
+			// Minimized windows have a zero sized surface, there is nothing to present to until they're restored.
+			const VkExtent2D extent = select_extent(capabilities, impl.description);
+			if (extent.width == 0 || extent.height == 0)
+			{
+				return swapchain_status::outOfDate;
+			}
 
-			auto& nativeInstance = get_native_ref(impl.instance);
+			const VkSurfaceFormatKHR surfaceFormat =
+				select_surface_format(physicalDevice, vkSurface, impl.description.imageFormat);
+			const present_mode presentMode =
+				select_present_mode(physicalDevice, vkSurface, impl.description.presentMode);
 
-			bool surfaceCreated = false;
-			if (!surface)
+			// Images are shared between every queue family of the device, so frames can be submitted and presented on
+			// queues from different families without ownership transfers.
+			std::vector<rsl::uint32> queueFamilyIndices;
+			for (auto& deviceQueue : renderDevice.queues)
 			{
-				surface = impl.instance.create_surface();
-				surfaceCreated = true;
+				const auto familyIndex = static_cast<rsl::uint32>(deviceQueue.get_family_index());
+				if (std::find(queueFamilyIndices.begin(), queueFamilyIndices.end(), familyIndex) ==
+					queueFamilyIndices.end())
+				{
+					queueFamilyIndices.push_back(familyIndex);
+				}
 			}
 
-			auto* nativeSurface = get_native_ptr(surface);
+			const bool concurrent = queueFamilyIndices.size() > 1;
 
-			for (rsl::uint32 queueFamilyIndex = 0; queueFamilyIndex < queueFamilyCount; queueFamilyIndex++)
+			const VkSwapchainKHR oldSwapchain = impl.swapchain;
+			if (oldSwapchain != VK_NULL_HANDLE)
 			{
-				auto& queueFamily = queueFamiliesBuffer[queueFamilyIndex];
+				discard_acquired_image(impl);
+				impl.retiredSwapchains.push_back(take_swapchain_images(impl));
+				// Present ids are per swapchain, the new one can't be asked about presents on the old one.
+				impl.pendingPresents.clear();
+			}
 
-				VkBool32 supportsPresent = VK_FALSE;
+			const VkSwapchainCreateInfoKHR swapchainCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+				.pNext = nullptr,
+				.flags = 0,
+				.surface = vkSurface,
+				.minImageCount = select_image_count(capabilities, impl.description, presentMode),
+				.imageFormat = surfaceFormat.format,
+				.imageColorSpace = surfaceFormat.colorSpace,
+				.imageExtent = extent,
+				.imageArrayLayers = 1,
+				.imageUsage = static_cast<VkImageUsageFlags>(impl.description.imageUsage),
+				.imageSharingMode = concurrent ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE,
+				.queueFamilyIndexCount = concurrent ? static_cast<rsl::uint32>(queueFamilyIndices.size()) : 0,
+				.pQueueFamilyIndices = concurrent ? queueFamilyIndices.data() : nullptr,
+				.preTransform = capabilities.currentTransform,
+				.compositeAlpha = select_composite_alpha(capabilities.supportedCompositeAlpha),
+				.presentMode = static_cast<VkPresentModeKHR>(presentMode),
+				.clipped = VK_TRUE,
+				.oldSwapchain = oldSwapchain,
+			};
 
-				if (nativeSurface)
+			result = renderDevice.functions->vkCreateSwapchainKHR(
+				renderDevice.device, &swapchainCreateInfo, impl.allocCallbacks, &impl.swapchain
+			);
+
+			if (result != VK_SUCCESS || impl.swapchain == VK_NULL_HANDLE)
+			{
+				std::cout << "Failed to create swapchain\n";
+				impl.swapchain = VK_NULL_HANDLE;
+				return swapchain_status::failed;
+			}
+
+			impl.presentMode = presentMode;
+			impl.imageFormat = static_cast<format>(surfaceFormat.format);
+			impl.extent = rsl::math::uint2(extent.width, extent.height);
+
+			rsl::uint32 imageCount = 0;
+			renderDevice.functions->vkGetSwapchainImagesKHR(renderDevice.device, impl.swapchain, &imageCount, nullptr);
+			impl.images.resize(imageCount);
+			renderDevice.functions->vkGetSwapchainImagesKHR(
+				renderDevice.device, impl.swapchain, &imageCount, impl.images.data()
+			);
+
+			impl.imageViews.reserve(imageCount);
+			impl.renderFinishedSemaphores.reserve(imageCount);
+			for (auto image : impl.images)
+			{
+				const VkImageViewCreateInfo imageViewCreateInfo{
+					.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+					.pNext = nullptr,
+					.flags = 0,
+					.image = image,
+					.viewType = VK_IMAGE_VIEW_TYPE_2D,
+					.format = surfaceFormat.format,
+					.components = {},
+					.subresourceRange =
+						VkImageSubresourceRange{
+							.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+							.baseMipLevel = 0,
+							.levelCount = 1,
+							.baseArrayLayer = 0,
+							.layerCount = 1,
+						},
+				};
+
+				VkImageView imageView = VK_NULL_HANDLE;
+				result = renderDevice.functions->vkCreateImageView(
+					renderDevice.device, &imageViewCreateInfo, impl.allocCallbacks, &imageView
+				);
+
+				if (result != VK_SUCCESS)
 				{
-					if (nativeInstance.vkGetPhysicalDeviceSurfaceSupportKHR(
-							impl.physicalDevice, queueFamilyIndex, nativeSurface->surface, &supportsPresent
-						) != VK_SUCCESS)
-					{
-						supportsPresent = VK_FALSE;
-					}
+					std::cout << "Failed to create swapchain image view\n";
+					destroy_swapchain_images(impl);
+					return swapchain_status::failed;
 				}
 
-				impl.availableQueueFamilies.push_back({
-					.features = map_vk_queue_features(queueFamily.queueFlags, supportsPresent == VK_TRUE),
-					.queueCount = queueFamily.queueCount,
-					.timestampValidBits = queueFamily.timestampValidBits,
-					.minImageTransferGranularity =
-						rsl::math::uint3{
-										 queueFamily.minImageTransferGranularity.width,
-										 queueFamily.minImageTransferGranularity.height,
-										 queueFamily.minImageTransferGranularity.depth,
-										 },
-				});
+				impl.imageViews.push_back(std::bit_cast<image_view_handle>(imageView));
+
+				const VkSemaphoreCreateInfo semaphoreCreateInfo{
+					.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+					.pNext = nullptr,
+					.flags = 0,
+				};
+
+				VkSemaphore semaphore = VK_NULL_HANDLE;
+				result = renderDevice.functions->vkCreateSemaphore(
+					renderDevice.device, &semaphoreCreateInfo, impl.allocCallbacks, &semaphore
+				);
+
+				if (result != VK_SUCCESS)
+				{
+					std::cout << "Failed to create swapchain semaphore\n";
+					destroy_swapchain_images(impl);
+					return swapchain_status::failed;
+				}
+
+				impl.renderFinishedSemaphores.push_back(semaphore);
 			}
 
-			if (surfaceCreated)
+			return swapchain_status::ready;
+		}
+
+		void destroy_frame_sync(native_swapchain_vk& impl)
+		{
+			auto& renderDevice = get_native_ref(impl.renderDevice);
+
+			for (auto semaphore : impl.acquireSemaphores)
 			{
-				surface.release();
+				renderDevice.functions->vkDestroySemaphore(renderDevice.device, semaphore, impl.allocCallbacks);
+			}
+
+			for (auto fence : impl.frameFences)
+			{
+				renderDevice.functions->vkDestroyFence(renderDevice.device, fence, impl.allocCallbacks);
 			}
+
+			impl.acquireSemaphores.clear();
+			impl.frameFences.clear();
 		}
 
-		return impl.availableQueueFamilies;
+		[[nodiscard]] bool create_frame_sync(native_swapchain_vk& impl, rsl::size_type framesInFlight)
+		{
+			auto& renderDevice = get_native_ref(impl.renderDevice);
+
+			const VkSemaphoreCreateInfo semaphoreCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+			};
+
+			// Fences start signaled so the first acquire of every frame slot doesn't wait.
+			const VkFenceCreateInfo fenceCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = VK_FENCE_CREATE_SIGNALED_BIT,
+			};
+
+			for (rsl::size_type i = 0; i < framesInFlight; i++)
+			{
+				VkSemaphore semaphore = VK_NULL_HANDLE;
+				VkFence fence = VK_NULL_HANDLE;
+
+				if (renderDevice.functions->vkCreateSemaphore(
+						renderDevice.device, &semaphoreCreateInfo, impl.allocCallbacks, &semaphore
+					) != VK_SUCCESS)
+				{
+					std::cout << "Failed to create frame semaphore\n";
+					destroy_frame_sync(impl);
+					return false;
+				}
+				impl.acquireSemaphores.push_back(semaphore);
+
+				if (renderDevice.functions->vkCreateFence(
+						renderDevice.device, &fenceCreateInfo, impl.allocCallbacks, &fence
+					) != VK_SUCCESS)
+				{
+					std::cout << "Failed to create frame fence\n";
+					destroy_frame_sync(impl);
+					return false;
+				}
+				impl.frameFences.push_back(fence);
+			}
+
+			return true;
+		}
+	} // namespace
+
+	swapchain render_device::create_swapchain(surface surface, const swapchain_description& description)
+	{
+		auto& impl = get_native_ref(*this);
+
+		if (!impl.functions->vkCreateSwapchainKHR)
+		{
+			std::cout << "Swapchains need " VK_KHR_SWAPCHAIN_EXTENSION_NAME " to be enabled\n";
+			return {};
+		}
+
+		auto* swapchainPtr = allocate<native_swapchain_vk>(*impl.alloc);
+		swapchainPtr->renderDevice = *this;
+		swapchainPtr->alloc = impl.alloc;
+		swapchainPtr->allocCallbacks = impl.allocCallbacks;
+		swapchainPtr->targetSurface = surface;
+		swapchainPtr->description = description;
+		swapchainPtr->presentWait = impl.presentWait;
+
+		if (!create_frame_sync(*swapchainPtr, std::max(description.framesInFlight, 1u)) ||
+			build_swapchain(*swapchainPtr) != swapchain_status::ready)
+		{
+			destroy_frame_sync(*swapchainPtr);
+			deallocate<native_swapchain_vk>(*impl.alloc, swapchainPtr);
+			return {};
+		}
+
+		swapchain result;
+		set_native_handle(result, create_native_handle(swapchainPtr));
+		return result;
 	}
 
-	bool physical_device::get_queue_family_selection(
-		std::span<queue_family_selection> queueFamilySelections, std::span<const queue_description> queueDesciptions,
-		surface surface
-	)
+	swapchain::operator bool() const noexcept
 	{
-		for (rsl::size_type i = 0; i < queueDesciptions.size(); i++)
+		auto* impl = get_native_ptr(*this);
+		return impl != nullptr && impl->swapchain != VK_NULL_HANDLE;
+	}
+
+	void swapchain::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
+		{
+			return;
+		}
+
+		auto& renderDevice = get_native_ref(impl->renderDevice);
+		discard_acquired_image(*impl);
+		if (!impl->frameFences.empty())
+		{
+			renderDevice.functions->vkWaitForFences(
+				renderDevice.device, static_cast<rsl::uint32>(impl->frameFences.size()), impl->frameFences.data(),
+				VK_TRUE, ~0ull
+			);
+		}
+
+		// The fences only cover the submits, the presentation engine may still wait on the render finished semaphores
+		// and read the images. Only the present queue is idled, not the whole device.
+		if (impl->lastPresentQueue != VK_NULL_HANDLE)
 		{
-			queueFamilySelections[i].familyIndex = queueDesciptions[i].queueFamilyIndexOverride;
+			renderDevice.functions->vkQueueWaitIdle(impl->lastPresentQueue);
 		}
 
-		auto queueFamilies = get_available_queue_families(surface);
+		for (auto& retired : impl->retiredSwapchains) { destroy_retired_swapchain(*impl, retired); }
+		destroy_swapchain_images(*impl);
+		destroy_frame_sync(*impl);
 
-		for (rsl::size_type queueIndex = 0; queueIndex < queueDesciptions.size(); queueIndex++)
-		{
-			auto& queueDesciption = queueDesciptions[queueIndex];
-			auto& selectionInfo = queueFamilySelections[queueIndex];
+		m_nativeSwapchain = invalid_native_swapchain;
+		deallocate<native_swapchain_vk>(*impl->alloc, impl);
+	}
 
-			selectionInfo.familyIndex = rsl::npos;
-			for (rsl::size_type familyIndex = 0; familyIndex < queueFamilies.size(); familyIndex++)
-			{
-				auto& queueFamily = queueFamilies[familyIndex];
+	swapchain_status swapchain::acquire_next_image()
+	{
+		auto& impl = get_native_ref(*this);
+		auto& renderDevice = get_native_ref(impl.renderDevice);
 
-				if (queueDesciption.queueFamilyIndexOverride != rsl::npos ||
-					!rsl::enum_flags::has_all_flags(queueFamily.features, queueDesciption.requiredFeatures) ||
-					queueFamily.queueCount == 0)
-				{
-					continue;
-				}
+		if (!impl.frameStarted)
+		{
+			start_frame_timing(impl);
+		}
 
-				rsl::size_type score = 1;
+		// A failed recreate leaves no swapchain until the next successful one.
+		if (impl.swapchain == VK_NULL_HANDLE)
+		{
+			return swapchain_status::outOfDate;
+		}
 
-				score += queueFamily.queueCount * queueDesciption.queueCountImportance;
-				score += queueFamily.timestampValidBits * queueDesciption.timestampImportance;
+		// The frame was abandoned before present, its image is still acquired and the same one is handed out again.
+		if (impl.imageAcquired)
+		{
+			return swapchain_status::ready;
+		}
 
-				if (queueDesciption.imageTransferGranularityImportance != 0ull)
-				{
-					rsl::size_type maxScore = 128ull * queueDesciption.imageTransferGranularityImportance;
+		const VkFence frameFence = impl.frameFences[impl.frameIndex];
+		renderDevice.functions->vkWaitForFences(renderDevice.device, 1, &frameFence, VK_TRUE, ~0ull);
 
-					score += maxScore - rsl::math::min(
-											maxScore, ((queueFamily.minImageTransferGranularity.x +
-														queueFamily.minImageTransferGranularity.y +
-														queueFamily.minImageTransferGranularity.z) /
-													   3u) *
-														  queueDesciption.imageTransferGranularityImportance
-										);
-				}
+		collect_retired_swapchains(impl);
+		if (impl.presentWait)
+		{
+			poll_present_completion(impl);
+		}
 
-				if (score > selectionInfo.score)
-				{
-					selectionInfo.familyIndex = familyIndex;
-					selectionInfo.score = score;
-				}
-			}
+		const VkResult result = renderDevice.functions->vkAcquireNextImageKHR(
+			renderDevice.device, impl.swapchain, ~0ull, impl.acquireSemaphores[impl.frameIndex], VK_NULL_HANDLE,
+			&impl.imageIndex
+		);
+		impl.currentTiming.acquireReturn = get_timestamp();
 
-			if (selectionInfo.familyIndex == rsl::npos)
-			{
-				std::cout << "No compatible queue family found for queue " << queueIndex << '\n';
-				return false;
-			}
+		// The fence stays signaled until present resets it right before submitting, so a frame that is never
+		// submitted can't leave the next wait on this slot hanging.
+		const swapchain_status status = map_vk_swapchain_result(result);
+		if (status == swapchain_status::ready || status == swapchain_status::suboptimal)
+		{
+			impl.imageAcquired = true;
+		}
+		else if (status == swapchain_status::failed)
+		{
+			std::cout << "Failed to acquire swapchain image\n";
 		}
 
-		return true;
+		return status;
 	}
 
-	bool physical_device::in_use() const noexcept
+	swapchain_status
+	swapchain::present(queue submitQueue, std::span<const command_buffer> commandBuffers, queue presentQueue)
 	{
-		return get_native_ref(*this).renderDevice;
-	}
+		auto& impl = get_native_ref(*this);
+		auto& renderDevice = get_native_ref(impl.renderDevice);
 
-	[[nodiscard]] render_device physical_device::create_render_device(
-		std::span<const queue_description> queueDesciptions, std::span<const rsl::hashed_string> extensions
-	)
-	{
-		using namespace rsl::hashed_string_literals;
+		if (!impl.imageAcquired)
+		{
+			std::cout << "Presenting without an acquired swapchain image\n";
+			return swapchain_status::failed;
+		}
 
-		auto& impl = get_native_ref(*this);
+		impl.submitCommandBuffers.clear();
+		for (auto& commandBuffer : commandBuffers)
+		{
+			impl.submitCommandBuffers.push_back(get_native_ref(commandBuffer).commandBuffer);
+		}
 
-		bool presentingApplication = impl.instance.get_application_info().windowHandle != invalid_native_window_handle;
+		const VkQueue vkSubmitQueue = get_native_ref(submitQueue).queue;
+		const VkQueue vkPresentQueue = get_native_ref(presentQueue).queue;
+		const VkSemaphore acquireSemaphore = impl.acquireSemaphores[impl.frameIndex];
+		const VkSemaphore renderFinishedSemaphore = impl.renderFinishedSemaphores[impl.imageIndex];
+		constexpr VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 
-		std::vector<rsl::cstring> enabledExtensions;
-		enabledExtensions.reserve(extensions.size() + (presentingApplication ? 1 : 0));
+		const VkSubmitInfo submitInfo{
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+			.pNext = nullptr,
+			.waitSemaphoreCount = 1,
+			.pWaitSemaphores = &acquireSemaphore,
+			.pWaitDstStageMask = &waitStage,
+			.commandBufferCount = static_cast<rsl::uint32>(impl.submitCommandBuffers.size()),
+			.pCommandBuffers = impl.submitCommandBuffers.data(),
+			.signalSemaphoreCount = 1,
+			.pSignalSemaphores = &renderFinishedSemaphore,
+		};
 
-		bool swapchainExtensionPresent = false;
+		renderDevice.functions->vkResetFences(renderDevice.device, 1, &impl.frameFences[impl.frameIndex]);
+		VkResult result =
+			renderDevice.functions->vkQueueSubmit(vkSubmitQueue, 1, &submitInfo, impl.frameFences[impl.frameIndex]);
 
-		for (auto& extensionName : extensions)
+		impl.imageAcquired = false;
+		impl.lastSubmitQueue = vkSubmitQueue;
+		impl.lastPresentQueue = vkPresentQueue;
+
+		if (result != VK_SUCCESS)
 		{
-			if (is_extension_available(extensionName))
-			{
-				enabledExtensions.push_back(extensionName.c_str());
-			}
-			else
+			// The frame is dropped, but the slot still moves on with a signaled fence and the image is presented
+			// as is so the swapchain gets it back.
+			std::cout << "Failed to submit frame\n";
+			if (submit_dropped_frame(impl, vkSubmitQueue, renderFinishedSemaphore))
 			{
-				std::cout << "Extension \"" << extensionName << "\" is not available.\n";
+				const VkPresentInfoKHR presentInfo{
+					.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+					.pNext = nullptr,
+					.waitSemaphoreCount = 1,
+					.pWaitSemaphores = &renderFinishedSemaphore,
+					.swapchainCount = 1,
+					.pSwapchains = &impl.swapchain,
+					.pImageIndices = &impl.imageIndex,
+					.pResults = nullptr,
+				};
+				renderDevice.functions->vkQueuePresentKHR(vkPresentQueue, &presentInfo);
 			}
 
-			if (presentingApplication &&
-				extensionName == MAKE_HASHED_STRING_VIEW_LITERAL(VK_KHR_SWAPCHAIN_EXTENSION_NAME))
-			{
-				swapchainExtensionPresent = true;
-			}
+			impl.frameIndex = (impl.frameIndex + 1) % impl.frameFences.size();
+			impl.frameCounter++;
+			impl.frameStarted = false;
+			return swapchain_status::failed;
 		}
 
-		if (presentingApplication && !swapchainExtensionPresent)
-		{
-			enabledExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
-		}
+		frame_timing& timing = impl.currentTiming;
+		timing.submit = get_timestamp();
+		timing.frameNumber = impl.frameCounter + 1;
 
-		if (!presentingApplication && swapchainExtensionPresent)
+		// Present ids must be non zero and increasing, the frame number is both.
+		const VkPresentIdKHR presentId{
+			.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR,
+			.pNext = nullptr,
+			.swapchainCount = 1,
+			.pPresentIds = &timing.frameNumber,
+		};
+
+		const VkPresentInfoKHR presentInfo{
+			.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+			.pNext = impl.presentWait ? &presentId : nullptr,
+			.waitSemaphoreCount = 1,
+			.pWaitSemaphores = &renderFinishedSemaphore,
+			.swapchainCount = 1,
+			.pSwapchains = &impl.swapchain,
+			.pImageIndices = &impl.imageIndex,
+			.pResults = nullptr,
+		};
+
+		result = renderDevice.functions->vkQueuePresentKHR(vkPresentQueue, &presentInfo);
+		timing.present = get_timestamp();
+		impl.frameIndex = (impl.frameIndex + 1) % impl.frameFences.size();
+		impl.frameCounter++;
+		impl.frameStarted = false;
+
+		// A frame that never reached the presentation engine would skew the histograms, it's left out of them and
+		// of the last frame timing.
+		const swapchain_status status = map_vk_swapchain_result(result);
+		if (status != swapchain_status::ready && status != swapchain_status::suboptimal)
 		{
-			std::cout << "Swapchain extension is activated, but no window handle was provided.\n";
-			return {};
+			return status;
 		}
 
-		auto& instancePtr = get_native_ref(impl.instance);
-		std::vector<rsl::cstring> enabledLayers;
-		enabledLayers.reserve(instancePtr.enabledLayers.size());
-		for (auto& layer : instancePtr.enabledLayers) { enabledLayers.push_back(layer.name.c_str()); }
+		impl.latency.acquire.record(timing.acquireReturn - timing.frameStart);
+		impl.latency.cpuFrame.record(timing.submit - timing.frameStart);
+		impl.latency.present.record(timing.present - timing.submit);
 
-		return create_render_device_no_extension_check(*this, queueDesciptions, enabledExtensions, enabledLayers);
-	}
+		if (impl.presentWait)
+		{
+			impl.pendingPresents.push_back(timing);
+			// A second check per frame besides the one in acquire_next_image narrows the error of presentComplete.
+			poll_present_completion(impl);
+		}
+		else
+		{
+			impl.lastTiming = timing;
+		}
 
-	render_device::operator bool() const noexcept
-	{
-		auto ptr = get_native_ptr(*this);
-		return ptr != nullptr && ptr->device != VK_NULL_HANDLE;
+		return status;
 	}
 
-	void render_device::release()
+	swapchain_status swapchain::recreate(rsl::math::uint2 extent)
 	{
-		auto* impl = get_native_ptr(*this);
+		auto& impl = get_native_ref(*this);
 
-		if (!impl)
+		if (extent.x != 0 && extent.y != 0)
 		{
-			return;
+			impl.description.extent = extent;
 		}
 
-		impl->vkDestroyDevice(impl->device, impl->allocCallbacks);
+		return build_swapchain(impl);
+	}
 
-		impl->physicalDevice.release();
+	rsl::size_type swapchain::get_retired_count() const noexcept
+	{
+		return get_native_ref(*this).retiredSwapchains.size();
+	}
 
-		m_nativeRenderDevice = invalid_native_render_device;
-		deallocate<native_render_device_vk>(*impl->alloc, impl);
+	void swapchain::begin_frame() noexcept
+	{
+		start_frame_timing(get_native_ref(*this));
 	}
 
-	std::span<queue> render_device::get_queues() noexcept
+	const frame_timing& swapchain::get_last_frame_timing() const noexcept
 	{
-		return get_native_ref(*this).queues;
+		return get_native_ref(*this).lastTiming;
 	}
 
-	physical_device render_device::get_physical_device() const noexcept
+	const frame_latency& swapchain::get_latency() const noexcept
 	{
-		return get_native_ref(*this).physicalDevice;
+		return get_native_ref(*this).latency;
 	}
 
-	bool native_render_device_vk::load_functions(std::span<const rsl::cstring> extensions)
+	void swapchain::reset_latency() noexcept
 	{
-#define DEVICE_LEVEL_VULKAN_FUNCTION(name)                                                                             \
-	name = std::bit_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name));                                              \
-	if (!name)                                                                                                         \
-	{                                                                                                                  \
-		std::cout << "Could not load device-level Vulkan function \"" #name "\"\n";                                    \
-		return false;                                                                                                  \
+		get_native_ref(*this).latency = frame_latency{};
 	}
 
-#define DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION(name, extension)                                                   \
-	for (auto& enabledExtension : extensions)                                                                          \
-	{                                                                                                                  \
-		if (std::string_view(enabledExtension) == std::string_view(extension))                                         \
-		{                                                                                                              \
-			name = std::bit_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name));                                      \
-			if (!name)                                                                                                 \
-			{                                                                                                          \
-				std::cout << "Could not load device-level Vulkan function \"" #name "\"\n";                            \
-				return false;                                                                                          \
-			}                                                                                                          \
-			break;                                                                                                     \
-		}                                                                                                              \
+	bool swapchain::measures_present_completion() const noexcept
+	{
+		return get_native_ref(*this).presentWait;
 	}
 
-#include "impl/list_of_vulkan_functions.inl"
+	rsl::size_type swapchain::get_image_count() const noexcept
+	{
+		return get_native_ref(*this).images.size();
+	}
 
-		return true;
+	std::span<const image_view_handle> swapchain::get_image_views() const noexcept
+	{
+		return get_native_ref(*this).imageViews;
 	}
 
-	queue::operator bool() const noexcept
+	rsl::uint32 swapchain::get_current_image_index() const noexcept
 	{
-		auto* impl = get_native_ptr(*this);
-		return impl != nullptr && impl->queue != VK_NULL_HANDLE;
+		return get_native_ref(*this).imageIndex;
 	}
 
-	void queue::release()
+	image_handle swapchain::get_current_image() const noexcept
 	{
-		auto* impl = get_native_ptr(*this);
-		if (!impl)
-		{
-			return;
-		}
+		auto& impl = get_native_ref(*this);
+		return std::bit_cast<image_handle>(impl.images[impl.imageIndex]);
+	}
 
-		m_nativeQueue = invalid_native_queue;
-		deallocate<native_queue_vk>(*impl->alloc, impl);
+	image_view_handle swapchain::get_current_image_view() const noexcept
+	{
+		auto& impl = get_native_ref(*this);
+		return impl.imageViews[impl.imageIndex];
 	}
 
-	rsl::size_type queue::get_index() const noexcept
+	rsl::size_type swapchain::get_frame_index() const noexcept
 	{
-		return get_native_ref(*this).queueIndex;
+		return get_native_ref(*this).frameIndex;
 	}
 
-	rsl::size_type queue::get_family_index() const noexcept
+	rsl::size_type swapchain::get_frames_in_flight() const noexcept
 	{
-		return get_native_ref(*this).familyIndex;
+		return get_native_ref(*this).frameFences.size();
 	}
 
-	queue_priority queue::get_priority() const noexcept
+	format swapchain::get_format() const noexcept
 	{
-		return get_native_ref(*this).priority;
+		return get_native_ref(*this).imageFormat;
 	}
 
-	const queue_family_properties& queue::get_family() const noexcept
+	rsl::math::uint2 swapchain::get_extent() const noexcept
 	{
-		return get_native_ref(*this).family;
+		return get_native_ref(*this).extent;
+	}
+
+	present_mode swapchain::get_present_mode() const noexcept
+	{
+		return get_native_ref(*this).presentMode;
+	}
+
+	image_layout swapchain::get_present_layout() const noexcept
+	{
+		return image_layout::presentSrc;
 	}
 
 	namespace
 	{
-		bool create_command_pool(queue q, command_pool& commandPool, VkCommandPoolCreateFlags flags)
+		// First memory type in typeBits with all of the properties, or the first one in typeBits when none has them.
+		[[nodiscard]] rsl::uint32
+		find_memory_type(native_render_device_vk& renderDevice, rsl::uint32 typeBits, VkMemoryPropertyFlags properties)
+		{
+			auto& physicalDevice = get_native_ref(renderDevice.physicalDevice);
+
+			VkPhysicalDeviceMemoryProperties memoryProperties;
+			physicalDevice.functions->vkGetPhysicalDeviceMemoryProperties(
+				physicalDevice.physicalDevice, &memoryProperties
+			);
+
+			rsl::uint32 fallback = ~0u;
+			for (rsl::uint32 i = 0; i < memoryProperties.memoryTypeCount; i++)
+			{
+				if ((typeBits & (1u << i)) == 0)
+				{
+					continue;
+				}
+
+				if ((memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+				{
+					return i;
+				}
+
+				if (fallback == ~0u)
+				{
+					fallback = i;
+				}
+			}
+
+			return fallback;
+		}
+
+		void destroy_headless_images(native_headless_target_vk& impl)
 		{
-			auto& impl = get_native_ref(q);
 			auto& renderDevice = get_native_ref(impl.renderDevice);
-			const VkCommandPoolCreateInfo commandPoolCreateInfo{
-				.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+
+			for (auto imageView : impl.imageViews) { impl.renderDevice.destroy_image_view(imageView); }
+			for (auto image : impl.images)
+			{
+				renderDevice.functions->vkDestroyImage(renderDevice.device, image, impl.allocCallbacks);
+			}
+			for (auto memory : impl.imageMemory)
+			{
+				renderDevice.functions->vkFreeMemory(renderDevice.device, memory, impl.allocCallbacks);
+			}
+
+			impl.images.clear();
+			impl.imageMemory.clear();
+			impl.imageViews.clear();
+		}
+
+		[[nodiscard]] bool build_headless_images(native_headless_target_vk& impl)
+		{
+			auto& renderDevice = get_native_ref(impl.renderDevice);
+			const auto& description = impl.description;
+
+			const VkFormat format = static_cast<VkFormat>(description.imageFormat);
+			const rsl::uint32 imageCount =
+				std::max(description.imageCount, static_cast<rsl::uint32>(impl.frameFences.size()));
+
+			const VkImageCreateInfo imageCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
 				.pNext = nullptr,
-				.flags = flags,
-				.queueFamilyIndex = static_cast<rsl::uint32>(impl.familyIndex),
+				.flags = 0,
+				.imageType = VK_IMAGE_TYPE_2D,
+				.format = format,
+				.extent = {.width = description.extent.x, .height = description.extent.y, .depth = 1},
+				.mipLevels = 1,
+				.arrayLayers = 1,
+				.samples = VK_SAMPLE_COUNT_1_BIT,
+				.tiling = VK_IMAGE_TILING_OPTIMAL,
+				.usage = static_cast<VkImageUsageFlags>(description.imageUsage) | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+						 VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+				.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+				.queueFamilyIndexCount = 0,
+				.pQueueFamilyIndices = nullptr,
+				.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
 			};
 
-			VkCommandPool vkCommandPool = VK_NULL_HANDLE;
-			VkResult result = renderDevice.vkCreateCommandPool(
-				renderDevice.device, &commandPoolCreateInfo, impl.allocCallbacks, &vkCommandPool
-			);
+			for (rsl::uint32 i = 0; i < imageCount; i++)
+			{
+				VkImage image = VK_NULL_HANDLE;
+				if (renderDevice.functions->vkCreateImage(
+						renderDevice.device, &imageCreateInfo, impl.allocCallbacks, &image
+					) != VK_SUCCESS)
+				{
+					std::cout << "Failed to create headless image\n";
+					destroy_headless_images(impl);
+					return false;
+				}
+				impl.images.push_back(image);
+
+				VkMemoryRequirements memoryRequirements;
+				renderDevice.functions->vkGetImageMemoryRequirements(renderDevice.device, image, &memoryRequirements);
+
+				const VkMemoryAllocateInfo allocateInfo{
+					.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+					.pNext = nullptr,
+					.allocationSize = memoryRequirements.size,
+					.memoryTypeIndex = find_memory_type(
+						renderDevice, memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+					),
+				};
+
+				VkDeviceMemory memory = VK_NULL_HANDLE;
+				if (allocateInfo.memoryTypeIndex == ~0u ||
+					renderDevice.functions->vkAllocateMemory(
+						renderDevice.device, &allocateInfo, impl.allocCallbacks, &memory
+					) != VK_SUCCESS)
+				{
+					std::cout << "Failed to allocate headless image memory\n";
+					destroy_headless_images(impl);
+					return false;
+				}
+				impl.imageMemory.push_back(memory);
 
-			if (result != VK_SUCCESS || vkCommandPool == VK_NULL_HANDLE)
+				if (renderDevice.functions->vkBindImageMemory(renderDevice.device, image, memory, 0) != VK_SUCCESS)
+				{
+					std::cout << "Failed to bind headless image memory\n";
+					destroy_headless_images(impl);
+					return false;
+				}
+
+				const VkImageViewCreateInfo imageViewCreateInfo{
+					.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+					.pNext = nullptr,
+					.flags = 0,
+					.image = image,
+					.viewType = VK_IMAGE_VIEW_TYPE_2D,
+					.format = format,
+					.components = {},
+					.subresourceRange = firstColorSubresource,
+				};
+
+				VkImageView imageView = VK_NULL_HANDLE;
+				if (renderDevice.functions->vkCreateImageView(
+						renderDevice.device, &imageViewCreateInfo, impl.allocCallbacks, &imageView
+					) != VK_SUCCESS)
+				{
+					std::cout << "Failed to create headless image view\n";
+					destroy_headless_images(impl);
+					return false;
+				}
+				impl.imageViews.push_back(std::bit_cast<image_view_handle>(imageView));
+			}
+
+			return true;
+		}
+
+		void destroy_headless_fences(native_headless_target_vk& impl)
+		{
+			auto& renderDevice = get_native_ref(impl.renderDevice);
+
+			for (auto fence : impl.frameFences)
 			{
-				std::cout << "Failed to create command pool for queue " << impl.queueIndex << '\n';
-				return false;
+				renderDevice.functions->vkDestroyFence(renderDevice.device, fence, impl.allocCallbacks);
 			}
 
-			native_command_pool_vk* nativeCommandPool = allocate<native_command_pool_vk>(*impl.alloc);
+			impl.frameFences.clear();
+		}
 
-			nativeCommandPool->alloc = impl.alloc;
-			nativeCommandPool->allocCallbacks = impl.allocCallbacks;
-			nativeCommandPool->commandPool = vkCommandPool;
-			nativeCommandPool->renderDevice = impl.renderDevice;
+		[[nodiscard]] bool create_headless_fences(native_headless_target_vk& impl, rsl::size_type framesInFlight)
+		{
+			auto& renderDevice = get_native_ref(impl.renderDevice);
+
+			// Fences start signaled so the first acquire of every frame slot doesn't wait.
+			const VkFenceCreateInfo fenceCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = VK_FENCE_CREATE_SIGNALED_BIT,
+			};
+
+			for (rsl::size_type i = 0; i < framesInFlight; i++)
+			{
+				VkFence fence = VK_NULL_HANDLE;
+				if (renderDevice.functions->vkCreateFence(
+						renderDevice.device, &fenceCreateInfo, impl.allocCallbacks, &fence
+					) != VK_SUCCESS)
+				{
+					std::cout << "Failed to create frame fence\n";
+					destroy_headless_fences(impl);
+					return false;
+				}
+				impl.frameFences.push_back(fence);
+			}
 
-			set_native_handle(commandPool, create_native_handle(nativeCommandPool));
 			return true;
 		}
+
+		void wait_for_headless_frames(native_headless_target_vk& impl)
+		{
+			auto& renderDevice = get_native_ref(impl.renderDevice);
+
+			if (!impl.frameFences.empty())
+			{
+				renderDevice.functions->vkWaitForFences(
+					renderDevice.device, static_cast<rsl::uint32>(impl.frameFences.size()), impl.frameFences.data(),
+					VK_TRUE, ~0ull
+				);
+			}
+		}
 	} // namespace
 
-	[[nodiscard]] persistent_command_pool queue::create_persistent_command_pool(bool protectedCommandBuffers)
+	headless_target render_device::create_headless_target(const headless_target_description& description)
 	{
-		persistent_command_pool commandPool;
+		auto& impl = get_native_ref(*this);
 
-		if (!create_command_pool(
-				*this, commandPool,
-				VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT |
-					(protectedCommandBuffers ? VK_COMMAND_POOL_CREATE_PROTECTED_BIT : 0)
-			))
+		if (description.extent.x == 0 || description.extent.y == 0)
 		{
+			std::cout << "Headless targets need a non zero extent\n";
 			return {};
 		}
 
-		return commandPool;
-	}
-
-	transient_command_pool queue::create_transient_command_pool(bool protectedCommandBuffers)
-	{
-		transient_command_pool commandPool;
+		auto* targetPtr = allocate<native_headless_target_vk>(*impl.alloc);
+		targetPtr->renderDevice = *this;
+		targetPtr->alloc = impl.alloc;
+		targetPtr->allocCallbacks = impl.allocCallbacks;
+		targetPtr->description = description;
 
-		if (!create_command_pool(
-				*this, commandPool,
-				VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
-					(protectedCommandBuffers ? VK_COMMAND_POOL_CREATE_PROTECTED_BIT : 0)
-			))
+		if (!create_headless_fences(*targetPtr, std::max(description.framesInFlight, 1u)) ||
+			!build_headless_images(*targetPtr))
 		{
+			destroy_headless_fences(*targetPtr);
+			deallocate<native_headless_target_vk>(*impl.alloc, targetPtr);
 			return {};
 		}
 
-		return commandPool;
+		headless_target result;
+		set_native_handle(result, create_native_handle(targetPtr));
+		return result;
 	}
 
-	namespace
+	headless_target::operator bool() const noexcept
 	{
-		bool create_command_buffers(
-			native_command_pool_vk& impl, std::span<command_buffer> buffers,
-			std::span<VkCommandBuffer> commandBuffersBuffer, command_buffer_level level
-		)
+		auto* impl = get_native_ptr(*this);
+		return impl != nullptr && !impl->images.empty();
+	}
+
+	void headless_target::release()
+	{
+		auto* impl = get_native_ptr(*this);
+		if (!impl)
 		{
-			rsl_assert_consistent(buffers.size() <= commandBuffersBuffer.size());
+			return;
+		}
 
-			auto& renderDevice = get_native_ref(impl.renderDevice);
+		wait_for_headless_frames(*impl);
+		destroy_headless_images(*impl);
+		destroy_headless_fences(*impl);
 
-			const VkCommandBufferAllocateInfo commandBufferAllocateInfo = {
-				.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-				.pNext = nullptr,
-				.commandPool = impl.commandPool,
-				.level =
-					(level == command_buffer_level::primary ? VK_COMMAND_BUFFER_LEVEL_PRIMARY
-															: VK_COMMAND_BUFFER_LEVEL_SECONDARY),
-				.commandBufferCount = static_cast<rsl::uint32>(buffers.size()),
-			};
+		m_nativeHeadlessTarget = invalid_native_headless_target;
+		deallocate<native_headless_target_vk>(*impl->alloc, impl);
+	}
 
-			VkResult result = renderDevice.vkAllocateCommandBuffers(
-				renderDevice.device, &commandBufferAllocateInfo, commandBuffersBuffer.data()
-			);
+	swapchain_status headless_target::acquire_next_image()
+	{
+		auto& impl = get_native_ref(*this);
+		auto& renderDevice = get_native_ref(impl.renderDevice);
 
-			if (result != VK_SUCCESS)
-			{
-				return false;
-			}
+		if (!impl.frameStarted)
+		{
+			start_frame_timing(impl);
+		}
 
-			for (rsl::size_type i = 0; i < buffers.size(); i++)
-			{
-				command_buffer& buffer = buffers[i];
-				auto* nativeCommandBuffer = get_native_ptr(buffer);
-				if (!nativeCommandBuffer)
-				{
-					nativeCommandBuffer = allocate<native_command_buffer_vk>(*impl.alloc);
-					set_native_handle(buffer, create_native_handle(nativeCommandBuffer));
-				}
+		if (impl.images.empty())
+		{
+			return swapchain_status::failed;
+		}
 
-				nativeCommandBuffer->device = impl.renderDevice;
-				nativeCommandBuffer->nextUnusedIndex = i + 1;
-				nativeCommandBuffer->indexInPool = i;
-				nativeCommandBuffer->level = level;
-				nativeCommandBuffer->commandBuffer = commandBuffersBuffer[i];
-			}
+		// The fence stays signaled until present resets it right before submitting.
+		const VkFence frameFence = impl.frameFences[impl.frameIndex];
+		renderDevice.functions->vkWaitForFences(renderDevice.device, 1, &frameFence, VK_TRUE, ~0ull);
 
-			return true;
-		}
-	} // namespace
+		// There are at least as many images as frame slots, so the frame that last used this image has finished.
+		impl.imageIndex = static_cast<rsl::uint32>(impl.frameCounter % impl.images.size());
+		impl.currentTiming.acquireReturn = get_timestamp();
 
-	command_pool::operator bool() const noexcept
-	{
-		auto* impl = get_native_ptr(*this);
-		return impl != nullptr && impl->commandPool != VK_NULL_HANDLE;
+		return swapchain_status::ready;
 	}
 
-	void persistent_command_pool::release()
+	swapchain_status headless_target::present(
+		queue submitQueue, std::span<const command_buffer> commandBuffers, [[maybe_unused]] queue presentQueue
+	)
 	{
-		auto* impl = get_native_ptr(*this);
-		if (!impl)
+		auto& impl = get_native_ref(*this);
+		auto& renderDevice = get_native_ref(impl.renderDevice);
+
+		impl.submitCommandBuffers.clear();
+		for (auto& commandBuffer : commandBuffers)
 		{
-			return;
+			impl.submitCommandBuffers.push_back(get_native_ref(commandBuffer).commandBuffer);
 		}
 
-		for (auto& commandBuffer : impl->primaryCommandBuffers.commandBuffers)
+		const VkSubmitInfo submitInfo{
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+			.pNext = nullptr,
+			.waitSemaphoreCount = 0,
+			.pWaitSemaphores = nullptr,
+			.pWaitDstStageMask = nullptr,
+			.commandBufferCount = static_cast<rsl::uint32>(impl.submitCommandBuffers.size()),
+			.pCommandBuffers = impl.submitCommandBuffers.data(),
+			.signalSemaphoreCount = 0,
+			.pSignalSemaphores = nullptr,
+		};
+
+		const VkQueue vkSubmitQueue = get_native_ref(submitQueue).queue;
+		VkFence& frameFence = impl.frameFences[impl.frameIndex];
+		renderDevice.functions->vkResetFences(renderDevice.device, 1, &frameFence);
+
+		if (renderDevice.functions->vkQueueSubmit(vkSubmitQueue, 1, &submitInfo, frameFence) != VK_SUCCESS)
 		{
-			auto* ptr = get_native_ptr(commandBuffer);
-			if (ptr)
+			// The fence is signaled again with an empty submit, or replaced by a signaled one, so waiting on the
+			// slot in acquire_next_image, recreate and release doesn't hang.
+			std::cout << "Failed to submit frame\n";
+			if (renderDevice.functions->vkQueueSubmit(vkSubmitQueue, 0, nullptr, frameFence) != VK_SUCCESS)
 			{
-				deallocate<native_command_buffer_vk>(*impl->alloc, ptr);
+				replace_with_signaled_fence(renderDevice, frameFence, impl.allocCallbacks);
 			}
+
+			impl.frameStarted = false;
+			return swapchain_status::failed;
 		}
 
-		for (auto& commandBuffer : impl->secondaryCommandBuffers.commandBuffers)
+		frame_timing& timing = impl.currentTiming;
+		timing.submit = get_timestamp();
+		timing.frameNumber = impl.frameCounter + 1;
+
+		impl.frameIndex = (impl.frameIndex + 1) % impl.frameFences.size();
+		impl.frameCounter++;
+
+		impl.latency.acquire.record(timing.acquireReturn - timing.frameStart);
+		impl.latency.cpuFrame.record(timing.submit - timing.frameStart);
+		impl.frameStarted = false;
+		impl.lastTiming = timing;
+
+		return swapchain_status::ready;
+	}
+
+	swapchain_status headless_target::recreate(rsl::math::uint2 extent)
+	{
+		auto& impl = get_native_ref(*this);
+
+		if (extent.x != 0 && extent.y != 0)
 		{
-			auto* ptr = get_native_ptr(commandBuffer);
-			if (ptr)
-			{
-				deallocate<native_command_buffer_vk>(*impl->alloc, ptr);
-			}
+			impl.description.extent = extent;
 		}
 
-		auto& renderDevice = get_native_ref(impl->renderDevice);
+		wait_for_headless_frames(impl);
+		destroy_headless_images(impl);
 
-		renderDevice.vkDestroyCommandPool(renderDevice.device, impl->commandPool, impl->allocCallbacks);
+		return build_headless_images(impl) ? swapchain_status::ready : swapchain_status::failed;
+	}
 
-		m_nativeCommandPool = invalid_native_command_pool;
-		deallocate<native_command_pool_vk>(*impl->alloc, impl);
+	void headless_target::begin_frame() noexcept
+	{
+		start_frame_timing(get_native_ref(*this));
 	}
 
-	rsl::size_type persistent_command_pool::get_capacity(command_buffer_level level) const noexcept
+	const frame_timing& headless_target::get_last_frame_timing() const noexcept
 	{
-		auto& impl = get_native_ref(*this);
-		return level == command_buffer_level::primary ? impl.primaryCommandBuffers.commandBuffers.size()
-													  : impl.secondaryCommandBuffers.commandBuffers.size();
+		return get_native_ref(*this).lastTiming;
 	}
 
-	rsl::size_type persistent_command_pool::get_unused_count(command_buffer_level level) const noexcept
+	const frame_latency& headless_target::get_latency() const noexcept
 	{
-		auto& impl = get_native_ref(*this);
-		return level == command_buffer_level::primary ? impl.primaryCommandBuffers.unusedCount
-													  : impl.secondaryCommandBuffers.unusedCount;
+		return get_native_ref(*this).latency;
 	}
 
-	void persistent_command_pool::reserve(rsl::size_type count, command_buffer_level level)
+	void headless_target::reset_latency() noexcept
+	{
+		get_native_ref(*this).latency = frame_latency{};
+	}
+
+	rsl::size_type headless_target::get_image_count() const noexcept
+	{
+		return get_native_ref(*this).images.size();
+	}
+
+	std::span<const image_view_handle> headless_target::get_image_views() const noexcept
+	{
+		return get_native_ref(*this).imageViews;
+	}
+
+	rsl::uint32 headless_target::get_current_image_index() const noexcept
+	{
+		return get_native_ref(*this).imageIndex;
+	}
+
+	image_handle headless_target::get_current_image() const noexcept
 	{
 		auto& impl = get_native_ref(*this);
+		return std::bit_cast<image_handle>(impl.images[impl.imageIndex]);
+	}
 
-		auto& commandBufferPool =
-			level == command_buffer_level::primary ? impl.primaryCommandBuffers : impl.secondaryCommandBuffers;
+	image_view_handle headless_target::get_current_image_view() const noexcept
+	{
+		auto& impl = get_native_ref(*this);
+		return impl.imageViews[impl.imageIndex];
+	}
 
-		auto oldCount = commandBufferPool.commandBuffers.size();
+	rsl::size_type headless_target::get_frame_index() const noexcept
+	{
+		return get_native_ref(*this).frameIndex;
+	}
 
-		if (oldCount >= count)
-		{
-			return;
-		}
+	rsl::size_type headless_target::get_frames_in_flight() const noexcept
+	{
+		return get_native_ref(*this).frameFences.size();
+	}
 
-		rsl::size_type additionalCount = count - oldCount;
-		commandBufferPool.commandBuffers.resize(count);
-		if (additionalCount > impl.commandBuffersBuffer.size())
-		{
-			impl.commandBuffersBuffer.resize(additionalCount);
-		}
+	format headless_target::get_format() const noexcept
+	{
+		return get_native_ref(*this).description.imageFormat;
+	}
 
-        [[maybe_unused]]bool result = create_command_buffers(
-			impl, std::span(commandBufferPool.commandBuffers.data() + oldCount, additionalCount),
-			impl.commandBuffersBuffer, level
-		);
-		rsl_soft_assert_msg_consistent(result, "failed to create command buffer");
+	rsl::math::uint2 headless_target::get_extent() const noexcept
+	{
+		return get_native_ref(*this).description.extent;
+	}
 
-		commandBufferPool.unusedCount += additionalCount;
+	image_layout headless_target::get_present_layout() const noexcept
+	{
+		return image_layout::transferSrcOptimal;
 	}
 
-	command_buffer persistent_command_pool::get_command_buffer(command_buffer_level level)
+	[[nodiscard]] buffer render_device::create_buffer(const buffer_description& description)
 	{
 		auto& impl = get_native_ref(*this);
 
-		auto& commandBufferPool =
-			level == command_buffer_level::primary ? impl.primaryCommandBuffers : impl.secondaryCommandBuffers;
-
-		if (commandBufferPool.unusedCount == 0)
+		if (description.size == 0)
 		{
-			reserve(commandBufferPool.lastUnusedIndex + 1, level);
+			std::cout << "Buffers need a non zero size\n";
+			return {};
 		}
-		else
+
+		const VkBufferCreateInfo bufferCreateInfo{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.size = description.size,
+			.usage = static_cast<VkBufferUsageFlags>(description.usage),
+			.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+			.queueFamilyIndexCount = 0,
+			.pQueueFamilyIndices = nullptr,
+		};
+
+		VkBuffer vkBuffer = VK_NULL_HANDLE;
+		if (impl.functions->vkCreateBuffer(
+				impl.device, &bufferCreateInfo, impl.allocCallbacks, &vkBuffer
+			) != VK_SUCCESS)
 		{
-			rsl_assert_consistent(commandBufferPool.lastUnusedIndex < commandBufferPool.commandBuffers.size());
+			std::cout << "Failed to create buffer\n";
+			return {};
 		}
 
-		command_buffer commandBuffer = commandBufferPool.commandBuffers[commandBufferPool.lastUnusedIndex];
-
-		auto& nativeCommandBuffer = get_native_ref(commandBuffer);
-		nativeCommandBuffer.commandPoolStorage.set(*this);
-		commandBufferPool.lastUnusedIndex = nativeCommandBuffer.nextUnusedIndex;
-		commandBufferPool.unusedCount--;
+		VkMemoryRequirements memoryRequirements;
+		impl.functions->vkGetBufferMemoryRequirements(impl.device, vkBuffer, &memoryRequirements);
 
-		return commandBuffer;
-	}
+		const VkMemoryAllocateInfo allocateInfo{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+			.pNext = nullptr,
+			.allocationSize = memoryRequirements.size,
+			.memoryTypeIndex =
+				find_memory_type(impl, memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+		};
 
-	void persistent_command_pool::return_command_buffer(command_buffer& commandBuffer)
-	{
-		auto& impl = get_native_ref(*this);
-		auto& nativeCommandBuffer = get_native_ref(commandBuffer);
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		if (allocateInfo.memoryTypeIndex == ~0u ||
+			impl.functions->vkAllocateMemory(impl.device, &allocateInfo, impl.allocCallbacks, &memory) != VK_SUCCESS)
+		{
+			std::cout << "Failed to allocate buffer memory\n";
+			impl.functions->vkDestroyBuffer(impl.device, vkBuffer, impl.allocCallbacks);
+			return {};
+		}
 
+		if (impl.functions->vkBindBufferMemory(impl.device, vkBuffer, memory, 0) != VK_SUCCESS)
+		{
+			std::cout << "Failed to bind buffer memory\n";
+			impl.functions->vkDestroyBuffer(impl.device, vkBuffer, impl.allocCallbacks);
+			impl.functions->vkFreeMemory(impl.device, memory, impl.allocCallbacks);
+			return {};
+		}
 
-		auto& commandBufferPool = nativeCommandBuffer.level == command_buffer_level::primary
-									  ? impl.primaryCommandBuffers
-									  : impl.secondaryCommandBuffers;
+		auto* bufferPtr = allocate<native_buffer_vk>(*impl.alloc);
+		bufferPtr->renderDevice = *this;
+		bufferPtr->alloc = impl.alloc;
+		bufferPtr->allocCallbacks = impl.allocCallbacks;
+		bufferPtr->description = description;
+		bufferPtr->buffer = vkBuffer;
+		bufferPtr->memory = memory;
 
-		nativeCommandBuffer.nextUnusedIndex = commandBufferPool.lastUnusedIndex;
-		commandBufferPool.lastUnusedIndex = nativeCommandBuffer.indexInPool;
-		commandBufferPool.unusedCount++;
+		buffer result;
+		set_native_handle(result, create_native_handle(bufferPtr));
+		return result;
+	}
 
-		set_native_handle(commandBuffer, invalid_native_command_buffer);
+	buffer::operator bool() const noexcept
+	{
+		auto* impl = get_native_ptr(*this);
+		return impl != nullptr && impl->buffer != VK_NULL_HANDLE;
 	}
 
-	void transient_command_pool::release()
+	void buffer::release()
 	{
 		auto* impl = get_native_ptr(*this);
 		if (!impl)
@@ -2732,48 +10954,75 @@ namespace vk
 		}
 
 		auto& renderDevice = get_native_ref(impl->renderDevice);
+		renderDevice.functions->vkDestroyBuffer(renderDevice.device, impl->buffer, impl->allocCallbacks);
+		renderDevice.functions->vkFreeMemory(renderDevice.device, impl->memory, impl->allocCallbacks);
 
-		renderDevice.vkDestroyCommandPool(renderDevice.device, impl->commandPool, impl->allocCallbacks);
+		m_nativeBuffer = invalid_native_buffer;
+		deallocate<native_buffer_vk>(*impl->alloc, impl);
+	}
 
-		m_nativeCommandPool = invalid_native_command_pool;
-		deallocate<native_command_pool_vk>(*impl->alloc, impl);
+	const buffer_description& buffer::get_description() const noexcept
+	{
+		return get_native_ref(*this).description;
 	}
 
-	rsl::size_type transient_command_pool::get_capacity([[maybe_unused]] command_buffer_level level) const noexcept
+	buffer_handle buffer::get_buffer_handle() const noexcept
 	{
-		return rsl::size_type();
+		return std::bit_cast<buffer_handle>(get_native_ref(*this).buffer);
 	}
 
-	rsl::size_type transient_command_pool::get_unused_count([[maybe_unused]] command_buffer_level level) const noexcept
+	void latency_histogram::record(rsl::uint64 nanoseconds) noexcept
 	{
-		return rsl::size_type();
+		m_buckets[std::min<rsl::uint64>(nanoseconds / bucket_width, bucket_count - 1)]++;
+		m_sampleCount++;
+		m_total += nanoseconds;
+		m_min = std::min(m_min, nanoseconds);
+		m_max = std::max(m_max, nanoseconds);
 	}
 
-	void
-	transient_command_pool::reserve([[maybe_unused]] rsl::size_type count, [[maybe_unused]] command_buffer_level level)
+	void latency_histogram::reset() noexcept
 	{
+		*this = latency_histogram{};
 	}
 
-	command_buffer transient_command_pool::get_command_buffer([[maybe_unused]] command_buffer_level level)
+	rsl::uint64 latency_histogram::get_min() const noexcept
 	{
-		return command_buffer();
+		return m_sampleCount == 0 ? 0 : m_min;
 	}
 
-	void transient_command_pool::return_command_buffer([[maybe_unused]] command_buffer& commandBuffer) {}
+	rsl::uint64 latency_histogram::get_max() const noexcept
+	{
+		return m_max;
+	}
 
-	command_buffer::operator bool() const noexcept
+	rsl::uint64 latency_histogram::get_mean() const noexcept
 	{
-		auto* impl = get_native_ptr(*this);
-		return impl && impl->commandBuffer != VK_NULL_HANDLE;
+		return m_sampleCount == 0 ? 0 : m_total / m_sampleCount;
 	}
 
-	void command_buffer::return_to_pool()
+	rsl::uint64 latency_histogram::get_percentile(float percentile) const noexcept
 	{
-		auto* impl = get_native_ptr(*this);
-		if (impl)
+		if (m_sampleCount == 0)
 		{
-			impl->get_pool().return_command_buffer(*this);
+			return 0;
 		}
-	}
 
+		const rsl::uint64 target = std::max<rsl::uint64>(
+			static_cast<rsl::uint64>(std::ceil(std::clamp(percentile, 0.0f, 1.0f) * static_cast<float>(m_sampleCount))),
+			1
+		);
+
+		rsl::uint64 count = 0;
+		for (rsl::size_type i = 0; i < bucket_count; i++)
+		{
+			count += m_buckets[i];
+			if (count >= target)
+			{
+				// The overflow bucket has no upper bound, the largest sample is the best estimate there.
+				return i == bucket_count - 1 ? m_max : std::min((i + 1) * bucket_width, m_max);
+			}
+		}
+
+		return m_max;
+	}
 } // namespace vk
@@ -7,7 +7,9 @@
 #include <rsl/primitives>
 
 #include <semver/semver.hpp>
+#include <future>
 #include <span>
+#include <vector>
 
 #if RYTHE_PLATFORM_WINDOWS
 	#define WIN32_LEAN_AND_MEAN
@@ -33,11 +35,37 @@ namespace vk
 	DECLARE_API_TYPE(queue)
 	DECLARE_API_TYPE(command_pool)
 	DECLARE_API_TYPE(command_buffer)
+	DECLARE_API_TYPE(pipeline_cache)
+	DECLARE_API_TYPE(shader_module)
+	DECLARE_API_TYPE(shader_pack)
+	DECLARE_API_TYPE(descriptor_set_layout)
+	DECLARE_API_TYPE(pipeline_layout)
+	DECLARE_API_TYPE(descriptor_set)
+	DECLARE_API_TYPE(descriptor_allocator)
+	DECLARE_API_TYPE(descriptor_writer)
+	DECLARE_API_TYPE(sampler)
+	DECLARE_API_TYPE(bindless_table)
+	DECLARE_API_TYPE(render_pass)
+	DECLARE_API_TYPE(pipeline)
+	DECLARE_API_TYPE(pipeline_batch)
+	DECLARE_API_TYPE(swapchain)
+	DECLARE_API_TYPE(headless_target)
+	DECLARE_API_TYPE(buffer)
 
 #undef DECLARE_API_TYPE
 
 	DECLARE_OPAQUE_HANDLE(native_window_handle);
 
+	// Raw VkBuffer, VkImage, VkImageView and VkSampler handles for resources created outside of this module, or owned
+	// by buffers, swapchains and headless targets.
+	DECLARE_OPAQUE_HANDLE(buffer_handle);
+	DECLARE_OPAQUE_HANDLE(image_handle);
+	DECLARE_OPAQUE_HANDLE(image_view_handle);
+	DECLARE_OPAQUE_HANDLE(sampler_handle);
+
+	// Raw VkFramebuffer owned by the render device's framebuffer cache.
+	DECLARE_OPAQUE_HANDLE(framebuffer_handle);
+
 #if RYTHE_PLATFORM_WINDOWS
 	struct native_window_info_win32
 	{
@@ -107,12 +135,16 @@ namespace vk
 
 		std::span<const layer_properties> get_available_instance_layers(bool forceRefresh = false);
 		bool is_instance_layer_available(rsl::hashed_string_view layerName);
+		// True when every layer is available, a single hash lookup per layer.
+		bool are_instance_layers_available(std::span<const rsl::hashed_string_view> layerNames);
 
 		std::span<const extension_properties> get_available_instance_extensions(bool forceRefresh = false);
 		bool is_instance_extension_available(rsl::hashed_string_view extensionName);
+		bool are_instance_extensions_available(std::span<const rsl::hashed_string_view> extensionNames);
 
+		// apiVersion is lowered to the highest version the Vulkan loader supports.
 		[[nodiscard]] instance create_instance(
-			const application_info& applicationInfo, const semver::version& apiVersion = {1, 0, 0},
+			const application_info& applicationInfo, const semver::version& apiVersion = {1, 3, 0},
 			std::span<const rsl::hashed_string> layers = {}, std::span<const rsl::hashed_string> extensions = {}
 		);
 
@@ -124,63 +156,114 @@ namespace vk
 		friend void set_native_handle(graphics_library&, native_graphics_library);
 	};
 
+	// Bit indices into physical_device_features, in VkPhysicalDeviceFeatures member order.
+	enum struct [[rythe_closed_enum]] physical_device_feature : rsl::uint8
+	{
+		robustBufferAccess,
+		fullDrawIndexUint32,
+		imageCubeArray,
+		independentBlend,
+		geometryShader,
+		tessellationShader,
+		sampleRateShading,
+		dualSrcBlend,
+		logicOp,
+		multiDrawIndirect,
+		drawIndirectFirstInstance,
+		depthClamp,
+		depthBiasClamp,
+		fillModeNonSolid,
+		depthBounds,
+		wideLines,
+		largePoints,
+		alphaToOne,
+		multiViewport,
+		samplerAnisotropy,
+		textureCompressionETC2,
+		textureCompressionASTC_LDR,
+		textureCompressionBC,
+		occlusionQueryPrecise,
+		pipelineStatisticsQuery,
+		vertexPipelineStoresAndAtomics,
+		fragmentStoresAndAtomics,
+		shaderTessellationAndGeometryPointSize,
+		shaderImageGatherExtended,
+		shaderStorageImageExtendedFormats,
+		shaderStorageImageMultisample,
+		shaderStorageImageReadWithoutFormat,
+		shaderStorageImageWriteWithoutFormat,
+		shaderUniformBufferArrayDynamicIndexing,
+		shaderSampledImageArrayDynamicIndexing,
+		shaderStorageBufferArrayDynamicIndexing,
+		shaderStorageImageArrayDynamicIndexing,
+		shaderClipDistance,
+		shaderCullDistance,
+		shaderFloat64,
+		shaderInt64,
+		shaderInt16,
+		shaderResourceResidency,
+		shaderResourceMinLod,
+		sparseBinding,
+		sparseResidencyBuffer,
+		sparseResidencyImage2D,
+		sparseResidencyImage3D,
+		sparseResidency2Samples,
+		sparseResidency4Samples,
+		sparseResidency8Samples,
+		sparseResidency16Samples,
+		sparseResidencyAliased,
+		variableMultisampleRate,
+		inheritedQueries,
+	};
+
+	// One bit per physical_device_feature. Checking requirements is a single masked compare and a set hashes as one
+	// integer.
 	struct physical_device_features
 	{
-		bool robustBufferAccess : 1 = false;
-		bool fullDrawIndexUint32 : 1 = false;
-		bool imageCubeArray : 1 = false;
-		bool independentBlend : 1 = false;
-		bool geometryShader : 1 = false;
-		bool tessellationShader : 1 = false;
-		bool sampleRateShading : 1 = false;
-		bool dualSrcBlend : 1 = false;
-		bool logicOp : 1 = false;
-		bool multiDrawIndirect : 1 = false;
-		bool drawIndirectFirstInstance : 1 = false;
-		bool depthClamp : 1 = false;
-		bool depthBiasClamp : 1 = false;
-		bool fillModeNonSolid : 1 = false;
-		bool depthBounds : 1 = false;
-		bool wideLines : 1 = false;
-		bool largePoints : 1 = false;
-		bool alphaToOne : 1 = false;
-		bool multiViewport : 1 = false;
-		bool samplerAnisotropy : 1 = false;
-		bool textureCompressionETC2 : 1 = false;
-		bool textureCompressionASTC_LDR : 1 = false;
-		bool textureCompressionBC : 1 = false;
-		bool occlusionQueryPrecise : 1 = false;
-		bool pipelineStatisticsQuery : 1 = false;
-		bool vertexPipelineStoresAndAtomics : 1 = false;
-		bool fragmentStoresAndAtomics : 1 = false;
-		bool shaderTessellationAndGeometryPointSize : 1 = false;
-		bool shaderImageGatherExtended : 1 = false;
-		bool shaderStorageImageExtendedFormats : 1 = false;
-		bool shaderStorageImageMultisample : 1 = false;
-		bool shaderStorageImageReadWithoutFormat : 1 = false;
-		bool shaderStorageImageWriteWithoutFormat : 1 = false;
-		bool shaderUniformBufferArrayDynamicIndexing : 1 = false;
-		bool shaderSampledImageArrayDynamicIndexing : 1 = false;
-		bool shaderStorageBufferArrayDynamicIndexing : 1 = false;
-		bool shaderStorageImageArrayDynamicIndexing : 1 = false;
-		bool shaderClipDistance : 1 = false;
-		bool shaderCullDistance : 1 = false;
-		bool shaderFloat64 : 1 = false;
-		bool shaderInt64 : 1 = false;
-		bool shaderInt16 : 1 = false;
-		bool shaderResourceResidency : 1 = false;
-		bool shaderResourceMinLod : 1 = false;
-		bool sparseBinding : 1 = false;
-		bool sparseResidencyBuffer : 1 = false;
-		bool sparseResidencyImage2D : 1 = false;
-		bool sparseResidencyImage3D : 1 = false;
-		bool sparseResidency2Samples : 1 = false;
-		bool sparseResidency4Samples : 1 = false;
-		bool sparseResidency8Samples : 1 = false;
-		bool sparseResidency16Samples : 1 = false;
-		bool sparseResidencyAliased : 1 = false;
-		bool variableMultisampleRate : 1 = false;
-		bool inheritedQueries : 1 = false;
+		constexpr static rsl::size_type featureCount = 55;
+		static_assert(static_cast<rsl::size_type>(physical_device_feature::inheritedQueries) + 1 == featureCount);
+
+		rsl::uint64 bits = 0;
+
+		// Builds a feature set at compile time, e.g. of<physical_device_feature::wideLines>().
+		template <physical_device_feature... Features>
+		[[nodiscard]] constexpr static physical_device_features of() noexcept
+		{
+			return physical_device_features{.bits = (0ull | ... | (1ull << static_cast<rsl::uint64>(Features)))};
+		}
+
+		[[nodiscard]] constexpr bool has(physical_device_feature feature) const noexcept
+		{
+			return (bits & (1ull << static_cast<rsl::uint64>(feature))) != 0;
+		}
+
+		constexpr physical_device_features& set(physical_device_feature feature, bool enabled = true) noexcept
+		{
+			const rsl::uint64 mask = 1ull << static_cast<rsl::uint64>(feature);
+			bits = enabled ? (bits | mask) : (bits & ~mask);
+			return *this;
+		}
+
+		// True when every feature in required is in this set as well.
+		[[nodiscard]] constexpr bool contains(const physical_device_features& required) const noexcept
+		{
+			return (required.bits & ~bits) == 0;
+		}
+
+		[[nodiscard]] constexpr bool empty() const noexcept { return bits == 0; }
+		[[nodiscard]] constexpr rsl::uint64 get_hash() const noexcept { return bits; }
+
+		[[nodiscard]] constexpr physical_device_features operator|(const physical_device_features& other) const noexcept
+		{
+			return physical_device_features{.bits = bits | other.bits};
+		}
+
+		[[nodiscard]] constexpr physical_device_features operator&(const physical_device_features& other) const noexcept
+		{
+			return physical_device_features{.bits = bits & other.bits};
+		}
+
+		constexpr bool operator==(const physical_device_features&) const noexcept = default;
 	};
 
 	enum struct [[rythe_closed_enum]] physical_device_type : rsl::uint8
@@ -327,15 +410,45 @@ namespace vk
 	struct physical_device_properties
 	{
 		semver::version apiVersion;
+		// Decomposed with the Vulkan version layout, which drivers don't all follow. Compare rawDriverVersion to
+		// detect driver updates.
 		semver::version driverVersion;
+		rsl::uint32 rawDriverVersion;
 		rsl::uint32 vendorID;
 		rsl::uint32 deviceID;
 		physical_device_type deviceType;
 		std::string deviceName;
+		rsl::uint8 pipelineCacheUUID[16];
 		physical_device_limits limits;
 		physical_device_sparse_properties sparseProperties;
 	};
 
+	// The parts of VK_EXT_descriptor_indexing used by bindless descriptor tables. Everything stays false and zero when
+	// the device lacks the extension or the instance lacks VK_KHR_get_physical_device_properties2.
+	struct descriptor_indexing_capabilities
+	{
+		bool shaderSampledImageArrayNonUniformIndexing : 1 = false;
+		bool shaderStorageBufferArrayNonUniformIndexing : 1 = false;
+		bool shaderStorageImageArrayNonUniformIndexing : 1 = false;
+		bool descriptorBindingSampledImageUpdateAfterBind : 1 = false;
+		bool descriptorBindingStorageImageUpdateAfterBind : 1 = false;
+		bool descriptorBindingStorageBufferUpdateAfterBind : 1 = false;
+		bool descriptorBindingUpdateUnusedWhilePending : 1 = false;
+		bool descriptorBindingPartiallyBound : 1 = false;
+		bool descriptorBindingVariableDescriptorCount : 1 = false;
+		bool runtimeDescriptorArray : 1 = false;
+
+		rsl::uint32 maxUpdateAfterBindDescriptorsInAllPools = 0;
+		rsl::uint32 maxPerStageDescriptorUpdateAfterBindSamplers = 0;
+		rsl::uint32 maxPerStageDescriptorUpdateAfterBindStorageBuffers = 0;
+		rsl::uint32 maxPerStageDescriptorUpdateAfterBindSampledImages = 0;
+		rsl::uint32 maxPerStageDescriptorUpdateAfterBindStorageImages = 0;
+		rsl::uint32 maxDescriptorSetUpdateAfterBindSamplers = 0;
+		rsl::uint32 maxDescriptorSetUpdateAfterBindStorageBuffers = 0;
+		rsl::uint32 maxDescriptorSetUpdateAfterBindSampledImages = 0;
+		rsl::uint32 maxDescriptorSetUpdateAfterBindStorageImages = 0;
+	};
+
 	struct physical_device_description
 	{
 		rsl::size_type deviceTypeImportance[5] = {
@@ -346,7 +459,10 @@ namespace vk
 			0ull,    // CPU
 		};
 		semver::version apiVersion = semver::version(0, 0, 0);
+		// Devices without every required feature are skipped. The device is created with only the required features
+		// and the optional features it supports, nothing else is enabled.
 		physical_device_features requiredFeatures = {};
+		physical_device_features optionalFeatures = {};
 		rsl::size_type requiredPerStageSampledImages = 4096;
 	};
 
@@ -480,11 +596,22 @@ namespace vk
 	public:
 		operator bool() const noexcept;
 
+		// Frees the function table physical and render devices share, every render device created from the instance
+		// must be released first. Physical device handles taken from create_physical_devices become invalid.
 		void release();
 
-		std::span<physical_device> create_physical_devices(bool forceRefresh = false);
+		// Queries the capabilities of every device on threadCount threads (0 picks one per hardware thread, at most one
+		// per device), devices are then selected from the cached results.
+		std::span<physical_device> create_physical_devices(bool forceRefresh = false, rsl::size_type threadCount = 0);
 		void release_physical_devices();
 
+		// When set, physical devices take their capabilities from the snapshot at filePath if it was written against
+		// the same drivers, and auto_select_and_create_device only queries the driver for the selected device. Takes
+		// effect the next time the physical devices are created, an empty path disables the snapshot.
+		void set_capability_snapshot_path(std::string_view filePath);
+		// Writes the capabilities of every physical device, replacing the previous snapshot atomically.
+		bool save_capability_snapshot();
+
 		const application_info& get_application_info() const noexcept;
 		const semver::version& get_api_version() const noexcept;
 
@@ -514,9 +641,12 @@ namespace vk
 		const surface_capabilities& get_surface_capabilities(surface _surface, bool forceRefresh = false);
 		const physical_device_properties& get_properties(bool forceRefresh = false);
 		const physical_device_features& get_features(bool forceRefresh = false);
+		const descriptor_indexing_capabilities& get_descriptor_indexing_capabilities(bool forceRefresh = false);
 
 		std::span<const extension_properties> get_available_extensions(bool forceRefresh = false);
 		bool is_extension_available(rsl::hashed_string_view extensionName);
+		// True when every extension is available, a single hash lookup per extension.
+		bool are_extensions_available(std::span<const rsl::hashed_string_view> extensionNames);
 
 		std::span<const queue_family_properties>
 		get_available_queue_families(surface surface = {}, bool forceRefresh = false);
@@ -527,8 +657,10 @@ namespace vk
 
 		bool in_use() const noexcept;
 
+		// Enables exactly the given core features, fails when the device doesn't support all of them.
 		[[nodiscard]] render_device create_render_device(
-			std::span<const queue_description> queueDesciptions, std::span<const rsl::hashed_string> extensions = {}
+			std::span<const queue_description> queueDesciptions, std::span<const rsl::hashed_string> extensions = {},
+			const physical_device_features& features = {}
 		);
 
 		[[rythe_always_inline]] native_physical_device get_native_handle() const noexcept
@@ -542,7 +674,775 @@ namespace vk
 		friend void set_native_handle(physical_device&, native_physical_device);
 	};
 
+	// Values match their Vulkan counterparts, only the commonly used subset is named.
+	enum struct format : rsl::uint32
+	{
+		undefined = 0,
+		r8Unorm = 9,
+		r8g8Unorm = 16,
+		r8g8b8a8Unorm = 37,
+		r8g8b8a8Uint = 41,
+		r8g8b8a8Srgb = 43,
+		b8g8r8a8Unorm = 44,
+		b8g8r8a8Srgb = 50,
+		a2b10g10r10UnormPack32 = 64,
+		r16g16Sfloat = 83,
+		r16g16b16a16Unorm = 91,
+		r16g16b16a16Sfloat = 97,
+		r32Uint = 98,
+		r32Sint = 99,
+		r32Sfloat = 100,
+		r32g32Uint = 101,
+		r32g32Sint = 102,
+		r32g32Sfloat = 103,
+		r32g32b32Uint = 104,
+		r32g32b32Sint = 105,
+		r32g32b32Sfloat = 106,
+		r32g32b32a32Uint = 107,
+		r32g32b32a32Sint = 108,
+		r32g32b32a32Sfloat = 109,
+		b10g11r11UfloatPack32 = 122,
+		d16Unorm = 124,
+		d32Sfloat = 126,
+		s8Uint = 127,
+		d24UnormS8Uint = 129,
+		d32SfloatS8Uint = 130,
+	};
+
+	enum struct [[rythe_closed_enum]] [[rythe_flag_enum]] shader_stage_flags : rsl::uint32
+	{
+		vertex = 1 << 0,
+		tessellationControl = 1 << 1,
+		tessellationEvaluation = 1 << 2,
+		geometry = 1 << 3,
+		fragment = 1 << 4,
+		compute = 1 << 5,
+		allGraphics = 0x1F,
+		all = 0x3F,
+	};
+
+	enum struct [[rythe_closed_enum]] descriptor_type : rsl::uint32
+	{
+		sampler,
+		combinedImageSampler,
+		sampledImage,
+		storageImage,
+		uniformTexelBuffer,
+		storageTexelBuffer,
+		uniformBuffer,
+		storageBuffer,
+		uniformBufferDynamic,
+		storageBufferDynamic,
+		inputAttachment,
+	};
+
+	enum struct [[rythe_closed_enum]] vertex_input_rate : rsl::uint8
+	{
+		vertex,
+		instance,
+	};
+
+	enum struct [[rythe_closed_enum]] primitive_topology : rsl::uint8
+	{
+		pointList,
+		lineList,
+		lineStrip,
+		triangleList,
+		triangleStrip,
+		triangleFan,
+		lineListWithAdjacency,
+		lineStripWithAdjacency,
+		triangleListWithAdjacency,
+		triangleStripWithAdjacency,
+		patchList,
+	};
+
+	enum struct [[rythe_closed_enum]] polygon_mode : rsl::uint8
+	{
+		fill,
+		line,
+		point,
+	};
+
+	enum struct [[rythe_closed_enum]] cull_mode : rsl::uint8
+	{
+		none,
+		front,
+		back,
+		frontAndBack,
+	};
+
+	enum struct [[rythe_closed_enum]] front_face : rsl::uint8
+	{
+		counterClockwise,
+		clockwise,
+	};
+
+	enum struct [[rythe_closed_enum]] compare_op : rsl::uint8
+	{
+		never,
+		less,
+		equal,
+		lessOrEqual,
+		greater,
+		notEqual,
+		greaterOrEqual,
+		always,
+	};
+
+	enum struct [[rythe_closed_enum]] blend_factor : rsl::uint8
+	{
+		zero,
+		one,
+		srcColor,
+		oneMinusSrcColor,
+		dstColor,
+		oneMinusDstColor,
+		srcAlpha,
+		oneMinusSrcAlpha,
+		dstAlpha,
+		oneMinusDstAlpha,
+		constantColor,
+		oneMinusConstantColor,
+		constantAlpha,
+		oneMinusConstantAlpha,
+		srcAlphaSaturate,
+	};
+
+	enum struct [[rythe_closed_enum]] blend_op : rsl::uint8
+	{
+		add,
+		subtract,
+		reverseSubtract,
+		min,
+		max,
+	};
+
+	enum struct [[rythe_closed_enum]] [[rythe_flag_enum]] color_component_flags : rsl::uint8
+	{
+		r = 1 << 0,
+		g = 1 << 1,
+		b = 1 << 2,
+		a = 1 << 3,
+		all = 0xF,
+	};
+
+	enum struct [[rythe_closed_enum]] attachment_load_op : rsl::uint8
+	{
+		load,
+		clear,
+		dontCare,
+	};
+
+	enum struct [[rythe_closed_enum]] attachment_store_op : rsl::uint8
+	{
+		store,
+		dontCare,
+	};
+
+	enum struct image_layout : rsl::uint32
+	{
+		undefined = 0,
+		general = 1,
+		colorAttachmentOptimal = 2,
+		depthStencilAttachmentOptimal = 3,
+		depthStencilReadOnlyOptimal = 4,
+		shaderReadOnlyOptimal = 5,
+		transferSrcOptimal = 6,
+		transferDstOptimal = 7,
+		presentSrc = 1000001002,
+	};
+
+	struct shader_reflection;
+
+	class shader_module
+	{
+	public:
+		operator bool() const noexcept;
+
+		void release();
+
+		[[nodiscard]] rsl::uint64 get_hash() const noexcept;
+		[[nodiscard]] const shader_reflection& get_reflection() const noexcept;
+
+		[[rythe_always_inline]] native_shader_module get_native_handle() const noexcept { return m_nativeShaderModule; }
+
+	private:
+		native_shader_module m_nativeShaderModule = invalid_native_shader_module;
+		friend void set_native_handle(shader_module&, native_shader_module);
+	};
+
+	// Read-only pack of SPIR-V blobs, memory mapped for as long as the pack is open.
+	// Layout, all little endian:
+	//   shader_pack_header { uint32 magic = "SPVK", uint32 version = 1, uint32 entryCount, uint32 reserved }
+	//   entryCount x { uint32 nameOffset, uint32 nameSize, uint64 dataOffset, uint64 dataSize }
+	//   names and SPIR-V data, data offsets aligned to 4 bytes. Offsets are relative to the start of the file.
+	class shader_pack
+	{
+	public:
+		operator bool() const noexcept;
+
+		void release();
+
+		[[nodiscard]] rsl::size_type get_shader_count() const noexcept;
+		[[nodiscard]] std::string_view get_shader_name(rsl::size_type index) const noexcept;
+		[[nodiscard]] std::span<const rsl::uint32> get_shader_code(rsl::size_type index) const noexcept;
+
+		// Returns npos when the pack has no shader with the given name.
+		[[nodiscard]] rsl::size_type find_shader(std::string_view name) const noexcept;
+
+		// Shader modules are shared through the render device's shader module store, so loading the same code twice,
+		// from this or any other pack, returns the same module. Each returned module must be released.
+		[[nodiscard]] shader_module load_shader_module(rsl::size_type index);
+		[[nodiscard]] shader_module load_shader_module(std::string_view name);
+
+		[[rythe_always_inline]] native_shader_pack get_native_handle() const noexcept { return m_nativeShaderPack; }
+
+	private:
+		native_shader_pack m_nativeShaderPack = invalid_native_shader_pack;
+		friend void set_native_handle(shader_pack&, native_shader_pack);
+	};
+
+	// Everything but none needs the matching descriptor_indexing_capabilities on the render device. Layouts with an
+	// updateAfterBind binding can only be allocated from update after bind pools.
+	enum struct [[rythe_closed_enum]] [[rythe_flag_enum]] descriptor_binding_flags : rsl::uint32
+	{
+		none = 0,
+		updateAfterBind = 1 << 0,
+		updateUnusedWhilePending = 1 << 1,
+		partiallyBound = 1 << 2,
+		variableDescriptorCount = 1 << 3,
+	};
+
+	struct descriptor_binding_description
+	{
+		rsl::uint32 binding = 0;
+		descriptor_type type = descriptor_type::uniformBuffer;
+		rsl::uint32 count = 1;
+		shader_stage_flags stages = shader_stage_flags::allGraphics;
+		descriptor_binding_flags flags = descriptor_binding_flags::none;
+	};
+
+	struct descriptor_set_layout_description
+	{
+		std::vector<descriptor_binding_description> bindings;
+	};
+
+	class descriptor_set_layout
+	{
+	public:
+		operator bool() const noexcept;
+
+		void release();
+
+		// Bindings sorted by binding number.
+		[[nodiscard]] const descriptor_set_layout_description& get_description() const noexcept;
+
+		[[rythe_always_inline]] native_descriptor_set_layout get_native_handle() const noexcept
+		{
+			return m_nativeDescriptorSetLayout;
+		}
+
+	private:
+		native_descriptor_set_layout m_nativeDescriptorSetLayout = invalid_native_descriptor_set_layout;
+		friend void set_native_handle(descriptor_set_layout&, native_descriptor_set_layout);
+	};
+
+	struct push_constant_range
+	{
+		shader_stage_flags stages = shader_stage_flags::allGraphics;
+		rsl::uint32 offset = 0;
+		rsl::uint32 size = 0;
+	};
+
+	struct pipeline_layout_description
+	{
+		std::vector<descriptor_set_layout_description> descriptorSets;
+		std::vector<push_constant_range> pushConstantRanges;
+	};
+
+	class pipeline_layout
+	{
+	public:
+		operator bool() const noexcept;
+
+		void release();
+
+		[[nodiscard]] rsl::size_type get_descriptor_set_count() const noexcept;
+		// The returned layout is owned by the pipeline layout and must not be released.
+		[[nodiscard]] descriptor_set_layout get_descriptor_set_layout(rsl::size_type set) const noexcept;
+
+		[[rythe_always_inline]] native_pipeline_layout get_native_handle() const noexcept
+		{
+			return m_nativePipelineLayout;
+		}
+
+	private:
+		native_pipeline_layout m_nativePipelineLayout = invalid_native_pipeline_layout;
+		friend void set_native_handle(pipeline_layout&, native_pipeline_layout);
+	};
+
+	// Descriptor sets are owned by the allocator they came from and are only valid until that allocator is reset, the
+	// handle is the raw Vulkan handle so allocating a set never touches the heap.
+	class descriptor_set
+	{
+	public:
+		operator bool() const noexcept;
+
+		[[rythe_always_inline]] native_descriptor_set get_native_handle() const noexcept
+		{
+			return m_nativeDescriptorSet;
+		}
+
+	private:
+		native_descriptor_set m_nativeDescriptorSet = invalid_native_descriptor_set;
+		friend void set_native_handle(descriptor_set&, native_descriptor_set);
+	};
+
+	// Average number of descriptors of a type per allocated set.
+	struct descriptor_pool_ratio
+	{
+		descriptor_type type;
+		rsl::float32 ratio;
+	};
+
+	struct descriptor_allocator_description
+	{
+		std::vector<descriptor_pool_ratio> ratios = {
+			{.type = descriptor_type::uniformBuffer, .ratio = 2.f},
+			{.type = descriptor_type::storageBuffer, .ratio = 2.f},
+			{.type = descriptor_type::combinedImageSampler, .ratio = 4.f},
+			{.type = descriptor_type::sampledImage, .ratio = 2.f},
+			{.type = descriptor_type::storageImage, .ratio = 1.f},
+			{.type = descriptor_type::sampler, .ratio = 1.f},
+		};
+		// Both are raised to at least one set.
+		rsl::uint32 initialSetsPerPool = 64;
+		rsl::uint32 maxSetsPerPool = 4096;
+		// Each new pool holds this many times the sets of the previous one, up to maxSetsPerPool.
+		rsl::float32 growthFactor = 2.f;
+	};
+
+	// Linear descriptor set allocator over a growing list of pools. Sets can't be freed individually, reset returns
+	// every set at once with a single vkResetDescriptorPool per pool, so keep one allocator per frame in flight and
+	// reset it once that frame's work has completed. Not thread safe, use one allocator per recording thread.
+	class descriptor_allocator
+	{
+	public:
+		operator bool() const noexcept;
+
+		void release();
+
+		[[nodiscard]] descriptor_set allocate(descriptor_set_layout layout);
+		// Allocates one set per layout, returns false and leaves sets empty if any allocation fails.
+		[[nodiscard]] bool allocate(std::span<const descriptor_set_layout> layouts, std::span<descriptor_set> sets);
+
+		void reset();
+
+		[[nodiscard]] rsl::size_type get_pool_count() const noexcept;
+		[[nodiscard]] rsl::size_type get_allocated_set_count() const noexcept;
+
+		[[rythe_always_inline]] native_descriptor_allocator get_native_handle() const noexcept
+		{
+			return m_nativeDescriptorAllocator;
+		}
+
+	private:
+		native_descriptor_allocator m_nativeDescriptorAllocator = invalid_native_descriptor_allocator;
+		friend void set_native_handle(descriptor_allocator&, native_descriptor_allocator);
+	};
+
+	enum struct [[rythe_closed_enum]] filter : rsl::uint8
+	{
+		nearest,
+		linear,
+	};
+
+	enum struct [[rythe_closed_enum]] sampler_mipmap_mode : rsl::uint8
+	{
+		nearest,
+		linear,
+	};
+
+	enum struct [[rythe_closed_enum]] sampler_address_mode : rsl::uint8
+	{
+		repeat,
+		mirroredRepeat,
+		clampToEdge,
+		clampToBorder,
+		mirrorClampToEdge,
+	};
+
+	enum struct [[rythe_closed_enum]] border_color : rsl::uint8
+	{
+		floatTransparentBlack,
+		intTransparentBlack,
+		floatOpaqueBlack,
+		intOpaqueBlack,
+		floatOpaqueWhite,
+		intOpaqueWhite,
+	};
+
+	struct sampler_description
+	{
+		filter magFilter = filter::linear;
+		filter minFilter = filter::linear;
+		sampler_mipmap_mode mipmapMode = sampler_mipmap_mode::linear;
+		sampler_address_mode addressModeU = sampler_address_mode::repeat;
+		sampler_address_mode addressModeV = sampler_address_mode::repeat;
+		sampler_address_mode addressModeW = sampler_address_mode::repeat;
+		rsl::float32 mipLodBias = 0.f;
+		bool anisotropyEnable = false;
+		rsl::float32 maxAnisotropy = 1.f;
+		bool compareEnable = false;
+		compare_op compareOp = compare_op::never;
+		rsl::float32 minLod = 0.f;
+		rsl::float32 maxLod = 1000.f;
+		border_color borderColor = border_color::floatTransparentBlack;
+		bool unnormalizedCoordinates = false;
+	};
+
+	class sampler
+	{
+	public:
+		operator bool() const noexcept;
+
+		void release();
+
+		// The description after canonicalization, fields that don't affect sampling are reset to their defaults.
+		[[nodiscard]] const sampler_description& get_description() const noexcept;
+		[[nodiscard]] sampler_handle get_sampler_handle() const noexcept;
+
+		[[rythe_always_inline]] native_sampler get_native_handle() const noexcept { return m_nativeSampler; }
+
+	private:
+		native_sampler m_nativeSampler = invalid_native_sampler;
+		friend void set_native_handle(sampler&, native_sampler);
+	};
+
+	// Collects descriptor writes and submits them all with a single vkUpdateDescriptorSets call on flush. The writer
+	// remembers what it last wrote to every descriptor and drops writes that wouldn't change anything. It forgets all
+	// of that whenever a descriptor allocator of the device is reset or released, call invalidate when a set's
+	// contents become undefined some other way. Writes to the same descriptor before a flush replace each other. Texel
+	// buffer descriptors aren't supported. Not thread safe.
+	class descriptor_writer
+	{
+	public:
+		operator bool() const noexcept;
+
+		void release();
+
+		void write_buffer(
+			descriptor_set set, rsl::uint32 binding, descriptor_type type, buffer_handle buffer, rsl::uint64 offset = 0,
+			rsl::uint64 range = ~0ull, rsl::uint32 arrayElement = 0
+		);
+		void write_image(
+			descriptor_set set, rsl::uint32 binding, descriptor_type type, image_view_handle imageView,
+			image_layout layout = image_layout::shaderReadOnlyOptimal, sampler_handle sampler = invalid_sampler_handle,
+			rsl::uint32 arrayElement = 0
+		);
+
+		// Returns the number of descriptors written.
+		rsl::size_type flush();
+
+		void invalidate(descriptor_set set);
+		void invalidate_all();
+
+		[[nodiscard]] rsl::size_type get_pending_count() const noexcept;
+		[[nodiscard]] rsl::size_type get_dropped_count() const noexcept;
+
+		[[rythe_always_inline]] native_descriptor_writer get_native_handle() const noexcept
+		{
+			return m_nativeDescriptorWriter;
+		}
+
+	private:
+		native_descriptor_writer m_nativeDescriptorWriter = invalid_native_descriptor_writer;
+		friend void set_native_handle(descriptor_writer&, native_descriptor_writer);
+	};
+
+	enum struct [[rythe_closed_enum]] bindless_binding : rsl::uint32
+	{
+		sampledImage = 0,
+		sampler = 1,
+		storageBuffer = 2,
+		storageImage = 3,
+	};
+
+	// Capacities are clamped to the device limits, including the update after bind per stage limits and what is left
+	// of maxUpdateAfterBindDescriptorsInAllPools. A capacity of 0 leaves the binding out of the layout. The sampled
+	// image default matches physical_device_description::requiredPerStageSampledImages.
+	struct bindless_table_description
+	{
+		rsl::uint32 sampledImageCapacity = 4096;
+		rsl::uint32 samplerCapacity = 256;
+		rsl::uint32 storageBufferCapacity = 4096;
+		rsl::uint32 storageImageCapacity = 1024;
+		shader_stage_flags stages = shader_stage_flags::all;
+	};
+
+	// A single large descriptor set holding arrays of sampled images, samplers, storage buffers and storage images at
+	// the bindings named by bindless_binding. Shaders index the arrays with the slots returned by the allocate
+	// functions, so materials only need to pass indices. Requires descriptorBindingPartiallyBound. Bindings whose type
+	// supports update after bind are allocated from an update after bind pool, allocating and freeing slots is then
+	// allowed while the set is bound in command buffers that don't access those slots. Without update after bind,
+	// slots may only change while the set isn't in use by any pending command buffer. Thread safe.
+	class bindless_table
+	{
+	public:
+		static constexpr rsl::uint32 invalid_slot = ~0u;
+
+		operator bool() const noexcept;
+
+		void release();
+
+		// Returns invalid_slot when the binding is full.
+		[[nodiscard]] rsl::uint32
+		allocate_sampled_image(image_view_handle view, image_layout layout = image_layout::shaderReadOnlyOptimal);
+		[[nodiscard]] rsl::uint32 allocate_sampler(sampler_handle sampler);
+		[[nodiscard]] rsl::uint32
+		allocate_storage_buffer(buffer_handle buffer, rsl::size_type offset = 0, rsl::size_type range = ~0ull);
+		[[nodiscard]] rsl::uint32 allocate_storage_image(image_view_handle view);
+
+		// The slot can be handed out again right away, GPU work that still reads it must have finished. Freeing a slot
+		// that isn't allocated is reported and ignored.
+		void free(bindless_binding binding, rsl::uint32 slot);
+
+		[[nodiscard]] rsl::uint32 get_capacity(bindless_binding binding) const noexcept;
+		[[nodiscard]] rsl::uint32 get_allocated_count(bindless_binding binding) const noexcept;
+		[[nodiscard]] bool is_update_after_bind(bindless_binding binding) const noexcept;
+
+		// Owned by the table and must not be released. Put its description in a pipeline_layout_description to build
+		// pipeline layouts compatible with the table.
+		[[nodiscard]] descriptor_set_layout get_descriptor_set_layout() const noexcept;
+		[[nodiscard]] descriptor_set get_descriptor_set() const noexcept;
+
+		[[rythe_always_inline]] native_bindless_table get_native_handle() const noexcept
+		{
+			return m_nativeBindlessTable;
+		}
+
+	private:
+		native_bindless_table m_nativeBindlessTable = invalid_native_bindless_table;
+		friend void set_native_handle(bindless_table&, native_bindless_table);
+	};
+
+	struct attachment_description
+	{
+		vk::format format = vk::format::undefined;
+		sample_count_flags samples = sample_count_flags::sc1Bit;
+		attachment_load_op loadOp = attachment_load_op::clear;
+		attachment_store_op storeOp = attachment_store_op::store;
+		attachment_load_op stencilLoadOp = attachment_load_op::dontCare;
+		attachment_store_op stencilStoreOp = attachment_store_op::dontCare;
+		image_layout initialLayout = image_layout::undefined;
+		image_layout finalLayout = image_layout::colorAttachmentOptimal;
+	};
+
+	// Describes a render pass with a single subpass that writes all color attachments and the optional depth stencil
+	// attachment. Leave depthStencilAttachment.format undefined to render without depth.
+	struct render_pass_description
+	{
+		std::vector<attachment_description> colorAttachments;
+		attachment_description depthStencilAttachment = {
+			.storeOp = attachment_store_op::dontCare,
+			.finalLayout = image_layout::depthStencilAttachmentOptimal,
+		};
+	};
+
+	class render_pass
+	{
+	public:
+		operator bool() const noexcept;
+
+		void release();
+
+		[[rythe_always_inline]] native_render_pass get_native_handle() const noexcept { return m_nativeRenderPass; }
+
+	private:
+		native_render_pass m_nativeRenderPass = invalid_native_render_pass;
+		friend void set_native_handle(render_pass&, native_render_pass);
+	};
+
+	// Attachments are in render pass order, color attachments first and the depth stencil attachment last.
+	struct framebuffer_description
+	{
+		render_pass renderPass;
+		std::vector<image_view_handle> attachments;
+		rsl::uint32 width = 0;
+		rsl::uint32 height = 0;
+		rsl::uint32 layers = 1;
+	};
+
+	struct shader_stage_description
+	{
+		shader_stage_flags stage = shader_stage_flags::vertex;
+		shader_module module;
+		std::string entryPoint = "main";
+	};
+
+	struct vertex_binding_description
+	{
+		rsl::uint32 binding = 0;
+		rsl::uint32 stride = 0;
+		vertex_input_rate inputRate = vertex_input_rate::vertex;
+	};
+
+	struct vertex_attribute_description
+	{
+		rsl::uint32 location = 0;
+		rsl::uint32 binding = 0;
+		vk::format format = vk::format::undefined;
+		rsl::uint32 offset = 0;
+	};
+
+	// Interface of a single SPIR-V module. descriptorSets is indexed by set number, sets the shader doesn't use are
+	// left empty. vertexInputs is only filled for vertex shaders and assumes a single tightly packed vertex binding 0.
+	struct shader_reflection
+	{
+		shader_stage_flags stage = shader_stage_flags::vertex;
+		std::vector<descriptor_set_layout_description> descriptorSets;
+		std::vector<push_constant_range> pushConstantRanges;
+		std::vector<vertex_attribute_description> vertexInputs;
+	};
+
+	// Returns false when the code isn't valid SPIR-V, descriptors of unsupported types are skipped with a warning.
+	[[nodiscard]] bool reflect_spirv(std::span<const rsl::uint32> spirv, shader_reflection& reflection);
+
+	// Merges the interfaces of all stages into one layout. Bindings used by several stages get the combined stage
+	// flags, push constants are merged into a single range visible to every stage that uses them.
+	[[nodiscard]] pipeline_layout_description merge_shader_reflections(std::span<const shader_module> modules);
+
+	// Fixed function state that is set while recording instead of being baked into the pipeline. cullMode through
+	// depthBiasEnable need Vulkan 1.3 or VK_EXT_extended_dynamic_state and VK_EXT_extended_dynamic_state2, the rest
+	// VK_EXT_extended_dynamic_state3 and its matching feature.
+	enum struct [[rythe_closed_enum]] [[rythe_flag_enum]] dynamic_state_flags : rsl::uint32
+	{
+		none = 0,
+		cullMode = 1 << 0,
+		frontFace = 1 << 1,
+		primitiveTopology = 1 << 2,
+		primitiveRestartEnable = 1 << 3,
+		depthTestEnable = 1 << 4,
+		depthWriteEnable = 1 << 5,
+		depthCompareOp = 1 << 6,
+		depthBiasEnable = 1 << 7,
+		polygonMode = 1 << 8,
+		depthClampEnable = 1 << 9,
+		colorBlendEnable = 1 << 10,
+		colorBlendEquation = 1 << 11,
+		colorWriteMask = 1 << 12,
+		all = 0x1FFF,
+	};
+
+	struct rasterization_state
+	{
+		polygon_mode polygonMode = polygon_mode::fill;
+		cull_mode cullMode = cull_mode::back;
+		front_face frontFace = front_face::counterClockwise;
+		bool depthClampEnable = false;
+		bool depthBiasEnable = false;
+		rsl::float32 lineWidth = 1.f;
+	};
+
+	struct depth_stencil_state
+	{
+		bool depthTestEnable = true;
+		bool depthWriteEnable = true;
+		compare_op depthCompareOp = compare_op::less;
+	};
+
+	struct color_blend_attachment_state
+	{
+		bool blendEnable = false;
+		blend_factor srcColorBlendFactor = blend_factor::one;
+		blend_factor dstColorBlendFactor = blend_factor::zero;
+		blend_op colorBlendOp = blend_op::add;
+		blend_factor srcAlphaBlendFactor = blend_factor::one;
+		blend_factor dstAlphaBlendFactor = blend_factor::zero;
+		blend_op alphaBlendOp = blend_op::add;
+		color_component_flags colorWriteMask = color_component_flags::all;
+	};
+
+	// Viewport and scissor are always dynamic. States in dynamicState that the device supports are left out of the
+	// pipeline and its cache key, pipelines that only differ in those states are shared and the state has to be set
+	// with command_buffer::set_dynamic_state after binding. A dynamic topology still keys on its topology class.
+	struct graphics_pipeline_description
+	{
+		std::vector<shader_stage_description> stages;
+		std::vector<vertex_binding_description> vertexBindings;
+		std::vector<vertex_attribute_description> vertexAttributes;
+		primitive_topology topology = primitive_topology::triangleList;
+		bool primitiveRestartEnable = false;
+		rasterization_state rasterization;
+		sample_count_flags samples = sample_count_flags::sc1Bit;
+		depth_stencil_state depthStencil;
+		std::vector<color_blend_attachment_state> colorBlendAttachments;
+		pipeline_layout layout;
+		render_pass renderPass;
+		rsl::uint32 subpass = 0;
+		// Attachment formats for pipelines used with command_buffer::begin_rendering, only read when renderPass is
+		// empty.
+		std::vector<format> colorAttachmentFormats;
+		format depthAttachmentFormat = format::undefined;
+		format stencilAttachmentFormat = format::undefined;
+		// States to leave dynamic, limited to get_dynamic_state_support. Dynamic states have to be recorded before
+		// every draw, so none are by default.
+		dynamic_state_flags dynamicState = dynamic_state_flags::none;
+	};
+
+	struct compute_pipeline_description
+	{
+		shader_stage_description stage = {.stage = shader_stage_flags::compute, .module = {}};
+		pipeline_layout layout;
+	};
+
+	enum struct [[rythe_closed_enum]] [[rythe_flag_enum]] buffer_usage_flags : rsl::uint32
+	{
+		transferSrc = 1 << 0,
+		transferDst = 1 << 1,
+		uniformTexelBuffer = 1 << 2,
+		storageTexelBuffer = 1 << 3,
+		uniformBuffer = 1 << 4,
+		storageBuffer = 1 << 5,
+		indexBuffer = 1 << 6,
+		vertexBuffer = 1 << 7,
+		indirectBuffer = 1 << 8,
+	};
+
+	struct buffer_description
+	{
+		rsl::uint64 size = 0;
+		buffer_usage_flags usage = buffer_usage_flags::storageBuffer;
+	};
+
+	// Device local buffer with a dedicated allocation, meant for a few long lived buffers rather than one per object.
+	// The contents start out undefined. Must be released before its render device.
+	class buffer
+	{
+	public:
+		operator bool() const noexcept;
+
+		void release();
+
+		[[nodiscard]] const buffer_description& get_description() const noexcept;
+		[[nodiscard]] buffer_handle get_buffer_handle() const noexcept;
+
+		[[rythe_always_inline]] native_buffer get_native_handle() const noexcept { return m_nativeBuffer; }
+
+	private:
+		native_buffer m_nativeBuffer = invalid_native_buffer;
+		friend void set_native_handle(buffer&, native_buffer);
+	};
+
 	class queue;
+	class pipeline_cache;
+	class pipeline;
+	class pipeline_batch;
+	class swapchain;
+	struct swapchain_description;
+	class headless_target;
+	struct headless_target_description;
 
 	class render_device
 	{
@@ -553,6 +1453,106 @@ namespace vk
 
 		std::span<queue> get_queues() noexcept;
 		physical_device get_physical_device() const noexcept;
+		// The lower of the instance and physical device API versions.
+		semver::version get_api_version() const noexcept;
+
+		// True on Vulkan 1.3 devices and devices with VK_KHR_dynamic_rendering, which create_render_device enables
+		// when the device is older than 1.3.
+		[[nodiscard]] bool supports_dynamic_rendering() const noexcept;
+		// The states graphics pipelines on this device can leave dynamic.
+		[[nodiscard]] dynamic_state_flags get_dynamic_state_support() const noexcept;
+		// True when VK_EXT_graphics_pipeline_library is enabled, create_render_device enables it when available.
+		[[nodiscard]] bool supports_graphics_pipeline_library() const noexcept;
+		// VK_KHR_present_id and VK_KHR_present_wait are enabled for applications with a window handle when available.
+		[[nodiscard]] bool supports_present_wait() const noexcept;
+		// The core features the device was created with, a subset of physical_device::get_features.
+		[[nodiscard]] const physical_device_features& get_enabled_features() const noexcept;
+
+		// Loads the cache from filePath if it exists and was written by the same device and driver, otherwise starts
+		// empty. An empty filePath creates an in-memory cache that can only be saved with an explicit path.
+		[[nodiscard]] pipeline_cache create_pipeline_cache(std::string_view filePath = {});
+
+		// Shader modules are content addressed, identical SPIR-V returns the same reference counted module.
+		[[nodiscard]] shader_module create_shader_module(std::span<const rsl::uint32> spirv);
+		[[nodiscard]] shader_pack open_shader_pack(std::string_view filePath);
+		// Descriptor set layouts are hash-consed on their bindings, equal descriptions return the same reference
+		// counted layout. Binding order doesn't matter.
+		[[nodiscard]] descriptor_set_layout
+		create_descriptor_set_layout(const descriptor_set_layout_description& description);
+
+		// Pipeline layouts are deduplicated on their description, equal descriptions return the same reference
+		// counted layout, which keeps pipelines built from them layout compatible.
+		[[nodiscard]] pipeline_layout create_pipeline_layout(const pipeline_layout_description& description);
+		// Derives the layout from the reflected interfaces of the given modules.
+		[[nodiscard]] pipeline_layout create_pipeline_layout(std::span<const shader_module> modules);
+		// Render passes are hash-consed on their full description, including load/store ops and layouts, and reference
+		// counted.
+		[[nodiscard]] render_pass create_render_pass(const render_pass_description& description);
+
+		// Returns the cached framebuffer for the attachments, extent and render pass compatibility class, creating it
+		// on first use. The cache owns the framebuffer, it stays valid until one of its image views is destroyed with
+		// destroy_image_view or the device is released. Thread safe.
+		// The cache is keyed on the raw image view handles, so views used with get_framebuffer must be destroyed
+		// through destroy_image_view. A view destroyed any other way leaves its framebuffers behind, and a new view
+		// that gets the same handle would be given them.
+		[[nodiscard]] framebuffer_handle get_framebuffer(const framebuffer_description& description);
+		[[nodiscard]] rsl::size_type get_cached_framebuffer_count() const noexcept;
+		// Evicts and destroys every cached framebuffer that uses the view before destroying the view itself, only
+		// call it once no pending command buffer uses the view anymore.
+		void destroy_image_view(image_view_handle imageView);
+		// Evicts the view's framebuffers from the cache right away but only destroys them and the view once
+		// collect_retired_image_views is called with retireFrame or a later frame. Frame numbers are the caller's,
+		// e.g. the number of the last frame that may still use the view.
+		void destroy_image_view(image_view_handle imageView, rsl::uint64 retireFrame);
+		// Call with the last frame known to have completed on the GPU, e.g. right after waiting on its fence.
+		void collect_retired_image_views(rsl::uint64 completedFrame);
+
+		[[nodiscard]] descriptor_allocator
+		create_descriptor_allocator(const descriptor_allocator_description& description = {});
+		[[nodiscard]] descriptor_writer create_descriptor_writer();
+
+		// Samplers are hash-consed on their canonical description and reference counted. Live samplers are counted
+		// against maxSamplerAllocationCount, a warning is printed when nearing the limit and creation fails past it.
+		// Anisotropy is turned off unless samplerAnisotropy was enabled on the device.
+		[[nodiscard]] sampler create_sampler(const sampler_description& description);
+		[[nodiscard]] rsl::size_type get_live_sampler_count() const noexcept;
+
+		// Only filled when VK_EXT_descriptor_indexing was enabled on the device, which then enables all of it.
+		[[nodiscard]] const descriptor_indexing_capabilities& get_descriptor_indexing_capabilities() const noexcept;
+		[[nodiscard]] bindless_table create_bindless_table(const bindless_table_description& description = {});
+
+		// Pipelines are deduplicated on their shader modules, fixed function state, layout and render pass
+		// compatibility. Identical requests return the same reference counted pipeline, every handle must be released.
+		// With graphics pipeline library support the vertex input, pre-rasterization, fragment shader and fragment
+		// output parts are compiled once each and shared, new combinations are fast-linked from them and get their
+		// link time optimized version from a background thread.
+		[[nodiscard]] pipeline create_graphics_pipeline(const graphics_pipeline_description& description);
+		[[nodiscard]] pipeline
+		create_graphics_pipeline(const graphics_pipeline_description& description, pipeline_cache cache);
+		[[nodiscard]] pipeline create_compute_pipeline(const compute_pipeline_description& description);
+		[[nodiscard]] pipeline
+		create_compute_pipeline(const compute_pipeline_description& description, pipeline_cache cache);
+
+		// Compiles the pipelines on threadCount worker threads (0 picks one per hardware thread), each with its own
+		// VkPipelineCache seeded from cache. The worker caches are merged back into cache once the whole batch has
+		// finished, so cache must not be saved or merged into until then. Everything the descriptions reference has to
+		// outlive the batch.
+		[[nodiscard]] pipeline_batch create_pipelines_async(
+			std::span<const graphics_pipeline_description> graphicsPipelines,
+			std::span<const compute_pipeline_description> computePipelines
+		);
+		[[nodiscard]] pipeline_batch create_pipelines_async(
+			std::span<const graphics_pipeline_description> graphicsPipelines,
+			std::span<const compute_pipeline_description> computePipelines, pipeline_cache cache,
+			rsl::size_type threadCount = 0
+		);
+
+		// Needs VK_KHR_swapchain, which create_render_device enables for applications with a window handle.
+		[[nodiscard]] swapchain create_swapchain(surface surface, const swapchain_description& description);
+		// Offscreen stand-in for a swapchain, needs no surface or window.
+		[[nodiscard]] headless_target create_headless_target(const headless_target_description& description);
+
+		[[nodiscard]] buffer create_buffer(const buffer_description& description);
 
 		[[rythe_always_inline]] native_render_device get_native_handle() const noexcept { return m_nativeRenderDevice; }
 
@@ -579,6 +1579,11 @@ namespace vk
 		[[nodiscard]] persistent_command_pool create_persistent_command_pool(bool protectedCommandBuffers = false);
 		[[nodiscard]] transient_command_pool create_transient_command_pool(bool protectedCommandBuffers = false);
 
+		// Submits without semaphores or a fence, for work that is waited on with wait_idle. Frames go through
+		// swapchain::present or headless_target::present instead.
+		bool submit(std::span<const command_buffer> commandBuffers);
+		bool wait_idle();
+
 		[[rythe_always_inline]] native_queue get_native_handle() const noexcept { return m_nativeQueue; }
 
 	private:
@@ -649,13 +1654,80 @@ namespace vk
 		void return_command_buffer(command_buffer& commandBuffer) override;
 	};
 
+	// Clear values are read according to the attachment, color for color attachments and depth and stencil otherwise.
+	struct clear_value
+	{
+		rsl::float32 color[4] = {0.f, 0.f, 0.f, 0.f};
+		rsl::float32 depth = 1.f;
+		rsl::uint32 stencil = 0;
+	};
+
+	struct rendering_attachment
+	{
+		image_view_handle imageView = invalid_image_view_handle;
+		image_layout layout = image_layout::colorAttachmentOptimal;
+		attachment_load_op loadOp = attachment_load_op::clear;
+		attachment_store_op storeOp = attachment_store_op::store;
+		clear_value clearValue;
+	};
+
+	// Depth and stencil attachments without an image view are left out. Color attachments without one keep their
+	// slot so the attachment locations stay put, writes to them are discarded. The attachment views are only read
+	// during begin_rendering, nothing is allocated, so this can be built on the stack every frame.
+	struct rendering_description
+	{
+		rsl::math::int2 renderAreaOffset = {0, 0};
+		rsl::math::uint2 renderAreaExtent;
+		rsl::uint32 layerCount = 1;
+		std::span<const rendering_attachment> colorAttachments;
+		rendering_attachment depthAttachment = {
+			.layout = image_layout::depthStencilAttachmentOptimal,
+			.clearValue = {},
+		};
+		rendering_attachment stencilAttachment = {
+			.layout = image_layout::depthStencilAttachmentOptimal,
+			.clearValue = {},
+		};
+	};
+
 	class command_buffer
 	{
 	public:
+		static constexpr rsl::size_type max_rendering_color_attachments = 8;
+
 		operator bool() const noexcept;
 
 		void return_to_pool();
 
+		// Starts recording a primary command buffer for a single submit, implicitly resetting what was recorded
+		// before. The previous submit of the command buffer must have finished.
+		bool begin();
+		bool end();
+
+		// Barrier on the first mip level and layer of a color image, with the stages and accesses derived from the
+		// layouts. Transitions from undefined wait on all earlier commands, which also covers swapchain acquire
+		// semaphores regardless of their wait stage.
+		void transition_image_layout(image_handle image, image_layout oldLayout, image_layout newLayout);
+		// The image must be in layout general or transferDstOptimal.
+		void clear_color_image(image_handle image, image_layout layout, const clear_value& value);
+
+		// Starts a render pass instance directly from the attachments, without VkRenderPass or VkFramebuffer objects.
+		// Needs render_device::supports_dynamic_rendering and at most max_rendering_color_attachments color
+		// attachments, returns false otherwise. Pipelines drawn inside must be created without a render pass.
+		bool begin_rendering(const rendering_description& description);
+		void end_rendering();
+
+		void bind_pipeline(const pipeline& pipeline);
+		// Binds the sets from firstSet on, at the bind point and with the layout of pipeline.
+		void bind_descriptor_sets(const pipeline& pipeline, rsl::uint32 firstSet, std::span<const descriptor_set> sets);
+		void push_constants(
+			const pipeline& pipeline, shader_stage_flags stages, rsl::uint32 offset, std::span<const rsl::byte> data
+		);
+		void dispatch(rsl::uint32 groupCountX, rsl::uint32 groupCountY = 1, rsl::uint32 groupCountZ = 1);
+		// Records the states in dynamicState with their values from description, usually called with
+		// pipeline::get_dynamic_state after binding a pipeline created from an equivalent description.
+		void set_dynamic_state(const graphics_pipeline_description& description, dynamic_state_flags dynamicState);
+
 		[[rythe_always_inline]] native_command_buffer get_native_handle() const noexcept
 		{
 			return m_nativeCommandBuffer;
@@ -665,4 +1737,296 @@ namespace vk
 		native_command_buffer m_nativeCommandBuffer = invalid_native_command_buffer;
 		friend void set_native_handle(command_buffer&, native_command_buffer);
 	};
+
+	class pipeline_cache
+	{
+	public:
+		operator bool() const noexcept;
+
+		void release();
+
+		// Writes to a temporary file first and renames it over the target, so a crash never leaves a torn cache.
+		bool save();
+		bool save(std::string_view filePath);
+
+		bool merge(std::span<const pipeline_cache> sourceCaches);
+
+		[[nodiscard]] rsl::size_type get_data_size() const;
+		[[nodiscard]] std::string_view get_file_path() const noexcept;
+
+		[[rythe_always_inline]] native_pipeline_cache get_native_handle() const noexcept
+		{
+			return m_nativePipelineCache;
+		}
+
+	private:
+		native_pipeline_cache m_nativePipelineCache = invalid_native_pipeline_cache;
+		friend void set_native_handle(pipeline_cache&, native_pipeline_cache);
+	};
+
+	enum struct [[rythe_closed_enum]] pipeline_bind_point : rsl::uint8
+	{
+		graphics,
+		compute,
+	};
+
+	class pipeline
+	{
+	public:
+		operator bool() const noexcept;
+
+		void release();
+
+		[[nodiscard]] pipeline_bind_point get_bind_point() const noexcept;
+		// The states that were left dynamic, always none for compute pipelines.
+		[[nodiscard]] dynamic_state_flags get_dynamic_state() const noexcept;
+		// True while a fast-linked pipeline waits for its link time optimized version, command_buffer::bind_pipeline
+		// binds that version once it's ready.
+		[[nodiscard]] bool is_link_pending() const noexcept;
+
+		[[rythe_always_inline]] native_pipeline get_native_handle() const noexcept { return m_nativePipeline; }
+
+	private:
+		native_pipeline m_nativePipeline = invalid_native_pipeline;
+		friend void set_native_handle(pipeline&, native_pipeline);
+	};
+
+	class pipeline_batch
+	{
+	public:
+		operator bool() const noexcept;
+
+		// Waits for the batch to finish. The compiled pipelines are owned by the caller and stay valid.
+		void release();
+
+		void wait();
+		[[nodiscard]] bool is_done() const noexcept;
+		[[nodiscard]] rsl::size_type get_completed_count() const noexcept;
+
+		// Futures hold an invalid pipeline if compilation failed.
+		[[nodiscard]] std::span<const std::shared_future<pipeline>> get_graphics_pipelines() const noexcept;
+		[[nodiscard]] std::span<const std::shared_future<pipeline>> get_compute_pipelines() const noexcept;
+
+		[[rythe_always_inline]] native_pipeline_batch get_native_handle() const noexcept
+		{
+			return m_nativePipelineBatch;
+		}
+
+	private:
+		native_pipeline_batch m_nativePipelineBatch = invalid_native_pipeline_batch;
+		friend void set_native_handle(pipeline_batch&, native_pipeline_batch);
+	};
+
+	// Same values as VkPresentModeKHR.
+	enum struct [[rythe_closed_enum]] present_mode : rsl::uint32
+	{
+		immediate = 0,
+		mailbox = 1,
+		fifo = 2,
+		fifoRelaxed = 3,
+	};
+
+	std::string_view to_string(present_mode mode);
+
+	enum struct [[rythe_closed_enum]] swapchain_status : rsl::uint8
+	{
+		ready,
+		// The image can still be presented, but the swapchain should be recreated to match the surface.
+		suboptimal,
+		outOfDate,
+		failed,
+	};
+
+	struct swapchain_description
+	{
+		// Falls back to fifo, which is always supported, when the surface doesn't support the requested mode.
+		present_mode presentMode = present_mode::mailbox;
+		// 0 picks minImageCount + 1, and at least 3 for mailbox so there is always an image to render into while one
+		// is on screen and one is queued. Clamped to the surface's minImageCount and maxImageCount.
+		rsl::uint32 imageCount = 0;
+		// Frames the CPU may record ahead of the GPU, each has its own acquire semaphore and fence.
+		rsl::uint32 framesInFlight = 2;
+		// Falls back to the first format the surface reports when this one isn't supported.
+		format imageFormat = format::b8g8r8a8Srgb;
+		image_usage_flags imageUsage = image_usage_flags::colorAttachment;
+		// Only used when the surface leaves the extent up to the swapchain, clamped to the surface limits.
+		rsl::math::uint2 extent = {0, 0};
+	};
+
+	// Nanoseconds on std::chrono::steady_clock, 0 for points that weren't reached or can't be measured.
+	struct frame_timing
+	{
+		// Also the present id when present waits are used, starts at 1.
+		rsl::uint64 frameNumber = 0;
+		rsl::uint64 frameStart = 0;
+		rsl::uint64 acquireReturn = 0;
+		rsl::uint64 submit = 0;
+		// Return of vkQueuePresentKHR.
+		rsl::uint64 present = 0;
+		// When the presentation engine actually showed the image, only measured with VK_KHR_present_wait. Present
+		// waits are checked without blocking from acquire_next_image and present, so this is when the first of those
+		// calls saw the image on screen, which can be up to the time between them later than the actual display.
+		rsl::uint64 presentComplete = 0;
+	};
+
+	// Fixed width buckets of bucket_width nanoseconds, the last bucket also counts everything beyond it.
+	class latency_histogram
+	{
+	public:
+		constexpr static rsl::size_type bucket_count = 256;
+		constexpr static rsl::uint64 bucket_width = 250'000;
+
+		void record(rsl::uint64 nanoseconds) noexcept;
+		void reset() noexcept;
+
+		[[nodiscard]] rsl::uint64 get_sample_count() const noexcept { return m_sampleCount; }
+		[[nodiscard]] rsl::uint64 get_min() const noexcept;
+		[[nodiscard]] rsl::uint64 get_max() const noexcept;
+		[[nodiscard]] rsl::uint64 get_mean() const noexcept;
+		// Upper bound of the bucket holding the given percentile in [0, 1], 0 without samples.
+		[[nodiscard]] rsl::uint64 get_percentile(float percentile) const noexcept;
+		[[nodiscard]] std::span<const rsl::uint64> get_buckets() const noexcept { return m_buckets; }
+
+	private:
+		rsl::uint64 m_buckets[bucket_count] = {};
+		rsl::uint64 m_sampleCount = 0;
+		rsl::uint64 m_total = 0;
+		rsl::uint64 m_min = ~0ull;
+		rsl::uint64 m_max = 0;
+	};
+
+	// Frames whose present failed, e.g. with outOfDate, aren't recorded.
+	struct frame_latency
+	{
+		// frameStart to acquireReturn, time blocked on the frame slot's fence and the presentation engine.
+		latency_histogram acquire;
+		// frameStart to submit.
+		latency_histogram cpuFrame;
+		// submit to the return of vkQueuePresentKHR.
+		latency_histogram present;
+		// frameStart to presentComplete, empty without VK_KHR_present_wait. Has the resolution of presentComplete.
+		latency_histogram startToDisplay;
+	};
+
+	class swapchain
+	{
+	public:
+		operator bool() const noexcept;
+
+		// Waits for the frames in flight of this swapchain and for the last present queue used, not for the whole
+		// device.
+		void release();
+
+		// Waits until the current frame slot is free again and acquires the next image with the slot's semaphore.
+		// Calling it again before present returns the image that is still acquired.
+		[[nodiscard]] swapchain_status acquire_next_image();
+		// Submits the command buffers on submitQueue, waiting for the acquired image and signalling the frame's fence,
+		// then presents the image on presentQueue and moves to the next frame slot. When the submit fails the frame
+		// is dropped, its image is presented as is and failed is returned, the slot still moves on.
+		swapchain_status
+		present(queue submitQueue, std::span<const command_buffer> commandBuffers, queue presentQueue);
+
+		// Builds a swapchain for the surface's current size with the current one as oldSwapchain, without waiting
+		// for the device. The old images are destroyed once every frame slot's fence has been waited on by
+		// acquire_next_image, so frames still in flight on them can finish. Call it after present, or when
+		// acquire_next_image returned outOfDate. Returns outOfDate and keeps the current swapchain while the surface
+		// has a zero size, like a minimized window. extent is only used when the surface leaves the size up to the
+		// swapchain, {0, 0} keeps the previous one.
+		swapchain_status recreate(rsl::math::uint2 extent = {0, 0});
+		// Old swapchains still waiting for their frames to finish.
+		[[nodiscard]] rsl::size_type get_retired_count() const noexcept;
+
+		// Marks the start of the CPU work of a frame, acquire_next_image marks it when this wasn't called first.
+		void begin_frame() noexcept;
+		// The most recent frame with all of its timestamps. With present waits that's the last frame seen on
+		// screen, which is checked without blocking on every acquire_next_image.
+		[[nodiscard]] const frame_timing& get_last_frame_timing() const noexcept;
+		[[nodiscard]] const frame_latency& get_latency() const noexcept;
+		void reset_latency() noexcept;
+		// Whether presentComplete and the startToDisplay histogram are measured.
+		[[nodiscard]] bool measures_present_completion() const noexcept;
+
+		[[nodiscard]] rsl::size_type get_image_count() const noexcept;
+		[[nodiscard]] std::span<const image_view_handle> get_image_views() const noexcept;
+		[[nodiscard]] rsl::uint32 get_current_image_index() const noexcept;
+		[[nodiscard]] image_handle get_current_image() const noexcept;
+		[[nodiscard]] image_view_handle get_current_image_view() const noexcept;
+		// Index of the current frame slot, in [0, get_frames_in_flight()), for indexing per frame resources.
+		[[nodiscard]] rsl::size_type get_frame_index() const noexcept;
+		[[nodiscard]] rsl::size_type get_frames_in_flight() const noexcept;
+
+		[[nodiscard]] format get_format() const noexcept;
+		[[nodiscard]] rsl::math::uint2 get_extent() const noexcept;
+		[[nodiscard]] present_mode get_present_mode() const noexcept;
+		// The layout the current image has to be in when present is called, presentSrc.
+		[[nodiscard]] image_layout get_present_layout() const noexcept;
+
+		[[rythe_always_inline]] native_swapchain get_native_handle() const noexcept { return m_nativeSwapchain; }
+
+	private:
+		native_swapchain m_nativeSwapchain = invalid_native_swapchain;
+		friend void set_native_handle(swapchain&, native_swapchain);
+	};
+
+	struct headless_target_description
+	{
+		// Images in the ring, raised to framesInFlight so an image is never rendered to by two frames at once.
+		rsl::uint32 imageCount = 3;
+		rsl::uint32 framesInFlight = 2;
+		format imageFormat = format::r8g8b8a8Unorm;
+		// transferSrc and transferDst are always added, for clears and for copying results out.
+		image_usage_flags imageUsage = image_usage_flags::colorAttachment;
+		rsl::math::uint2 extent = {1280, 720};
+	};
+
+	// Ring of device local images with the same frame API as swapchain, so a frame loop written against one runs on
+	// the other. There is no presentation engine, present only submits and acquire_next_image hands out the images in
+	// order, which makes it usable for benchmarks on machines without a display, like CI with a CPU implementation.
+	class headless_target
+	{
+	public:
+		operator bool() const noexcept;
+
+		// Waits for the frames in flight of this target only, not for the whole device.
+		void release();
+
+		// Waits until the current frame slot is free again and moves to the next image. Never out of date.
+		[[nodiscard]] swapchain_status acquire_next_image();
+		// Submits the command buffers on submitQueue, signalling the frame's fence, and moves to the next frame slot.
+		// A failed submit returns failed and stays on the slot, whose fence is left signaled. presentQueue is only
+		// there to match swapchain::present and isn't used.
+		swapchain_status
+		present(queue submitQueue, std::span<const command_buffer> commandBuffers, queue presentQueue = {});
+
+		// Rebuilds the images, waiting for this target's own frames in flight first. {0, 0} keeps the extent.
+		swapchain_status recreate(rsl::math::uint2 extent = {0, 0});
+
+		// Same timings as the swapchain's, the present histogram and presentComplete stay empty.
+		void begin_frame() noexcept;
+		[[nodiscard]] const frame_timing& get_last_frame_timing() const noexcept;
+		[[nodiscard]] const frame_latency& get_latency() const noexcept;
+		void reset_latency() noexcept;
+
+		[[nodiscard]] rsl::size_type get_image_count() const noexcept;
+		[[nodiscard]] std::span<const image_view_handle> get_image_views() const noexcept;
+		[[nodiscard]] rsl::uint32 get_current_image_index() const noexcept;
+		[[nodiscard]] image_handle get_current_image() const noexcept;
+		[[nodiscard]] image_view_handle get_current_image_view() const noexcept;
+		[[nodiscard]] rsl::size_type get_frame_index() const noexcept;
+		[[nodiscard]] rsl::size_type get_frames_in_flight() const noexcept;
+
+		[[nodiscard]] format get_format() const noexcept;
+		[[nodiscard]] rsl::math::uint2 get_extent() const noexcept;
+		// transferSrcOptimal, so finished images can be copied out for inspection.
+		[[nodiscard]] image_layout get_present_layout() const noexcept;
+
+		[[rythe_always_inline]] native_headless_target get_native_handle() const noexcept
+		{
+			return m_nativeHeadlessTarget;
+		}
+
+	private:
+		native_headless_target m_nativeHeadlessTarget = invalid_native_headless_target;
+		friend void set_native_handle(headless_target&, native_headless_target);
+	};
 } // namespace vk